@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <unistd.h>
+#include <iostream>
+#include "adafruitms1438.h"
+#include "motionengine.h"
+
+using namespace std;
+using namespace upm;
+
+static void moveDone(unsigned int id, bool completed, void *ctx)
+{
+  cout << (const char *)ctx << ": move " << id
+       << (completed ? " completed" : " cancelled") << endl;
+}
+
+int main(int argc, char **argv)
+{
+//! [Interesting]
+  // Instantiate an Adafruit MS 1438 on I2C bus 0, with 200 step per
+  // revolution steppers on M1 & M2 and M3 & M4
+
+  upm::AdafruitMS1438 *ms =
+    new upm::AdafruitMS1438(ADAFRUITMS1438_I2C_BUS,
+                            ADAFRUITMS1438_DEFAULT_I2C_ADDR);
+
+  MotionAxis *x = ms->getMotionAxis(AdafruitMS1438::STEPMOTOR_M12);
+  MotionAxis *y = ms->getMotionAxis(AdafruitMS1438::STEPMOTOR_M34);
+
+  ms->enableStepper(AdafruitMS1438::STEPMOTOR_M12);
+  ms->enableStepper(AdafruitMS1438::STEPMOTOR_M34);
+
+  // 100 steps/s (30 RPM), reached after half a second
+  x->setMaxSpeed(100);
+  x->setAcceleration(200);
+  y->setMaxSpeed(100);
+  y->setAcceleration(200);
+
+  // queue moves on both axes; they run at the same time, in the
+  // background
+  x->move(400, moveDone, (void *)"X");
+  x->move(-400, moveDone, (void *)"X");
+  unsigned int last = y->move(200, moveDone, (void *)"Y");
+
+  while (x->busy() || y->busy())
+    {
+      cout << "X at " << x->getPosition() << " (" << x->getSpeed()
+           << " steps/s), Y at " << y->getPosition() << " ("
+           << y->getSpeed() << " steps/s)" << endl;
+      usleep(250000);
+    }
+
+  y->waitMove(last);
+
+  ms->disableStepper(AdafruitMS1438::STEPMOTOR_M12);
+  ms->disableStepper(AdafruitMS1438::STEPMOTOR_M34);
+
+  cout << "Exiting" << endl;
+
+//! [Interesting]
+
+  delete ms;
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "ads1115.h"
+
+using namespace std;
+
+bool shouldRun = true;
+
+void sig_handler(int signo)
+{
+  if (signo == SIGINT)
+    shouldRun = false;
+}
+
+int main(int argc, char **argv)
+{
+  signal(SIGINT, sig_handler);
+
+//! [Interesting]
+  // ADS1115 on I2C bus 1, address 0x48, with ALERT/RDY wired to GPIO 2
+  upm::ADS1115 *ads = new upm::ADS1115(1, 0x48);
+
+  ads->setGain(upm::ADS1X15::GAIN_ONE);
+  ads->setSPS(upm::ADS1115::SPS_860);
+
+  int channels[4];
+  channels[0] = ads->addScanChannel(upm::ADS1X15::SINGLE_0);
+  channels[1] = ads->addScanChannel(upm::ADS1X15::SINGLE_1);
+  channels[2] = ads->addScanChannel(upm::ADS1X15::SINGLE_2);
+  channels[3] = ads->addScanChannel(upm::ADS1X15::SINGLE_3);
+
+  ads->startScan(2);
+
+  upm::ADS1X15::SCAN_SAMPLE_T samples[256];
+
+  while (shouldRun)
+    {
+      sleep(1);
+
+      for (int i = 0; i < 4; i++)
+        {
+          int n = ads->readScan(channels[i], samples, 256);
+          float sum = 0.0;
+
+          for (int j = 0; j < n; j++)
+            sum += samples[j].value;
+
+          printf("AIN%d: %4d samples/s, mean %.4f V\n", i, n,
+                 n ? sum / n : 0.0);
+        }
+
+      cout << "overflows: " << ads->getScanOverflowCount()
+           << ", restarts: " << ads->getScanRestartCount() << endl;
+    }
+
+  ads->stopScan();
+//! [Interesting]
+
+  cout << "Exiting..." << endl;
+
+  delete ads;
+  return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <unistd.h>
+#include <iostream>
+#include <signal.h>
+#include <stdio.h>
+#include "aioacquire.h"
+#include "mic.h"
+#include "loudness.h"
+
+using namespace std;
+
+int shouldRun = true;
+
+void sig_handler(int signo)
+{
+  if (signo == SIGINT)
+    shouldRun = false;
+}
+
+static void printStats(const char *name, upm::AioAcquisition &acq, int channel)
+{
+  upm::AioAcquisition::STATS_T stats;
+
+  acq.getStats(channel, &stats);
+
+  printf("%-9s %8llu samples, latency %6.1fus mean (%.1f..%.1fus), "
+         "jitter %6.1fus, %llu overruns, %llu dropped\n", name,
+         (unsigned long long)stats.samples, stats.meanLatency / 1000.0,
+         stats.minLatency / 1000.0, stats.maxLatency / 1000.0,
+         stats.jitter / 1000.0, (unsigned long long)stats.overruns,
+         (unsigned long long)stats.overflows);
+}
+
+int main()
+{
+  signal(SIGINT, sig_handler);
+
+//! [Interesting]
+  // One acquisition thread samples both sensors
+  upm::AioAcquisition acq;
+
+  // Microphone on A0, sampled every 2ms for its windows
+  upm::Microphone mic(0);
+  mic.attachAcquisition(&acq, 2000);
+
+  // Loudness sensor on A1, sampled every 10ms
+  upm::Loudness loud(1);
+  loud.attachAcquisition(&acq, 10000);
+
+  thresholdContext ctx;
+  ctx.averageReading = 0;
+  ctx.runningAverage = 0;
+  ctx.averagedOver   = 2;
+
+  uint16_t buffer[128];
+
+  while (shouldRun)
+    {
+      // 128 samples taken 2ms apart by the acquisition thread
+      int len = mic.getSampledWindow(2, 128, buffer);
+
+      if (len)
+        mic.findThreshold(&ctx, 30, buffer, len);
+
+      printf("mic average %ld, loudness %.2fV\n", ctx.runningAverage,
+             loud.loudness());
+
+      printStats("mic", acq, mic.getAcquisitionChannel());
+      printStats("loudness", acq, loud.getAcquisitionChannel());
+    }
+
+  acq.stop();
+//! [Interesting]
+
+  cout << "Exiting..." << endl;
+
+  return 0;
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "dsp.h"
+
+using namespace std;
+
+// 25kHz sampling of a 50Hz mains current transformer: a 500 sample
+// block is one mains period, as ECS1030 uses
+#define RATE       25000.0
+#define BLOCK      500
+#define BLOCKS     2000
+
+static uint64_t nanos()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void report(const char *label, uint64_t ns, double result)
+{
+  double perSample = (double)ns / ((double)BLOCK * BLOCKS);
+
+  printf("  %-34s %7.2f ns/sample %8.1f Msamples/s   (%.4f)\n", label,
+         perSample, 1000.0 / perSample, result);
+}
+
+// the scalar per-sample loops the drivers used
+
+static double scalarFilteredRms(const uint16_t *in, int count,
+                                 int *lastSample, double *lastFilter)
+{
+  double sum = 0;
+
+  for (int i = 0; i < count; i++)
+    {
+      double filtered = 0.996 * (*lastFilter + in[i] - *lastSample);
+
+      *lastSample = in[i];
+      *lastFilter = filtered;
+      sum += filtered * filtered;
+    }
+
+  return sqrt(sum / count);
+}
+
+static long scalarAverage(const uint16_t *in, int count)
+{
+  long sum = 0;
+
+  for (int i = 0; i < count; i++)
+    sum += in[i];
+
+  return sum / count;
+}
+
+static unsigned int scalarPeak(const uint16_t *in, int count)
+{
+  unsigned int hi = 0;
+
+  for (int i = 0; i < count; i++)
+    if (in[i] > hi)
+      hi = in[i];
+
+  return hi;
+}
+
+static float scalarRms(const float *in, int count)
+{
+  float sum = 0;
+
+  for (int i = 0; i < count; i++)
+    sum += in[i] * in[i];
+
+  return sqrtf(sum / count);
+}
+
+static float scalarGoertzel(const float *in, int count, float freq)
+{
+  float coeff = 2.0 * cosf(2.0 * M_PI * freq / RATE);
+  float s1 = 0, s2 = 0;
+
+  for (int i = 0; i < count; i++)
+    {
+      float s = in[i] + coeff * s1 - s2;
+
+      s2 = s1;
+      s1 = s;
+    }
+
+  return 2.0 * sqrtf(s1 * s1 + s2 * s2 - coeff * s1 * s2) / count;
+}
+
+int main(int argc, char **argv)
+{
+  // mains fundamental and odd harmonics
+  const float tones[4] = { 50.0, 150.0, 250.0, 350.0 };
+  uint16_t *raw = new uint16_t[BLOCK * BLOCKS];
+  float block[BLOCK];
+  double r = 0;
+  uint64_t start;
+
+  // 10 bit ADC, 512 bias, 300 count fundamental, 3rd harmonic, noise
+  for (int i = 0; i < BLOCK * BLOCKS; i++)
+    {
+      double t = i / RATE;
+
+      raw[i] = (uint16_t)(512.0 + 300.0 * sin(2 * M_PI * 50.0 * t) +
+                          60.0 * sin(2 * M_PI * 150.0 * t) +
+                          (rand() % 9) - 4);
+    }
+
+  cout << BLOCKS << " blocks of " << BLOCK << " samples" << endl;
+
+  cout << "Filtered RMS (ECS1030 getCurrency_B)" << endl;
+  {
+    int lastSample = 512;
+    double lastFilter = 0;
+
+    start = nanos();
+    for (int b = 0; b < BLOCKS; b++)
+      r = scalarFilteredRms(raw + b * BLOCK, BLOCK, &lastSample, &lastFilter);
+    report("scalar double per-sample", nanos() - start, r);
+  }
+  {
+//! [Interesting]
+    // remove the bias with a DC blocker, then take the RMS
+    upm::DCBlocker dcBlock(0.996);
+
+    start = nanos();
+    for (int b = 0; b < BLOCKS; b++)
+      {
+        dcBlock.process(raw + b * BLOCK, block, BLOCK);
+        r = upm::Dsp::rms(block, BLOCK);
+      }
+//! [Interesting]
+    report("DCBlocker + rms", nanos() - start, r);
+  }
+
+  cout << "Block average (Microphone findThreshold)" << endl;
+  start = nanos();
+  for (int b = 0; b < BLOCKS; b++)
+    r = scalarAverage(raw + b * BLOCK, BLOCK);
+  report("scalar long sum", nanos() - start, r);
+
+  start = nanos();
+  for (int b = 0; b < BLOCKS; b++)
+    r = upm::Dsp::sum(raw + b * BLOCK, BLOCK) / BLOCK;
+  report("Dsp::sum", nanos() - start, r);
+
+  cout << "Peak (TA12200 highestValue)" << endl;
+  start = nanos();
+  for (int b = 0; b < BLOCKS; b++)
+    r = scalarPeak(raw + b * BLOCK, BLOCK);
+  report("scalar compare", nanos() - start, r);
+
+  start = nanos();
+  for (int b = 0; b < BLOCKS; b++)
+    {
+      uint16_t lo, hi;
+
+      upm::Dsp::peak(raw + b * BLOCK, BLOCK, &lo, &hi);
+      r = hi;
+    }
+  report("Dsp::peak", nanos() - start, r);
+
+  // the float kernels on their own, input already converted
+  float *conv = new float[BLOCK * BLOCKS];
+  upm::Dsp::toFloat(raw, conv, BLOCK * BLOCKS, 1.0, -512.0);
+
+  cout << "RMS of float blocks" << endl;
+  start = nanos();
+  for (int b = 0; b < BLOCKS; b++)
+    r = scalarRms(conv + b * BLOCK, BLOCK);
+  report("scalar", nanos() - start, r);
+
+  start = nanos();
+  for (int b = 0; b < BLOCKS; b++)
+    r = upm::Dsp::rms(conv + b * BLOCK, BLOCK);
+  report("Dsp::rms", nanos() - start, r);
+
+  cout << "Goertzel, 4 tones" << endl;
+  start = nanos();
+  for (int b = 0; b < BLOCKS; b++)
+    for (int t = 0; t < 4; t++)
+      r = scalarGoertzel(conv + b * BLOCK, BLOCK, tones[t]);
+  report("scalar, one tone per pass", nanos() - start, r);
+
+  {
+    upm::Goertzel goertzel(RATE, tones, 4);
+
+    start = nanos();
+    for (int b = 0; b < BLOCKS; b++)
+      {
+        goertzel.reset();
+        goertzel.process(conv + b * BLOCK, BLOCK);
+        r = goertzel.amplitude(3);
+      }
+    report("Goertzel, 4 tones per pass", nanos() - start, r);
+
+    printf("  levels: 50Hz %.1f  150Hz %.1f  250Hz %.1f  350Hz %.1f\n",
+           goertzel.amplitude(0), goertzel.amplitude(1),
+           goertzel.amplitude(2), goertzel.amplitude(3));
+  }
+
+  delete [] conv;
+  delete [] raw;
+
+  return 0;
+}
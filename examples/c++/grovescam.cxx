@@ -66,7 +66,12 @@ int main (int argc, char **argv)
     {
       cout << "Storing image.jpg..." << endl;
       if (camera->storeImage("image.jpg"))
-        cout << "storeImage succeeded..." << endl;
+        {
+          const upm::GROVESCAM::DOWNLOAD_STATS_T *stats = camera->getStats();
+          cout << "storeImage succeeded: " << stats->bytes << " bytes in "
+               << stats->packets << " packets (" << stats->retries
+               << " retries), " << stats->bytesPerSec << " bytes/sec" << endl;
+        }
       else
         cout << "storeImage failed." << endl;
     }
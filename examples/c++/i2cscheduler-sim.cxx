@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unistd.h>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "i2cscheduler.h"
+
+using namespace std;
+
+// Stand-in for an I2C adapter that only accounts for bus time.  A
+// register read is a write of the register pointer followed by a
+// read; each transaction costs a fixed per-call overhead plus 9
+// clocks per byte (8 bits + ACK), start, address and stop.  Changing
+// the slave address costs an extra ioctl.
+class SimBus
+{
+  public:
+    SimBus(double hz, double callUs, double switchUs) :
+        m_bitUs(1000000.0 / hz), m_callUs(callUs), m_switchUs(switchUs),
+        m_lastAddr(-1)
+    {
+    }
+
+    void readReg(uint8_t addr, int bytes)
+    {
+        double us = 0.0;
+
+        if (addr != m_lastAddr)
+            us += m_switchUs;
+        m_lastAddr = addr;
+
+        us += transaction(1) + transaction(bytes);
+        spin(us);
+    }
+
+    void writeReg(uint8_t addr, int bytes)
+    {
+        double us = 0.0;
+
+        if (addr != m_lastAddr)
+            us += m_switchUs;
+        m_lastAddr = addr;
+
+        us += transaction(bytes);
+        spin(us);
+    }
+
+  private:
+    double transaction(int bytes)
+    {
+        // start + address/ACK + data/ACK + stop
+        return m_callUs + m_bitUs * (1 + 9 + 9 * bytes + 1);
+    }
+
+    // the bus is held for the whole transfer, so don't sleep
+    void spin(double us)
+    {
+        uint64_t end = upm::I2cScheduler::getNanos() + (uint64_t)(us * 1000);
+
+        while (upm::I2cScheduler::getNanos() < end)
+            ;
+    }
+
+    double m_bitUs;
+    double m_callUs;
+    double m_switchUs;
+    int m_lastAddr;
+};
+
+struct SimSensor {
+    const char *name;
+    uint8_t address;
+    float rateHz;
+    int bytes;                  // bytes read per sample
+    int conversionMs;           // 0 for a single phase read
+    int phaseUs;                // added this long after the start
+    SimBus *bus;
+};
+
+static int simSample(float *values, int, void *ctx)
+{
+    SimSensor *s = (SimSensor *)ctx;
+
+    s->bus->readReg(s->address, s->bytes);
+    values[0] = rand() % 100;
+    return 1;
+}
+
+static bool simStart(void *ctx)
+{
+    SimSensor *s = (SimSensor *)ctx;
+
+    s->bus->writeReg(s->address, 1);
+    return true;
+}
+
+static int addSim(upm::I2cScheduler &sched, SimSensor *s)
+{
+    return sched.addSensor(s->address, s->rateHz, simSample, s, 0,
+                           s->conversionMs ? simStart : 0, s->conversionMs);
+}
+
+static void run(const char *label, SimSensor *sensors, int count,
+                int windowUs, int seconds)
+{
+    upm::I2cScheduler sched(0);
+    int ids[16];
+
+    sched.setCoalesceWindow(windowUs);
+
+    // a sensor's periods start when it is added, so the ones with a
+    // phase are added once the scheduler runs, in phase order
+    for (int i = 0; i < count; i++)
+        if (!sensors[i].phaseUs)
+            ids[i] = addSim(sched, &sensors[i]);
+
+    sched.start();
+    uint64_t start = upm::I2cScheduler::getNanos();
+
+    for (int i = 0; i < count; i++) {
+        if (!sensors[i].phaseUs)
+            continue;
+
+        uint64_t when = start + (uint64_t)sensors[i].phaseUs * 1000;
+        while (upm::I2cScheduler::getNanos() < when)
+            ;
+        ids[i] = addSim(sched, &sensors[i]);
+    }
+
+    sleep(seconds);
+    sched.stop();
+
+    cout << label << endl;
+    printf("  %-24s %8s %9s %9s %7s %8s\n", "sensor", "addr", "req Hz",
+           "got Hz", "missed", "overrun");
+
+    for (int i = 0; i < count; i++) {
+        upm::I2cScheduler::SENSOR_STATS_T stats;
+
+        sched.getSensorStats(ids[i], &stats);
+        printf("  %-24s     0x%02x %9.1f %9.1f %7u %8u\n", sensors[i].name,
+               sensors[i].address, stats.requestedHz, stats.achievedHz,
+               stats.missedDeadlines, stats.overruns);
+    }
+
+    upm::I2cScheduler::BUS_STATS_T bus;
+    sched.getBusStats(&bus);
+    printf("  bus utilization %.1f%%, %u transactions, %u address switches\n",
+           bus.utilization * 100.0, bus.transactions, bus.addressSwitches);
+}
+
+int main(int argc, char **argv)
+{
+//! [Interesting]
+    int seconds = (argc > 1) ? atoi(argv[1]) : 5;
+    // 100kHz (I2C_STD) with ~50us per ioctl/read()/write() round trip
+    double hz = (argc > 2) ? atof(argv[2]) : 100000.0;
+    SimBus bus(hz, 50.0, 20.0);
+
+    // registers of one device are read at different rates and out of
+    // step with each other, with other devices due in between
+    SimSensor sensors[] = {
+        { "ADXL345 accel",      0x53, 100.0, 6, 0,   0,   &bus },
+        { "BMPX8X pressure",    0x77, 20.0,  3, 26,  0,   &bus },
+        { "TSL2561 light",      0x29, 5.0,   4, 101, 0,   &bus },
+        { "HMC5883L mag",       0x1e, 100.0, 6, 0,   300, &bus },
+        { "MCP9808 temp",       0x18, 10.0,  2, 0,   400, &bus },
+        { "ADXL345 FIFO status", 0x53, 25.0, 1, 0,   600, &bus },
+        { "HMC5883L status",    0x1e, 20.0,  1, 0,   700, &bus },
+    };
+    int count = sizeof(sensors) / sizeof(sensors[0]);
+
+    cout << "Simulated I2C bus at " << hz << "Hz, " << seconds
+         << " seconds per run" << endl;
+
+    run("Deadline order only", sensors, count, 0, seconds);
+    run("Deadline order, grouped by address", sensors, count, 1000, seconds);
+//! [Interesting]
+
+    return 0;
+}
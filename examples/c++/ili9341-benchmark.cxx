@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "ili9341.h"
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static void report(const char *label, double pixels, double secs)
+{
+    printf("%-24s %12.0f pixels/sec  (%.3f s)\n", label, pixels / secs, secs);
+}
+
+int main(int argc, char **argv)
+{
+    // Pins (Edison)
+    // CS_LCD   GP44 (MRAA 31)
+    // CS_SD    GP43 (MRAA 38) unused
+    // DC       GP12 (MRAA 20)
+    // RESEST   GP13 (MRAA 14)
+    upm::ILI9341 *lcd = new upm::ILI9341(31, 38, 20, 14);
+    const int loops = 10;
+    double start, pixels;
+
+    // full screen fills
+    start = now();
+    for (int i = 0; i < loops; i++)
+        lcd->fillScreen((i & 1) ? ILI9341_BLUE : ILI9341_BLACK);
+    report("fillScreen", (double) loops * lcd->width() * lcd->height(),
+           now() - start);
+
+    // opaque text, sizes 1 and 2
+    for (uint8_t size = 1; size <= 2; size++) {
+        int cols = lcd->width() / (6 * size);
+        int rows = lcd->height() / (8 * size);
+
+        lcd->setTextSize(size);
+        lcd->setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+        start = now();
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                lcd->drawChar(c * 6 * size, r * 8 * size,
+                              'A' + (r + c) % 26, ILI9341_WHITE,
+                              ILI9341_BLACK, size);
+            }
+        }
+        pixels = (double) rows * cols * 48 * size * size;
+        report(size == 1 ? "text (size 1)" : "text (size 2)",
+               pixels, now() - start);
+    }
+
+    // horizontal and vertical lines
+    start = now();
+    pixels = 0;
+    for (int y = 0; y < lcd->height(); y++) {
+        lcd->drawFastHLine(0, y, lcd->width(), ILI9341_GREEN);
+        pixels += lcd->width();
+    }
+    for (int x = 0; x < lcd->width(); x++) {
+        lcd->drawFastVLine(x, 0, lcd->height(), ILI9341_RED);
+        pixels += lcd->height();
+    }
+    report("fast H/V lines", pixels, now() - start);
+
+    // arbitrary lines go through drawPixel
+    start = now();
+    pixels = 0;
+    for (int x = 0; x < lcd->width(); x += 8) {
+        lcd->drawLine(x, 0, lcd->width() - 1 - x, lcd->height() - 1,
+                      ILI9341_YELLOW);
+        pixels += lcd->height();
+    }
+    report("diagonal lines", pixels, now() - start);
+
+    delete lcd;
+    return 0;
+}
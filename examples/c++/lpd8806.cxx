@@ -83,7 +83,8 @@ void scanner(uint8_t r, uint8_t g, uint8_t b, uint8_t wait) {
         sensor->setPixelColor(pos + 1, r/2, g/2, b/2);
         sensor->setPixelColor(pos + 2, r/4, g/4, b/4);
 
-        sensor->show();
+        // the next frame is drawn while this one is being sent
+        sensor->showAsync();
         usleep (wait * 1000);
         // If we wanted to be sneaky we could erase just the tail end
         // pixel, but it's much easier just to erase the whole thing
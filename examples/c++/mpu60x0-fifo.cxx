@@ -0,0 +1,96 @@
+/*
+ * Author: Jon Trulson <jtrulson@ics.com>
+ * Copyright (c) 2015 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <unistd.h>
+#include <stdlib.h>
+#include <iostream>
+#include <signal.h>
+#include "mpu9150.h"
+
+using namespace std;
+
+int shouldRun = true;
+
+void sig_handler(int signo)
+{
+  if (signo == SIGINT)
+    shouldRun = false;
+}
+
+
+int main(int argc, char **argv)
+{
+  signal(SIGINT, sig_handler);
+//! [Interesting]
+
+  // GPIO pin the MPU60X0 INT output is connected to
+  int intrPin = (argc > 1) ? atoi(argv[1]) : 2;
+
+  upm::MPU60X0 *sensor = new upm::MPU60X0();
+
+  sensor->init();
+
+  // room for one second of samples at the default 1kHz rate, and
+  // drain the FIFO every 32 samples
+  static upm::MPU60X0::FIFO_SAMPLE_T ring[1024];
+  upm::MPU60X0::FIFO_SAMPLE_T batch[64];
+
+  if (!sensor->enableFIFOStreaming(ring, 1024, 32, intrPin))
+    {
+      cerr << "enableFIFOStreaming() failed" << endl;
+      delete sensor;
+      return 1;
+    }
+
+  while (shouldRun)
+    {
+      int n = sensor->getFIFOSamples(batch, 64);
+
+      if (n > 0)
+        {
+          upm::MPU60X0::FIFO_SAMPLE_T *s = &batch[n - 1];
+
+          cout << n << " samples, last at " << s->timestamp << "us" << endl;
+          cout << "  AX: " << s->accelX << " AY: " << s->accelY
+               << " AZ: " << s->accelZ << endl;
+          cout << "  GX: " << s->gyroX << " GY: " << s->gyroY
+               << " GZ: " << s->gyroZ << endl;
+        }
+
+      cout << "Total: " << sensor->getFIFOSampleCount()
+           << " FIFO overflows: " << sensor->getFIFOOverflowCount()
+           << " ring overflows: " << sensor->getRingOverflowCount() << endl;
+
+      usleep(100000);
+    }
+
+  sensor->disableFIFOStreaming();
+
+//! [Interesting]
+
+  cout << "Exiting..." << endl;
+  
+  delete sensor;
+  
+  return 0;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nrf24l01.h"
+
+using namespace std;
+
+// Stand-in for the radio that only accounts for time.  Every SPI
+// command costs two CSN GPIO writes plus, per transfer() call, a fixed
+// userspace -> kernel overhead and 8 clocks per byte.  The TX FIFO is
+// modelled with Enhanced ShockBurst air timing at 2Mbps: 130us PLL
+// settling, then preamble, 5-byte address, 9-bit PCF, payload and
+// 16-bit CRC, plus the RX turnaround and ACK packet when acknowledged.
+class MockNrf
+{
+  public:
+    MockNrf(double spiHz, double callUs, double gpioUs, double irqUs,
+            bool ack, bool irq) :
+        m_byteUs(8 * 1000000.0 / spiHz), m_callUs(callUs), m_gpioUs(gpioUs),
+        m_irqUs(irqUs), m_irq(irq), m_perByte(false), m_ce(false),
+        m_now(0.0), m_txEnd(0.0), m_status(0), m_fifo(0), m_sent(0),
+        m_calls(0), m_overruns(0)
+    {
+        m_packetUs = 130 + (8 + 40 + 9 + 8 * MAX_BUFFER + 16) / 2.0;
+        if (ack)
+            m_packetUs += 130 + (8 + 40 + 9 + 16) / 2.0;
+    }
+
+    // the old driver clocked every byte with its own writeByte() call
+    void setPerByte(bool perByte) { m_perByte = perByte; }
+
+    uint8_t command(uint8_t cmd, const uint8_t* out, uint8_t* in, int len)
+    {
+        m_now += 2 * m_gpioUs;
+        if (m_perByte) {
+            m_now += (len + 1) * (m_callUs + m_byteUs);
+            m_calls += len + 1;
+        } else {
+            m_now += m_callUs + (len + 1) * m_byteUs;
+            m_calls++;
+        }
+        advance();
+
+        // RX FIFO always empty
+        uint8_t status = m_status | (0x07 << RX_P_NO);
+
+        if (in != NULL)
+            memset(in, 0, len);
+
+        if (cmd == (R_REGISTER | FIFO_STATUS) && in != NULL) {
+            if (m_fifo == 0)
+                in[0] |= (1 << TX_EMPTY);
+            if (m_fifo == NRF_TX_FIFO_DEPTH)
+                in[0] |= (1 << FIFO_FULL);
+        } else if (cmd == (R_REGISTER | STATUS) && in != NULL) {
+            in[0] = status;
+        } else if (cmd == (W_REGISTER | STATUS) && out != NULL) {
+            m_status &= ~(out[0] & ((1 << RX_DR) | (1 << TX_DS) | (1 << MAX_RT)));
+        } else if (cmd == W_TX_PAYLOAD || cmd == W_TX_PAYLOAD_NOACK) {
+            push();
+        } else if (cmd == FLUSH_TX) {
+            m_fifo = 0;
+        }
+
+        return status;
+    }
+
+    bool waitTxEvent(int timeout)
+    {
+        double deadline = m_now + timeout * 1000.0;
+
+        if (m_irq) {
+            // sleep until the IRQ fires, then pay the wakeup latency.
+            // It only fires if a packet is pending or on the air.
+            if (!(m_status & (1 << TX_DS))) {
+                if (!m_ce || m_fifo == 0 || m_txEnd > deadline) {
+                    sleep(deadline - m_now);
+                    return false;
+                }
+                if (m_txEnd > m_now)
+                    m_now = m_txEnd;
+            }
+            m_now += m_irqUs;
+            advance();
+            m_status &= ~(1 << TX_DS);
+            return true;
+        }
+
+        while (m_now < deadline) {
+            uint8_t status = command(NOP, NULL, NULL, 0);
+            if (status & (1 << TX_DS)) {
+                uint8_t clear = (1 << TX_DS);
+                command(W_REGISTER | STATUS, &clear, NULL, 1);
+                return true;
+            }
+            sleep(50);
+        }
+
+        return false;
+    }
+
+    void ce(bool high)
+    {
+        m_now += m_gpioUs;
+        advance();
+        if (high && !m_ce && m_fifo > 0)
+            m_txEnd = m_now + m_packetUs;
+        m_ce = high;
+    }
+
+    void sleep(double us)
+    {
+        m_now += us;
+        advance();
+    }
+
+    int fifo() { return m_fifo; }
+    long sent() { return m_sent; }
+    long calls() { return m_calls; }
+    long overruns() { return m_overruns; }
+    double now() { return m_now; }
+    double packetUs() { return m_packetUs; }
+
+  private:
+    void advance()
+    {
+        while (m_ce && m_fifo > 0 && m_txEnd <= m_now) {
+            m_fifo--;
+            m_sent++;
+            m_status |= (1 << TX_DS);
+            if (m_fifo > 0)
+                m_txEnd += m_packetUs;
+        }
+    }
+
+    void push()
+    {
+        if (m_fifo >= NRF_TX_FIFO_DEPTH) {
+            m_overruns++;
+            return;
+        }
+        if (m_fifo == 0 && m_ce)
+            m_txEnd = m_now + m_packetUs;
+        m_fifo++;
+    }
+
+    double m_byteUs;
+    double m_callUs;
+    double m_gpioUs;
+    double m_irqUs;
+    bool m_irq;
+    bool m_perByte;
+    bool m_ce;
+    double m_now;
+    double m_txEnd;
+    double m_packetUs;
+    uint8_t m_status;
+    int m_fifo;
+    long m_sent;
+    long m_calls;
+    long m_overruns;
+};
+
+// The SPI sequence of the old NRF24L01::send(): one payload per call,
+// busy-polling STATUS for TX_DS, then back to RX and a 10ms sleep.
+static void legacySend(MockNrf& radio, uint8_t* payload)
+{
+    uint8_t config = _CONFIG | (1 << PWR_UP);
+    uint8_t clear = (1 << TX_DS) | (1 << MAX_RT);
+    uint8_t status = 0;
+
+    radio.command(R_REGISTER | STATUS, NULL, &status, 1);
+    radio.ce(false);
+    radio.command(W_REGISTER | CONFIG, &config, NULL, 1);
+    radio.command(FLUSH_TX, NULL, NULL, 0);
+    radio.command(W_TX_PAYLOAD, payload, NULL, MAX_BUFFER);
+    radio.ce(true);
+
+    do {
+        radio.command(R_REGISTER | STATUS, NULL, &status, 1);
+    } while (!(status & (1 << TX_DS)));
+
+    config |= (1 << PRIM_RX);
+    radio.ce(false);
+    radio.command(W_REGISTER | CONFIG, &config, NULL, 1);
+    radio.ce(true);
+    radio.command(W_REGISTER | STATUS, &clear, NULL, 1);
+
+    radio.sleep(10000);
+}
+
+static void report(const char* label, MockNrf& radio)
+{
+    double secs = radio.now() / 1000000.0;
+    double airUs = radio.sent() * radio.packetUs();
+
+    printf("%-34s %6.1f calls/pkt %9.0f pkts/sec %7.1f kB/sec %5.1f%% air\n",
+           label, (double)radio.calls() / radio.sent(), radio.sent() / secs,
+           radio.sent() * MAX_BUFFER / secs / 1024.0,
+           100.0 * airUs / radio.now());
+
+    if (radio.overruns())
+        printf("  %ld TX FIFO overruns!\n", radio.overruns());
+}
+
+static void stream(MockNrf& radio, uint8_t writeCmd, uint8_t* data,
+                   int packets)
+{
+    const int batch = 16;
+
+    // what streamStart() leaves behind: PTX, FIFO empty, CE high
+    radio.ce(true);
+
+    for (int sent = 0; sent < packets; sent += batch)
+        upm::nrfStreamWrite(radio, writeCmd, data, MAX_BUFFER, batch, 1000, NULL);
+
+    while (radio.fifo() > 0)
+        radio.waitTxEvent(1000);
+}
+
+int main(int argc, char **argv)
+{
+    // 4MHz SPI, ~20us per transfer() ioctl and ~5us per sysfs GPIO
+    // write, ~100us from IRQ edge to the waiting thread
+    double hz = (argc > 1) ? atof(argv[1]) : 4000000.0;
+    double callUs = (argc > 2) ? atof(argv[2]) : 20.0;
+    double gpioUs = (argc > 3) ? atof(argv[3]) : 5.0;
+    double irqUs = (argc > 4) ? atof(argv[4]) : 100.0;
+    const int packets = 1024;
+    uint8_t data[16 * MAX_BUFFER];
+
+    for (unsigned int i = 0; i < sizeof(data); i++)
+        data[i] = rand() & 0xff;
+
+    cout << "Mock SPI at " << hz << "Hz, " << callUs << "us per transfer, "
+         << gpioUs << "us per GPIO write, " << irqUs << "us IRQ latency, "
+         << MAX_BUFFER << " byte payloads" << endl;
+
+    {
+        MockNrf radio(hz, callUs, gpioUs, irqUs, true, false);
+        radio.setPerByte(true);
+        for (int i = 0; i < packets / 16; i++)
+            legacySend(radio, data);
+        report("send(), per-byte SPI", radio);
+    }
+
+    {
+        MockNrf radio(hz, callUs, gpioUs, irqUs, true, false);
+        stream(radio, W_TX_PAYLOAD, data, packets);
+        report("streamWrite(), ACK, polled", radio);
+    }
+
+    {
+        MockNrf radio(hz, callUs, gpioUs, irqUs, true, true);
+        stream(radio, W_TX_PAYLOAD, data, packets);
+        report("streamWrite(), ACK, IRQ", radio);
+    }
+
+    {
+        MockNrf radio(hz, callUs, gpioUs, irqUs, false, true);
+        stream(radio, W_TX_PAYLOAD_NOACK, data, packets);
+        report("streamWrite(), NOACK, IRQ", radio);
+    }
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <unistd.h>
+#include <iostream>
+#include <signal.h>
+#include <stdio.h>
+#include "nrf24l01.h"
+
+using namespace std;
+
+bool shouldRun = true;
+
+void sig_handler(int signo)
+{
+    if (signo == SIGINT)
+        shouldRun = false;
+}
+
+int main(int argc, char **argv)
+{
+    signal(SIGINT, sig_handler);
+
+//! [Interesting]
+    // Pipes 0 and 1 have full addresses, pipes 2-5 share bytes 1-4
+    // with pipe 1 and only differ in their first byte
+    uint8_t pipe0[5] = {0x01, 0x01, 0x01, 0x01, 0x01};
+    uint8_t pipe1[5] = {0xC2, 0xB2, 0xB2, 0xB2, 0xB2};
+    uint8_t pipeN[4] = {0xC3, 0xC4, 0xC5, 0xC6};
+
+    // CSN on D7, CE on D8, IRQ on D2
+    upm::NRF24L01 radio(7, 8);
+
+    radio.setPayload(MAX_BUFFER);
+    radio.configure();
+    radio.setSpeedRate(upm::NRF_2MBPS);
+    radio.setChannel(99);
+    radio.setDynamicPayload(true);
+
+    radio.setPipeAddress(0, pipe0);
+    radio.setPipeAddress(1, pipe1);
+    radio.enablePipe(0);
+    radio.enablePipe(1);
+    for (uint8_t pipe = 2; pipe < NRF_MAX_PIPES; pipe++) {
+        radio.setPipeAddress(pipe, &pipeN[pipe - 2]);
+        radio.enablePipe(pipe);
+    }
+
+    radio.attachIrq(2);
+    radio.startReceiver();
+
+    while (shouldRun) {
+        upm::nrf_packet_t pkt;
+
+        if (!radio.waitPacket(&pkt, 1000))
+            continue;
+
+        printf("%llu: pipe %d, %d bytes\n",
+               (unsigned long long)pkt.timestamp, pkt.pipe, pkt.len);
+
+        // queue a reply that goes out with the next ACK on that pipe
+        uint8_t reply = pkt.len;
+        radio.setAckPayload(pkt.pipe, &reply, 1);
+    }
+
+    cout << "Dropped " << radio.getRxOverflowCount() << " packets" << endl;
+
+    radio.stopReceiver();
+    radio.detachIrq();
+//! [Interesting]
+
+    cout << "Exiting..." << endl;
+
+    return 0;
+}
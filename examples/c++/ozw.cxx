@@ -128,6 +128,18 @@ int main(int argc, char **argv)
   //
   // cout << "Turning OFF node 7" << endl;
   // sensor->setValueAsBool(7, 0, false);
+  //
+  // 4. Print every change to the values of node 3 as it is reported,
+  // instead of polling them:
+  //
+  // int sub = sensor->subscribe(3);
+  // upm::OZW::VALUE_EVENT_T event;
+  //
+  // while (sensor->waitEvent(sub, &event, 60000))
+  //   cout << "Node " << event.nodeId << " index " << event.index
+  //        << ": " << event.value << endl;
+  //
+  // sensor->unsubscribe(sub);
 
 
 //! [Interesting]
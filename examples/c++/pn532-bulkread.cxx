@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <iostream>
+#include "pn532.h"
+
+using namespace std;
+
+bool shouldRun = true;
+
+void sig_handler(int signo)
+{
+  if (signo == SIGINT)
+    shouldRun = false;
+}
+
+static double millis()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+static void dump(const uint8_t *data, int len)
+{
+  for (int i = 0; i < len; i++)
+    printf("%02x%c", data[i], ((i % 16) == 15) ? '\n' : ' ');
+  if (len % 16)
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+  signal(SIGINT, sig_handler);
+
+//! [Interesting]
+  // Instantiate an PN532 on I2C bus 0 (default) using gpio 3 for the
+  // IRQ, and gpio 2 for the reset pin.
+
+  upm::PN532 *nfc = new upm::PN532(3, 2);
+
+  if (!nfc->init())
+    cerr << "init() failed" << endl;
+
+  if (!nfc->getFirmwareVersion())
+    {
+      printf("Could not identify PN532\n");
+      return 1;
+    }
+
+  nfc->SAMConfig();
+
+  // give up on an empty field quickly
+  nfc->setPassiveActivationRetries(0x10);
+
+  // the factory default MIFARE Classic key
+  uint8_t key[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+  uint8_t data[45 * 4];
+
+  while (shouldRun)
+    {
+      // up to two cards can be in the field at once
+      int found = nfc->inListPassiveTargets(2, 1000);
+
+      for (int i = 0; i < found; i++)
+        {
+          upm::PN532::TARGET_T target;
+
+          if (!nfc->getTarget(i, &target) || !nfc->selectTarget(i))
+            {
+              printf("Card %d could not be selected\n", i);
+              continue;
+            }
+
+          printf("Card %d: UID len %d, SAK 0x%02x, ATQA 0x%04x\n",
+                 i, target.uidLen, target.sak, target.atqa);
+
+          double start = millis();
+
+          if (nfc->tagType() == upm::PN532::TAG_TYPE_MIFARE_CLASSIC)
+            {
+              // sector 1: 4 blocks for a single authentication
+              if (nfc->mifareclassic_ReadSector(target.uid, target.uidLen,
+                                                1, 0, key, data))
+                {
+                  printf("Sector 1 read in %.1fms\n", millis() - start);
+                  dump(data, 64);
+                }
+              else
+                printf("Sector 1 read failed\n");
+            }
+          else if (nfc->tagType() == upm::PN532::TAG_TYPE_NFC2)
+            {
+              // all 45 pages of an NTAG213
+              int pages = nfc->ntag2xx_ReadPages(0, 45, data);
+
+              printf("%d pages read in %.1fms\n", pages, millis() - start);
+              dump(data, pages * 4);
+            }
+        }
+
+      if (found)
+        sleep(1);
+      else
+        printf("Waiting for a card...\n");
+    }
+
+//! [Interesting]
+
+  delete nfc;
+  return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <unistd.h>
+#include <iostream>
+#include <signal.h>
+#include <stdio.h>
+#include "quadrature.h"
+
+using namespace std;
+
+int shouldRun = true;
+
+void sig_handler(int signo)
+{
+  if (signo == SIGINT)
+    shouldRun = false;
+}
+
+int main()
+{
+  signal(SIGINT, sig_handler);
+
+//! [Interesting]
+  // Decode a 100 cycle/rev shaft encoder on D2 (A) and D3 (B)
+  const double countsPerRev = 100 * 4;
+  upm::QuadratureDecoder encoder(2, 3, true);
+
+  // average over 50ms, report 0 after 1s without a count
+  encoder.setVelocityWindow(50);
+  encoder.setStopTimeout(1000);
+  encoder.start();
+
+  while (shouldRun)
+    {
+      upm::QuadratureDecoder::STATE_T state;
+
+      encoder.getState(&state);
+
+      printf("position %lld, %.1f RPM, %.1f RPM/s, %u glitches\n",
+             (long long)state.position,
+             state.velocity * 60.0 / countsPerRev,
+             state.acceleration * 60.0 / countsPerRev,
+             state.glitches);
+      usleep(100000);
+    }
+
+  encoder.stop();
+//! [Interesting]
+
+  cout << "Exiting..." << endl;
+
+  return 0;
+}
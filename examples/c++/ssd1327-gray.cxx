@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <unistd.h>
+#include <iostream>
+#include "ssd1327.h"
+
+using namespace std;
+
+// 8x8 anti-aliased disc, coverage 0-15 per pixel
+static const uint8_t disc[8 * 8] = {
+    0,  2,  9, 14, 14,  9,  2,  0,
+    2, 14, 15, 15, 15, 15, 14,  2,
+    9, 15, 15, 15, 15, 15, 15,  9,
+   14, 15, 15, 15, 15, 15, 15, 14,
+   14, 15, 15, 15, 15, 15, 15, 14,
+    9, 15, 15, 15, 15, 15, 15,  9,
+    2, 14, 15, 15, 15, 15, 14,  2,
+    0,  2,  9, 14, 14,  9,  2,  0,
+};
+
+int main(int argc, char **argv)
+{
+//! [Interesting]
+    // Instantiate an SSD1327 on I2C bus 0
+    upm::SSD1327 *lcd = new upm::SSD1327(0, 0x3C);
+
+    // gray ramp background, one level per 6 columns
+    for (int level = 0; level < 16; level++)
+        lcd->fillRect(level * 6, 0, 6, 96, level);
+
+    lcd->fillRect(8, 36, 80, 24, 0);
+    lcd->drawString(12, 44, "UPM 4bpp", 15, 0);
+
+    // bounce a ball across the screen; only changed rows are sent
+    int x = 0, y = 70, dx = 2;
+    for (int frame = 0; frame < 200; frame++) {
+        // restore the ramp under the old position
+        for (int col = x; col < x + 8; col++)
+            lcd->fillRect(col, y, 1, 8, col / 6);
+
+        x += dx;
+        if (x < 0 || x > 88) {
+            dx = -dx;
+            x += 2 * dx;
+        }
+        lcd->drawGlyph(x, y, 8, 8, disc, (x / 6 < 8) ? 15 : 0);
+        lcd->flush();
+    }
+//! [Interesting]
+
+    delete lcd;
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include "ssdbuffer.h"
+
+using namespace std;
+
+// Stand-in for mraa::I2c that only accounts for bus time.  An I2C
+// write costs a start condition, the address byte, 9 clocks per data
+// byte (8 bits + ACK) and a stop condition, plus a fixed per-call
+// overhead for the userspace -> kernel round trip.
+class MockI2c
+{
+  public:
+    MockI2c(double hz, double callOverheadUs) :
+        m_bitUs(1000000.0 / hz), m_callUs(callOverheadUs),
+        m_transactions(0), m_bytes(0), m_busUs(0.0)
+    {
+    }
+
+    mraa::Result write(const uint8_t*, int length)
+    {
+        account(length);
+        return mraa::SUCCESS;
+    }
+
+    mraa::Result writeReg(uint8_t, uint8_t)
+    {
+        account(2);
+        return mraa::SUCCESS;
+    }
+
+    void reset()
+    {
+        m_transactions = 0;
+        m_bytes = 0;
+        m_busUs = 0.0;
+    }
+
+    long transactions() { return m_transactions; }
+    long bytes() { return m_bytes; }
+    double busUs() { return m_busUs; }
+
+  private:
+    void account(int length)
+    {
+        m_transactions++;
+        m_bytes += length;
+        // start + address/ACK + data/ACK + stop
+        m_busUs += m_callUs + m_bitUs * (1 + 9 + 9 * length + 1);
+    }
+
+    double m_bitUs;
+    double m_callUs;
+    long m_transactions;
+    long m_bytes;
+    double m_busUs;
+};
+
+static void report(const char* label, MockI2c& bus, int frames)
+{
+    double frameUs = bus.busUs() / frames;
+
+    printf("%-28s %8ld xfers/frame %8ld bytes/frame %10.1f frames/sec\n",
+           label, bus.transactions() / frames, bus.bytes() / frames,
+           1000000.0 / frameUs);
+}
+
+int main(int argc, char **argv)
+{
+    // 400kHz (I2C_FAST) with ~50us per ioctl/write() round trip
+    double hz = (argc > 1) ? atof(argv[1]) : 400000.0;
+    double overheadUs = (argc > 2) ? atof(argv[2]) : 50.0;
+    const int frames = 100;
+
+    struct panel {
+        const char* name;
+        int lineBytes;
+        int lines;
+    } panels[] = {
+        { "SSD1306/SSD1308 128x64", 128, 64 / 8 },
+        { "SSD1327 96x96 (4bpp)", 96 / 2, 96 },
+    };
+
+    cout << "Mock I2C bus at " << hz << "Hz, " << overheadUs
+         << "us per transaction" << endl;
+
+    for (unsigned int p = 0; p < sizeof(panels) / sizeof(panels[0]); p++) {
+        upm::SSDFrameBuffer fb(panels[p].lineBytes, panels[p].lines);
+        MockI2c bus(hz, overheadUs);
+
+        for (int i = 0; i < fb.size(); i++)
+            fb.data()[i] = rand() & 0xff;
+
+        cout << panels[p].name << endl;
+
+        // the old path: one control/data register write per byte
+        for (int f = 0; f < frames; f++) {
+            for (int i = 0; i < fb.size(); i++)
+                bus.writeReg(0x40, fb.data()[i]);
+        }
+        report("  per-byte writeReg", bus, frames);
+
+        bus.reset();
+        for (int f = 0; f < frames; f++)
+            fb.flush(bus, 0x40);
+        report("  page burst flush", bus, frames);
+    }
+
+    return 0;
+}
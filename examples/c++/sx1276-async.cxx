@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <unistd.h>
+#include <stdio.h>
+#include <iostream>
+#include <signal.h>
+#include "sx1276.h"
+
+using namespace std;
+
+int shouldRun = true;
+
+void sig_handler(int signo)
+{
+  if (signo == SIGINT)
+    shouldRun = false;
+}
+
+
+int main(int argc, char **argv)
+{
+  signal(SIGINT, sig_handler);
+//! [Interesting]
+  cout << "Specify an argument to also send a beacon every 5 seconds"
+       << endl;
+
+  bool beacon = false;
+  if (argc > 1)
+    beacon = true;
+
+  // Instantiate an SX1276 using default parameters
+  upm::SX1276 *sensor = new upm::SX1276();
+
+  // 915Mhz
+  sensor->setChannel(915000000);
+
+  // Same LORA configuration as the sx1276-lora example
+  sensor->setTxConfig(sensor->MODEM_LORA, 14, 0, 125000,
+                      7, 1, 8, false, true, false, 0, false);
+
+  sensor->setRxConfig(sensor->MODEM_LORA, 125000, 7,
+                       1, 0, 8, 5, false, 0, true, false, 0, false, true);
+
+  // run CAD before each transmission, backing off 20ms when busy
+  sensor->setListenBeforeTalk(true, -90, 20);
+
+  // keep up to 32 packets while we are busy with earlier ones
+  sensor->startAsync(32, 8);
+
+  int count = 0;
+  int elapsed = 0;
+  char buffer[64];
+  upm::SX1276::RX_PACKET_T pkt;
+
+  while (shouldRun)
+    {
+      if (sensor->waitPacket(&pkt, 500))
+        {
+          string data((char *)pkt.data, pkt.len);
+          cout << "Received (" << pkt.len << " bytes, RSSI " << pkt.rssi
+               << " SNR " << pkt.snr << "): " << data.c_str() << endl;
+        }
+
+      elapsed += 500;
+      if (beacon && elapsed >= 5000)
+        {
+          elapsed = 0;
+          snprintf(buffer, sizeof(buffer), "Beacon %d", count++);
+          if (!sensor->queueTxStr(string(buffer)))
+            cout << "Transmit queue full" << endl;
+        }
+    }
+
+  upm::SX1276::ASYNC_STATS_T stats = sensor->getAsyncStats();
+  cout << "rx " << stats.rxPackets << " (" << stats.rxErrors << " crc, "
+       << stats.rxOverflows << " overflows), tx " << stats.txPackets
+       << " (" << stats.txTimeouts << " timeouts, " << stats.lbtBusy
+       << " deferred)" << endl;
+
+  sensor->stopAsync();
+//! [Interesting]
+
+  cout << "Exiting..." << endl;
+
+  delete sensor;
+
+  return 0;
+}
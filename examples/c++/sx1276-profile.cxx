@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <unistd.h>
+#include <stdio.h>
+#include <iostream>
+#include <signal.h>
+#include "sx1276.h"
+
+using namespace std;
+
+int shouldRun = true;
+
+void sig_handler(int signo)
+{
+  if (signo == SIGINT)
+    shouldRun = false;
+}
+
+
+int main(int argc, char **argv)
+{
+  signal(SIGINT, sig_handler);
+//! [Interesting]
+  // Instantiate an SX1276 using default parameters
+  upm::SX1276 *sensor = new upm::SX1276();
+
+  // hop between these channels, sending one packet on each
+  static const uint32_t channels[] = {
+    903900000, 904100000, 904300000, 904500000
+  };
+  static const int numChannels = sizeof(channels) / sizeof(channels[0]);
+
+  // Record one profile per channel.  Nothing is sent to the radio
+  // while recording; applying a profile later only writes the
+  // registers that differ from the current configuration.
+  upm::SX1276::PROFILE_T *profiles = new upm::SX1276::PROFILE_T[numChannels];
+
+  for (int i = 0; i < numChannels; i++)
+    {
+      sensor->beginProfile(&profiles[i]);
+
+      sensor->setChannel(channels[i]);
+      sensor->setTxConfig(sensor->MODEM_LORA, 14, 0, 125000,
+                          7, 1, 8, false, true, false, 0, false);
+      sensor->setRxConfig(sensor->MODEM_LORA, 125000, 7,
+                          1, 0, 8, 5, false, 0, true, false, 0, false, 
+                          true);
+
+      sensor->endProfile();
+    }
+
+  int count = 0;
+  char buffer[64];
+
+  while (shouldRun)
+    {
+      int ch = count % numChannels;
+
+      // typically only the 3 frequency registers change, in one burst
+      sensor->applyProfile(&profiles[ch]);
+
+      snprintf(buffer, sizeof(buffer), "Hop %d", count++);
+      cout << "Sending on " << channels[ch] << "Hz: " << buffer << endl;
+      sensor->sendStr(string(buffer), 3000);
+      sensor->setSleep();
+
+      usleep(250000);
+    }
+//! [Interesting]
+
+  cout << "Exiting..." << endl;
+
+  delete [] profiles;
+  delete sensor;
+
+  return 0;
+}
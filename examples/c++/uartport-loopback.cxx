@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <iostream>
+#include "uartport.h"
+
+using namespace std;
+
+// number of pseudo-terminals serviced by the one reader thread
+#define PORTS 4
+
+// framer for '\n' terminated lines
+int lineFramer(const uint8_t *data, int len, void *)
+{
+  const uint8_t *eol = (const uint8_t *)memchr(data, '\n', len);
+
+  return eol ? (int)(eol - data) + 1 : 0;
+}
+
+void lineHandler(const uint8_t *, int, void *ctx)
+{
+  int *lines = (int *)ctx;
+
+  (*lines)++;
+}
+
+int main(int argc, char **argv)
+{
+//! [Interesting]
+  // A pseudo-terminal stands in for the device: the master side
+  // plays the role of the remote end, and the UartPort opens the
+  // slave side just like a real tty.
+  int masters[PORTS];
+  upm::UartPort *ports[PORTS];
+  int lines[PORTS];
+
+  for (int i = 0; i < PORTS; i++)
+    {
+      if ( (masters[i] = posix_openpt(O_RDWR | O_NOCTTY)) < 0 ||
+           grantpt(masters[i]) || unlockpt(masters[i]) )
+        {
+          cerr << "Unable to allocate a pseudo-terminal" << endl;
+          return 1;
+        }
+
+      ports[i] = new upm::UartPort(ptsname(masters[i]));
+      ports[i]->setupTty(B115200);
+      lines[i] = 0;
+    }
+
+  // raw reads through the receive ring
+  const char *msg = "hello from the other side";
+  if (write(masters[0], msg, strlen(msg)) < 0)
+    cerr << "write failed" << endl;
+
+  uint8_t buf[64];
+  int got = 0;
+  while (got < (int)strlen(msg))
+    {
+      int rv = ports[0]->readData(buf + got, sizeof(buf) - got, 1000);
+      if (rv <= 0)
+        break;
+      got += rv;
+    }
+  cout << "Read " << got << " bytes: " << string((char *)buf, got) << endl;
+
+  // framed reception on every port at once
+  for (int i = 0; i < PORTS; i++)
+    ports[i]->setFramer(lineFramer, lineHandler, &lines[i], 100);
+
+  for (int n = 0; n < 100; n++)
+    for (int i = 0; i < PORTS; i++)
+      {
+        const char *line = "$GPGGA,,,,,,0,00,,,M,,M,,*66\r\n";
+        if (write(masters[i], line, strlen(line)) < 0)
+          cerr << "write failed" << endl;
+      }
+
+  usleep(200000);
+
+  for (int i = 0; i < PORTS; i++)
+    {
+      cout << "Port " << i << ": " << lines[i] << " lines, "
+           << ports[i]->getOverflowCount() << " bytes dropped" << endl;
+      delete ports[i];
+      close(masters[i]);
+    }
+//! [Interesting]
+
+  return 0;
+}
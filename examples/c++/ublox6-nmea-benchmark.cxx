@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include <vector>
+#include "nmeaparser.h"
+
+using namespace std;
+
+static double now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void addSentence(vector<uint8_t>& log, const char *body)
+{
+  char sentence[128];
+  uint8_t cksum = 0;
+
+  for (const char *p = body; *p; p++)
+    cksum ^= *p;
+
+  int len = snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, cksum);
+  log.insert(log.end(), sentence, sentence + len);
+}
+
+// Stand-in for a recorded log: one epoch per second of the sentences
+// a u-blox 6 outputs by default.
+static void makeLog(vector<uint8_t>& log, int epochs)
+{
+  char body[128];
+
+  for (int i = 0; i < epochs; i++)
+    {
+      int h = (i / 3600) % 24, m = (i / 60) % 60, s = i % 60;
+      double lat = 4530.0 + (i % 1000) * 0.0001;
+      double lon = 12230.0 + (i % 1000) * 0.0001;
+
+      snprintf(body, sizeof(body),
+               "GPRMC,%02d%02d%02d.00,A,%.5f,N,%.5f,W,0.512,77.52,150716,,,A",
+               h, m, s, lat, lon);
+      addSentence(log, body);
+      addSentence(log, "GPVTG,77.52,T,,M,0.512,N,0.948,K,A");
+      snprintf(body, sizeof(body),
+               "GPGGA,%02d%02d%02d.00,%.5f,N,%.5f,W,1,08,1.01,61.7,M,-21.3,M,,",
+               h, m, s, lat, lon);
+      addSentence(log, body);
+      addSentence(log, "GPGSA,A,3,21,26,15,29,05,18,16,20,,,,,1.83,1.01,1.53");
+      addSentence(log, "GPGSV,3,1,12,05,36,299,40,10,03,062,,13,03,158,,15,42,"
+                  "188,43");
+      snprintf(body, sizeof(body), "GPGLL,%.5f,N,%.5f,W,%02d%02d%02d.00,A,A",
+               lat, lon, h, m, s);
+      addSentence(log, body);
+    }
+}
+
+int main(int argc, char **argv)
+{
+//! [Interesting]
+  vector<uint8_t> log;
+
+  // feed a recorded NMEA log if one is given, otherwise synthesize one
+  if (argc > 1)
+    {
+      FILE *f = fopen(argv[1], "rb");
+      if (!f)
+        {
+          cerr << "Unable to open " << argv[1] << endl;
+          return 1;
+        }
+
+      uint8_t buf[4096];
+      size_t n;
+      while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        log.insert(log.end(), buf, buf + n);
+      fclose(f);
+    }
+  else
+    makeLog(log, 10000);
+
+  upm::NMEAParser parser;
+  const int passes = 20;
+
+  // feed the log in random sized chunks, like reads from a tty
+  vector<int> chunks;
+  srand(1);
+  for (size_t off = 0; off < log.size(); )
+    {
+      int len = 1 + rand() % 256;
+      chunks.push_back(len);
+      off += len;
+    }
+
+  double start = now();
+  for (int pass = 0; pass < passes; pass++)
+    {
+      size_t off = 0;
+      for (size_t i = 0; i < chunks.size() && off < log.size(); i++)
+        {
+          int len = chunks[i];
+          if (off + len > log.size())
+            len = log.size() - off;
+          parser.parse(&log[off], len);
+          off += len;
+        }
+    }
+  double elapsed = now() - start;
+
+  const upm::NMEAParser::GPS_FIX_T *fix = parser.getFix();
+
+  printf("%lu bytes x %d passes in %.3f sec\n", (unsigned long)log.size(),
+         passes, elapsed);
+  printf("%.0f sentences/sec, %.1f MB/sec\n",
+         parser.getSentenceCount() / elapsed,
+         log.size() * passes / elapsed / 1e6);
+  printf("%lu sentences, %lu UBX messages, %lu errors, %lu fixes\n",
+         parser.getSentenceCount(), parser.getUBXCount(),
+         parser.getErrorCount(), parser.getFixCount());
+  printf("last fix: %02d:%02d:%02d %.6f %.6f alt %.1fm %.2fm/s hdop %.2f\n",
+         fix->hour, fix->minute, fix->second, fix->latitude, fix->longitude,
+         fix->altitude, fix->speed, fix->hdop);
+//! [Interesting]
+
+  return 0;
+}
@@ -37,16 +37,44 @@ AD8232::AD8232(int loPlus, int loMinus, int output, float aref) :
   
   m_aref = aref;
   m_ares = (1 << m_aioOUT.getBit());
+
+  m_outputPin = output;
+  m_acq = 0;
+  m_acqChannel = -1;
 }
 
 AD8232::~AD8232()
 {
+  detachAcquisition();
 }
 
 int AD8232::value()
 {
+  AioAcquisition::SAMPLE_T sample;
+
   if (m_gpioLOPlus.read() || m_gpioLOMinus.read())
     return 0;
+  else if (m_acq && m_acq->getLatest(m_acqChannel, &sample))
+    return sample.value;
   else
     return m_aioOUT.read();
 }
+
+void AD8232::attachAcquisition(AioAcquisition *acq, unsigned int periodUs)
+{
+  detachAcquisition();
+
+  m_acqChannel = acq->addChannel(m_outputPin, periodUs, 0);
+  m_acq = acq;
+  m_acq->start();
+}
+
+void AD8232::detachAcquisition()
+{
+  if (m_acq)
+    {
+      m_acq->removeChannel(m_acqChannel);
+      m_acq = 0;
+      m_acqChannel = -1;
+    }
+}
@@ -30,6 +30,8 @@
 
 #include <mraa/aio.hpp>
 
+#include "aioacquire.h"
+
 #define AD8232_DEFAULT_AREF  3.3
 
 namespace upm {
@@ -61,6 +63,9 @@ namespace upm {
    * Processing (https://www.processing.org/) is software
    * that should work, using information from the SparkFun* website.
    *
+   * With a shared AioAcquisition engine attached, the output is
+   * sampled at a fixed rate and value() returns the latest sample.
+   *
    * This example just dumps the raw data:
    *
    * @image html ad8232.jpg
@@ -88,6 +93,27 @@ namespace upm {
      */
     ~AD8232();
 
+    /**
+     * Samples the output with a shared acquisition engine.
+     * The engine is started if it is not running.
+     *
+     * @param acq Acquisition engine
+     * @param periodUs Sample period in microseconds
+     */
+    void attachAcquisition(AioAcquisition *acq, unsigned int periodUs=2000);
+
+    /**
+     * Stops sampling with the acquisition engine
+     */
+    void detachAcquisition();
+
+    /**
+     * Returns the acquisition channel of the sensor
+     *
+     * @return Channel number, or -1 if not attached
+     */
+    int getAcquisitionChannel() { return m_acqChannel; };
+
     /**
      * Returns the current ADC value for the device output pin.  If an
      * LO (leads off) event is detected, 0 is returned.
@@ -104,6 +130,10 @@ namespace upm {
     float m_aref;
     int m_ares;
 
+    int m_outputPin;
+    AioAcquisition *m_acq;
+    int m_acqChannel;
+
   };
 }
 
@@ -28,6 +28,7 @@
 #include <string>
 
 #include "adafruitms1438.h"
+#include "motionengine.h"
 
 using namespace upm;
 using namespace std;
@@ -51,6 +52,14 @@ AdafruitMS1438::AdafruitMS1438(int bus, uint8_t address) :
   // Set all 'on time' registers to 0
   m_pca9685->ledOnTime(PCA9685_ALL_LED, 0);
 
+  // one motion engine axis per stepper
+  for (int i = 0; i < 2; i++)
+    {
+      m_stepConfig[i].owner = this;
+      m_stepConfig[i].motor = STEPMOTORS_T(i);
+      m_stepConfig[i].axis = new MotionAxis(&stepCallback, &m_stepConfig[i]);
+    }
+
   // set the default stepper config at 200 steps per rev
   stepConfig(STEPMOTOR_M12, 200);
   stepConfig(STEPMOTOR_M34, 200);
@@ -58,6 +67,8 @@ AdafruitMS1438::AdafruitMS1438(int bus, uint8_t address) :
 
 AdafruitMS1438::~AdafruitMS1438()
 {
+  delete m_stepConfig[STEPMOTOR_M12].axis;
+  delete m_stepConfig[STEPMOTOR_M34].axis;
   delete m_pca9685;
 }
 
@@ -132,14 +143,18 @@ void AdafruitMS1438::disableMotor(DCMOTORS_T motor)
 
 void AdafruitMS1438::enableStepper(STEPMOTORS_T motor)
 {
+  m_pca9685->begin();
   m_pca9685->ledFullOff(m_stepMotors[motor].pwmA, false);
   m_pca9685->ledFullOff(m_stepMotors[motor].pwmB, false);
+  m_pca9685->commit();
 }
 
 void AdafruitMS1438::disableStepper(STEPMOTORS_T motor)
 {
+  m_pca9685->begin();
   m_pca9685->ledFullOff(m_stepMotors[motor].pwmA, true);
   m_pca9685->ledFullOff(m_stepMotors[motor].pwmB, true);
+  m_pca9685->commit();
 }
 
 void AdafruitMS1438::setMotorSpeed(DCMOTORS_T motor, int speed)
@@ -164,10 +179,15 @@ void AdafruitMS1438::setStepperSpeed(STEPMOTORS_T motor, int speed)
 {
   m_stepConfig[motor].stepDelay = 60 * 1000 / 
     m_stepConfig[motor].stepsPerRev / speed;
+
+  m_stepConfig[motor].axis->setMaxSpeed(double(speed) *
+                                        m_stepConfig[motor].stepsPerRev /
+                                        60.0);
 }
 
 void AdafruitMS1438::setMotorDirection(DCMOTORS_T motor, DIRECTION_T dir)
 {
+  m_pca9685->begin();
   if (dir & 0x01)
     {
       m_pca9685->ledFullOn(m_dcMotors[motor].in1, true);
@@ -189,6 +209,7 @@ void AdafruitMS1438::setMotorDirection(DCMOTORS_T motor, DIRECTION_T dir)
       m_pca9685->ledFullOff(m_dcMotors[motor].in2, true);
       m_pca9685->ledFullOn(m_dcMotors[motor].in2, false);
     }
+  m_pca9685->commit();
 }
 
 void AdafruitMS1438::setStepperDirection(STEPMOTORS_T motor, DIRECTION_T dir)
@@ -218,6 +239,8 @@ void AdafruitMS1438::stepConfig(STEPMOTORS_T motor, unsigned int stepsPerRev)
   // Since FULL OFF has precedence, we can then control the steps by
   // just turning on/off the FULL OFF bit for the relevant outputs
 
+  m_pca9685->begin();
+
   m_pca9685->ledFullOff(m_stepMotors[motor].pwmA, true);
   m_pca9685->ledFullOn(m_stepMotors[motor].pwmA, true);
 
@@ -235,6 +258,8 @@ void AdafruitMS1438::stepConfig(STEPMOTORS_T motor, unsigned int stepsPerRev)
 
   m_pca9685->ledFullOff(m_stepMotors[motor].in2B, true);
   m_pca9685->ledFullOn(m_stepMotors[motor].in2B, true);
+
+  m_pca9685->commit();
 }
 
 void AdafruitMS1438::stepperStep(STEPMOTORS_T motor)
@@ -248,7 +273,9 @@ void AdafruitMS1438::stepperStep(STEPMOTORS_T motor)
   //     4  1  0  0  1
 
   // we invert the logic since we are essentially toggling an OFF bit,
-  // not an ON bit.
+  // not an ON bit.  The four changes go out together on commit().
+  m_pca9685->begin();
+
   switch (step)
     {
     case 0:    // 1010
@@ -276,35 +303,34 @@ void AdafruitMS1438::stepperStep(STEPMOTORS_T motor)
       m_pca9685->ledFullOff(m_stepMotors[motor].in2B, false);
       break;
     }
+
+  m_pca9685->commit();
 }
 
 void AdafruitMS1438::stepperSteps(STEPMOTORS_T motor, unsigned int steps)
 {
-  while (steps > 0)
+  MotionAxis *axis = m_stepConfig[motor].axis;
+
+  axis->waitMove(axis->move(m_stepConfig[motor].stepDirection * int(steps)));
+}
+
+void AdafruitMS1438::stepCallback(int dir, void *ctx)
+{
+  STEPPER_CONFIG_T *cfg = (STEPPER_CONFIG_T *)ctx;
+
+  cfg->currentStep += dir;
+
+  if (dir == 1)
     {
-      if (getMillis(motor) >= m_stepConfig[motor].stepDelay)
-        {
-          // reset the clock
-          initClock(motor);
-
-          m_stepConfig[motor].currentStep += m_stepConfig[motor].stepDirection;
-
-          if (m_stepConfig[motor].stepDirection == 1)
-            {
-              if (m_stepConfig[motor].currentStep >= 
-                  m_stepConfig[motor].stepsPerRev)
-                m_stepConfig[motor].currentStep = 0;
-            }
-          else
-            {
-              if (m_stepConfig[motor].currentStep <= 0)
-                m_stepConfig[motor].currentStep = 
-                  m_stepConfig[motor].stepsPerRev;
-            }
-
-          steps--;
-          stepperStep(motor);
-        }
+      if (cfg->currentStep >= cfg->stepsPerRev)
+        cfg->currentStep = 0;
     }
+  else
+    {
+      if (cfg->currentStep <= 0)
+        cfg->currentStep = cfg->stepsPerRev;
+    }
+
+  cfg->owner->stepperStep(cfg->motor);
 }
 
@@ -36,6 +36,7 @@
 #define ADAFRUITMS1438_DEFAULT_I2C_ADDR 0x60
 
 namespace upm {
+  class MotionAxis;
   
   /**
    * @brief Adafruit Motor Shield 1438 library
@@ -207,6 +208,20 @@ namespace upm {
      */
     void stepperSteps(STEPMOTORS_T motor, unsigned int steps);
 
+    /**
+     * Returns the motion engine axis driving a stepper motor.  Moves
+     * queued on it run in the background, with optional
+     * acceleration; both steppers can move at the same time.  Speeds
+     * on the axis are in steps per second.
+     *
+     * @param motor Stepper motor
+     * @return Motion axis
+     */
+    MotionAxis *getMotionAxis(STEPMOTORS_T motor)
+    {
+      return m_stepConfig[motor].axis;
+    };
+
   private:
     // SWIG will generate a warning for these 'nested structs'; however,
     // it can be ignored as these structs are never exposed.
@@ -235,10 +250,14 @@ namespace upm {
       uint32_t stepDelay;       // delay between steps
       int stepDirection;        // direction to step
       struct timeval startTime; // starting time
+      MotionAxis *axis;         // background step generator
+      AdafruitMS1438 *owner;    // for the step callback
+      STEPMOTORS_T motor;
     } STEPPER_CONFIG_T;
 
     void setupPinMaps();
     void stepperStep(STEPMOTORS_T motor);
+    static void stepCallback(int dir, void *ctx);
 
     DC_PINMAP_T m_dcMotors[4];
     STEPPER_PINMAP_T m_stepMotors[2];
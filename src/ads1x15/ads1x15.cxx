@@ -26,9 +26,19 @@
 #include "ads1x15.h"
 
 #include <unistd.h>
+#include <time.h>
+#include <stdexcept>
 
 using namespace upm;
 
+static uint64_t getNanos()
+{
+     struct timespec now;
+
+     clock_gettime(CLOCK_MONOTONIC, &now);
+     return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
 ADS1X15::ADS1X15(int bus, uint8_t address){
 
      if(!(i2c = new mraa::I2c(bus))){
@@ -49,29 +59,67 @@ ADS1X15::ADS1X15(int bus, uint8_t address){
      m_bitShift = 0;
      m_conversionDelay = .001;
      m_config_reg = 0x0000;
+
+     m_scanRingSize = 0;
+     m_scanGpio = 0;
+     m_scanning = false;
+     m_scanIndex = 0;
+     m_scanConfig = 0;
+     m_scanSavedConfig = 0;
+     m_scanSavedLowThresh = 0;
+     m_scanSavedHighThresh = 0;
+     m_scanMultiplier = 0.0;
+     m_scanLast = 0;
+     m_scanTimeout = 0;
+     m_scanOverflows = 0;
+     m_scanRestarts = 0;
+     pthread_mutex_init(&m_scanLock, NULL);
 }
 
-ADS1X15::~ADS1X15(){}
+ADS1X15::~ADS1X15(){
+     // no virtual calls from here, so don't use stopScan()
+     if(m_scanning){
+          haltScan();
+          i2c->writeWordReg(ADS1X15_REG_POINTER_CONFIG,
+                            swapWord(m_scanSavedConfig & 0x7FFF));
+          restoreThresh();
+     }
+     pthread_mutex_destroy(&m_scanLock);
+}
 
 float
 ADS1X15::getSample(ADSMUXMODE mode){
+     if(m_scanning){
+          throw std::runtime_error(std::string(__FUNCTION__) + ": scan in progress");
+          return 0.0;
+     }
      updateConfigRegister((m_config_reg & ~ADS1X15_MUX_MASK) | mode, true);
-     usleep(m_conversionDelay);
+     // m_conversionDelay is the nominal conversion time in us; after
+     // it, wait for the OS bit in case the oscillator runs slow
+     usleep((useconds_t)m_conversionDelay);
+     for(int tries = 0; tries < 100; tries++){
+          uint16_t config = swapWord(i2c->readWordReg(ADS1X15_REG_POINTER_CONFIG));
+          if(config & ADS1X15_OS_NOTBUSY) break;
+          usleep(100);
+     }
      return getLastSample();
 }
 
 float
 ADS1X15::getLastSample(int reg){
-     uint16_t value = i2c->readWordReg(reg);
+     return convertSample(swapWord(i2c->readWordReg(reg)), getMultiplier());
+}
+
+float
+ADS1X15::convertSample(uint16_t value, float multiplier){
      bool neg = false;
-     value = swapWord(value);
      if(value & 0x8000){
           neg = true;
           value = ~value;
      }
      if(m_name == "ADS1015") value = value >> m_bitShift;
-     if(neg) return 0.0 - value * getMultiplier();
-      else return value * getMultiplier();
+     if(neg) return 0.0 - value * multiplier;
+      else return value * multiplier;
 }
 
 void
@@ -157,6 +205,194 @@ ADS1X15::setThresh(ADSTHRESH reg, float value){
 }
 
 
+int
+ADS1X15::addScanChannel(ADSMUXMODE mode){
+     if(m_scanning){
+          throw std::runtime_error(std::string(__FUNCTION__) + ": scan in progress");
+          return -1;
+     }
+     m_scanModes.push_back(mode);
+     return m_scanModes.size() - 1;
+}
+
+void
+ADS1X15::clearScanChannels(){
+     stopScan();
+     m_scanModes.clear();
+     m_scanRing.clear();
+     m_scanHead.clear();
+     m_scanCount.clear();
+}
+
+void
+ADS1X15::startScan(int gpio, int ringSize){
+     if(m_scanModes.empty()){
+          throw std::invalid_argument(std::string(__FUNCTION__) + ": no scan channels");
+          return;
+     }
+     if(ringSize < 1){
+          throw std::invalid_argument(std::string(__FUNCTION__) + ": ringSize must be at least 1");
+          return;
+     }
+
+     stopScan();
+
+     int channels = m_scanModes.size();
+     m_scanRingSize = ringSize;
+     m_scanRing.assign(channels * ringSize, SCAN_SAMPLE_T());
+     m_scanHead.assign(channels, 0);
+     m_scanCount.assign(channels, 0);
+     m_scanOverflows = 0;
+     m_scanRestarts = 0;
+
+     // ALERT/RDY as conversion ready, asserted after every conversion.
+     // This takes over the threshold registers, keep them for stopScan()
+     m_scanSavedLowThresh = i2c->readWordReg(ADS1X15_REG_POINTER_LOWTHRESH);
+     m_scanSavedHighThresh = i2c->readWordReg(ADS1X15_REG_POINTER_HITHRESH);
+     setThresh(CONVERSION_RDY);
+     m_scanSavedConfig = m_config_reg;
+     m_scanMultiplier = getMultiplier();
+     m_scanConfig = (m_config_reg & ~(ADS1X15_OS_MASK | ADS1X15_MUX_MASK |
+                                      ADS1X15_MODE_MASK | ADS1X15_CLAT_MASK |
+                                      ADS1X15_CQUE_MASK)) | CQUE_1CONV;
+     if(channels > 1) m_scanConfig |= ADS1X15_MODE_SINGLE;
+
+     // a lost edge stalls the chain; restart after 10 conversion times
+     m_scanTimeout = (uint64_t)(m_conversionDelay * 10000) + 10000000;
+
+     m_scanGpio = new mraa::Gpio(gpio);
+     m_scanGpio->dir(mraa::DIR_IN);
+
+     m_scanIndex = 0;
+     m_scanning = true;
+     m_scanGpio->isr(getCompPol() ? mraa::EDGE_RISING : mraa::EDGE_FALLING,
+                     scanISR, this);
+
+     pthread_mutex_lock(&m_scanLock);
+     scanKick();
+     pthread_mutex_unlock(&m_scanLock);
+}
+
+void
+ADS1X15::stopScan(){
+     if(!m_scanning) return;
+
+     haltScan();
+
+     // back to the previous (normally single-shot) configuration
+     updateConfigRegister(m_scanSavedConfig);
+     restoreThresh();
+}
+
+void
+ADS1X15::restoreThresh(){
+     // raw register contents, as read by startScan()
+     i2c->writeWordReg(ADS1X15_REG_POINTER_LOWTHRESH, m_scanSavedLowThresh);
+     i2c->writeWordReg(ADS1X15_REG_POINTER_HITHRESH, m_scanSavedHighThresh);
+}
+
+void
+ADS1X15::haltScan(){
+     pthread_mutex_lock(&m_scanLock);
+     m_scanning = false;
+     pthread_mutex_unlock(&m_scanLock);
+
+     m_scanGpio->isrExit();
+     delete m_scanGpio;
+     m_scanGpio = 0;
+}
+
+int
+ADS1X15::scanAvailable(int channel){
+     if(channel < 0 || channel >= (int)m_scanCount.size()) return 0;
+
+     scanCheck();
+
+     pthread_mutex_lock(&m_scanLock);
+     int rv = m_scanCount[channel];
+     pthread_mutex_unlock(&m_scanLock);
+
+     return rv;
+}
+
+int
+ADS1X15::readScan(int channel, SCAN_SAMPLE_T *samples, int max){
+     if(channel < 0 || channel >= (int)m_scanCount.size()) return 0;
+
+     scanCheck();
+
+     pthread_mutex_lock(&m_scanLock);
+     int n = 0;
+     SCAN_SAMPLE_T *ring = &m_scanRing[channel * m_scanRingSize];
+     while(n < max && m_scanCount[channel] > 0){
+          int tail = m_scanHead[channel] - m_scanCount[channel];
+          if(tail < 0) tail += m_scanRingSize;
+          samples[n++] = ring[tail];
+          m_scanCount[channel]--;
+     }
+     pthread_mutex_unlock(&m_scanLock);
+
+     return n;
+}
+
+void
+ADS1X15::scanISR(void *ctx){
+     ADS1X15 *This = (ADS1X15 *)ctx;
+
+     pthread_mutex_lock(&This->m_scanLock);
+     if(This->m_scanning) This->scanNext();
+     pthread_mutex_unlock(&This->m_scanLock);
+}
+
+// called with m_scanLock held
+void
+ADS1X15::scanNext(){
+     uint64_t now = getNanos();
+     int channel = m_scanIndex;
+     int channels = m_scanModes.size();
+
+     // read this result before starting the next conversion; at the
+     // higher data rates a conversion is shorter than the config write
+     // and would overwrite the result before it is read
+     uint16_t raw = swapWord(i2c->readWordReg(ADS1X15_REG_POINTER_CONVERT));
+
+     if(channels > 1){
+          m_scanIndex = (m_scanIndex + 1) % channels;
+          i2c->writeWordReg(ADS1X15_REG_POINTER_CONFIG,
+                            swapWord(m_scanConfig | m_scanModes[m_scanIndex] |
+                                     ADS1X15_OS_SINGLE));
+     }
+
+     SCAN_SAMPLE_T *ring = &m_scanRing[channel * m_scanRingSize];
+     ring[m_scanHead[channel]].timestamp = now;
+     ring[m_scanHead[channel]].value = convertSample(raw, m_scanMultiplier);
+     m_scanHead[channel] = (m_scanHead[channel] + 1) % m_scanRingSize;
+     if(m_scanCount[channel] == m_scanRingSize) m_scanOverflows++;
+      else m_scanCount[channel]++;
+
+     m_scanLast = now;
+}
+
+// called with m_scanLock held
+void
+ADS1X15::scanKick(){
+     uint16_t config = m_scanConfig | m_scanModes[m_scanIndex];
+     if(m_scanModes.size() > 1) config |= ADS1X15_OS_SINGLE;
+
+     i2c->writeWordReg(ADS1X15_REG_POINTER_CONFIG, swapWord(config));
+     m_scanLast = getNanos();
+}
+
+void
+ADS1X15::scanCheck(){
+     pthread_mutex_lock(&m_scanLock);
+     if(m_scanning && getNanos() - m_scanLast > m_scanTimeout){
+          m_scanRestarts++;
+          scanKick();
+     }
+     pthread_mutex_unlock(&m_scanLock);
+}
+
 //Private functions
 void
 ADS1X15::getCurrentConfig(){
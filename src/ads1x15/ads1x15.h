@@ -26,8 +26,12 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
 #include "mraa.hpp"
 #include "mraa/i2c.hpp"
+#include "mraa/gpio.hpp"
 
 /*=========================================================================
     I2C ADDRESS/BITS
@@ -100,6 +104,9 @@
 */
 /*=========================================================================*/
 
+// default number of samples kept per scanned channel
+#define ADS1X15_SCAN_RING_SIZE          (1024)
+
 namespace upm {
   /**
    * @brief ADS1X15 family adc library
@@ -107,6 +114,12 @@ namespace upm {
    * Library for TI analog to digital converter ic. Base clase fro ADS1X15 provides all the functionality that
    * ADS1115 and ADS1015 ics have in common.
    *
+   * Besides single reads, the device can scan a list of inputs in
+   * the background: the ALERT/RDY pin is set up as a conversion
+   * ready signal and an ISR on the GPIO it is wired to reads each
+   * result and starts the next conversion, storing timestamped
+   * samples in a ring buffer per channel.
+   *
    * @defgroup ads1x15 libupm-ads1x15
    * @ingroup ti adafruit i2c electric
    */
@@ -406,6 +419,83 @@ namespace upm {
              */
             void setThresh(ADSTHRESH reg = THRESH_DEFAULT , float value = 0.0);
 
+            /**
+             * One scanned sample
+             */
+            typedef struct {
+                uint64_t timestamp;     // CLOCK_MONOTONIC, ns
+                float value;            // volts
+            } SCAN_SAMPLE_T;
+
+            /**
+             * Adds an input to the scan list. Must be called before
+             * startScan().
+             * @param mode ADSMUXMODE specifying inputs to be sampled.
+             * @return Channel number used to read the samples back
+             */
+            int addScanChannel(ADSMUXMODE mode);
+
+            /**
+             * Empties the scan list. Stops the scan if running.
+             */
+            void clearScanChannels();
+
+            /**
+             * Starts scanning the inputs of the scan list at the
+             * current data rate and gain. The ALERT/RDY pin must be
+             * connected to the given GPIO.
+             *
+             * A single channel uses continuous conversion mode, so it
+             * is sampled at the full data rate. Several channels are
+             * converted one after the other in single-shot mode, each
+             * conversion started from the ISR of the previous one.
+             *
+             * The comparator is used for the ready signal, and other
+             * methods of this object must not be used until stopScan().
+             * @param gpio GPIO pin connected to ALERT/RDY
+             * @param ringSize Number of samples kept per channel
+             */
+            void startScan(int gpio, int ringSize = ADS1X15_SCAN_RING_SIZE);
+
+            /**
+             * Stops scanning and restores the previous configuration and
+             * threshold registers.
+             * Samples not read yet are kept until the next startScan().
+             */
+            void stopScan();
+
+            /**
+             * Returns true while a scan is running
+             */
+            bool isScanning() { return m_scanning; };
+
+            /**
+             * Returns the number of unread samples of a channel
+             * @param channel Channel number from addScanChannel()
+             */
+            int scanAvailable(int channel);
+
+            /**
+             * Reads and removes the oldest samples of a channel
+             * @param channel Channel number from addScanChannel()
+             * @param samples Buffer for the samples
+             * @param max Maximum number of samples to read
+             * @return Number of samples read
+             */
+            int readScan(int channel, SCAN_SAMPLE_T *samples, int max);
+
+            /**
+             * Returns the number of samples dropped because a channel
+             * ring buffer was full
+             */
+            unsigned int getScanOverflowCount() { return m_scanOverflows; };
+
+            /**
+             * Returns the number of times the scan had to be restarted
+             * because a ready edge was lost
+             */
+            unsigned int getScanRestartCount() { return m_scanRestarts; };
+
         protected:
             std::string m_name;
             float m_conversionDelay;
@@ -418,7 +508,38 @@ namespace upm {
             void getCurrentConfig();
             void updateConfigRegister(uint16_t update, bool read = false);
             uint16_t swapWord(uint16_t value);
+            float convertSample(uint16_t value, float multiplier);
 
                mraa::I2c* i2c;
 
+        private:
+            static void scanISR(void *ctx);
+            void scanNext();
+            void scanKick();
+            void scanCheck();
+            void haltScan();
+            void restoreThresh();
+
+            std::vector<uint16_t> m_scanModes;
+            std::vector<SCAN_SAMPLE_T> m_scanRing;  // channel * ringSize
+            std::vector<int> m_scanHead;
+            std::vector<int> m_scanCount;
+            int m_scanRingSize;
+
+            mraa::Gpio *m_scanGpio;
+            bool m_scanning;
+            int m_scanIndex;            // channel being converted
+            uint16_t m_scanConfig;      // config register without MUX
+            uint16_t m_scanSavedConfig;
+            uint16_t m_scanSavedLowThresh;  // as read, not byte swapped
+            uint16_t m_scanSavedHighThresh;
+            float m_scanMultiplier;
+            uint64_t m_scanLast;
+            uint64_t m_scanTimeout;
+            unsigned int m_scanOverflows;
+            unsigned int m_scanRestarts;
+
+            // protects the I2C context and the rings while scanning
+            pthread_mutex_t m_scanLock;
+
     };}
@@ -0,0 +1,779 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <sys/prctl.h>
+#include <sys/eventfd.h>
+
+#include "aioacquire.h"
+
+using namespace upm;
+using namespace std;
+
+AioAcquisition::AioAcquisition()
+{
+  m_running = false;
+
+  if ((m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)) < 0)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": timerfd_create() failed");
+      return;
+    }
+
+  if ((m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+    {
+      close(m_timerFd);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": eventfd() failed");
+      return;
+    }
+
+  pthread_mutex_init(&m_lock, NULL);
+}
+
+AioAcquisition::~AioAcquisition()
+{
+  stop();
+
+  for (unsigned int i = 0; i < m_channels.size(); i++)
+    {
+      CHANNEL_T *chan = m_channels[i];
+
+      if (chan)
+        {
+          if (chan->owned)
+            mraa_aio_close(chan->aio);
+          delete chan;
+        }
+    }
+
+  close(m_timerFd);
+  close(m_wakeFd);
+  pthread_mutex_destroy(&m_lock);
+}
+
+uint64_t AioAcquisition::getNanos()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int AioAcquisition::addChannel(int pin, unsigned int periodUs, int ringSize,
+                               SAMPLE_HANDLER_T handler, void *ctx)
+{
+  mraa_aio_context aio;
+
+  if (!periodUs)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": period must be greater than 0");
+      return -1;
+    }
+
+  if ( !(aio = mraa_aio_init(pin)) )
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": mraa_aio_init() failed, invalid pin?");
+      return -1;
+    }
+
+  return addChannel(aio, true, periodUs, ringSize, handler, ctx);
+}
+
+int AioAcquisition::addChannel(mraa_aio_context aio, unsigned int periodUs,
+                               int ringSize, SAMPLE_HANDLER_T handler,
+                               void *ctx)
+{
+  if (!aio || !periodUs)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": invalid context or period");
+      return -1;
+    }
+
+  return addChannel(aio, false, periodUs, ringSize, handler, ctx);
+}
+
+int AioAcquisition::addChannel(mraa_aio_context aio, bool owned,
+                               unsigned int periodUs, int ringSize,
+                               SAMPLE_HANDLER_T handler, void *ctx)
+{
+  if (ringSize < 0)
+    {
+      if (owned)
+        mraa_aio_close(aio);
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": ring size must not be negative");
+      return -1;
+    }
+
+  CHANNEL_T *chan = new CHANNEL_T;
+
+  // round the ring up to a power of 2 so indexes can be masked
+  int size = 0;
+  if (ringSize)
+    {
+      size = 2;
+      while (size < ringSize)
+        size <<= 1;
+    }
+
+  chan->aio = aio;
+  chan->owned = owned;
+  chan->period = periodUs;
+  chan->due = 0;
+  chan->newPeriod = periodUs;
+  chan->periodChanged = false;
+  chan->ring.resize(size);
+  chan->ringMask = (size) ? size - 1 : 0;
+  chan->head = 0;
+  chan->tail = 0;
+  chan->handler = handler;
+  chan->handlerCtx = ctx;
+  chan->latencySum = 0.0;
+  chan->latencySumSq = 0.0;
+  chan->resetPending = false;
+  chan->seq = 0;
+  chan->sampled = false;
+  chan->latest.timestamp = 0;
+  chan->latest.value = 0;
+  chan->stats.samples = 0;
+  chan->stats.overruns = 0;
+  chan->stats.overflows = 0;
+  chan->stats.minLatency = 0;
+  chan->stats.maxLatency = 0;
+  chan->stats.meanLatency = 0.0;
+  chan->stats.jitter = 0.0;
+
+  pthread_mutex_lock(&m_lock);
+
+  // the thread walks m_channels without a lock, so it must not run
+  // while the vector changes
+  bool wasRunning = m_running;
+  stopLocked();
+
+  int index = -1;
+  for (unsigned int i = 0; i < m_channels.size(); i++)
+    {
+      if (!m_channels[i])
+        {
+          index = i;
+          m_channels[i] = chan;
+          break;
+        }
+    }
+
+  if (index < 0)
+    {
+      index = m_channels.size();
+      m_channels.push_back(chan);
+    }
+
+  try
+    {
+      if (wasRunning)
+        startLocked();
+    }
+  catch (...)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+
+  return index;
+}
+
+void AioAcquisition::removeChannel(int channel)
+{
+  pthread_mutex_lock(&m_lock);
+
+  if (channel < 0 || channel >= (int)m_channels.size() ||
+      !m_channels[channel])
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": invalid channel");
+      return;
+    }
+
+  bool wasRunning = m_running;
+  stopLocked();
+
+  CHANNEL_T *chan = m_channels[channel];
+  m_channels[channel] = 0;
+
+  if (chan->owned)
+    mraa_aio_close(chan->aio);
+  delete chan;
+
+  try
+    {
+      if (wasRunning)
+        startLocked();
+    }
+  catch (...)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+AioAcquisition::CHANNEL_T *AioAcquisition::channel(int channel)
+{
+  if (channel < 0 || channel >= (int)m_channels.size() ||
+      !m_channels[channel])
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": invalid channel");
+      return 0;
+    }
+
+  return m_channels[channel];
+}
+
+void AioAcquisition::setPeriod(int channel, unsigned int periodUs)
+{
+  if (!periodUs)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": period must be greater than 0");
+      return;
+    }
+
+  pthread_mutex_lock(&m_lock);
+
+  CHANNEL_T *chan;
+  try
+    {
+      chan = this->channel(channel);
+    }
+  catch (...)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw;
+    }
+
+  if (m_running)
+    {
+      // the thread owns the schedule; it takes the new period and
+      // samples the channel right away when woken
+      chan->newPeriod = periodUs;
+      __sync_synchronize();
+      chan->periodChanged = true;
+      wake();
+    }
+  else
+    chan->period = periodUs;
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+unsigned int AioAcquisition::getPeriod(int channel)
+{
+  CHANNEL_T *chan = this->channel(channel);
+
+  return (chan->periodChanged) ? chan->newPeriod : chan->period;
+}
+
+void AioAcquisition::start()
+{
+  pthread_mutex_lock(&m_lock);
+
+  try
+    {
+      startLocked();
+    }
+  catch (...)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+void AioAcquisition::stop()
+{
+  pthread_mutex_lock(&m_lock);
+  stopLocked();
+  pthread_mutex_unlock(&m_lock);
+}
+
+// called with m_lock held
+void AioAcquisition::startLocked()
+{
+  if (m_running)
+    return;
+
+  uint64_t now = getNanos();
+
+  for (unsigned int i = 0; i < m_channels.size(); i++)
+    {
+      CHANNEL_T *chan = m_channels[i];
+
+      if (chan)
+        {
+          if (chan->periodChanged)
+            {
+              chan->period = chan->newPeriod;
+              chan->periodChanged = false;
+            }
+          chan->due = now;
+        }
+    }
+
+  // discard any wakeup left over from the last stop()
+  uint64_t junk;
+  while (::read(m_wakeFd, &junk, sizeof(junk)) > 0)
+    ;
+
+  m_running = true;
+
+  if (pthread_create(&m_thread, NULL, acquireThread, this))
+    {
+      m_running = false;
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_create() failed");
+      return;
+    }
+}
+
+// called with m_lock held
+void AioAcquisition::stopLocked()
+{
+  if (!m_running)
+    return;
+
+  m_running = false;
+  wake();
+  pthread_join(m_thread, NULL);
+}
+
+void AioAcquisition::wake()
+{
+  uint64_t one = 1;
+
+  if (::write(m_wakeFd, &one, sizeof(one)) != sizeof(one))
+    cerr << __FUNCTION__ << ": eventfd write failed" << endl;
+}
+
+void *AioAcquisition::acquireThread(void *ctx)
+{
+  AioAcquisition *This = (AioAcquisition *)ctx;
+
+  // the default 50us timer slack would show up as latency on every
+  // sample
+  prctl(PR_SET_TIMERSLACK, 1, 0, 0, 0);
+
+  This->acquire();
+
+  return NULL;
+}
+
+void AioAcquisition::acquire()
+{
+  struct pollfd fds[2];
+
+  fds[0].fd = m_timerFd;
+  fds[0].events = POLLIN;
+  fds[1].fd = m_wakeFd;
+  fds[1].events = POLLIN;
+
+  while (m_running)
+    {
+      // arm the timer for the earliest sample due.  With no channels
+      // the timer is disarmed and only a wakeup ends the wait.
+      struct itimerspec its;
+      uint64_t next = 0;
+
+      for (unsigned int i = 0; i < m_channels.size(); i++)
+        {
+          CHANNEL_T *chan = m_channels[i];
+
+          if (chan && (!next || chan->due < next))
+            next = chan->due;
+        }
+
+      its.it_interval.tv_sec = 0;
+      its.it_interval.tv_nsec = 0;
+      its.it_value.tv_sec = next / 1000000000;
+      its.it_value.tv_nsec = next % 1000000000;
+
+      timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &its, NULL);
+
+      if (poll(fds, 2, -1) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          cerr << __FUNCTION__ << ": poll() failed" << endl;
+          break;
+        }
+
+      uint64_t count;
+
+      if (fds[0].revents & POLLIN)
+        ::read(m_timerFd, &count, sizeof(count));
+
+      uint64_t now = getNanos();
+
+      if (fds[1].revents & POLLIN)
+        {
+          ::read(m_wakeFd, &count, sizeof(count));
+
+          if (!m_running)
+            break;
+
+          for (unsigned int i = 0; i < m_channels.size(); i++)
+            {
+              CHANNEL_T *chan = m_channels[i];
+
+              if (chan && chan->periodChanged)
+                {
+                  __sync_synchronize();
+                  chan->period = chan->newPeriod;
+                  chan->periodChanged = false;
+                  chan->due = now;
+                }
+            }
+        }
+
+      for (unsigned int i = 0; i < m_channels.size(); i++)
+        {
+          CHANNEL_T *chan = m_channels[i];
+
+          if (chan && chan->due <= now)
+            sample(i, chan);
+        }
+    }
+}
+
+// called from the acquisition thread only
+void AioAcquisition::sample(int index, CHANNEL_T *chan)
+{
+  uint64_t start = getNanos();
+  int val = mraa_aio_read(chan->aio);
+  int64_t latency = (int64_t)(start - chan->due);
+
+  // schedule the next sample from the ideal time, not the actual one,
+  // so reading time does not accumulate.  Slots that are already
+  // past are skipped rather than taken back to back.
+  uint64_t periodNs = (uint64_t)chan->period * 1000;
+  uint64_t skipped = 0;
+
+  chan->due += periodNs;
+  if (chan->due <= start)
+    {
+      skipped = (start - chan->due) / periodNs + 1;
+      chan->due += skipped * periodNs;
+    }
+
+  if (val < 0)
+    return;
+
+  SAMPLE_T s;
+  s.timestamp = start;
+  s.value = (uint16_t)val;
+
+  // the ring is single producer/single consumer: publish the slot
+  // before the head that makes it visible.  Without a ring only the
+  // latest sample is published, nothing is dropped.
+  unsigned int head = chan->head;
+  bool hasRing = !chan->ring.empty();
+  bool full = hasRing && (head - chan->tail) > chan->ringMask;
+
+  if (hasRing && !full)
+    {
+      chan->ring[head & chan->ringMask] = s;
+      __sync_synchronize();
+      chan->head = head + 1;
+    }
+
+  chan->seq++;
+  __sync_synchronize();
+
+  if (chan->resetPending)
+    {
+      chan->latencySum = 0.0;
+      chan->latencySumSq = 0.0;
+      chan->stats.samples = 0;
+      chan->stats.overruns = 0;
+      chan->stats.overflows = 0;
+      chan->resetPending = false;
+    }
+
+  STATS_T *st = &chan->stats;
+
+  if (!st->samples || latency < st->minLatency)
+    st->minLatency = latency;
+  if (!st->samples || latency > st->maxLatency)
+    st->maxLatency = latency;
+
+  st->samples++;
+  st->overruns += skipped;
+  if (full)
+    st->overflows++;
+
+  chan->latencySum += (double)latency;
+  chan->latencySumSq += (double)latency * (double)latency;
+
+  st->meanLatency = chan->latencySum / st->samples;
+
+  double var = chan->latencySumSq / st->samples -
+    st->meanLatency * st->meanLatency;
+  st->jitter = (var > 0.0) ? sqrt(var) : 0.0;
+
+  chan->latest = s;
+  chan->sampled = true;
+
+  __sync_synchronize();
+  chan->seq++;
+
+  if (chan->handler)
+    chan->handler(index, &s, chan->handlerCtx);
+}
+
+int AioAcquisition::available(int channel)
+{
+  CHANNEL_T *chan = this->channel(channel);
+
+  return chan->head - chan->tail;
+}
+
+int AioAcquisition::read(int channel, SAMPLE_T *samples, int max)
+{
+  CHANNEL_T *chan = this->channel(channel);
+  unsigned int head = chan->head;
+  unsigned int tail = chan->tail;
+  int count = 0;
+
+  // see the slots the head covers before copying them
+  __sync_synchronize();
+
+  while (tail != head && count < max)
+    samples[count++] = chan->ring[tail++ & chan->ringMask];
+
+  // finish copying before the slots are handed back
+  __sync_synchronize();
+  chan->tail = tail;
+
+  return count;
+}
+
+int AioAcquisition::readValues(int channel, uint16_t *values, int max)
+{
+  CHANNEL_T *chan = this->channel(channel);
+  unsigned int head = chan->head;
+  unsigned int tail = chan->tail;
+  int count = 0;
+
+  __sync_synchronize();
+
+  while (tail != head && count < max)
+    values[count++] = chan->ring[tail++ & chan->ringMask].value;
+
+  __sync_synchronize();
+  chan->tail = tail;
+
+  return count;
+}
+
+void AioAcquisition::flush(int channel)
+{
+  CHANNEL_T *chan = this->channel(channel);
+
+  chan->tail = chan->head;
+}
+
+bool AioAcquisition::waitSamples(int channel, int count, unsigned int millis)
+{
+  CHANNEL_T *chan = this->channel(channel);
+
+  if (chan->ring.empty())
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": channel has no ring");
+      return false;
+    }
+
+  // the ring can never hold more than its size
+  if (count > (int)(chan->ringMask + 1))
+    count = chan->ringMask + 1;
+
+  uint64_t deadline = getNanos() + (uint64_t)millis * 1000000;
+
+  while (true)
+    {
+      int avail = chan->head - chan->tail;
+
+      if (avail >= count)
+        return true;
+
+      uint64_t now = getNanos();
+
+      if (!m_running || now >= deadline)
+        return false;
+
+      // sleep until the missing samples should have arrived
+      uint64_t wait = (uint64_t)(count - avail) * getPeriod(channel) * 1000;
+
+      if (wait > deadline - now)
+        wait = deadline - now;
+
+      struct timespec ts;
+      ts.tv_sec = wait / 1000000000;
+      ts.tv_nsec = wait % 1000000000;
+
+      nanosleep(&ts, NULL);
+    }
+}
+
+int AioAcquisition::readWindow(int channel, uint16_t *values, int count)
+{
+  CHANNEL_T *chan = this->channel(channel);
+
+  if (chan->ring.empty())
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": channel has no ring");
+      return 0;
+    }
+
+  flush(channel);
+
+  // collect in pieces of half a ring so the thread never finds it full
+  int piece = (chan->ringMask + 1) / 2;
+  int got = 0;
+
+  while (got < count)
+    {
+      int want = count - got;
+
+      if (want > piece)
+        want = piece;
+
+      // allow twice the expected time before giving up
+      unsigned int millis = (uint64_t)want * getPeriod(channel) * 2 / 1000 + 100;
+      bool ok = waitSamples(channel, want, millis);
+
+      got += readValues(channel, values + got, count - got);
+
+      if (!ok)
+        break;
+    }
+
+  return got;
+}
+
+bool AioAcquisition::getLatest(int channel, SAMPLE_T *sample)
+{
+  CHANNEL_T *chan = this->channel(channel);
+  unsigned int seq;
+  bool sampled;
+
+  // retry until no sample was published during the copy
+  do
+    {
+      while ((seq = chan->seq) & 1)
+        ;
+      __sync_synchronize();
+      sampled = chan->sampled;
+      *sample = chan->latest;
+      __sync_synchronize();
+    }
+  while (seq != chan->seq);
+
+  return sampled;
+}
+
+void AioAcquisition::getStats(int channel, STATS_T *stats)
+{
+  CHANNEL_T *chan = this->channel(channel);
+  unsigned int seq;
+
+  do
+    {
+      while ((seq = chan->seq) & 1)
+        ;
+      __sync_synchronize();
+      *stats = chan->stats;
+      __sync_synchronize();
+    }
+  while (seq != chan->seq);
+}
+
+void AioAcquisition::resetStats(int channel)
+{
+  pthread_mutex_lock(&m_lock);
+
+  CHANNEL_T *chan;
+  try
+    {
+      chan = this->channel(channel);
+    }
+  catch (...)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw;
+    }
+
+  // the thread owns the statistics while it runs
+  if (m_running)
+    chan->resetPending = true;
+  else
+    {
+      chan->seq++;
+      __sync_synchronize();
+      chan->latencySum = 0.0;
+      chan->latencySumSq = 0.0;
+      chan->stats.samples = 0;
+      chan->stats.overruns = 0;
+      chan->stats.overflows = 0;
+      chan->stats.minLatency = 0;
+      chan->stats.maxLatency = 0;
+      chan->stats.meanLatency = 0.0;
+      chan->stats.jitter = 0.0;
+      __sync_synchronize();
+      chan->seq++;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+}
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <vector>
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <mraa/aio.h>
+
+// default number of samples held in each channel ring (power of 2)
+#define AIOACQUIRE_RING_SIZE 1024
+
+namespace upm {
+  /**
+   * @brief Fixed rate analog acquisition engine
+   * @defgroup aioacquire libupm-aioacquire
+   * @ingroup analog
+   */
+
+  /**
+   * @library aioacquire
+   * @sensor aioacquire
+   * @comname Fixed rate analog acquisition
+   * @con analog
+   *
+   * @brief Timer driven AIO sampling shared by the analog drivers
+   *
+   * An AioAcquisition samples any number of AIO channels, each at its
+   * own period, from a single thread.  The thread sleeps on a
+   * CLOCK_MONOTONIC timerfd armed for the next sample that is due, so
+   * sample times do not drift with the time spent reading, and
+   * analog drivers no longer need a thread or a usleep() loop each.
+   *
+   * Every sample is timestamped and stored in a ring buffer for its
+   * channel.  The acquisition thread is the only writer and one
+   * consumer is the only reader, so the rings need no lock; when a
+   * ring is full new samples are dropped and counted.  Channels that
+   * only need the latest value can be added without a ring.  The
+   * most recent sample and the timing statistics of each channel are
+   * published through a sequence counter and can be read from any
+   * thread.
+   *
+   * The timing statistics compare the time each read started against
+   * the time it was scheduled for.  A sample that could not be taken
+   * before the next one was due is skipped and counted as an overrun.
+   *
+   * @snippet aioacquire.cxx Interesting
+   */
+  class AioAcquisition {
+  public:
+    // one sample
+    typedef struct {
+      uint64_t timestamp;               // CLOCK_MONOTONIC, nanoseconds
+      uint16_t value;                   // raw ADC value
+    } SAMPLE_T;
+
+    // sampling statistics of a channel
+    typedef struct {
+      uint64_t samples;                 // samples taken
+      uint64_t overruns;                // scheduled samples skipped
+      uint64_t overflows;               // samples dropped, ring full
+      int64_t  minLatency;              // earliest read vs. schedule, ns
+      int64_t  maxLatency;              // latest read vs. schedule, ns
+      double   meanLatency;             // mean lateness, ns
+      double   jitter;                  // standard deviation, ns
+    } STATS_T;
+
+    /**
+     * Sample callback.  Called from the acquisition thread after each
+     * sample of a channel has been stored; it must return well before
+     * the next sample is due.
+     *
+     * @param channel Channel the sample belongs to
+     * @param sample The sample
+     */
+    typedef void (*SAMPLE_HANDLER_T)(int channel, const SAMPLE_T *sample,
+                                     void *ctx);
+
+    /**
+     * AioAcquisition constructor.  No thread runs until start() is
+     * called.
+     */
+    AioAcquisition();
+
+    /**
+     * AioAcquisition destructor.  Stops the acquisition thread and
+     * closes the AIO contexts it opened.
+     */
+    ~AioAcquisition();
+
+    /**
+     * Adds a channel on an AIO pin.  The context is opened and owned
+     * by the engine.  If the engine is running it is stopped while
+     * the channel is added.
+     *
+     * @param pin AIO pin to sample
+     * @param periodUs Sample period in microseconds
+     * @param ringSize Number of samples held in the ring, rounded up
+     * to a power of 2, or 0 for a channel that only publishes its
+     * latest sample
+     * @param handler Optional callback run for every sample
+     * @param ctx Argument passed to the callback
+     * @return Channel number
+     */
+    int addChannel(int pin, unsigned int periodUs,
+                   int ringSize=AIOACQUIRE_RING_SIZE,
+                   SAMPLE_HANDLER_T handler=0, void *ctx=0);
+
+    /**
+     * Adds a channel on an AIO context that is already open.  The
+     * context remains owned by the caller and must stay open until
+     * the channel is removed.
+     *
+     * @param aio MRAA AIO context
+     * @param periodUs Sample period in microseconds
+     * @param ringSize Number of samples held in the ring, rounded up
+     * to a power of 2, or 0 for a channel that only publishes its
+     * latest sample
+     * @param handler Optional callback run for every sample
+     * @param ctx Argument passed to the callback
+     * @return Channel number
+     */
+    int addChannel(mraa_aio_context aio, unsigned int periodUs,
+                   int ringSize=AIOACQUIRE_RING_SIZE,
+                   SAMPLE_HANDLER_T handler=0, void *ctx=0);
+
+    /**
+     * Removes a channel.  If the engine is running it is stopped
+     * while the channel is removed.  The channel number may be reused
+     * by a later addChannel().
+     *
+     * @param channel Channel number
+     */
+    void removeChannel(int channel);
+
+    /**
+     * Changes the sample period of a channel.  The new period starts
+     * with the next sample.
+     *
+     * @param channel Channel number
+     * @param periodUs Sample period in microseconds
+     */
+    void setPeriod(int channel, unsigned int periodUs);
+
+    /**
+     * Returns the sample period of a channel
+     *
+     * @param channel Channel number
+     * @return Sample period in microseconds
+     */
+    unsigned int getPeriod(int channel);
+
+    /**
+     * Starts the acquisition thread, if it is not running
+     */
+    void start();
+
+    /**
+     * Stops the acquisition thread, if it is running
+     */
+    void stop();
+
+    /**
+     * Returns whether the acquisition thread is running
+     *
+     * @return True if running
+     */
+    bool isRunning() { return m_running; };
+
+    /**
+     * Returns the number of samples waiting in a channel ring
+     *
+     * @param channel Channel number
+     * @return Number of samples available
+     */
+    int available(int channel);
+
+    /**
+     * Removes samples from a channel ring
+     *
+     * @param channel Channel number
+     * @param samples Array to hold the samples
+     * @param max Size of the array
+     * @return Number of samples stored
+     */
+    int read(int channel, SAMPLE_T *samples, int max);
+
+    /**
+     * Removes samples from a channel ring, without their timestamps
+     *
+     * @param channel Channel number
+     * @param values Array to hold the values
+     * @param max Size of the array
+     * @return Number of values stored
+     */
+    int readValues(int channel, uint16_t *values, int max);
+
+    /**
+     * Discards the samples waiting in a channel ring
+     *
+     * @param channel Channel number
+     */
+    void flush(int channel);
+
+    /**
+     * Waits for samples to arrive in a channel ring.  The caller
+     * sleeps until the samples are expected rather than polling.
+     * The channel must have a ring.
+     *
+     * @param channel Channel number
+     * @param count Number of samples to wait for
+     * @param millis Number of milliseconds to wait
+     * @return True if at least count samples are in the ring
+     */
+    bool waitSamples(int channel, int count, unsigned int millis);
+
+    /**
+     * Discards the samples waiting in a channel ring, then collects
+     * the next count samples.  Counts larger than the ring are
+     * collected as they arrive.  The channel must have a ring.
+     *
+     * @param channel Channel number
+     * @param values Array to hold count values
+     * @param count Number of values to collect
+     * @return Number of values stored, less than count if the engine
+     * stopped or the samples did not arrive in time
+     */
+    int readWindow(int channel, uint16_t *values, int count);
+
+    /**
+     * Returns the most recent sample of a channel.  This does not
+     * consume anything from the ring.
+     *
+     * @param channel Channel number
+     * @param sample Pointer to hold the sample
+     * @return True if the channel has been sampled at all
+     */
+    bool getLatest(int channel, SAMPLE_T *sample);
+
+    /**
+     * Returns the sampling statistics of a channel
+     *
+     * @param channel Channel number
+     * @param stats Pointer to hold the statistics
+     */
+    void getStats(int channel, STATS_T *stats);
+
+    /**
+     * Clears the sampling statistics of a channel
+     *
+     * @param channel Channel number
+     */
+    void resetStats(int channel);
+
+    /**
+     * Returns the current CLOCK_MONOTONIC time
+     *
+     * @return Time in nanoseconds
+     */
+    static uint64_t getNanos();
+
+  private:
+    typedef struct {
+      mraa_aio_context aio;
+      bool owned;
+      unsigned int period;              // microseconds
+      uint64_t due;
+
+      // set by setPeriod() while running, applied by the thread
+      volatile unsigned int newPeriod;
+      volatile bool periodChanged;
+
+      // written by the acquisition thread only, empty for a channel
+      // without a ring
+      std::vector<SAMPLE_T> ring;
+      unsigned int ringMask;
+      volatile unsigned int head;
+      // written by the consumer only
+      volatile unsigned int tail;
+
+      SAMPLE_HANDLER_T handler;
+      void *handlerCtx;
+
+      // sums behind the published statistics
+      double latencySum;
+      double latencySumSq;
+      volatile bool resetPending;
+
+      // published through seq
+      volatile unsigned int seq;
+      bool sampled;
+      SAMPLE_T latest;
+      STATS_T stats;
+    } CHANNEL_T;
+
+    static void *acquireThread(void *ctx);
+    void acquire();
+    void sample(int index, CHANNEL_T *chan);
+    void wake();
+    int addChannel(mraa_aio_context aio, bool owned, unsigned int periodUs,
+                   int ringSize, SAMPLE_HANDLER_T handler, void *ctx);
+    CHANNEL_T *channel(int channel);
+    void startLocked();
+    void stopLocked();
+
+    std::vector<CHANNEL_T *> m_channels;
+
+    int m_timerFd;
+    // wakes the thread to stop or apply new periods
+    int m_wakeFd;
+    volatile bool m_running;
+    pthread_t m_thread;
+
+    // serializes channel changes and start()/stop()
+    pthread_mutex_t m_lock;
+  };
+}
@@ -0,0 +1,20 @@
+%module javaupm_aioacquire
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "aioacquire.h"
+%}
+
+%include "aioacquire.h"
+
+%pragma(java) jniclasscode=%{
+    static {
+        try {
+            System.loadLibrary("javaupm_aioacquire");
+        } catch (UnsatisfiedLinkError e) {
+            System.err.println("Native code library failed to load. \n" + e);
+            System.exit(1);
+        }
+    }
+%}
@@ -0,0 +1,9 @@
+%module jsupm_aioacquire
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "aioacquire.h"
+%}
+
+%include "aioacquire.h"
@@ -34,12 +34,22 @@
 
 using namespace upm;
 
+static uint64_t getMonotonicUs()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
 char g_name[] = AM2315_NAME;
 
 AM2315::AM2315(int bus, int devAddr) {
     m_temperature = 0;
     m_humidity    = 0;
     m_last_time = 0;
+    m_convState = 0;
+    m_convDeadline = 0;
 
     m_name = g_name;
 
@@ -90,6 +100,59 @@ AM2315::update_values(void)
     }
 }
 
+bool
+AM2315::startConversion(void)
+{
+    time_t ctime = time(NULL);
+
+    // In case the time is changed - backwards
+    if (ctime < m_last_time)
+        m_last_time = ctime;
+
+    if (m_last_time && (ctime - m_last_time) < AM2315_SAMPLE) {
+        m_convState = 2;
+        return true;
+    }
+
+    if (i2cReadRequest(AM2315_HUMIDITY, 4) < 0) {
+        m_convState = 0;
+        return false;
+    }
+
+    m_convDeadline = getMonotonicUs() + AM2315_RESPONSE_US;
+    m_convState = 1;
+
+    return true;
+}
+
+bool
+AM2315::conversionReady(void)
+{
+    if (m_convState == 2)
+        return true;
+
+    return (m_convState == 1 && getMonotonicUs() >= m_convDeadline);
+}
+
+bool
+AM2315::collect(void)
+{
+    if (!conversionReady())
+        return false;
+
+    if (m_convState == 1) {
+        uint8_t data[4];
+
+        i2cReadResponse(data, 4);
+        m_humidity = ((uint16_t)data[0] << 8) | data[1];
+        m_temperature = ((uint16_t)data[2] << 8) | data[3];
+        m_last_time = time(NULL);
+    }
+
+    m_convState = 0;
+    return true;
+}
+
 float
 AM2315::getTemperature(void)
 {
@@ -233,7 +296,19 @@ AM2315::i2cWriteReg(uint8_t reg, uint8_t* data, uint8_t ilen)
 uint8_t
 AM2315::i2cReadReg(int reg, uint8_t* data, int ilen)
 {
-    uint8_t tdata[16] = { AM2315_READ, reg, ilen };
+    if (i2cReadRequest(reg, ilen) < 0)
+        return -1;
+
+    usleep(AM2315_RESPONSE_US);
+    i2cReadResponse(data, ilen);
+
+    return 0;
+}
+
+int
+AM2315::i2cReadRequest(int reg, int ilen)
+{
+    uint8_t tdata[3] = { AM2315_READ, reg, ilen };
 
     mraa_result_t ret = mraa_i2c_address(m_i2ControlCtx, m_controlAddr);
     int iLoops = 5;
@@ -242,12 +317,23 @@ AM2315::i2cReadReg(int reg, uint8_t* data, int ilen)
         ret = mraa_i2c_write(m_i2ControlCtx, tdata, 3);
         usleep(800);
     } while(ret != MRAA_SUCCESS && --iLoops);
+    mraa_set_priority(m_base_priority);
+
     if (ret != MRAA_SUCCESS) {
         fprintf(stdout, "%s: Error, timeout reading sensor.\n", m_name);
-        mraa_set_priority(m_base_priority);
         return -1;
     }
-    usleep(5000);
+
+    return 0;
+}
+
+int
+AM2315::i2cReadResponse(uint8_t* data, int ilen)
+{
+    uint8_t tdata[16];
+
+    mraa_i2c_address(m_i2ControlCtx, m_controlAddr);
+    mraa_set_priority(HIGH_PRIORITY);
     mraa_i2c_read(m_i2ControlCtx, tdata, ilen+4);
     mraa_set_priority(m_base_priority);
 
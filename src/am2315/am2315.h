@@ -44,6 +44,7 @@
 #define AM2315_USER_B   0x12
 
 #define AM2315_SAMPLE   2
+#define AM2315_RESPONSE_US 5000 /* request to response delay */
 
 #define HIGH_PRIORITY   99
 
@@ -74,6 +75,10 @@ namespace upm {
  * The sampling period of this sensor is 2 seconds. Reads occurring
  * more often than that return cached data.
  *
+ * A reading can also be split with startConversion(),
+ * conversionReady() and collect(), so that the wake-up/measurement
+ * delay of several sensors can overlap.
+ *
  * @image html am2315.jpeg
  * @snippet am2315.cxx Interesting
  */
@@ -117,6 +122,44 @@ class AM2315 {
          */
         float getTemperatureF(void);
 
+        /**
+         * Sends the request for a humidity/temperature reading and
+         * returns without waiting for the answer.  If the last reading
+         * is less than 2 seconds old, nothing is sent and collect()
+         * keeps the cached data.
+         *
+         * @return True if successful
+         */
+        bool startConversion(void);
+
+        /**
+         * Checks whether the reading requested by startConversion()
+         * can be fetched
+         *
+         * @return True if collect() can be called
+         */
+        bool conversionReady(void);
+
+        /**
+         * Fetches the reading requested by startConversion().  The
+         * values are then available from getLastHumidity() and
+         * getLastTemperature().
+         *
+         * @return True if a result was collected, false if the
+         * reading is not ready or none was requested
+         */
+        bool collect(void);
+
+        /**
+         * Returns the humidity from the last collect() [RH]
+         */
+        float getLastHumidity(void) { return (float)m_humidity / 10; };
+
+        /**
+         * Returns the temperature from the last collect() [degC]
+         */
+        float getLastTemperature(void) { return (float)m_temperature / 10; };
+
         /**
          * Function intended to test the device and verify it
          * is operating correctly.
@@ -184,6 +227,8 @@ class AM2315 {
 
         void update_values(void);
         uint8_t i2cReadReg(int reg, uint8_t* data, int ilen);
+        int i2cReadRequest(int reg, int ilen);
+        int i2cReadResponse(uint8_t* data, int ilen);
         int i2cWriteReg(uint8_t reg, uint8_t* data, uint8_t ilen);
         uint16_t crc16(uint8_t* ptr, uint8_t len);
 
@@ -196,6 +241,10 @@ class AM2315 {
 
         time_t    m_last_time;
 
+        // 0 = idle, 1 = request sent, 2 = using cached data
+        int       m_convState;
+        uint64_t  m_convDeadline;
+
         int       m_base_priority;
         pthread_t this_thread;
 };
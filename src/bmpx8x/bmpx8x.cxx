@@ -27,14 +27,29 @@
 #include <stdexcept>
 #include <unistd.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "bmpx8x.h"
 
 using namespace upm;
 
+static uint64_t getMonotonicUs()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
 BMPX8X::BMPX8X (int bus, int devAddr, uint8_t mode) : m_controlAddr(devAddr), m_i2ControlCtx(bus) {
  
     m_name = "BMPX8X";
+
+    m_convState = CONV_IDLE;
+    m_convDeadline = 0;
+    m_UT = 0;
+    m_pressure = 0;
+    m_temperature = 0.0;
  
     mraa::Result ret = m_i2ControlCtx.address(m_controlAddr);
     if (ret != mraa::SUCCESS) {
@@ -72,11 +87,71 @@ BMPX8X::BMPX8X (int bus, int devAddr, uint8_t mode) : m_controlAddr(devAddr), m_
 
 int32_t
 BMPX8X::getPressure () {
-    int32_t UT, UP, B3, B5, B6, X1, X2, X3, p;
+    if (!startConversion()) {
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": unable to start conversion");
+        return 0;
+    }
+
+    while (!collect()) {
+        uint64_t now = getMonotonicUs();
+        if (now < m_convDeadline)
+            usleep(m_convDeadline - now);
+    }
+
+    return m_pressure;
+}
+
+bool
+BMPX8X::startConversion () {
+    if (i2cWriteReg (BMP085_CONTROL, BMP085_READTEMPCMD) != mraa::SUCCESS)
+        return false;
+
+    m_convDeadline = getMonotonicUs() + BMP085_TEMP_CONV_US;
+    m_convState = CONV_TEMPERATURE;
+
+    return true;
+}
+
+bool
+BMPX8X::conversionReady () {
+    if (m_convState == CONV_IDLE || getMonotonicUs() < m_convDeadline)
+        return false;
+
+    if (m_convState == CONV_TEMPERATURE) {
+        // temperature is done, move on to the pressure conversion
+        m_UT = i2cReadReg_16 (BMP085_TEMPDATA);
+
+        i2cWriteReg (BMP085_CONTROL,
+                     BMP085_READPRESSURECMD + (oversampling << 6));
+        m_convDeadline = getMonotonicUs() + pressureConvTime();
+        m_convState = CONV_PRESSURE;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool
+BMPX8X::collect () {
+    if (!conversionReady())
+        return false;
+
+    int32_t UP = readPressureData();
+    m_convState = CONV_IDLE;
+
+    m_pressure = computePressure(m_UT, UP);
+    m_temperature = (float)((computeB5(m_UT) + 8) >> 4) / 10;
+
+    return true;
+}
+
+int32_t
+BMPX8X::computePressure (int32_t UT, int32_t UP) {
+    int32_t B3, B5, B6, X1, X2, X3, p;
     uint32_t B4, B7;
 
-    UT = getTemperatureRaw();
-    UP = getPressureRaw();
     B5 = computeB5(UT);
 
     // do pressure calcs
@@ -108,19 +183,28 @@ BMPX8X::getPressure () {
 
 int32_t
 BMPX8X::getPressureRaw () {
-    uint32_t raw;
-
     i2cWriteReg (BMP085_CONTROL, BMP085_READPRESSURECMD + (oversampling << 6));
+    usleep(pressureConvTime());
+
+    return readPressureData();
+}
 
+int
+BMPX8X::pressureConvTime () {
     if (oversampling == BMP085_ULTRALOWPOWER) {
-        usleep(5000);
+        return 5000;
     } else if (oversampling == BMP085_STANDARD) {
-        usleep(8000);
+        return 8000;
     } else if (oversampling == BMP085_HIGHRES) {
-        usleep(14000);
+        return 14000;
     } else {
-        usleep(26000);
+        return 26000;
     }
+}
+
+int32_t
+BMPX8X::readPressureData () {
+    uint32_t raw;
 
     raw = i2cReadReg_16 (BMP085_PRESSUREDATA);
 
@@ -134,7 +218,7 @@ BMPX8X::getPressureRaw () {
 int16_t
 BMPX8X::getTemperatureRaw () {
     i2cWriteReg (BMP085_CONTROL, BMP085_READTEMPCMD);
-    usleep(5000);
+    usleep(BMP085_TEMP_CONV_US);
     return i2cReadReg_16 (BMP085_TEMPDATA);
 }
 
@@ -56,6 +56,8 @@
 #define BMP085_READTEMPCMD       0x2E
 #define BMP085_READPRESSURECMD   0x34
 
+#define BMP085_TEMP_CONV_US      5000  // worst case temperature conversion
+
 #define HIGH               1
 #define LOW                0
 
@@ -84,6 +86,10 @@ namespace upm {
  *
  * This module has been tested on the GY65/BMP085 and BMP180 sensors.
  *
+ * Besides the blocking getters, a measurement can be split in
+ * phases with startConversion(), conversionReady() and collect(),
+ * so that one thread can run conversions on many sensors at once.
+ *
  * @image html bmp085.jpeg
  * @snippet bmpx8x.cxx Interesting
  */
@@ -127,6 +133,44 @@ class BMPX8X {
          */
         float getTemperature ();
 
+        /**
+         * Starts a temperature + pressure measurement and returns
+         * immediately.  Call conversionReady() until it returns true,
+         * then collect().
+         *
+         * @return True if the conversion was started
+         */
+        bool startConversion ();
+
+        /**
+         * Checks whether the measurement started by startConversion()
+         * has finished.  The temperature result is read and the
+         * pressure conversion started from here once it is due.
+         *
+         * @return True if collect() can be called
+         */
+        bool conversionReady ();
+
+        /**
+         * Reads and compensates the result of a finished measurement.
+         * The values are then available from getLastPressure() and
+         * getLastTemperature().
+         *
+         * @return True if a result was collected, false if the
+         * measurement is still in progress or none was started
+         */
+        bool collect ();
+
+        /**
+         * Returns the pressure from the last collect() [Pa]
+         */
+        int32_t getLastPressure () { return m_pressure; };
+
+        /**
+         * Returns the temperature from the last collect() [degC]
+         */
+        float getLastTemperature () { return m_temperature; };
+
         /**
          * With a given absolute altitude, sea level can be calculated
          *
@@ -171,12 +215,28 @@ class BMPX8X {
         uint8_t i2cReadReg_8 (int reg);
 
     private:
+        typedef enum {
+            CONV_IDLE = 0,
+            CONV_TEMPERATURE,
+            CONV_PRESSURE
+        } CONV_STATE_T;
+
+        int pressureConvTime ();
+        int32_t readPressureData ();
+        int32_t computePressure (int32_t UT, int32_t UP);
+
         std::string m_name;
 
         int m_controlAddr;
         int m_bus;
         mraa::I2c m_i2ControlCtx;
 
+        CONV_STATE_T m_convState;
+        uint64_t m_convDeadline;
+        int32_t m_UT;
+        int32_t m_pressure;
+        float m_temperature;
+
         uint8_t oversampling;
         int16_t ac1, ac2, ac3, b1, b2, mb, mc, md;
         uint16_t ac4, ac5, ac6;
@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <string.h>
+#include <math.h>
+
+#include "dsp.h"
+
+using namespace upm;
+
+// 4 float lanes.  GCC lowers these to SSE/NEON where available and
+// to scalar code elsewhere; memcpy keeps the loads alignment-safe.
+typedef float v4sf __attribute__ ((vector_size (16)));
+typedef int v4si __attribute__ ((vector_size (16)));
+typedef unsigned int v4su __attribute__ ((vector_size (16)));
+typedef unsigned short v8hu __attribute__ ((vector_size (16)));
+
+static inline v4sf load4(const float *p)
+{
+  v4sf v;
+
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void store4(float *p, v4sf v)
+{
+  memcpy(p, &v, sizeof(v));
+}
+
+static inline v4sf splat4(float f)
+{
+  v4sf v = { f, f, f, f };
+
+  return v;
+}
+
+static inline float hsum4(v4sf v)
+{
+  float f[4];
+
+  store4(f, v);
+  return (f[0] + f[1]) + (f[2] + f[3]);
+}
+
+// lane-wise select, mask lanes are all ones or all zeros
+static inline v4sf select4(v4si mask, v4sf a, v4sf b)
+{
+  return (v4sf)(((v4si)a & mask) | ((v4si)b & ~mask));
+}
+
+void Dsp::toFloat(const uint16_t *in, float *out, int count, float scale,
+                  float offset)
+{
+  for (int i = 0; i < count; i++)
+    out[i] = (float)in[i] * scale + offset;
+}
+
+float Dsp::sum(const float *in, int count)
+{
+  // two accumulators so consecutive adds do not wait on each other
+  v4sf acc0 = splat4(0.0);
+  v4sf acc1 = splat4(0.0);
+  int i = 0;
+
+  for (; i + 8 <= count; i += 8)
+    {
+      acc0 += load4(in + i);
+      acc1 += load4(in + i + 4);
+    }
+
+  float total = hsum4(acc0 + acc1);
+
+  for (; i < count; i++)
+    total += in[i];
+
+  return total;
+}
+
+uint64_t Dsp::sum(const uint16_t *in, int count)
+{
+  const v4su lowMask = { 0xffff, 0xffff, 0xffff, 0xffff };
+  uint64_t total = 0;
+  int i = 0;
+
+  // 8 samples seen as 4 pairs; the low and high halves are added
+  // separately into 32 bit lanes, which are flushed to the 64 bit
+  // total before they can overflow
+  while (i + 8 <= count)
+    {
+      v4su acc = { 0, 0, 0, 0 };
+      int end = i + 8 * 16384;
+
+      if (end > count)
+        end = count;
+
+      for (; i + 8 <= end; i += 8)
+        {
+          v4su v;
+
+          memcpy(&v, in + i, sizeof(v));
+          acc += (v & lowMask) + (v >> 16);
+        }
+
+      unsigned int a[4];
+      memcpy(a, &acc, sizeof(a));
+      total += (uint64_t)a[0] + a[1] + a[2] + a[3];
+    }
+
+  for (; i < count; i++)
+    total += in[i];
+
+  return total;
+}
+
+float Dsp::mean(const float *in, int count)
+{
+  if (count <= 0)
+    return 0.0;
+
+  return sum(in, count) / count;
+}
+
+float Dsp::sumSquares(const float *in, int count)
+{
+  v4sf acc0 = splat4(0.0);
+  v4sf acc1 = splat4(0.0);
+  int i = 0;
+
+  for (; i + 8 <= count; i += 8)
+    {
+      v4sf a = load4(in + i);
+      v4sf b = load4(in + i + 4);
+
+      acc0 += a * a;
+      acc1 += b * b;
+    }
+
+  float total = hsum4(acc0 + acc1);
+
+  for (; i < count; i++)
+    total += in[i] * in[i];
+
+  return total;
+}
+
+float Dsp::rms(const float *in, int count)
+{
+  if (count <= 0)
+    return 0.0;
+
+  return sqrtf(sumSquares(in, count) / count);
+}
+
+float Dsp::rmsAC(const float *in, int count)
+{
+  if (count <= 0)
+    return 0.0;
+
+  float m = mean(in, count);
+  v4sf mv = splat4(m);
+  v4sf acc0 = splat4(0.0);
+  v4sf acc1 = splat4(0.0);
+  int i = 0;
+
+  for (; i + 8 <= count; i += 8)
+    {
+      v4sf a = load4(in + i) - mv;
+      v4sf b = load4(in + i + 4) - mv;
+
+      acc0 += a * a;
+      acc1 += b * b;
+    }
+
+  float total = hsum4(acc0 + acc1);
+
+  for (; i < count; i++)
+    total += (in[i] - m) * (in[i] - m);
+
+  return sqrtf(total / count);
+}
+
+void Dsp::peak(const float *in, int count, float *min, float *max)
+{
+  if (count <= 0)
+    {
+      *min = *max = 0.0;
+      return;
+    }
+
+  v4sf lo = splat4(in[0]);
+  v4sf hi = lo;
+  int i = 0;
+
+  for (; i + 4 <= count; i += 4)
+    {
+      v4sf v = load4(in + i);
+
+      lo = select4(v < lo, v, lo);
+      hi = select4(v > hi, v, hi);
+    }
+
+  float l[4], h[4];
+  store4(l, lo);
+  store4(h, hi);
+
+  float mn = l[0], mx = h[0];
+  for (int j = 1; j < 4; j++)
+    {
+      if (l[j] < mn)
+        mn = l[j];
+      if (h[j] > mx)
+        mx = h[j];
+    }
+
+  for (; i < count; i++)
+    {
+      if (in[i] < mn)
+        mn = in[i];
+      if (in[i] > mx)
+        mx = in[i];
+    }
+
+  *min = mn;
+  *max = mx;
+}
+
+void Dsp::peak(const uint16_t *in, int count, uint16_t *min,
+               uint16_t *max)
+{
+  if (count <= 0)
+    {
+      *min = *max = 0;
+      return;
+    }
+
+  uint16_t mn = in[0], mx = in[0];
+  int i = 0;
+
+  if (count >= 8)
+    {
+      v8hu lo, hi;
+
+      memcpy(&lo, in, sizeof(lo));
+      hi = lo;
+
+      for (i = 8; i + 8 <= count; i += 8)
+        {
+          v8hu v;
+
+          memcpy(&v, in + i, sizeof(v));
+          v8hu lt = (v8hu)(v < lo);
+          v8hu gt = (v8hu)(v > hi);
+
+          lo = (v & lt) | (lo & ~lt);
+          hi = (v & gt) | (hi & ~gt);
+        }
+
+      uint16_t l[8], h[8];
+      memcpy(l, &lo, sizeof(l));
+      memcpy(h, &hi, sizeof(h));
+
+      for (int j = 0; j < 8; j++)
+        {
+          if (l[j] < mn)
+            mn = l[j];
+          if (h[j] > mx)
+            mx = h[j];
+        }
+    }
+
+  for (; i < count; i++)
+    {
+      if (in[i] < mn)
+        mn = in[i];
+      if (in[i] > mx)
+        mx = in[i];
+    }
+
+  *min = mn;
+  *max = mx;
+}
+
+float Dsp::removeDC(float *data, int count)
+{
+  float m = mean(data, count);
+  v4sf mv = splat4(m);
+  int i = 0;
+
+  for (; i + 4 <= count; i += 4)
+    store4(data + i, load4(data + i) - mv);
+
+  for (; i < count; i++)
+    data[i] -= m;
+
+  return m;
+}
+
+DCBlocker::DCBlocker(float pole)
+{
+  m_pole = pole;
+  reset();
+}
+
+void DCBlocker::reset()
+{
+  m_lastIn = 0.0;
+  m_lastOut = 0.0;
+}
+
+void DCBlocker::process(const float *in, float *out, int count)
+{
+  // keep the state in locals so it stays in registers
+  float pole = m_pole;
+  float x1 = m_lastIn;
+  float y1 = m_lastOut;
+
+  for (int i = 0; i < count; i++)
+    {
+      float x = in[i];
+
+      y1 = pole * (y1 + x - x1);
+      x1 = x;
+      out[i] = y1;
+    }
+
+  m_lastIn = x1;
+  m_lastOut = y1;
+}
+
+void DCBlocker::process(const uint16_t *in, float *out, int count)
+{
+  float pole = m_pole;
+  float x1 = m_lastIn;
+  float y1 = m_lastOut;
+
+  for (int i = 0; i < count; i++)
+    {
+      float x = (float)in[i];
+
+      y1 = pole * (y1 + x - x1);
+      x1 = x;
+      out[i] = y1;
+    }
+
+  m_lastIn = x1;
+  m_lastOut = y1;
+}
+
+Biquad::Biquad()
+{
+  setCoefficients(1.0, 0.0, 0.0, 1.0, 0.0, 0.0);
+  reset();
+}
+
+void Biquad::reset()
+{
+  m_z1 = 0.0;
+  m_z2 = 0.0;
+}
+
+void Biquad::setCoefficients(float b0, float b1, float b2,
+                             float a0, float a1, float a2)
+{
+  m_b0 = b0 / a0;
+  m_b1 = b1 / a0;
+  m_b2 = b2 / a0;
+  m_a1 = a1 / a0;
+  m_a2 = a2 / a0;
+}
+
+void Biquad::setLowPass(float sampleRate, float freq, float q)
+{
+  float w0 = 2.0 * M_PI * freq / sampleRate;
+  float c = cosf(w0);
+  float alpha = sinf(w0) / (2.0 * q);
+
+  setCoefficients((1.0 - c) / 2.0, 1.0 - c, (1.0 - c) / 2.0,
+                  1.0 + alpha, -2.0 * c, 1.0 - alpha);
+}
+
+void Biquad::setHighPass(float sampleRate, float freq, float q)
+{
+  float w0 = 2.0 * M_PI * freq / sampleRate;
+  float c = cosf(w0);
+  float alpha = sinf(w0) / (2.0 * q);
+
+  setCoefficients((1.0 + c) / 2.0, -(1.0 + c), (1.0 + c) / 2.0,
+                  1.0 + alpha, -2.0 * c, 1.0 - alpha);
+}
+
+void Biquad::setBandPass(float sampleRate, float freq, float q)
+{
+  float w0 = 2.0 * M_PI * freq / sampleRate;
+  float c = cosf(w0);
+  float alpha = sinf(w0) / (2.0 * q);
+
+  setCoefficients(alpha, 0.0, -alpha, 1.0 + alpha, -2.0 * c, 1.0 - alpha);
+}
+
+void Biquad::process(const float *in, float *out, int count)
+{
+  float b0 = m_b0, b1 = m_b1, b2 = m_b2, a1 = m_a1, a2 = m_a2;
+  float z1 = m_z1, z2 = m_z2;
+
+  for (int i = 0; i < count; i++)
+    {
+      float x = in[i];
+      float y = b0 * x + z1;
+
+      z1 = b1 * x - a1 * y + z2;
+      z2 = b2 * x - a2 * y;
+      out[i] = y;
+    }
+
+  m_z1 = z1;
+  m_z2 = z2;
+}
+
+Goertzel::Goertzel(float sampleRate, const float *freqs, int count)
+{
+  init(sampleRate, freqs, count);
+}
+
+Goertzel::Goertzel(float sampleRate, float freq)
+{
+  init(sampleRate, &freq, 1);
+}
+
+void Goertzel::init(float sampleRate, const float *freqs, int count)
+{
+  if (count < 0)
+    count = 0;
+
+  m_tones = count;
+
+  // unused lanes get a coefficient of 0 and stay harmless
+  int lanes = (count + 3) & ~3;
+  m_coeff.assign(lanes, 0.0);
+  m_s1.assign(lanes, 0.0);
+  m_s2.assign(lanes, 0.0);
+
+  for (int i = 0; i < count; i++)
+    m_coeff[i] = 2.0 * cosf(2.0 * M_PI * freqs[i] / sampleRate);
+
+  m_samples = 0;
+}
+
+void Goertzel::reset()
+{
+  for (unsigned int i = 0; i < m_s1.size(); i++)
+    {
+      m_s1[i] = 0.0;
+      m_s2[i] = 0.0;
+    }
+
+  m_samples = 0;
+}
+
+void Goertzel::process(const float *in, int count)
+{
+  // 4 tones per pass: s = x + coeff * s1 - s2 in every lane
+  for (unsigned int t = 0; t < m_coeff.size(); t += 4)
+    {
+      v4sf coeff = load4(&m_coeff[t]);
+      v4sf s1 = load4(&m_s1[t]);
+      v4sf s2 = load4(&m_s2[t]);
+
+      for (int i = 0; i < count; i++)
+        {
+          v4sf s = splat4(in[i]) + coeff * s1 - s2;
+
+          s2 = s1;
+          s1 = s;
+        }
+
+      store4(&m_s1[t], s1);
+      store4(&m_s2[t], s2);
+    }
+
+  m_samples += count;
+}
+
+float Goertzel::power(int tone)
+{
+  if (tone < 0 || tone >= m_tones)
+    return 0.0;
+
+  float s1 = m_s1[tone];
+  float s2 = m_s2[tone];
+  float p = s1 * s1 + s2 * s2 - m_coeff[tone] * s1 * s2;
+
+  return (p > 0.0) ? p : 0.0;
+}
+
+float Goertzel::amplitude(int tone)
+{
+  if (!m_samples)
+    return 0.0;
+
+  return 2.0 * sqrtf(power(tone)) / m_samples;
+}
+
+EnvelopeFollower::EnvelopeFollower(float sampleRate, float attackMs,
+                                   float releaseMs)
+{
+  // one pole coefficients reaching 1 - 1/e after the time constant
+  m_attack = (attackMs > 0.0) ? expf(-1000.0 / (sampleRate * attackMs)) : 0.0;
+  m_release = (releaseMs > 0.0) ?
+    expf(-1000.0 / (sampleRate * releaseMs)) : 0.0;
+  m_env = 0.0;
+}
+
+float EnvelopeFollower::process(const float *in, float *out, int count)
+{
+  float attack = m_attack;
+  float release = m_release;
+  float env = m_env;
+
+  for (int i = 0; i < count; i++)
+    {
+      float x = fabsf(in[i]);
+      float k = (x > env) ? attack : release;
+
+      env = x + k * (env - x);
+      if (out)
+        out[i] = env;
+    }
+
+  m_env = env;
+
+  return env;
+}
@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace upm {
+  /**
+   * @brief Block signal processing kernels
+   * @defgroup dsp libupm-dsp
+   * @ingroup analog
+   */
+
+  /**
+   * @library dsp
+   * @sensor dsp
+   * @comname Block signal processing
+   * @con analog
+   *
+   * @brief Float kernels for processing blocks of analog samples
+   *
+   * The analog drivers use these to turn blocks of ADC samples into
+   * RMS values, levels and tones.  The stateless kernels (sums,
+   * RMS, peaks, DC removal) work 4 samples at a time using the
+   * compiler's vector extensions, which become SSE or NEON
+   * instructions where the target has them and plain scalar code
+   * where it does not.  The filters are recursive, so they run one
+   * sample at a time with their state held in registers for the
+   * whole block; Goertzel runs 4 tones side by side instead.
+   *
+   * Filter state carries over between calls, so a stream can be
+   * processed in blocks of any size with the same result as one
+   * long block.
+   *
+   * @snippet dsp-benchmark.cxx Interesting
+   */
+  class Dsp {
+  public:
+    /**
+     * Converts ADC samples to floats, out = in * scale + offset
+     *
+     * @param in Samples
+     * @param out Array of count floats
+     * @param count Number of samples
+     * @param scale Multiplier
+     * @param offset Value added after scaling
+     */
+    static void toFloat(const uint16_t *in, float *out, int count,
+                        float scale=1.0, float offset=0.0);
+
+    /**
+     * Returns the sum of a block
+     *
+     * @param in Samples
+     * @param count Number of samples
+     * @return Sum
+     */
+    static float sum(const float *in, int count);
+
+    /**
+     * Returns the sum of a block of ADC samples.  This is exact
+     * integer arithmetic, done 8 samples at a time.
+     *
+     * @param in Samples
+     * @param count Number of samples
+     * @return Sum
+     */
+    static uint64_t sum(const uint16_t *in, int count);
+
+    /**
+     * Returns the mean of a block
+     *
+     * @param in Samples
+     * @param count Number of samples
+     * @return Mean, or 0 for an empty block
+     */
+    static float mean(const float *in, int count);
+
+    /**
+     * Returns the sum of the squares of a block
+     *
+     * @param in Samples
+     * @param count Number of samples
+     * @return Sum of squares
+     */
+    static float sumSquares(const float *in, int count);
+
+    /**
+     * Returns the RMS value of a block
+     *
+     * @param in Samples
+     * @param count Number of samples
+     * @return RMS value, or 0 for an empty block
+     */
+    static float rms(const float *in, int count);
+
+    /**
+     * Returns the RMS value of a block around its mean, i.e. the RMS
+     * of the AC part of the signal.  The mean is removed first so a
+     * large DC bias does not cost precision.
+     *
+     * @param in Samples
+     * @param count Number of samples
+     * @return AC RMS value, or 0 for an empty block
+     */
+    static float rmsAC(const float *in, int count);
+
+    /**
+     * Finds the smallest and largest samples of a block
+     *
+     * @param in Samples
+     * @param count Number of samples, at least 1
+     * @param min Pointer to hold the smallest sample
+     * @param max Pointer to hold the largest sample
+     */
+    static void peak(const float *in, int count, float *min, float *max);
+
+    /**
+     * Finds the smallest and largest of a block of ADC samples, 8
+     * samples at a time
+     *
+     * @param in Samples
+     * @param count Number of samples, at least 1
+     * @param min Pointer to hold the smallest sample
+     * @param max Pointer to hold the largest sample
+     */
+    static void peak(const uint16_t *in, int count, uint16_t *min,
+                     uint16_t *max);
+
+    /**
+     * Subtracts the mean of a block from every sample
+     *
+     * @param data Samples, modified in place
+     * @param count Number of samples
+     * @return The mean that was removed
+     */
+    static float removeDC(float *data, int count);
+  };
+
+  /**
+   * @brief One pole DC blocking filter
+   *
+   * y[n] = pole * (y[n-1] + x[n] - x[n-1]).  The pole sets the corner
+   * frequency, about (1 - pole) * sampleRate / (2 * pi).
+   */
+  class DCBlocker {
+  public:
+    /**
+     * DCBlocker constructor
+     *
+     * @param pole Filter pole, just below 1
+     */
+    DCBlocker(float pole=0.995);
+
+    /**
+     * Filters a block.  in and out may be the same array.
+     *
+     * @param in Samples
+     * @param out Array of count floats for the result
+     * @param count Number of samples
+     */
+    void process(const float *in, float *out, int count);
+
+    /**
+     * Filters a block of ADC samples, converting them to float on
+     * the way
+     *
+     * @param in Samples
+     * @param out Array of count floats for the result
+     * @param count Number of samples
+     */
+    void process(const uint16_t *in, float *out, int count);
+
+    /**
+     * Clears the filter state
+     */
+    void reset();
+
+  private:
+    float m_pole;
+    float m_lastIn;
+    float m_lastOut;
+  };
+
+  /**
+   * @brief Second order IIR filter
+   *
+   * Transposed direct form II, with the low pass, high pass and band
+   * pass designs of the RBJ audio EQ cookbook.  A new Biquad passes
+   * its input through unchanged.
+   */
+  class Biquad {
+  public:
+    /**
+     * Biquad constructor
+     */
+    Biquad();
+
+    /**
+     * Makes the filter a low pass
+     *
+     * @param sampleRate Sample rate in Hz
+     * @param freq Corner frequency in Hz
+     * @param q Quality factor; 0.7071 is maximally flat
+     */
+    void setLowPass(float sampleRate, float freq, float q=0.7071);
+
+    /**
+     * Makes the filter a high pass
+     *
+     * @param sampleRate Sample rate in Hz
+     * @param freq Corner frequency in Hz
+     * @param q Quality factor; 0.7071 is maximally flat
+     */
+    void setHighPass(float sampleRate, float freq, float q=0.7071);
+
+    /**
+     * Makes the filter a band pass with unity gain at the center
+     *
+     * @param sampleRate Sample rate in Hz
+     * @param freq Center frequency in Hz
+     * @param q Quality factor, center frequency / bandwidth
+     */
+    void setBandPass(float sampleRate, float freq, float q);
+
+    /**
+     * Filters a block.  in and out may be the same array.
+     *
+     * @param in Samples
+     * @param out Array of count floats for the result
+     * @param count Number of samples
+     */
+    void process(const float *in, float *out, int count);
+
+    /**
+     * Clears the filter state
+     */
+    void reset();
+
+  private:
+    void setCoefficients(float b0, float b1, float b2,
+                         float a0, float a1, float a2);
+
+    float m_b0, m_b1, m_b2, m_a1, m_a2;
+    float m_z1, m_z2;
+  };
+
+  /**
+   * @brief Goertzel tone detector
+   *
+   * Measures the level of a set of tones over the samples processed
+   * since the last reset().  Tones are processed 4 at a time.
+   */
+  class Goertzel {
+  public:
+    /**
+     * Goertzel constructor
+     *
+     * @param sampleRate Sample rate in Hz
+     * @param freqs Tone frequencies in Hz
+     * @param count Number of tones
+     */
+    Goertzel(float sampleRate, const float *freqs, int count);
+
+    /**
+     * Goertzel constructor for a single tone
+     *
+     * @param sampleRate Sample rate in Hz
+     * @param freq Tone frequency in Hz
+     */
+    Goertzel(float sampleRate, float freq);
+
+    /**
+     * Adds a block of samples
+     *
+     * @param in Samples
+     * @param count Number of samples
+     */
+    void process(const float *in, int count);
+
+    /**
+     * Returns the power of a tone over the samples processed
+     *
+     * @param tone Index of the tone
+     * @return Squared magnitude of the DFT of the samples at the tone
+     */
+    float power(int tone);
+
+    /**
+     * Returns the amplitude of a tone over the samples processed.  A
+     * sine of amplitude A at the tone frequency gives A.
+     *
+     * @param tone Index of the tone
+     * @return Amplitude, in sample units
+     */
+    float amplitude(int tone);
+
+    /**
+     * Returns the number of samples processed since the last reset()
+     *
+     * @return Number of samples
+     */
+    int samples() { return m_samples; };
+
+    /**
+     * Starts a new measurement
+     */
+    void reset();
+
+  private:
+    void init(float sampleRate, const float *freqs, int count);
+
+    int m_tones;
+    int m_samples;
+    // padded to a multiple of 4 tones
+    std::vector<float> m_coeff;
+    std::vector<float> m_s1;
+    std::vector<float> m_s2;
+  };
+
+  /**
+   * @brief Envelope follower
+   *
+   * Tracks the level of a signal: the envelope rises towards |x| with
+   * the attack time constant and falls with the release time
+   * constant.
+   */
+  class EnvelopeFollower {
+  public:
+    /**
+     * EnvelopeFollower constructor
+     *
+     * @param sampleRate Sample rate in Hz
+     * @param attackMs Attack time constant in milliseconds
+     * @param releaseMs Release time constant in milliseconds
+     */
+    EnvelopeFollower(float sampleRate, float attackMs, float releaseMs);
+
+    /**
+     * Follows a block
+     *
+     * @param in Samples
+     * @param out Array of count floats for the envelope, or NULL if
+     * only the final value is needed
+     * @param count Number of samples
+     * @return Envelope after the last sample
+     */
+    float process(const float *in, float *out, int count);
+
+    /**
+     * Returns the current envelope
+     *
+     * @return Envelope
+     */
+    float value() { return m_env; };
+
+    /**
+     * Sets the envelope to 0
+     */
+    void reset() { m_env = 0.0; };
+
+  private:
+    float m_attack;
+    float m_release;
+    float m_env;
+  };
+}
@@ -0,0 +1,20 @@
+%module javaupm_dsp
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "dsp.h"
+%}
+
+%include "dsp.h"
+
+%pragma(java) jniclasscode=%{
+    static {
+        try {
+            System.loadLibrary("javaupm_dsp");
+        } catch (UnsatisfiedLinkError e) {
+            System.err.println("Native code library failed to load. \n" + e);
+            System.exit(1);
+        }
+    }
+%}
@@ -0,0 +1,9 @@
+%module jsupm_dsp
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "dsp.h"
+%}
+
+%include "dsp.h"
@@ -0,0 +1,13 @@
+// Include doxygen-generated documentation
+%include "pyupm_doxy2swig.i"
+%module pyupm_dsp
+%include "../upm.i"
+%include "stdint.i"
+
+%feature("autodoc", "3");
+
+%{
+    #include "dsp.h"
+%}
+
+%include "dsp.h"
@@ -32,7 +32,10 @@
 
 using namespace upm;
 
-ECS1030::ECS1030 (uint8_t pinNumber) {
+ECS1030::ECS1030 (uint8_t pinNumber) : m_highPass(0.996) {
+    m_acq = NULL;
+    m_acqChannel = -1;
+
     m_dataPinCtx = mraa_aio_init(pinNumber);
     if (m_dataPinCtx == NULL) {
       throw std::invalid_argument(std::string(__FUNCTION__) + 
@@ -45,6 +48,8 @@ ECS1030::ECS1030 (uint8_t pinNumber) {
 ECS1030::~ECS1030 () {
     mraa_result_t error = MRAA_SUCCESS;
 
+    detachAcquisition ();
+
     error = mraa_aio_close (m_dataPinCtx);
     if (error != MRAA_SUCCESS) {
     }
@@ -57,6 +62,15 @@ ECS1030::getCurrency_A () {
     float   volt         = 0;
     float   rms          = 0;
 
+    if (m_acq) {
+        uint16_t window[NUMBER_OF_SAMPLES];
+        int count = m_acq->readWindow (m_acqChannel, window, NUMBER_OF_SAMPLES);
+
+        m_block.resize (NUMBER_OF_SAMPLES);
+        Dsp::toFloat (window, &m_block[0], count, VOLT_M, -2.5);
+        return Dsp::rms (&m_block[0], count) / R_LOAD;
+    }
+
     for (int i = 0; i < NUMBER_OF_SAMPLES; i++) {
         sensorValue = mraa_aio_read (m_dataPinCtx);
         volt = (VOLT_M * sensorValue) - 2.5;
@@ -70,20 +84,49 @@ ECS1030::getCurrency_A () {
     return rms / R_LOAD;
 }
 
+void
+ECS1030::attachAcquisition (AioAcquisition* acq) {
+    detachAcquisition ();
+
+    // a ring of twice the window lets readWindow() take it in one piece
+    m_acqChannel = acq->addChannel (m_dataPinCtx, DELAY_MS,
+                                    2 * NUMBER_OF_SAMPLES);
+    m_acq = acq;
+    m_acq->start ();
+}
+
+void
+ECS1030::detachAcquisition () {
+    if (m_acq) {
+        m_acq->removeChannel (m_acqChannel);
+        m_acq = NULL;
+        m_acqChannel = -1;
+    }
+}
+
 double
 ECS1030::getCurrency_B () {
-    double sumCurrency    = 0;
+    uint16_t samples[NUMBER_OF_SAMPLES];
 
+    // read the whole window first so the reads stay back to back
     for (int i = 0; i < NUMBER_OF_SAMPLES; i++) {
-        m_lastSample = m_sample;
-        m_sample = mraa_aio_read (m_dataPinCtx);
-        m_lastFilter = m_filteredSample;
-        m_filteredSample = 0.996 * (m_lastFilter + m_sample - m_lastSample);
-        sumCurrency += (m_filteredSample * m_filteredSample);
+        samples[i] = mraa_aio_read (m_dataPinCtx);
+    }
+
+    return getCurrency_B (samples, NUMBER_OF_SAMPLES);
+}
+
+double
+ECS1030::getCurrency_B (const uint16_t* samples, int count) {
+    if (count <= 0) {
+        return 0;
     }
 
+    m_block.resize (count);
+    m_highPass.process (samples, &m_block[0], count);
+
     double ratio = m_calibration * ((SUPPLYVOLTAGE / 1000.0) / (ADC_RESOLUTION));
-    return ( ratio * sqrt(sumCurrency / NUMBER_OF_SAMPLES) );
+    return ( ratio * Dsp::rms (&m_block[0], count) );
 }
 
 double
@@ -24,10 +24,14 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <math.h>
 #include <mraa/aio.h>
 #include <mraa/gpio.h>
 
+#include "aioacquire.h"
+#include "dsp.h"
+
 namespace upm {
 
 #define NUMBER_OF_SAMPLES  500
@@ -90,6 +94,28 @@ class ECS1030 {
          */
         ~ECS1030 ();
 
+        /**
+         * Samples the sensor with a shared acquisition engine, one
+         * sample every DELAY_MS microseconds.  getCurrency_A() then
+         * takes its window from the engine.  The engine is started if
+         * it is not running.
+         *
+         * @param acq Acquisition engine
+         */
+        void attachAcquisition (AioAcquisition* acq);
+
+        /**
+         * Stops sampling with the acquisition engine
+         */
+        void detachAcquisition ();
+
+        /**
+         * Returns the acquisition channel of the sensor
+         *
+         * @return Channel number, or -1 if not attached
+         */
+        int getAcquisitionChannel () { return m_acqChannel; }
+
         /**
          * Returns electric current data for a sampled period
          */
@@ -110,6 +136,17 @@ class ECS1030 {
          */
         double getPower_B ();
 
+        /**
+         * Returns electric current data for a block of samples taken
+         * by the caller, using the filter of getCurrency_B().  The
+         * filter state carries over from one block to the next, so a
+         * stream can be processed in blocks of any size.
+         *
+         * @param samples ADC samples
+         * @param count Number of samples
+         */
+        double getCurrency_B (const uint16_t* samples, int count);
+
         /**
          * Returns the name of the component
          */
@@ -119,11 +156,11 @@ class ECS1030 {
     private:
         std::string         m_name;
         mraa_aio_context    m_dataPinCtx;
+        AioAcquisition*     m_acq;
+        int                 m_acqChannel;
 
         double              m_calibration;
-        int                 m_lastSample;
-        double              m_lastFilter;
-        int                 m_sample;
-        double              m_filteredSample;
+        DCBlocker           m_highPass;
+        std::vector<float>  m_block;
 };
 }
@@ -0,0 +1,374 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+#include <time.h>
+#include <errno.h>
+
+#include "edgecapture.h"
+
+using namespace upm;
+using namespace std;
+
+EdgeCapture::EdgeCapture(mraa_gpio_context gpio, int ringSize) :
+  m_gpio(gpio)
+{
+  if (!m_gpio)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": gpio context is NULL");
+      return;
+    }
+
+  // round the ring up to a power of 2 so the indices can wrap freely
+  unsigned int size = 16;
+  while (size < (unsigned int)ringSize)
+    size <<= 1;
+
+  m_ring.resize(size);
+  m_ringMask = size - 1;
+  m_head = m_tail = 0;
+
+  m_pulseHandler = 0;
+  m_pulseCtx = 0;
+  m_overflows = 0;
+  m_missed = 0;
+
+  m_trigger = 0;
+  m_triggerCtx = 0;
+  m_triggerPeriod = 0;
+  m_triggerRunning = false;
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+  if (pthread_mutex_init(&m_lock, NULL) ||
+      pthread_cond_init(&m_cond, &attr))
+    {
+      pthread_condattr_destroy(&attr);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_mutex/cond_init() failed");
+      return;
+    }
+  pthread_condattr_destroy(&attr);
+
+  mraa_gpio_dir(m_gpio, MRAA_GPIO_IN);
+  reset();
+
+  if (mraa_gpio_isr(m_gpio, MRAA_GPIO_EDGE_BOTH, &edgeISR, this)
+      != MRAA_SUCCESS)
+    {
+      pthread_cond_destroy(&m_cond);
+      pthread_mutex_destroy(&m_lock);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": mraa_gpio_isr() failed");
+      return;
+    }
+}
+
+EdgeCapture::~EdgeCapture()
+{
+  stopTrigger();
+  mraa_gpio_isr_exit(m_gpio);
+
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_lock);
+}
+
+uint64_t EdgeCapture::getNanos()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void EdgeCapture::deadlineAfter(struct timespec *ts, unsigned int millis)
+{
+  clock_gettime(CLOCK_MONOTONIC, ts);
+
+  ts->tv_sec += millis / 1000;
+  ts->tv_nsec += (millis % 1000) * 1000000;
+  if (ts->tv_nsec >= 1000000000)
+    {
+      ts->tv_sec++;
+      ts->tv_nsec -= 1000000000;
+    }
+}
+
+// called with m_lock held, returns false once the deadline passed
+bool EdgeCapture::waitUntil(const struct timespec *deadline)
+{
+  return (pthread_cond_timedwait(&m_cond, &m_lock, deadline) != ETIMEDOUT);
+}
+
+void EdgeCapture::edgeISR(void *ctx)
+{
+  EdgeCapture *This = (EdgeCapture *)ctx;
+
+  This->edge();
+}
+
+void EdgeCapture::edge()
+{
+  // stamp the edge before anything else
+  uint64_t now = getNanos();
+  int level = (mraa_gpio_read(m_gpio) > 0) ? 1 : 0;
+
+  pthread_mutex_lock(&m_lock);
+
+  if (level == m_level)
+    {
+      // both edges of a short pulse were merged into one interrupt
+      m_missed++;
+      pthread_mutex_unlock(&m_lock);
+      return;
+    }
+
+  if ((m_head - m_tail) > m_ringMask)
+    m_overflows++;
+  else
+    {
+      EDGE_T *e = &m_ring[m_head & m_ringMask];
+      e->timestamp = now;
+      e->level = level;
+      m_head++;
+    }
+
+  // close the pulse at the previous level
+  uint64_t width = now - m_lastEdge;
+  int prev = m_level;
+
+  m_levelTime[prev] += width;
+  if (!m_pulses[prev]++)
+    m_firstWidth[prev] = width;
+
+  m_level = level;
+  m_lastEdge = now;
+
+  PULSE_HANDLER_T handler = m_pulseHandler;
+  void *handlerCtx = m_pulseCtx;
+
+  pthread_cond_broadcast(&m_cond);
+  pthread_mutex_unlock(&m_lock);
+
+  if (handler)
+    handler(prev, width, handlerCtx);
+}
+
+void EdgeCapture::reset()
+{
+  int level = (mraa_gpio_read(m_gpio) > 0) ? 1 : 0;
+  uint64_t now = getNanos();
+
+  pthread_mutex_lock(&m_lock);
+
+  m_tail = m_head;
+  m_level = level;
+  m_windowStart = now;
+  m_lastEdge = now;
+
+  for (int i = 0; i < 2; i++)
+    {
+      m_levelTime[i] = 0;
+      m_pulses[i] = 0;
+      m_firstWidth[i] = 0;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+int EdgeCapture::available()
+{
+  pthread_mutex_lock(&m_lock);
+  int rv = m_head - m_tail;
+  pthread_mutex_unlock(&m_lock);
+
+  return rv;
+}
+
+int EdgeCapture::readEdges(EDGE_T *edges, int max)
+{
+  int count = 0;
+
+  pthread_mutex_lock(&m_lock);
+  while (count < max && m_tail != m_head)
+    edges[count++] = m_ring[m_tail++ & m_ringMask];
+  pthread_mutex_unlock(&m_lock);
+
+  return count;
+}
+
+bool EdgeCapture::waitEdges(int count, unsigned int millis)
+{
+  struct timespec deadline;
+  deadlineAfter(&deadline, millis);
+
+  pthread_mutex_lock(&m_lock);
+  while ((int)(m_head - m_tail) < count)
+    {
+      if (!waitUntil(&deadline))
+        break;
+    }
+  bool rv = ((int)(m_head - m_tail) >= count);
+  pthread_mutex_unlock(&m_lock);
+
+  return rv;
+}
+
+int64_t EdgeCapture::waitPulse(int level, unsigned int millis)
+{
+  level = level ? 1 : 0;
+
+  struct timespec deadline;
+  deadlineAfter(&deadline, millis);
+
+  pthread_mutex_lock(&m_lock);
+  while (!m_pulses[level])
+    {
+      if (!waitUntil(&deadline))
+        break;
+    }
+  int64_t rv = m_pulses[level] ? (int64_t)m_firstWidth[level] : -1;
+  pthread_mutex_unlock(&m_lock);
+
+  return rv;
+}
+
+uint64_t EdgeCapture::getLevelTime(int level)
+{
+  level = level ? 1 : 0;
+  uint64_t now = getNanos();
+
+  pthread_mutex_lock(&m_lock);
+  uint64_t rv = m_levelTime[level];
+  if (m_level == level)
+    rv += now - m_lastEdge;
+  pthread_mutex_unlock(&m_lock);
+
+  return rv;
+}
+
+uint64_t EdgeCapture::getElapsed()
+{
+  uint64_t now = getNanos();
+
+  pthread_mutex_lock(&m_lock);
+  uint64_t rv = now - m_windowStart;
+  pthread_mutex_unlock(&m_lock);
+
+  return rv;
+}
+
+unsigned int EdgeCapture::getPulseCount(int level)
+{
+  pthread_mutex_lock(&m_lock);
+  unsigned int rv = m_pulses[level ? 1 : 0];
+  pthread_mutex_unlock(&m_lock);
+
+  return rv;
+}
+
+void EdgeCapture::setPulseHandler(PULSE_HANDLER_T handler, void *ctx)
+{
+  pthread_mutex_lock(&m_lock);
+  m_pulseHandler = handler;
+  m_pulseCtx = ctx;
+  pthread_mutex_unlock(&m_lock);
+}
+
+void EdgeCapture::startTrigger(TRIGGER_T trigger, void *ctx,
+                               unsigned int periodMs)
+{
+  stopTrigger();
+
+  if (!trigger || !periodMs)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": trigger and period must be non-zero");
+      return;
+    }
+
+  m_trigger = trigger;
+  m_triggerCtx = ctx;
+  m_triggerPeriod = periodMs;
+  m_triggerRunning = true;
+
+  if (pthread_create(&m_triggerThread, NULL, triggerThread, this))
+    {
+      m_triggerRunning = false;
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_create() failed");
+      return;
+    }
+}
+
+void EdgeCapture::stopTrigger()
+{
+  pthread_mutex_lock(&m_lock);
+  bool running = m_triggerRunning;
+  m_triggerRunning = false;
+  pthread_cond_broadcast(&m_cond);
+  pthread_mutex_unlock(&m_lock);
+
+  if (running)
+    pthread_join(m_triggerThread, NULL);
+}
+
+void *EdgeCapture::triggerThread(void *ctx)
+{
+  EdgeCapture *This = (EdgeCapture *)ctx;
+  struct timespec next;
+
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  pthread_mutex_lock(&This->m_lock);
+  while (This->m_triggerRunning)
+    {
+      pthread_mutex_unlock(&This->m_lock);
+      This->m_trigger(This->m_triggerCtx);
+      pthread_mutex_lock(&This->m_lock);
+
+      // absolute deadlines, so the rate does not drift with the time
+      // spent in the callback
+      next.tv_sec += This->m_triggerPeriod / 1000;
+      next.tv_nsec += (This->m_triggerPeriod % 1000) * 1000000;
+      if (next.tv_nsec >= 1000000000)
+        {
+          next.tv_sec++;
+          next.tv_nsec -= 1000000000;
+        }
+
+      while (This->m_triggerRunning && This->waitUntil(&next))
+        ;
+    }
+  pthread_mutex_unlock(&This->m_lock);
+
+  return NULL;
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <mraa/gpio.h>
+
+// default number of edges held in the capture ring (power of 2)
+#define EDGECAPTURE_RING_SIZE 256
+
+namespace upm {
+  /**
+   * @brief GPIO edge capture engine
+   * @defgroup edgecapture libupm-edgecapture
+   * @ingroup gpio
+   */
+
+  /**
+   * @library edgecapture
+   * @sensor edgecapture
+   * @comname GPIO edge capture
+   * @con gpio
+   *
+   * @brief Interrupt driven pulse measurement shared by the GPIO drivers
+   *
+   * An EdgeCapture installs an interrupt handler for both edges of a
+   * GPIO.  The handler stamps every edge with CLOCK_MONOTONIC, stores
+   * it in a ring buffer and keeps running totals of the time spent at
+   * each level, so pulse widths and occupancy are available without
+   * polling the pin.  Callers sleep on a condition variable until the
+   * edges they need have arrived.
+   *
+   * The level reported for an edge is read back in the interrupt
+   * handler.  If it matches the previous level, both edges of a pulse
+   * too short to be seen were merged into one interrupt; the edge is
+   * counted as missed and the current level continues.
+   *
+   * A periodic trigger thread can also be started to fire a callback
+   * (typically a trigger pulse on another pin) at a fixed rate.
+   */
+  class EdgeCapture {
+  public:
+    // one captured edge
+    typedef struct {
+      uint64_t timestamp;               // CLOCK_MONOTONIC, nanoseconds
+      int      level;                   // level after the edge
+    } EDGE_T;
+
+    /**
+     * Pulse callback.  Called from the interrupt thread each time the
+     * pin leaves a level.
+     *
+     * @param level Level of the pulse that just ended
+     * @param width Width of the pulse, in nanoseconds
+     */
+    typedef void (*PULSE_HANDLER_T)(int level, uint64_t width, void *ctx);
+
+    /**
+     * Trigger callback, called from the trigger thread
+     */
+    typedef void (*TRIGGER_T)(void *ctx);
+
+    /**
+     * EdgeCapture constructor.  The GPIO must already be initialized
+     * and remains owned by the caller; it is set to an input.
+     *
+     * @param gpio MRAA GPIO context
+     * @param ringSize Number of edges held in the ring, rounded up to
+     * a power of 2
+     */
+    EdgeCapture(mraa_gpio_context gpio, int ringSize=EDGECAPTURE_RING_SIZE);
+
+    /**
+     * EdgeCapture destructor.  Removes the interrupt handler and stops
+     * the trigger thread.
+     */
+    ~EdgeCapture();
+
+    /**
+     * Discards all captured edges, clears the level time totals and
+     * pulse counts and re-reads the current pin level.  This starts a
+     * new measurement window.
+     */
+    void reset();
+
+    /**
+     * Returns the number of edges waiting in the ring
+     *
+     * @return Number of edges available
+     */
+    int available();
+
+    /**
+     * Removes captured edges from the ring
+     *
+     * @param edges Array to hold the edges
+     * @param max Size of the array
+     * @return Number of edges stored
+     */
+    int readEdges(EDGE_T *edges, int max);
+
+    /**
+     * Waits for edges to be captured
+     *
+     * @param count Number of edges to wait for
+     * @param millis Number of milliseconds to wait
+     * @return True if at least count edges are in the ring
+     */
+    bool waitEdges(int count, unsigned int millis);
+
+    /**
+     * Waits for the first complete pulse at a level since the last
+     * reset()
+     *
+     * @param level Level of the pulse, 0 or 1
+     * @param millis Number of milliseconds to wait
+     * @return Width of the pulse in nanoseconds, or -1 on timeout
+     */
+    int64_t waitPulse(int level, unsigned int millis);
+
+    /**
+     * Returns the time spent at a level since the last reset(),
+     * including the level currently held
+     *
+     * @param level 0 or 1
+     * @return Time in nanoseconds
+     */
+    uint64_t getLevelTime(int level);
+
+    /**
+     * Returns the time elapsed since the last reset()
+     *
+     * @return Time in nanoseconds
+     */
+    uint64_t getElapsed();
+
+    /**
+     * Returns the number of complete pulses at a level since the
+     * last reset()
+     *
+     * @param level 0 or 1
+     * @return Number of pulses
+     */
+    unsigned int getPulseCount(int level);
+
+    /**
+     * Installs or removes a pulse callback
+     *
+     * @param handler Pulse callback, or NULL to remove it
+     * @param ctx Argument passed to the callback
+     */
+    void setPulseHandler(PULSE_HANDLER_T handler, void *ctx);
+
+    /**
+     * Starts a thread calling a trigger callback at a fixed rate.
+     * Any running trigger thread is stopped first.
+     *
+     * @param trigger Trigger callback
+     * @param ctx Argument passed to the callback
+     * @param periodMs Period in milliseconds
+     */
+    void startTrigger(TRIGGER_T trigger, void *ctx, unsigned int periodMs);
+
+    /**
+     * Stops the trigger thread, if running
+     */
+    void stopTrigger();
+
+    /**
+     * Returns the number of edges dropped because the ring was full
+     *
+     * @return Number of edges dropped
+     */
+    unsigned int getOverflowCount() { return m_overflows; };
+
+    /**
+     * Returns the number of interrupts that reported no level change
+     *
+     * @return Number of missed edges
+     */
+    unsigned int getMissedEdgeCount() { return m_missed; };
+
+    /**
+     * Returns the current CLOCK_MONOTONIC time
+     *
+     * @return Time in nanoseconds
+     */
+    static uint64_t getNanos();
+
+  private:
+    static void edgeISR(void *ctx);
+    static void *triggerThread(void *ctx);
+    void edge();
+    bool waitUntil(const struct timespec *deadline);
+    static void deadlineAfter(struct timespec *ts, unsigned int millis);
+
+    mraa_gpio_context m_gpio;
+
+    // everything below is protected by m_lock
+    std::vector<EDGE_T> m_ring;
+    unsigned int m_ringMask;
+    unsigned int m_head;
+    unsigned int m_tail;
+
+    int m_level;
+    uint64_t m_windowStart;
+    uint64_t m_lastEdge;
+    uint64_t m_levelTime[2];
+    unsigned int m_pulses[2];
+    uint64_t m_firstWidth[2];
+
+    PULSE_HANDLER_T m_pulseHandler;
+    void *m_pulseCtx;
+
+    unsigned int m_overflows;
+    unsigned int m_missed;
+
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_cond;
+
+    TRIGGER_T m_trigger;
+    void *m_triggerCtx;
+    unsigned int m_triggerPeriod;
+    bool m_triggerRunning;
+    pthread_t m_triggerThread;
+  };
+}
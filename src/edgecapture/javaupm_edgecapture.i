@@ -0,0 +1,20 @@
+%module javaupm_edgecapture
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "edgecapture.h"
+%}
+
+%include "edgecapture.h"
+
+%pragma(java) jniclasscode=%{
+    static {
+        try {
+            System.loadLibrary("javaupm_edgecapture");
+        } catch (UnsatisfiedLinkError e) {
+            System.err.println("Native code library failed to load. \n" + e);
+            System.exit(1);
+        }
+    }
+%}
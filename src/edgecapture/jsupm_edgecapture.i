@@ -0,0 +1,9 @@
+%module jsupm_edgecapture
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "edgecapture.h"
+%}
+
+%include "edgecapture.h"
@@ -0,0 +1,13 @@
+// Include doxygen-generated documentation
+%include "pyupm_doxy2swig.i"
+%module pyupm_edgecapture
+%include "../upm.i"
+%include "stdint.i"
+
+%feature("autodoc", "3");
+
+%{
+    #include "edgecapture.h"
+%}
+
+%include "edgecapture.h"
@@ -33,6 +33,9 @@ using namespace std;
 
 GroveEMG::GroveEMG(int pin)
 {
+  m_acq = 0;
+  m_acqChannel = -1;
+
     if ( !(m_aio = mraa_aio_init(pin)) )
     {
       throw std::invalid_argument(std::string(__FUNCTION__) +
@@ -43,6 +46,7 @@ GroveEMG::GroveEMG(int pin)
 
 GroveEMG::~GroveEMG()
 {
+  detachAcquisition();
   mraa_aio_close(m_aio);
 }
 
@@ -50,6 +54,23 @@ void GroveEMG::calibrate()
 {
 	int val, sum = 0;
 
+	if (m_acq)
+	{
+		// the value() channel keeps no ring, collect the window
+		// through a second channel on the same pin
+		uint16_t window[1100];
+		int chan = m_acq->addChannel(m_aio, m_acq->getPeriod(m_acqChannel));
+		int count = m_acq->readWindow(chan, window, 1100);
+		m_acq->removeChannel(chan);
+
+		for (int i=0; i<count; i++)
+			sum += window[i];
+		if (count)
+			sum /= count;
+		cout << "Static analog data = " << sum << endl;
+		return;
+	}
+
 	for (int i=0; i<1100; i++)
 	{
 		val = mraa_aio_read(m_aio);
@@ -62,6 +83,30 @@ void GroveEMG::calibrate()
 
 int GroveEMG::value()
 {
+	AioAcquisition::SAMPLE_T sample;
+
+	if (m_acq && m_acq->getLatest(m_acqChannel, &sample))
+		return sample.value;
+
 	int val = mraa_aio_read(m_aio);
 	return val;
 }
+
+void GroveEMG::attachAcquisition(AioAcquisition *acq, unsigned int periodUs)
+{
+  detachAcquisition();
+
+  m_acqChannel = acq->addChannel(m_aio, periodUs, 0);
+  m_acq = acq;
+  m_acq->start();
+}
+
+void GroveEMG::detachAcquisition()
+{
+  if (m_acq)
+    {
+      m_acq->removeChannel(m_acqChannel);
+      m_acq = 0;
+      m_acqChannel = -1;
+    }
+}
@@ -26,6 +26,8 @@
 #include <string>
 #include <mraa/aio.h>
 
+#include "aioacquire.h"
+
 namespace upm {
   /**
    * @brief Grove EMG Muscle Signal Reader library
@@ -46,6 +48,9 @@ namespace upm {
    * Grove EMG muscle signal reader gathers small muscle signals,
    * then processes them, and returns the result
    *
+   * With a shared AioAcquisition engine attached, calibrate() averages
+   * samples taken by the engine and value() returns the latest one.
+   *
    * @image html groveemg.jpg 
    * @snippet groveemg.cxx Interesting
    */
@@ -62,6 +67,27 @@ namespace upm {
      */
     ~GroveEMG();
 
+    /**
+     * Samples the reader with a shared acquisition engine.
+     * The engine is started if it is not running.
+     *
+     * @param acq Acquisition engine
+     * @param periodUs Sample period in microseconds
+     */
+    void attachAcquisition(AioAcquisition *acq, unsigned int periodUs=1000);
+
+    /**
+     * Stops sampling with the acquisition engine
+     */
+    void detachAcquisition();
+
+    /**
+     * Returns the acquisition channel of the sensor
+     *
+     * @return Channel number, or -1 if not attached
+     */
+    int getAcquisitionChannel() { return m_acqChannel; };
+
     /**
      * Calibrates the Grove EMG reader
      */
@@ -76,6 +102,8 @@ namespace upm {
 
   private:
     mraa_aio_context m_aio;
+    AioAcquisition *m_acq;
+    int m_acqChannel;
   };
 }
 
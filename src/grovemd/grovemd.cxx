@@ -28,6 +28,7 @@
 #include <stdexcept>
 
 #include "grovemd.h"
+#include "motionengine.h"
 
 using namespace upm;
 using namespace std;
@@ -57,10 +58,13 @@ GroveMD::GroveMD(int bus, uint8_t address) :
   initClock();
   // default to mode1 stepper operation, 200 steps per rev.
   configStepper(200, STEP_MODE1);
+
+  m_axis = new MotionAxis(&stepCallback, this);
 }
 
 GroveMD::~GroveMD()
 {
+  delete m_axis;
   setMotorSpeeds(0, 0);
   writePacket(SET_DIRECTION, 0, GROVEMD_NOOP);
 }
@@ -116,34 +120,15 @@ bool GroveMD::enableStepper(STEP_DIRECTION_T dir, uint8_t speed)
 
   m_stepDelay = 60 * 1000 / m_stepsPerRev / speed;
   m_stepDirection = ((dir == STEP_DIR_CW) ? 1 : -1);
+  m_axis->setMaxSpeed(double(speed) * m_stepsPerRev / 60.0);
 
   // seeed says speed should always be 255,255 for stepper operation
   setMotorSpeeds(255, 255);
 
-  while (m_totalSteps > 0)
-    {
-      if (getMillis() >= m_stepDelay)
-        {
-          // reset the clock
-          initClock();
-
-          m_currentStep += m_stepDirection;
-
-          if (m_stepDirection == 1)
-            {
-              if (m_currentStep >= m_stepsPerRev)
-                m_currentStep = 0;
-            }
-          else
-            {
-              if (m_currentStep <= 0)
-                m_currentStep = m_stepsPerRev;
-            }
-
-          m_totalSteps--;
-          stepperStep();
-        }
-    }
+  // the motion engine generates the steps, we just sleep until it's
+  // done
+  m_axis->waitMove(m_axis->move(m_stepDirection * int(m_totalSteps)));
+  m_totalSteps = 0;
 
   // and... we're done
   return true;
@@ -212,6 +197,26 @@ uint32_t GroveMD::getMillis()
   return elapse;
 }
 
+void GroveMD::stepCallback(int dir, void *ctx)
+{
+  GroveMD *This = (GroveMD *)ctx;
+
+  This->m_currentStep += dir;
+
+  if (dir == 1)
+    {
+      if (This->m_currentStep >= This->m_stepsPerRev)
+        This->m_currentStep = 0;
+    }
+  else
+    {
+      if (This->m_currentStep <= 0)
+        This->m_currentStep = This->m_stepsPerRev;
+    }
+
+  This->stepperStep();
+}
+
 void GroveMD::configStepper(unsigned int stepsPerRev, STEP_MODE_T mode)
 {
   m_stepsPerRev = stepsPerRev;
@@ -33,6 +33,8 @@
 #define GROVEMD_DEFAULT_I2C_ADDR 0x0f
 
 namespace upm {
+  class MotionAxis;
+
   /**
    * @brief Grove I2C Motor Driver library
    * @defgroup grovemd libupm-grovemd
@@ -209,6 +211,17 @@ namespace upm {
      */
     void configStepper(unsigned int stepsPerRev, STEP_MODE_T mode=STEP_MODE1);
 
+    /**
+     * Returns the motion engine axis that generates the steps in
+     * Mode1.  Moves queued on it run in the background with an
+     * optional acceleration; the motor outputs must have been set up
+     * by a previous enableStepper() call.  Speeds on the axis are in
+     * steps per second.
+     *
+     * @return Motion axis
+     */
+    MotionAxis *getMotionAxis() { return m_axis; };
+
   protected:
     mraa::I2c m_i2c;
     uint8_t m_addr;
@@ -220,6 +233,7 @@ namespace upm {
     uint32_t m_stepDelay;
     uint32_t m_totalSteps;
     STEP_MODE_T m_stepMode;
+    MotionAxis *m_axis;
 
     /**
      * Steps the motor one tick
@@ -227,6 +241,9 @@ namespace upm {
      */
     void stepperStep();
 
+    // motion engine step callback
+    static void stepCallback(int dir, void *ctx);
+
     // step direction: - 1 = forward, -1 = backward
     int m_stepDirection;
 
@@ -28,8 +28,12 @@
 #include <string>
 #include <stdexcept>
 #include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 #include "grovescam.h"
+#include "uartport.h"
 
 using namespace upm;
 using namespace std;
@@ -38,149 +42,49 @@ static const int maxRetries = 100;
 
 GROVESCAM::GROVESCAM(int uart, uint8_t camAddr)
 {
-  m_ttyFd = -1;
-
   // save our shifted camera address, we'll need it a lot
   m_camAddr = (camAddr << 5);
 
   m_picTotalLen = 0;
+  m_pktLen = MAX_PKT_LEN;
+  m_capPktLen = MAX_PKT_LEN;
+  memset(&m_stats, 0, sizeof(m_stats));
 
-  if ( !(m_uart = mraa_uart_init(uart)) )
-    {
-      throw std::invalid_argument(std::string(__FUNCTION__) +
-                                  ": mraa_uart_init() failed");
-      return;
-    }
-
-  // This requires a recent MRAA (1/2015)
-  const char *devPath = mraa_uart_get_dev_path(m_uart);
-
-  if (!devPath)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": mraa_uart_get_dev_path() failed");
-      return;
-    }
-
-  // now open the tty
-  if ( (m_ttyFd = open(devPath, O_RDWR)) == -1)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": open of " + 
-                               string(devPath) + " failed:" +
-                               string(strerror(errno)));
-      return;
-    }
+  m_port = new UartPort(uart);
 }
 
 GROVESCAM::~GROVESCAM()
 {
-  if (m_ttyFd != -1)
-    close(m_ttyFd);
+  delete m_port;
 }
 
 bool GROVESCAM::dataAvailable(unsigned int millis)
 {
-  if (m_ttyFd == -1)
-    return false;
-
-  struct timeval timeout;
-
-  if (millis == 0) 
-    {
-      // no waiting
-      timeout.tv_sec = 0;
-      timeout.tv_usec = 0;
-    }
-  else 
-    {
-      timeout.tv_sec = millis / 1000;
-      timeout.tv_usec = (millis % 1000) * 1000;
-    }
-
-  int nfds;  
-  fd_set readfds;
-
-  FD_ZERO(&readfds);
-
-  FD_SET(m_ttyFd, &readfds);
-  
-  if (select(m_ttyFd + 1, &readfds, NULL, NULL, &timeout) > 0)
-    return true;                // data is ready
-  else
-    return false;
+  return m_port->dataAvailable(millis);
 }
 
 int GROVESCAM::readData(uint8_t *buffer, int len)
 {
-  if (m_ttyFd == -1)
-    return(-1);
-
-  int rv = read(m_ttyFd, (char *)buffer, len);
-
-  if (rv < 0)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": read() failed: " +
-                               string(strerror(errno)));
-      return rv;
-    }
-
-  return rv;
+  return m_port->readData(buffer, len);
 }
 
 int GROVESCAM::writeData(uint8_t *buffer, int len)
 {
-  if (m_ttyFd == -1)
-    return(-1);
-
   // first, flush any pending but unread input
 
-  tcflush(m_ttyFd, TCIFLUSH);
-
-  int rv = write(m_ttyFd, (char *)buffer, len);
-
-  if (rv < 0)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": write() failed: " +
-                               string(strerror(errno)));
-      return rv;
-    }
-
-  tcdrain(m_ttyFd);
+  m_port->flushInput();
 
-  return rv;
+  return m_port->writeData(buffer, len);
 }
 
 bool GROVESCAM::setupTty(speed_t baud)
 {
-  if (m_ttyFd == -1)
-    return(false);
-  
-  struct termios termio;
-
-  // get current modes
-  tcgetattr(m_ttyFd, &termio);
-
-  // setup for a 'raw' mode.  81N, no echo or special character
-  // handling, such as flow control.
-  cfmakeraw(&termio);
-
-  // set our baud rates
-  cfsetispeed(&termio, baud);
-  cfsetospeed(&termio, baud);
-
-  // make it so
-  if (tcsetattr(m_ttyFd, TCSAFLUSH, &termio) < 0)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": tcsetattr() failed: " +
-                               string(strerror(errno)));
-      return false;
-    }
+  return m_port->setupTty(baud);
+}
 
-  return true;
+int GROVESCAM::ttyFd()
+{
+  return m_port->ttyFd();
 }
 
 void GROVESCAM::drainInput()
@@ -282,13 +186,18 @@ bool GROVESCAM::preCapture(PIC_FORMATS_T fmt)
 bool GROVESCAM::doCapture()
 {
   const unsigned int pktLen = 6;
-  uint8_t cmd[pktLen] = { 0xaa, 0x06 | m_camAddr, 0x08, MAX_PKT_LEN & 0xff, 
-                          (MAX_PKT_LEN >> 8) & 0xff, 0};
+  uint8_t cmd[pktLen] = { 0xaa, (uint8_t)(0x06 | m_camAddr), 0x08,
+                          (uint8_t)(m_pktLen & 0xff),
+                          (uint8_t)((m_pktLen >> 8) & 0xff), 0};
   uint8_t resp[pktLen];
   int retries = 0;
   
   m_picTotalLen = 0;
 
+  // the download must use the size the camera was told, even if
+  // setPacketSize() is called in between
+  m_capPktLen = m_pktLen;
+
   while (true)
     {
       if (retries++ > maxRetries)
@@ -300,9 +209,8 @@ bool GROVESCAM::doCapture()
 
       drainInput();
       writeData(cmd, pktLen);
-      usleep(100000);
 
-      if (!dataAvailable(100))
+      if (!dataAvailable(200))
         continue;
 
       if (readData(resp, pktLen) != pktLen)
@@ -389,98 +297,243 @@ bool GROVESCAM::doCapture()
   return true;
 }
 
-bool GROVESCAM::storeImage(const char *fname)
+void GROVESCAM::setPacketSize(unsigned int len)
 {
-  if (!fname)
+  if (len < MIN_PKT_LEN || len > MAX_NEGOTIATED_PKT_LEN)
     {
-      throw std::invalid_argument(std::string(__FUNCTION__) +
-                                  ": filename is NULL");
-      return false;
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": packet size must be between 64 and 512");
+      return;
     }
 
-  if (!m_picTotalLen)
+  m_pktLen = len;
+}
+
+void GROVESCAM::requestPacket(unsigned int index)
+{
+  uint8_t cmd[6] = { 0xaa, (uint8_t)(0x0e | m_camAddr), 0x00, 0x00,
+                     (uint8_t)(index & 0xff), (uint8_t)((index >> 8) & 0xff) };
+
+  // not writeData(), that would flush a packet already on its way
+  m_port->writeData(cmd, 6);
+}
+
+void GROVESCAM::endTransfer()
+{
+  uint8_t cmd[6] = { 0xaa, (uint8_t)(0x0e | m_camAddr), 0x00, 0x00,
+                     0xf0, 0xf0 };
+
+  drainInput();
+  writeData(cmd, 6);
+}
+
+bool GROVESCAM::readBytes(uint8_t *buffer, int len, unsigned int millis)
+{
+  int got = 0;
+
+  while (got < len)
     {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                    ": Picture length is zero, you need to capture first.");
+      int rv = m_port->readData(buffer + got, len - got, millis);
 
-      return false;
+      if (rv <= 0)
+        return false;
+
+      got += rv;
     }
 
-  FILE *file = fopen(fname, "wb");
+  return true;
+}
 
-  if (!file)
+int GROVESCAM::readPacket(unsigned int index, uint8_t *pkt)
+{
+  // id (2), data length (2), data, checksum (2)
+  if (!readBytes(pkt, 4, 1000))
+    return -1;
+
+  unsigned int id = pkt[0] | (pkt[1] << 8);
+  int len = pkt[2] | (pkt[3] << 8);
+
+  if (id != index || len > (int)(m_capPktLen - 6))
+    return -1;
+
+  if (!readBytes(&pkt[4], len + 2, 1000))
+    return -1;
+
+  uint8_t sum = 0;
+  for (int i = 0; i < len + 4; i++)
+    sum += pkt[i];
+
+  if (sum != pkt[len + 4])
+    return -1;
+
+  return len;
+}
+
+bool GROVESCAM::downloadImage(IMAGE_CALLBACK_T cb, void *ctx,
+                              unsigned int startPacket)
+{
+  if (!m_picTotalLen)
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": fopen() failed: " +
-                               string(strerror(errno)));
+                    ": Picture length is zero, you need to capture first.");
+
       return false;
     }
-  
-  /// let the games begin...
-  const unsigned int pktLen = 6;
-  unsigned int pktCnt = (m_picTotalLen) / (MAX_PKT_LEN - 6);
-  if ((m_picTotalLen % (MAX_PKT_LEN-6)) != 0) 
-    pktCnt += 1;
-  
-  uint8_t cmd[pktLen] = { 0xaa, 0x0e | m_camAddr, 0x00, 0x00, 0x00, 0x00 };
-  uint8_t pkt[MAX_PKT_LEN];
-  int retries = 0;
-  
-  for (unsigned int i = 0; i < pktCnt; i++)
-    {
-      cmd[4] = i & 0xff;
-      cmd[5] = (i >> 8) & 0xff;
-      
-      retries = 0;
 
-    retry:
+  const unsigned int payload = m_capPktLen - 6;
+  unsigned int pktCnt = (m_picTotalLen + payload - 1) / payload;
 
-      usleep(10000);
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
 
-      drainInput();
-      writeData(cmd, pktLen);
+  memset(&m_stats, 0, sizeof(m_stats));
+  m_stats.nextPacket = startPacket;
+
+  uint8_t pkt[MAX_NEGOTIATED_PKT_LEN];
+  int offset = startPacket * payload;
+  bool rv = true;
+
+  drainInput();
+  if (startPacket < pktCnt)
+    requestPacket(startPacket);
 
-      if (!dataAvailable(1000))
+  for (unsigned int i = startPacket; i < pktCnt; i++)
+    {
+      int len;
+      int retries = 0;
+
+      while ((len = readPacket(i, pkt)) < 0)
         {
-          if (retries++ > maxRetries)
+          if (retries++ >= maxRetries)
             {
+              // don't leave the camera in the middle of a transfer
+              endTransfer();
               throw std::runtime_error(std::string(__FUNCTION__) +
-                                       ": timeout, maximum retries exceeded");
+                                       ": maximum retries exceeded");
               return false;
             }
-          goto retry;
-        }
 
-      uint16_t cnt = readData(pkt, MAX_PKT_LEN);
-      
-      unsigned char sum = 0;
-      for (int y = 0; y < cnt - 2; y++)
-        {
-          sum += pkt[y];
+          // throw away the remains of the bad packet and ask again
+          m_stats.retries++;
+          m_port->flushInput();
+          requestPacket(i);
         }
-      if (sum != pkt[cnt-2])
+
+      // have the camera send the next packet while this one is
+      // handed off
+      if (i + 1 < pktCnt)
+        requestPacket(i + 1);
+
+      m_stats.packets++;
+      m_stats.bytes += len;
+      m_stats.nextPacket = i + 1;
+
+      if (cb && !cb(&pkt[4], len, offset, ctx))
         {
-          if (retries++ <= maxRetries)
-            goto retry;
-          else
-            {
-              throw std::runtime_error(std::string(__FUNCTION__) +
-                                       ": cksum error, maximum retries exceeded");
-              return false;
-            }
+          rv = false;
+          break;
         }
 
-      fwrite((const uint8_t *)&pkt[4], cnt - 6, 1, file);
+      offset += len;
     }
 
-  cmd[4] = 0xf0;
-  cmd[5] = 0xf0;
-  writeData(cmd, pktLen);
+  endTransfer();
 
-  fclose(file);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  m_stats.seconds = (end.tv_sec - start.tv_sec) +
+    (end.tv_nsec - start.tv_nsec) / 1e9;
+  if (m_stats.seconds > 0)
+    m_stats.bytesPerSec = m_stats.bytes / m_stats.seconds;
 
   // reset the pic length to 0 for another run.
-  m_picTotalLen = 0;
+  if (rv)
+    m_picTotalLen = 0;
+
+  return rv;
+}
 
+static bool fileCallback(const uint8_t *data, int len, int, void *ctx)
+{
+  return (fwrite(data, len, 1, (FILE *)ctx) == 1);
+}
+
+typedef struct {
+  uint8_t *buffer;
+  unsigned int len;
+} MEMORY_SINK_T;
+
+static bool memoryCallback(const uint8_t *data, int len, int offset,
+                           void *ctx)
+{
+  MEMORY_SINK_T *sink = (MEMORY_SINK_T *)ctx;
+
+  if (offset + len > (int)sink->len)
+    return false;
+
+  memcpy(sink->buffer + offset, data, len);
   return true;
 }
+
+bool GROVESCAM::storeImage(const char *fname)
+{
+  if (!fname)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": filename is NULL");
+      return false;
+    }
+
+  if (!m_picTotalLen)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                    ": Picture length is zero, you need to capture first.");
+
+      return false;
+    }
+
+  FILE *file = fopen(fname, "wb");
+
+  if (!file)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": fopen() failed: " +
+                               string(strerror(errno)));
+      return false;
+    }
+
+  bool rv;
+  try
+    {
+      rv = downloadImage(fileCallback, file);
+    }
+  catch (...)
+    {
+      fclose(file);
+      throw;
+    }
+
+  fclose(file);
+
+  return rv;
+}
+
+bool GROVESCAM::storeImage(uint8_t *buffer, unsigned int len)
+{
+  if (!buffer)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": buffer is NULL");
+      return false;
+    }
+
+  if (len < (unsigned int)m_picTotalLen)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": buffer is smaller than the image");
+      return false;
+    }
+
+  MEMORY_SINK_T sink = { buffer, len };
+
+  return downloadImage(memoryCallback, &sink);
+}
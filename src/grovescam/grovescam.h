@@ -47,6 +47,8 @@
 #define GROVESCAM_DEFAULT_CAMERA_ADDR 0
 
 namespace upm {
+  class UartPort;
+
     /**
      * @brief Grove Serial Camera library
      * @defgroup grovescam libupm-grovescam
@@ -80,12 +82,41 @@ namespace upm {
 
     static const unsigned int MAX_PKT_LEN = 128;
 
+    // largest data packet the camera can be asked for
+    static const unsigned int MAX_NEGOTIATED_PKT_LEN = 512;
+
+    // smallest data packet the camera accepts
+    static const unsigned int MIN_PKT_LEN = 64;
+
     typedef enum {
       FORMAT_VGA                   = 7, // 640x480
       FORMAT_CIF                   = 5, // 352×288
       FORMAT_OCIF                  = 3  // ??? (maybe they meant QCIF?)
     } PIC_FORMATS_T;
 
+    // image download statistics, see getStats()
+    typedef struct {
+      unsigned int packets;     // packets received
+      unsigned int retries;     // packets requested again
+      unsigned int bytes;       // image bytes delivered
+      unsigned int nextPacket;  // packet to resume from after a failure
+      float seconds;            // download time
+      float bytesPerSec;        // image throughput
+    } DOWNLOAD_STATS_T;
+
+    /**
+     * Image data callback for downloadImage().  Called once per
+     * packet, in order.
+     *
+     * @param data Image data
+     * @param len Number of bytes in data
+     * @param offset Offset of data in the image
+     * @param ctx Argument given to downloadImage()
+     * @return True to continue, false to abort the download
+     */
+    typedef bool (*IMAGE_CALLBACK_T)(const uint8_t *data, int len,
+                                     int offset, void *ctx);
+
     /**
      * Grove Serial Camera constructor
      *
@@ -156,6 +187,22 @@ namespace upm {
      */
     bool preCapture(PIC_FORMATS_T fmt=FORMAT_VGA);
 
+    /**
+     * Sets the data packet size requested by the next doCapture().
+     * Larger packets mean fewer request/response round trips per
+     * image.
+     *
+     * @param len Packet size, MIN_PKT_LEN to MAX_NEGOTIATED_PKT_LEN
+     */
+    void setPacketSize(unsigned int len);
+
+    /**
+     * Returns the data packet size used for captures
+     *
+     * @return Packet size
+     */
+    unsigned int getPacketSize() { return m_pktLen; };
+
     /**
      * Starts the capture
      *
@@ -171,6 +218,41 @@ namespace upm {
      */
     bool storeImage(const char *fname);
 
+    /**
+     * Stores the captured image in a memory buffer
+     *
+     * @param buffer Buffer to hold the image
+     * @param len Size of the buffer, at least getImageSize()
+     * @return True if successful
+     */
+    bool storeImage(uint8_t *buffer, unsigned int len);
+
+    /**
+     * Downloads the captured image and hands it to a callback.  The
+     * request for each packet is sent as soon as the previous one has
+     * been verified, so the camera transmits the next packet while
+     * the callback runs.  A packet that times out or fails its
+     * checksum is requested again on its own.
+     *
+     * If the download fails, it can be resumed by calling this
+     * function again with startPacket set to the nextPacket field
+     * of getStats().
+     *
+     * @param cb Callback receiving the image data
+     * @param ctx Argument passed to the callback
+     * @param startPacket Index of the first packet to download
+     * @return True if successful
+     */
+    bool downloadImage(IMAGE_CALLBACK_T cb, void *ctx,
+                       unsigned int startPacket=0);
+
+    /**
+     * Returns the statistics of the last image download
+     *
+     * @return Pointer to the statistics
+     */
+    const DOWNLOAD_STATS_T *getStats() { return &m_stats; };
+
     /**
      * Returns the picture length. Note: this is only valid after
      * doCapture() has run successfully.
@@ -180,14 +262,23 @@ namespace upm {
     int getImageSize() { return m_picTotalLen; };
 
   protected:
-    int ttyFd() { return m_ttyFd; };
+    int ttyFd();
 
   private:
-    mraa_uart_context m_uart;
-    int m_ttyFd;
+    void requestPacket(unsigned int index);
+    void endTransfer();
+    bool readBytes(uint8_t *buffer, int len, unsigned int millis);
+    int readPacket(unsigned int index, uint8_t *pkt);
+
+    UartPort *m_port;
 
     uint8_t m_camAddr;
     int m_picTotalLen;
+
+    unsigned int m_pktLen;
+    // packet size the camera was given by the last doCapture()
+    unsigned int m_capPktLen;
+    DOWNLOAD_STATS_T m_stats;
   };
 }
 
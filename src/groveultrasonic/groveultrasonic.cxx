@@ -25,17 +25,25 @@
  */
 
 #include <iostream>
+#include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <functional>
 
 #include "groveultrasonic.h"
+#include "edgecapture.h"
 
 using namespace upm;
 
+// echo pulses are at least 3 [cm] * 58 = 174 [us], anything shorter
+// is left over from the trigger pulse
+#define MIN_ECHO_US 100
+
 GroveUltraSonic::GroveUltraSonic (uint8_t pin) {
     mraa_result_t error = MRAA_SUCCESS;
     m_name = "GroveUltraSonic";
+    m_doWork = false;
+    m_lastEcho = -1;
 
     mraa_init();
 
@@ -46,59 +54,68 @@ GroveUltraSonic::GroveUltraSonic (uint8_t pin) {
         exit (1);
     }
     mraa_gpio_use_mmaped(m_pinCtx, 1);
-    mraa_gpio_isr (m_pinCtx, MRAA_GPIO_EDGE_BOTH,
-                   &signalISR, this);
+
+    m_capture = new EdgeCapture(m_pinCtx);
+    m_capture->setPulseHandler(&echoDetected, this);
 }
 
 GroveUltraSonic::~GroveUltraSonic () {
 
+    // stops the trigger thread and removes the ISR
+    delete m_capture;
+
     // close pin
-    mraa_gpio_isr_exit(m_pinCtx);
     mraa_gpio_close (m_pinCtx);
 }
 
-int
-GroveUltraSonic::getDistance () {
+void
+GroveUltraSonic::trigger (void *ctx) {
+    upm::GroveUltraSonic *This = (upm::GroveUltraSonic *)ctx;
 
     // output trigger signal
-    mraa_gpio_dir(m_pinCtx, MRAA_GPIO_OUT);
-    mraa_gpio_write(m_pinCtx, LOW);
+    mraa_gpio_dir(This->m_pinCtx, MRAA_GPIO_OUT);
+    mraa_gpio_write(This->m_pinCtx, LOW);
     usleep(2);
-    mraa_gpio_write(m_pinCtx, HIGH);
+    mraa_gpio_write(This->m_pinCtx, HIGH);
     usleep(5);
-    mraa_gpio_write(m_pinCtx, LOW);
+    mraa_gpio_write(This->m_pinCtx, LOW);
+
+    // and listen for the pulse
+    mraa_gpio_dir(This->m_pinCtx, MRAA_GPIO_IN);
+}
+
+int
+GroveUltraSonic::getDistance () {
+
+    trigger(this);
 
-    // wait for the pulse,
+    // wait for the pulse, though do not wait over 25 [ms].
     m_doWork = true;
-    m_InterruptCounter = 0;
-    mraa_gpio_dir(m_pinCtx, MRAA_GPIO_IN);
-
-    // though do not wait over 25 [ms].
-    int timer = 0;
-    while (m_doWork && timer++ < 5) {
-        // in 25 [ms], sound travels 25000 / 29 / 2 = 431 [cm],
-        // which is more than 400 [cm], the max distance measurable with this sensor.
-        usleep(5 * 1000); // 5 [ms]
-    }
+    m_capture->reset();
+    int64_t width = m_capture->waitPulse(HIGH,
+                                         GROVEULTRASONIC_ECHO_TIMEOUT_MS);
+    m_doWork = false;
 
-    // calc diff
-    long diff = m_FallingTimeStamp.tv_usec - m_RisingTimeStamp.tv_usec;
-    diff += (m_FallingTimeStamp.tv_sec - m_RisingTimeStamp.tv_sec) * 1000000;
-    return timer >= 5 ? 0 : diff;
+    return width < 0 ? 0 : width / 1000;
 }
 
 void
-GroveUltraSonic::signalISR(void *ctx) {
-    upm::GroveUltraSonic *This = (upm::GroveUltraSonic *)ctx;
-    This->ackEdgeDetected();
+GroveUltraSonic::startRanging (unsigned int periodMs) {
+    if (periodMs < GROVEULTRASONIC_ECHO_TIMEOUT_MS)
+        periodMs = GROVEULTRASONIC_ECHO_TIMEOUT_MS;
+
+    m_capture->startTrigger(&trigger, this, periodMs);
 }
 
 void
-GroveUltraSonic::ackEdgeDetected () {
-    if (++m_InterruptCounter % 2 == 0) {
-        gettimeofday(&m_FallingTimeStamp, NULL);
-        m_doWork = false;
-    } else {
-        gettimeofday(&m_RisingTimeStamp, NULL);
-    }
+GroveUltraSonic::stopRanging () {
+    m_capture->stopTrigger();
+}
+
+void
+GroveUltraSonic::echoDetected (int level, uint64_t width, void *ctx) {
+    upm::GroveUltraSonic *This = (upm::GroveUltraSonic *)ctx;
+
+    if (level == HIGH && width / 1000 >= MIN_ECHO_US)
+        This->m_lastEcho = width / 1000;
 }
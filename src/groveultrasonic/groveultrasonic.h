@@ -33,7 +33,13 @@
 #define HIGH                   1
 #define LOW                    0
 
+// in 25 [ms], sound travels 25000 / 29 / 2 = 431 [cm], which is more
+// than 400 [cm], the max distance measurable with this sensor.
+#define GROVEULTRASONIC_ECHO_TIMEOUT_MS 25
+
 namespace upm {
+class EdgeCapture;
+
 
 /**
  * @brief Grove ultrasonic sensor library
@@ -80,6 +86,30 @@ class GroveUltraSonic {
          */
         int getDistance ();
 
+        /**
+         * Starts triggering measurements at a fixed rate in the
+         * background.  Results are collected from the echo interrupt
+         * and read with getLastDistance().  getDistance() must not be
+         * called while ranging.
+         *
+         * @param periodMs Time between measurements in milliseconds
+         */
+        void startRanging (unsigned int periodMs);
+
+        /**
+         * Stops background ranging
+         */
+        void stopRanging ();
+
+        /**
+         * Returns the echo's pulse width of the latest measurement in
+         * microseconds, or -1 if no measurement completed yet
+         */
+        int getLastDistance ()
+        {
+            return m_lastEcho;
+        }
+
         /**
          * Return name of the component
          */
@@ -99,22 +129,19 @@ class GroveUltraSonic {
     private:
         bool m_doWork; /* Flag to control blocking function while waiting for falling edge interrupt */
         mraa_gpio_context m_pinCtx;
-        uint8_t m_InterruptCounter;
-        struct timeval m_RisingTimeStamp;
-        struct timeval m_FallingTimeStamp;
+        EdgeCapture *m_capture;
+        volatile int m_lastEcho;
         std::string m_name;
 
         /**
-         * ISR for the pulse signal
+         * Called from the capture engine at the end of each pulse
          */
-        static void signalISR(void *ctx);
+        static void echoDetected (int level, uint64_t width, void *ctx);
 
         /**
-         * On each interrupt this function will detect if the interrupt
-         * was falling edge or rising.
-         * Should be called from the interrupt handler.
+         * Sends a trigger pulse and switches the pin back to an input
          */
-        void ackEdgeDetected ();
+        static void trigger (void *ctx);
 };
 
 }
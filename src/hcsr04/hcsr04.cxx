@@ -31,12 +31,17 @@
 #include <functional>
 
 #include "hcsr04.h"
+#include "edgecapture.h"
 
 using namespace upm;
 
 HCSR04::HCSR04 (uint8_t triggerPin, uint8_t echoPin) {
     mraa_result_t error  = MRAA_SUCCESS;
     m_name              = "HCSR04";
+    m_ranging           = false;
+    m_lastEcho          = -1;
+    m_echoCount         = 0;
+    m_doWork            = 1;
 
     m_triggerPinCtx     = mraa_gpio_init (triggerPin);
     if (m_triggerPinCtx == NULL) {
@@ -50,18 +55,28 @@ HCSR04::HCSR04 (uint8_t triggerPin, uint8_t echoPin) {
 
     m_echoPinCtx = mraa_gpio_init(echoPin);
     if (m_echoPinCtx == NULL) {
+        mraa_gpio_close (m_triggerPinCtx);
         throw std::invalid_argument(std::string(__FUNCTION__) +
                                     ": mraa_gpio_init() failed, invalid pin?");
         return;
     }
 
-    mraa_gpio_dir(m_echoPinCtx, MRAA_GPIO_IN);
-    mraa_gpio_isr(m_echoPinCtx, MRAA_GPIO_EDGE_BOTH, &ackEdgeDetected, (void*)this);
+    try {
+        m_capture = new EdgeCapture(m_echoPinCtx);
+    } catch (...) {
+        mraa_gpio_close (m_echoPinCtx);
+        mraa_gpio_close (m_triggerPinCtx);
+        throw;
+    }
+
+    m_capture->setPulseHandler(&echoDetected, (void*)this);
 }
 
 HCSR04::~HCSR04 () {
     mraa_result_t error = MRAA_SUCCESS;
 
+    delete m_capture;
+
     error = mraa_gpio_close (m_triggerPinCtx);
     if (error != MRAA_SUCCESS) {
         mraa_result_print (error);
@@ -73,44 +88,85 @@ HCSR04::~HCSR04 () {
     }
 }
 
-double
-HCSR04::timing() {
-    mraa_gpio_write (m_triggerPinCtx, 1);
+void
+HCSR04::trigger (void *ctx) {
+    upm::HCSR04 *This = (upm::HCSR04 *)ctx;
+
+    mraa_gpio_write (This->m_triggerPinCtx, 1);
     usleep(10);
-    mraa_gpio_write (m_triggerPinCtx, 0);
+    mraa_gpio_write (This->m_triggerPinCtx, 0);
+}
 
+double
+HCSR04::timing() {
     m_doWork = 0;
-    m_InterruptCounter = 0;
-    while (!m_doWork) {
-        usleep (5);
-    }
+    m_capture->reset();
+    trigger(this);
+
+    // sleeps until the echo pulse has ended
+    int64_t width = m_capture->waitPulse(1, HCSR04_ECHO_TIMEOUT_MS);
+    m_doWork = 1;
+
+    if (width < 0)
+        return 0;
 
-    return m_FallingTimeStamp - m_RisingTimeStamp;
+    return width / 1000.0;
 }
 
 void
-HCSR04::ackEdgeDetected (void *ctx) {
+HCSR04::echoDetected (int level, uint64_t width, void *ctx) {
     upm::HCSR04 *This = (upm::HCSR04 *)ctx;
-    struct timeval timer;
-    gettimeofday(&timer, NULL);
 
-    This->m_InterruptCounter++;
-    if (!(This->m_InterruptCounter % 2)) {
-        This->m_FallingTimeStamp  = 1000000 * timer.tv_sec + timer.tv_usec;
-        This->m_doWork = 1;
-    } else {
-        This->m_RisingTimeStamp = 1000000 * timer.tv_sec + timer.tv_usec;
+    if (level) {
+        This->m_lastEcho = width / 1000.0;
+        This->m_echoCount++;
     }
 }
 
 double
-HCSR04::getDistance(int sys)
+HCSR04::toDistance(double timing, int sys)
 {
-    double _timing = timing();
     if (sys)
     {
-        return (_timing/2) / 29.1;
+        return (timing/2) / 29.1;
     } else {
-        return (_timing/2) / 74.1;
+        return (timing/2) / 74.1;
     }
 }
+
+double
+HCSR04::getDistance(int sys)
+{
+    if (m_ranging)
+        return getLastDistance(sys);
+
+    return toDistance(timing(), sys);
+}
+
+void
+HCSR04::startRanging(unsigned int periodMs)
+{
+    if (periodMs < HCSR04_ECHO_TIMEOUT_MS)
+        periodMs = HCSR04_ECHO_TIMEOUT_MS;
+
+    m_capture->startTrigger(&trigger, (void*)this, periodMs);
+    m_ranging = true;
+}
+
+void
+HCSR04::stopRanging()
+{
+    m_capture->stopTrigger();
+    m_ranging = false;
+}
+
+double
+HCSR04::getLastDistance(int sys)
+{
+    double echo = m_lastEcho;
+
+    if (echo < 0)
+        return -1;
+
+    return toDistance(echo, sys);
+}
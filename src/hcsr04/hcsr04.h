@@ -37,7 +37,12 @@
 #define CM 1
 #define INC 0
 
+// longest echo pulse (no obstacle) is about 38ms
+#define HCSR04_ECHO_TIMEOUT_MS 60
+
 namespace upm {
+class EdgeCapture;
+
 /**
  * @brief HC-SR04 Ultrasonic Sensor library
  * @defgroup hcsr04 libupm-hcsr04
@@ -75,10 +80,48 @@ class HCSR04 {
         ~HCSR04 ();
 
         /**
-         * Gets the distance from the sensor
+         * Gets the distance from the sensor.  This triggers a
+         * measurement and sleeps until the echo pulse has been
+         * captured, unless ranging is running (see startRanging()), in
+         * which case the latest result is returned immediately.
+         *
+         * @param sys CM or INC
+         * @return Distance, or 0 if no echo was received
          */
         double getDistance (int sys);
 
+        /**
+         * Starts triggering measurements at a fixed rate in the
+         * background.  Results are collected from the echo interrupt
+         * and read with getLastDistance().
+         *
+         * @param periodMs Time between measurements in milliseconds,
+         * at least HCSR04_ECHO_TIMEOUT_MS
+         */
+        void startRanging (unsigned int periodMs);
+
+        /**
+         * Stops background ranging
+         */
+        void stopRanging ();
+
+        /**
+         * Returns the result of the latest measurement
+         *
+         * @param sys CM or INC
+         * @return Distance, or -1 if no measurement completed yet
+         */
+        double getLastDistance (int sys);
+
+        /**
+         * Returns the number of echo pulses received since the object
+         * was created
+         */
+        unsigned int getEchoCount ()
+        {
+            return m_echoCount;
+        }
+
 
         uint8_t m_doWork; /**< Flag to control blocking function while waiting for a falling-edge interrupt */
 
@@ -92,18 +135,26 @@ class HCSR04 {
 
     private:
         /**
-         * On each interrupt, this function detects if the interrupt
-         * was falling-edge or rising-edge.
+         * Called from the capture engine at the end of each pulse on
+         * the echo pin
          */
-        static void ackEdgeDetected (void *ctx);
+        static void echoDetected (int level, uint64_t width, void *ctx);
+
+        /**
+         * Sends a trigger pulse
+         */
+        static void trigger (void *ctx);
 
         double timing();
+        double toDistance(double timing, int sys);
+
         mraa_gpio_context   m_triggerPinCtx;
         mraa_gpio_context   m_echoPinCtx;
+        EdgeCapture         *m_capture;
 
-        long    m_RisingTimeStamp;
-        long    m_FallingTimeStamp;
-        uint8_t m_InterruptCounter;
+        bool                  m_ranging;
+        volatile double       m_lastEcho;
+        volatile unsigned int m_echoCount;
 
         std::string         m_name;
 };
@@ -46,6 +46,8 @@
 #define HM11_DEFAULT_UART 0
 
 namespace upm {
+  class UartPort;
+
     /**
      * @brief HM-11 Bluetooth 4.0 Low Energy Module library
      * @defgroup hm11 libupm-hm11
@@ -133,11 +135,10 @@ namespace upm {
 
 
   protected:
-    int ttyFd() { return m_ttyFd; };
+    int ttyFd();
 
   private:
-    mraa_uart_context m_uart;
-    int m_ttyFd;
+    UartPort *m_port;
   };
 }
 
@@ -43,6 +43,8 @@
 #define HMTRP_DEFAULT_UART 0
 
 namespace upm {
+  class UartPort;
+
 /**
  * @brief HMTRP Serial RF Pro library
  * @defgroup hmtrp libupm-hmtrp
@@ -261,8 +263,7 @@ namespace upm {
 
 
   private:
-    mraa_uart_context m_uart;
-    int m_ttyFd;
+    UartPort *m_port;
   };
 }
 
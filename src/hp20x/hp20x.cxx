@@ -23,6 +23,7 @@
  */
 
 #include <unistd.h>
+#include <time.h>
 #include <math.h>
 #include <iostream>
 #include <string>
@@ -33,11 +34,29 @@
 using namespace upm;
 using namespace std;
 
+static uint64_t getMonotonicUs()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
+// pressure + temperature conversion time in us, indexed by DSR
+static const int convTimePT[] = { 131100, 65600, 32800, 16400, 8200, 4100 };
+
 
 HP20X::HP20X(int bus, uint8_t address):
   m_i2c(bus)
 {
   m_addr = address;
+  m_dsr = DSR_4096;
+  m_converting = false;
+  m_startPending = false;
+  m_convDeadline = 0;
+  m_temperature = 0.0;
+  m_pressure = 0.0;
+  m_altitude = 0.0;
 
   mraa::Result rv;
   if ( (rv = m_i2c.address(m_addr)) != mraa::SUCCESS)
@@ -145,6 +164,11 @@ int HP20X::readData()
       return 0;
     }
 
+  return convertData(buf);
+}
+
+int HP20X::convertData(uint8_t *buf)
+{
   // handle 24bit sign extension
   int minus = 1;
   if (buf[0] & 0x80)
@@ -157,6 +181,77 @@ int HP20X::readData()
   return ( minus * ((buf[0] << 16) | (buf[1] << 8) | buf[2]) );
 }
 
+bool HP20X::startConversion()
+{
+  m_converting = true;
+
+  // if the device is still busy (a previous command, or a reset),
+  // the conversion is started by conversionReady() once it is ready
+  m_startPending = !isReady();
+  if (!m_startPending)
+    issueConversion();
+
+  return true;
+}
+
+void HP20X::issueConversion()
+{
+  // start conversion, PT
+  uint8_t cmd = CMD_ADC_CVT | (CHNL_PT << CHNL_SHIFT) | (m_dsr << DSR_SHIFT);
+  writeCmd(cmd);
+
+  int dsr = (m_dsr <= DSR_128) ? (int)m_dsr : (int)DSR_4096;
+  m_convDeadline = getMonotonicUs() + convTimePT[dsr];
+}
+
+bool HP20X::conversionReady()
+{
+  if (!m_converting)
+    return false;
+
+  if (m_startPending)
+    {
+      if (!isReady())
+        return false;
+
+      m_startPending = false;
+      issueConversion();
+      return false;
+    }
+
+  if (getMonotonicUs() < m_convDeadline)
+    return false;
+
+  return isReady();
+}
+
+bool HP20X::collect()
+{
+  if (!conversionReady())
+    return false;
+
+  m_converting = false;
+
+  // temperature and pressure, 3 bytes each
+  uint8_t buf[6] = {0};
+
+  writeCmd(CMD_READ_PT);
+  if (!m_i2c.read(buf, 6))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": I2c.read() failed");
+      return false;
+    }
+
+  m_temperature = (float)convertData(&buf[0]) / 100.0;
+  m_pressure = (float)convertData(&buf[3]) / 100.0;
+
+  writeCmd(CMD_READ_A);
+  m_altitude = (float)readData() / 100.0;
+
+  return true;
+}
+
 float HP20X::getTemperature()
 {
   // wait for the device to report ready
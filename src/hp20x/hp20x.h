@@ -58,6 +58,10 @@ namespace upm {
    * This module was developed using a Grove Barometer (High-Accuracy)
    * based on an HP206C chip.
    *
+   * startConversion(), conversionReady() and collect() run a
+   * pressure/temperature conversion without blocking, so that many
+   * sensors can be converting at the same time.
+   *
    * @image html hp20x.jpg
    * @snippet hp20x.cxx Interesting
    */
@@ -286,6 +290,55 @@ namespace upm {
      */
     float getAltitude();
 
+    /**
+     * Starts a pressure and temperature conversion and returns
+     * immediately.  If the device is still busy, the conversion is
+     * started by a later conversionReady() once the device is ready.
+     *
+     * @return True if successful
+     */
+    bool startConversion();
+
+    /**
+     * Checks whether the conversion started by startConversion() has
+     * finished.  The device is only queried once the conversion time
+     * for the current DSR has passed.
+     *
+     * @return True if collect() can be called
+     */
+    bool conversionReady();
+
+    /**
+     * Reads the results of a finished conversion.  The values are
+     * then available from getLastTemperature(), getLastPressure() and
+     * getLastAltitude().
+     *
+     * @return True if a result was collected, false if the
+     * conversion is still in progress or none was started
+     */
+    bool collect();
+
+    /**
+     * Returns the temperature from the last collect() in Celsius
+     *
+     * @return Temperature
+     */
+    float getLastTemperature() { return m_temperature; };
+
+    /**
+     * Returns the pressure from the last collect() in millibars
+     *
+     * @return Pressure
+     */
+    float getLastPressure() { return m_pressure; };
+
+    /**
+     * Returns the altitude from the last collect() in meters
+     *
+     * @return Altitude
+     */
+    float getLastAltitude() { return m_altitude; };
+
     /**
      * Enables or disables the on-chip compensator. This allows the
      * chip to filter and clean up the output data.
@@ -376,9 +429,19 @@ namespace upm {
     mraa::I2c m_i2c;
 
   private:
+    int convertData(uint8_t *buf);
+    void issueConversion();
+
     uint8_t m_addr;
     uint8_t m_dsr;
 
+    bool m_converting;
+    bool m_startPending;        // waiting for the device to be ready
+    uint64_t m_convDeadline;
+    float m_temperature;
+    float m_pressure;
+    float m_altitude;
+
   };
 }
 
@@ -0,0 +1,561 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+#include <time.h>
+#include <string.h>
+#include <errno.h>
+
+#include "i2cscheduler.h"
+
+using namespace upm;
+using namespace std;
+
+pthread_mutex_t I2cScheduler::s_busesLock = PTHREAD_MUTEX_INITIALIZER;
+std::vector<int> I2cScheduler::s_buses;
+
+static const uint64_t NEVER = ~(uint64_t)0;
+
+static void toTimespec(uint64_t ns, struct timespec *ts)
+{
+  ts->tv_sec = ns / 1000000000;
+  ts->tv_nsec = ns % 1000000000;
+}
+
+I2cScheduler::I2cScheduler(int bus) :
+  m_bus(bus)
+{
+  pthread_mutex_lock(&s_busesLock);
+  for (size_t i = 0; i < s_buses.size(); i++)
+    {
+      if (s_buses[i] == bus)
+        {
+          pthread_mutex_unlock(&s_busesLock);
+          throw std::invalid_argument(std::string(__FUNCTION__) +
+                                      ": a scheduler already exists for this bus");
+          return;
+        }
+    }
+  s_buses.push_back(bus);
+  pthread_mutex_unlock(&s_busesLock);
+
+  pthread_mutex_init(&m_busLock, NULL);
+  pthread_mutex_init(&m_lock, NULL);
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&m_wakeCond, &attr);
+  pthread_cond_init(&m_doneCond, &attr);
+  pthread_condattr_destroy(&attr);
+
+  m_lastId = 0;
+  m_window = 1000000;
+  m_running = false;
+  m_busy = 0;
+
+  m_lastAddress = -1;
+  m_statsStart = getNanos();
+  m_busyNs = 0;
+  m_transactions = 0;
+  m_addressSwitches = 0;
+}
+
+I2cScheduler::~I2cScheduler()
+{
+  stop();
+
+  for (size_t i = 0; i < m_sensors.size(); i++)
+    delete m_sensors[i];
+
+  pthread_cond_destroy(&m_wakeCond);
+  pthread_cond_destroy(&m_doneCond);
+  pthread_mutex_destroy(&m_lock);
+  pthread_mutex_destroy(&m_busLock);
+
+  pthread_mutex_lock(&s_busesLock);
+  for (size_t i = 0; i < s_buses.size(); i++)
+    {
+      if (s_buses[i] == m_bus)
+        {
+          s_buses.erase(s_buses.begin() + i);
+          break;
+        }
+    }
+  pthread_mutex_unlock(&s_busesLock);
+}
+
+uint64_t I2cScheduler::getNanos()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int I2cScheduler::addSensor(uint8_t address, float rateHz, SAMPLE_T sample,
+                            void *ctx, int deadlineMs, START_T start,
+                            int conversionMs)
+{
+  if (!sample)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": sample callback is NULL");
+      return -1;
+    }
+
+  if (rateHz <= 0.0)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": rate must be greater than 0");
+      return -1;
+    }
+
+  SENSOR_T *s = new SENSOR_T;
+  memset(s, 0, sizeof(SENSOR_T));
+
+  s->address = address;
+  s->rateHz = rateHz;
+  s->period = (uint64_t)(1000000000.0 / rateHz);
+  s->deadline = (deadlineMs > 0) ? (uint64_t)deadlineMs * 1000000 :
+    s->period;
+  s->convTime = (start && conversionMs > 0) ?
+    (uint64_t)conversionMs * 1000000 : 0;
+  s->sample = sample;
+  s->start = start;
+  s->ctx = ctx;
+
+  pthread_mutex_lock(&m_lock);
+
+  s->id = ++m_lastId;
+  s->release = s->due = s->statsStart = getNanos();
+  m_sensors.push_back(s);
+
+  pthread_cond_signal(&m_wakeCond);
+  pthread_mutex_unlock(&m_lock);
+
+  return s->id;
+}
+
+void I2cScheduler::removeSensor(int id)
+{
+  pthread_mutex_lock(&m_lock);
+
+  SENSOR_T *s = findSensor(id);
+  if (s)
+    {
+      while (m_busy == s)
+        pthread_cond_wait(&m_doneCond, &m_lock);
+
+      for (size_t i = 0; i < m_sensors.size(); i++)
+        {
+          if (m_sensors[i] == s)
+            {
+              m_sensors.erase(m_sensors.begin() + i);
+              break;
+            }
+        }
+      delete s;
+
+      // wake up waitReading() callers for this sensor
+      pthread_cond_broadcast(&m_doneCond);
+    }
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+void I2cScheduler::setCoalesceWindow(int us)
+{
+  pthread_mutex_lock(&m_lock);
+  m_window = (us > 0) ? (uint64_t)us * 1000 : 0;
+  pthread_cond_signal(&m_wakeCond);
+  pthread_mutex_unlock(&m_lock);
+}
+
+void I2cScheduler::start()
+{
+  pthread_mutex_lock(&m_lock);
+
+  if (m_running)
+    {
+      pthread_mutex_unlock(&m_lock);
+      return;
+    }
+
+  // sampling periods and statistics start now
+  uint64_t now = getNanos();
+  for (size_t i = 0; i < m_sensors.size(); i++)
+    {
+      SENSOR_T *s = m_sensors[i];
+
+      s->release = s->due = now;
+      s->converting = false;
+    }
+
+  m_running = true;
+  if (pthread_create(&m_thread, NULL, schedulerThread, this))
+    {
+      m_running = false;
+      pthread_mutex_unlock(&m_lock);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_create() failed");
+      return;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+
+  resetStats();
+}
+
+void I2cScheduler::stop()
+{
+  pthread_mutex_lock(&m_lock);
+
+  if (!m_running)
+    {
+      pthread_mutex_unlock(&m_lock);
+      return;
+    }
+
+  m_running = false;
+  pthread_cond_signal(&m_wakeCond);
+  pthread_mutex_unlock(&m_lock);
+
+  pthread_join(m_thread, NULL);
+}
+
+void I2cScheduler::lock()
+{
+  pthread_mutex_lock(&m_busLock);
+}
+
+void I2cScheduler::unlock()
+{
+  pthread_mutex_unlock(&m_busLock);
+}
+
+bool I2cScheduler::getReading(int id, READING_T *reading)
+{
+  pthread_mutex_lock(&m_lock);
+
+  SENSOR_T *s = findSensor(id);
+  if (!s)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": invalid sensor id");
+      return false;
+    }
+
+  *reading = s->reading;
+  pthread_mutex_unlock(&m_lock);
+
+  return (reading->seq != 0);
+}
+
+bool I2cScheduler::waitReading(int id, uint32_t afterSeq, READING_T *reading,
+                               int millis)
+{
+  struct timespec deadline;
+  bool rv = false;
+
+  if (millis >= 0)
+    toTimespec(getNanos() + (uint64_t)millis * 1000000, &deadline);
+
+  pthread_mutex_lock(&m_lock);
+
+  for (;;)
+    {
+      SENSOR_T *s = findSensor(id);
+      if (!s)
+        break;
+
+      if (s->reading.seq != afterSeq && s->reading.seq != 0)
+        {
+          *reading = s->reading;
+          rv = true;
+          break;
+        }
+
+      if (millis < 0)
+        pthread_cond_wait(&m_doneCond, &m_lock);
+      else if (pthread_cond_timedwait(&m_doneCond, &m_lock, &deadline)
+               == ETIMEDOUT)
+        break;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+
+  return rv;
+}
+
+void I2cScheduler::getSensorStats(int id, SENSOR_STATS_T *stats)
+{
+  pthread_mutex_lock(&m_lock);
+
+  SENSOR_T *s = findSensor(id);
+  if (!s)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": invalid sensor id");
+      return;
+    }
+
+  double secs = (double)(getNanos() - s->statsStart) / 1000000000.0;
+
+  stats->requestedHz = s->rateHz;
+  stats->achievedHz = (secs > 0.0) ? (float)(s->samples / secs) : 0.0;
+  stats->samples = s->samples;
+  stats->errors = s->errors;
+  stats->missedDeadlines = s->missed;
+  stats->overruns = s->overruns;
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+void I2cScheduler::getBusStats(BUS_STATS_T *stats)
+{
+  pthread_mutex_lock(&m_lock);
+
+  stats->busyNs = m_busyNs;
+  stats->elapsedNs = getNanos() - m_statsStart;
+  stats->utilization = (stats->elapsedNs) ?
+    (float)((double)m_busyNs / stats->elapsedNs) : 0.0;
+  stats->transactions = m_transactions;
+  stats->addressSwitches = m_addressSwitches;
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+void I2cScheduler::resetStats()
+{
+  pthread_mutex_lock(&m_lock);
+
+  uint64_t now = getNanos();
+
+  for (size_t i = 0; i < m_sensors.size(); i++)
+    {
+      SENSOR_T *s = m_sensors[i];
+
+      s->statsStart = now;
+      s->samples = 0;
+      s->errors = 0;
+      s->missed = 0;
+      s->overruns = 0;
+    }
+
+  m_statsStart = now;
+  m_busyNs = 0;
+  m_transactions = 0;
+  m_addressSwitches = 0;
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+I2cScheduler::SENSOR_T *I2cScheduler::findSensor(int id)
+{
+  for (size_t i = 0; i < m_sensors.size(); i++)
+    {
+      if (m_sensors[i]->id == id)
+        return m_sensors[i];
+    }
+
+  return 0;
+}
+
+I2cScheduler::SENSOR_T *I2cScheduler::nextSensor(uint64_t now,
+                                                 uint64_t *wakeup)
+{
+  SENSOR_T *atRisk = 0;
+  SENSOR_T *sameAddr = 0;
+  SENSOR_T *due = 0;
+  uint64_t earliest = NEVER;
+
+  for (size_t i = 0; i < m_sensors.size(); i++)
+    {
+      SENSOR_T *s = m_sensors[i];
+      uint64_t deadline = s->release + s->deadline;
+
+      if (s->due < earliest)
+        earliest = s->due;
+
+      if (s->due > now + m_window)
+        continue;
+
+      if (s->due <= now)
+        {
+          // earliest deadline first, lower address on a tie
+          if (deadline <= now + m_window &&
+              (!atRisk || deadline < atRisk->release + atRisk->deadline))
+            atRisk = s;
+
+          if (!due || deadline < due->release + due->deadline ||
+              (deadline == due->release + due->deadline &&
+               s->address < due->address))
+            due = s;
+        }
+
+      // no address switch needed.  A converting sensor's due time is
+      // when its result is ready, it can't be collected any earlier.
+      if (m_window && s->address == m_lastAddress &&
+          (!s->converting || s->due <= now) &&
+          (!sameAddr || s->due < sameAddr->due))
+        sameAddr = s;
+    }
+
+  if (atRisk)
+    return atRisk;
+  if (sameAddr)
+    return sameAddr;
+  if (due)
+    return due;
+
+  *wakeup = earliest;
+  return 0;
+}
+
+void I2cScheduler::finishSample(SENSOR_T *s, int count, const float *values,
+                                uint64_t when)
+{
+  if (count < 0)
+    s->errors++;
+  else
+    {
+      if (count > I2CSCHED_MAX_VALUES)
+        count = I2CSCHED_MAX_VALUES;
+
+      for (int i = 0; i < count; i++)
+        s->reading.values[i] = values[i];
+      s->reading.count = count;
+      s->reading.timestamp = when;
+      if (++s->reading.seq == 0)
+        s->reading.seq = 1;
+
+      s->samples++;
+      if (when > s->release + s->deadline)
+        s->missed++;
+    }
+
+  // next period; skip the ones that are already over
+  uint64_t next = s->release + s->period;
+  if (next + s->period <= when)
+    {
+      uint64_t skip = (when - next) / s->period;
+
+      s->overruns += skip;
+      next += skip * s->period;
+    }
+
+  s->release = s->due = next;
+}
+
+void *I2cScheduler::schedulerThread(void *ctx)
+{
+  I2cScheduler *self = (I2cScheduler *)ctx;
+
+  pthread_mutex_lock(&self->m_lock);
+
+  while (self->m_running)
+    {
+      uint64_t wakeup = NEVER;
+      SENSOR_T *s = self->nextSensor(getNanos(), &wakeup);
+
+      if (!s)
+        {
+          if (wakeup == NEVER)
+            pthread_cond_wait(&self->m_wakeCond, &self->m_lock);
+          else
+            {
+              struct timespec deadline;
+
+              toTimespec(wakeup, &deadline);
+              pthread_cond_timedwait(&self->m_wakeCond, &self->m_lock,
+                                     &deadline);
+            }
+          continue;
+        }
+
+      bool starting = (s->start && !s->converting);
+      START_T start = s->start;
+      SAMPLE_T sample = s->sample;
+      void *sctx = s->ctx;
+
+      self->m_busy = s;
+      pthread_mutex_unlock(&self->m_lock);
+
+      float values[I2CSCHED_MAX_VALUES];
+      int count = -1;
+      bool started = false;
+
+      pthread_mutex_lock(&self->m_busLock);
+      uint64_t t0 = getNanos();
+      try
+        {
+          if (starting)
+            started = start(sctx);
+          else
+            count = sample(values, I2CSCHED_MAX_VALUES, sctx);
+        }
+      catch (...)
+        {
+          started = false;
+          count = -1;
+        }
+      uint64_t t1 = getNanos();
+      pthread_mutex_unlock(&self->m_busLock);
+
+      pthread_mutex_lock(&self->m_lock);
+
+      self->m_busy = 0;
+      self->m_busyNs += t1 - t0;
+      self->m_transactions++;
+      if (s->address != self->m_lastAddress)
+        {
+          if (self->m_lastAddress >= 0)
+            self->m_addressSwitches++;
+          self->m_lastAddress = s->address;
+        }
+
+      if (starting && started)
+        {
+          s->converting = true;
+          s->due = t1 + s->convTime;
+        }
+      else
+        {
+          s->converting = false;
+          self->finishSample(s, count, values, t1);
+        }
+
+      pthread_cond_broadcast(&self->m_doneCond);
+    }
+
+  pthread_mutex_unlock(&self->m_lock);
+
+  return 0;
+}
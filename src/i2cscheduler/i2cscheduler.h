@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <stdint.h>
+#include <pthread.h>
+
+#define I2CSCHED_MAX_VALUES 8
+
+namespace upm {
+  /**
+   * @brief I2C bus scheduler
+   * @defgroup i2cscheduler libupm-i2cscheduler
+   * @ingroup i2c
+   */
+
+  /**
+   * @library i2cscheduler
+   * @sensor i2cscheduler
+   * @comname I2C bus scheduler
+   * @con i2c
+   *
+   * @brief Samples many I2C sensors sharing one adapter
+   *
+   * An I2cScheduler owns one I2C adapter and samples the sensors
+   * registered with addSensor() from a single background thread, at
+   * the rate requested for each.  All sampling on the adapter is
+   * serialized by that thread; other code that needs the bus can
+   * bracket its transactions with lock() and unlock().
+   *
+   * Sensors are sampled through callbacks, so any driver can be
+   * used unmodified.  A sensor with a start callback is sampled in
+   * two phases (see startConversion()/collect() in the drivers): the
+   * conversion is started, the bus is used for other sensors while
+   * it runs, and the sample callback is called once the conversion
+   * time has passed.
+   *
+   * When several sensors are due at once, they are ordered by
+   * deadline, but a sensor at the slave address used last is run
+   * first (even up to the coalescing window early) to avoid address
+   * switches, as long as no other sensor's deadline is at risk.
+   *
+   * Readings are published with a CLOCK_MONOTONIC timestamp and a
+   * sequence number and can be read with getReading() or
+   * waitReading() from any thread.
+   *
+   * @snippet i2cscheduler-sim.cxx Interesting
+   */
+  class I2cScheduler {
+  public:
+    /**
+     * Sample callback.  Reads the sensor and stores up to maxValues
+     * values.
+     *
+     * @return The number of values stored, or -1 on error
+     */
+    typedef int (*SAMPLE_T)(float *values, int maxValues, void *ctx);
+
+    /**
+     * Conversion start callback, for two phase sampling
+     *
+     * @return True if the conversion was started
+     */
+    typedef bool (*START_T)(void *ctx);
+
+    typedef struct {
+      uint64_t timestamp;       // CLOCK_MONOTONIC, ns
+      uint32_t seq;             // 0 until the first reading
+      int count;
+      float values[I2CSCHED_MAX_VALUES];
+    } READING_T;
+
+    typedef struct {
+      float requestedHz;
+      float achievedHz;
+      uint32_t samples;
+      uint32_t errors;
+      uint32_t missedDeadlines; // sample finished after its deadline
+      uint32_t overruns;        // sampling periods skipped entirely
+    } SENSOR_STATS_T;
+
+    typedef struct {
+      float utilization;        // busyNs / elapsedNs
+      uint64_t busyNs;          // time spent in callbacks
+      uint64_t elapsedNs;
+      uint32_t transactions;    // callbacks run
+      uint32_t addressSwitches;
+    } BUS_STATS_T;
+
+    /**
+     * I2cScheduler constructor.  Only one scheduler can exist per
+     * adapter.
+     *
+     * @param bus I2C adapter the sensors are connected to
+     */
+    I2cScheduler(int bus);
+
+    /**
+     * I2cScheduler destructor; stops the scheduler
+     */
+    ~I2cScheduler();
+
+    /**
+     * Adds a sensor.  It is first sampled as soon as the scheduler
+     * is running.
+     *
+     * @param address Slave address of the sensor, used for ordering
+     * @param rateHz Requested sampling rate
+     * @param sample Sample callback
+     * @param ctx Context passed to the callbacks
+     * @param deadlineMs Time from the start of a sampling period by
+     * which the sample must be done; 0 for the whole period
+     * @param start Optional conversion start callback
+     * @param conversionMs Conversion time, if start is used
+     * @return Id of the sensor
+     */
+    int addSensor(uint8_t address, float rateHz, SAMPLE_T sample, void *ctx,
+                  int deadlineMs=0, START_T start=0, int conversionMs=0);
+
+    /**
+     * Removes a sensor, waiting for a callback in progress to return
+     *
+     * @param id Id returned by addSensor()
+     */
+    void removeSensor(int id);
+
+    /**
+     * Sets the coalescing window.  A sensor at the current slave
+     * address may be sampled up to this early, and sensors whose
+     * deadline is within the window are never delayed for the sake
+     * of address ordering.  0 disables address ordering.
+     *
+     * @param us Window in microseconds, default 1000
+     */
+    void setCoalesceWindow(int us);
+
+    /**
+     * Starts the scheduler thread
+     */
+    void start();
+
+    /**
+     * Stops the scheduler thread, after the callback in progress
+     */
+    void stop();
+
+    /**
+     * Locks the adapter against the scheduler, for transactions
+     * made outside of the callbacks
+     */
+    void lock();
+
+    /**
+     * Releases the lock taken with lock()
+     */
+    void unlock();
+
+    /**
+     * Gets the latest reading of a sensor
+     *
+     * @param id Id returned by addSensor()
+     * @param reading Returned reading
+     * @return True if the sensor has been sampled at least once
+     */
+    bool getReading(int id, READING_T *reading);
+
+    /**
+     * Waits for a reading newer than a given sequence number
+     *
+     * @param id Id returned by addSensor()
+     * @param afterSeq Sequence number of the last reading seen
+     * @param reading Returned reading
+     * @param millis Timeout in milliseconds, -1 to wait forever
+     * @return True if a newer reading was returned
+     */
+    bool waitReading(int id, uint32_t afterSeq, READING_T *reading,
+                     int millis=-1);
+
+    /**
+     * Gets the statistics of a sensor since it was added or the
+     * last resetStats()
+     *
+     * @param id Id returned by addSensor()
+     * @param stats Returned statistics
+     */
+    void getSensorStats(int id, SENSOR_STATS_T *stats);
+
+    /**
+     * Gets the adapter statistics since start() or the last
+     * resetStats()
+     *
+     * @param stats Returned statistics
+     */
+    void getBusStats(BUS_STATS_T *stats);
+
+    /**
+     * Resets the sensor and adapter statistics
+     */
+    void resetStats();
+
+    /**
+     * Returns the current CLOCK_MONOTONIC time, as used for the
+     * reading timestamps
+     *
+     * @return Time in nanoseconds
+     */
+    static uint64_t getNanos();
+
+  private:
+    typedef struct {
+      int id;
+      uint8_t address;
+      float rateHz;
+      uint64_t period;
+      uint64_t deadline;
+      uint64_t convTime;
+      SAMPLE_T sample;
+      START_T start;
+      void *ctx;
+
+      uint64_t release;         // start of the current period
+      uint64_t due;             // next callback
+      bool converting;
+      READING_T reading;
+
+      uint64_t statsStart;
+      uint32_t samples;
+      uint32_t errors;
+      uint32_t missed;
+      uint32_t overruns;
+    } SENSOR_T;
+
+    // called with m_lock held
+    SENSOR_T *findSensor(int id);
+    SENSOR_T *nextSensor(uint64_t now, uint64_t *wakeup);
+    void finishSample(SENSOR_T *s, int count, const float *values,
+                      uint64_t when);
+
+    static void *schedulerThread(void *ctx);
+
+    int m_bus;
+    pthread_mutex_t m_busLock;
+
+    // everything below is protected by m_lock
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_wakeCond;
+    pthread_cond_t m_doneCond;
+
+    std::vector<SENSOR_T *> m_sensors;
+    int m_lastId;
+    uint64_t m_window;
+
+    pthread_t m_thread;
+    bool m_running;
+    SENSOR_T *m_busy;           // sensor whose callback is running
+
+    int m_lastAddress;
+    uint64_t m_statsStart;
+    uint64_t m_busyNs;
+    uint32_t m_transactions;
+    uint32_t m_addressSwitches;
+
+    static pthread_mutex_t s_busesLock;
+    static std::vector<int> s_buses;
+  };
+}
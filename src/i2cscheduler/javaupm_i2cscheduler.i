@@ -0,0 +1,20 @@
+%module javaupm_i2cscheduler
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "i2cscheduler.h"
+%}
+
+%include "i2cscheduler.h"
+
+%pragma(java) jniclasscode=%{
+    static {
+        try {
+            System.loadLibrary("javaupm_i2cscheduler");
+        } catch (UnsatisfiedLinkError e) {
+            System.err.println("Native code library failed to load. \n" + e);
+            System.exit(1);
+        }
+    }
+%}
@@ -0,0 +1,9 @@
+%module jsupm_i2cscheduler
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "i2cscheduler.h"
+%}
+
+%include "i2cscheduler.h"
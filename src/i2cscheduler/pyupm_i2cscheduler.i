@@ -0,0 +1,13 @@
+// Include doxygen-generated documentation
+%include "pyupm_doxy2swig.i"
+%module pyupm_i2cscheduler
+%include "../upm.i"
+%include "stdint.i"
+
+%feature("autodoc", "3");
+
+%{
+    #include "i2cscheduler.h"
+%}
+
+%include "i2cscheduler.h"
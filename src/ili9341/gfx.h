@@ -267,7 +267,8 @@ namespace upm
                                uint16_t color);
                                
             /**
-             * Draw a character at the specified point.
+             * Draw a character at the specified point. Can be overridden
+             * with a screen-specific definition.
              *
              * @param x X-axis coordinate of the top-left corner
              * @param y Y-axis coordinate of the top-left corner
@@ -276,12 +277,12 @@ namespace upm
              * @param bg Background color (16-bit RGB)
              * @param size Font size
              */
-            void drawChar(int16_t x, 
-                          int16_t y, 
-                          unsigned char c, 
-                          uint16_t color,
-                          uint16_t bg, 
-                          uint8_t size);
+            virtual void drawChar(int16_t x, 
+                                  int16_t y, 
+                                  unsigned char c, 
+                                  uint16_t color,
+                                  uint16_t bg, 
+                                  uint8_t size);
             
             /**
              * Get the x-axis coordinate of the upper-left corner of the cursor.
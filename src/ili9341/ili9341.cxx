@@ -40,6 +40,8 @@ using namespace upm;
 ILI9341::ILI9341(uint8_t csLCD, uint8_t csSD, uint8_t dc, uint8_t rst) :
     GFX(ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT), m_csLCDPinCtx(csLCD), 
     m_csSDPinCtx(csSD), m_dcPinCtx(dc), m_rstPinCtx(rst), m_spi(0) {
+
+    m_spiBufferColor = -1;
     
     initModule();
     configModule();
@@ -267,19 +269,7 @@ void ILI9341::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
     }
 
     setAddrWindow(x, y, x, y+h-1);
-
-    uint8_t hi = color >> 8;
-    uint8_t lo = color;
-    
-    lcdCSOn();
-    dcHigh();
-
-    while (h--) {
-        m_spi.writeByte(hi);
-        m_spi.writeByte(lo);
-    }
-
-    lcdCSOff();
+    writeColor(color, h);
 }
 
 void ILI9341::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
@@ -294,19 +284,7 @@ void ILI9341::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
     }
 
     setAddrWindow(x, y, x+w-1, y);
-
-    uint8_t hi = color >> 8;
-    uint8_t lo = color;
-
-    lcdCSOn();
-    dcHigh();
-
-    while (w--) {
-        m_spi.writeByte(hi);
-        m_spi.writeByte(lo);
-    }
-
-    lcdCSOff();
+    writeColor(color, w);
 }
 
 void ILI9341::fillRect(int16_t x, 
@@ -321,25 +299,132 @@ void ILI9341::fillRect(int16_t x,
     if((y + h - 1) >= _height) h = _height - y;
 
     setAddrWindow(x, y, x+w-1, y+h-1);
+    writeColor(color, (uint32_t) w * h);
+}
+
+void ILI9341::fillScreen(uint16_t color) {
+    fillRect(0, 0,  _width, _height, color);
+}
+
+void ILI9341::drawChar(int16_t x,
+                       int16_t y,
+                       unsigned char c,
+                       uint16_t color,
+                       uint16_t bg,
+                       uint8_t size) {
+
+    int16_t w = 6 * size;
+    int16_t h = 8 * size;
+
+    // Transparent text only touches the set pixels, and clipped glyphs
+    // can't use a single address window; both take the generic path.
+    if((bg == color) || (x < 0) || (y < 0) ||
+       ((x + w) > _width) || ((y + h) > _height) ||
+       (w * 2 > ILI9341_SPI_BUFFER_SIZE)) {
+        GFX::drawChar(x, y, c, color, bg, size);
+        return;
+    }
+
+    if(!_cp437 && (c >= 176)) c++; // Handle 'classic' charset behavior
+
+    setAddrWindow(x, y, x + w - 1, y + h - 1);
 
-    uint8_t hi = color >> 8;
-    uint8_t lo = color;
-  
     lcdCSOn();
     dcHigh();
 
-    for(y = h; y > 0; y--) {
-        for(x = w; x > 0; x--) {
-            m_spi.writeByte(hi);
-            m_spi.writeByte(lo);
+    m_spiBufferColor = -1;
+    int len = 0;
+    for(int8_t j = 0; j < 8; j++) {
+        // build one scanline of the glyph, then repeat it size times
+        uint8_t *row = &m_spiBuffer[len];
+        int rowLen = 0;
+        for(int8_t i = 0; i < 6; i++) {
+            uint8_t line = (i < 5) ? font[(c * 5) + i] : 0x0;
+            uint16_t pixel = ((line >> j) & 0x1) ? color : bg;
+            for(uint8_t s = 0; s < size; s++) {
+                row[rowLen++] = pixel >> 8;
+                row[rowLen++] = pixel;
+            }
+        }
+        len += rowLen;
+
+        for(uint8_t s = 1; s < size; s++) {
+            if(len + rowLen > ILI9341_SPI_BUFFER_SIZE) {
+                flushSpiBuffer(len);
+                // the moved copy is this repetition of the scanline
+                memmove(m_spiBuffer, row, rowLen);
+                row = m_spiBuffer;
+                len = rowLen;
+                continue;
+            }
+            memcpy(&m_spiBuffer[len], row, rowLen);
+            len += rowLen;
+        }
+
+        if(len + w * 2 > ILI9341_SPI_BUFFER_SIZE) {
+            flushSpiBuffer(len);
+            len = 0;
         }
     }
+    flushSpiBuffer(len);
 
     lcdCSOff();
 }
 
-void ILI9341::fillScreen(uint16_t color) {
-    fillRect(0, 0,  _width, _height, color);
+void ILI9341::writeColor(uint16_t color, uint32_t count) {
+    const uint32_t pixels = ILI9341_SPI_BUFFER_SIZE / 2;
+
+    // the buffer keeps its pattern, so repeated fills skip this
+    if(m_spiBufferColor != color) {
+        for(uint32_t i = 0; i < pixels; i++) {
+            m_spiBuffer[i * 2] = color >> 8;
+            m_spiBuffer[i * 2 + 1] = color;
+        }
+        m_spiBufferColor = color;
+    }
+
+    lcdCSOn();
+    dcHigh();
+
+    while(count > 0) {
+        uint32_t n = (count > pixels) ? pixels : count;
+        flushSpiBuffer(n * 2);
+        count -= n;
+    }
+
+    lcdCSOff();
+}
+
+void ILI9341::writePixels(const uint16_t *colors, uint32_t count) {
+    const uint32_t pixels = ILI9341_SPI_BUFFER_SIZE / 2;
+
+    m_spiBufferColor = -1;
+
+    lcdCSOn();
+    dcHigh();
+
+    while(count > 0) {
+        uint32_t n = (count > pixels) ? pixels : count;
+        for(uint32_t i = 0; i < n; i++) {
+            m_spiBuffer[i * 2] = colors[i] >> 8;
+            m_spiBuffer[i * 2 + 1] = colors[i];
+        }
+        flushSpiBuffer(n * 2);
+        colors += n;
+        count -= n;
+    }
+
+    lcdCSOff();
+}
+
+void ILI9341::flushSpiBuffer(int bytes) {
+    if(bytes <= 0) {
+        return;
+    }
+
+    if(m_spi.transfer(m_spiBuffer, NULL, bytes) != mraa::SUCCESS) {
+        mraa::printError(mraa::ERROR_UNSPECIFIED);
+    }
 }
 
 void ILI9341::invertDisplay(bool i) {
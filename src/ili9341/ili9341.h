@@ -40,6 +40,9 @@
 
 #define SPI_FREQ            15000000
 
+// line buffer used to batch pixel data into large SPI transfers
+#define ILI9341_SPI_BUFFER_SIZE 4096
+
 #define ILI9341_NOP         0x00
 #define ILI9341_SWRESET     0x01
 #define ILI9341_RDDID       0x04
@@ -244,6 +247,43 @@ namespace upm {
              * @param color RGB (16-bit) color (R[0-4], G[5-10], B[11-15]
              */
             void fillScreen(uint16_t color);
+
+            /**
+             * Draw a character at the specified point. Glyphs with an
+             * opaque background are rendered into the line buffer and
+             * sent as a single block.
+             *
+             * @param x X-axis coordinate of the top-left corner
+             * @param y Y-axis coordinate of the top-left corner
+             * @param c Character to draw
+             * @param color RGB (16-bit) color (R[0-4], G[5-10], B[11-15]
+             * @param bg Background color (16-bit RGB)
+             * @param size Font size
+             */
+            void drawChar(int16_t x,
+                          int16_t y,
+                          unsigned char c,
+                          uint16_t color,
+                          uint16_t bg,
+                          uint8_t size);
+
+            /**
+             * Sends the same color count times to the current address
+             * window, in transfers of up to ILI9341_SPI_BUFFER_SIZE bytes.
+             *
+             * @param color RGB (16-bit) color (R[0-4], G[5-10], B[11-15]
+             * @param count Number of pixels
+             */
+            void writeColor(uint16_t color, uint32_t count);
+
+            /**
+             * Sends a run of pixels to the current address window, in
+             * transfers of up to ILI9341_SPI_BUFFER_SIZE bytes.
+             *
+             * @param colors RGB (16-bit) colors
+             * @param count Number of pixels
+             */
+            void writePixels(const uint16_t *colors, uint32_t count);
             
             /**
              * Sets the screen to one of four 90 deg rotations.
@@ -331,8 +371,12 @@ namespace upm {
             mraa::Result rstLow();
             
         private:
+            void flushSpiBuffer(int bytes);
+
             mraa::Spi   m_spi;
-            uint8_t     m_spiBuffer[32];
+            uint8_t     m_spiBuffer[ILI9341_SPI_BUFFER_SIZE];
+            // color m_spiBuffer is currently filled with, -1 if none
+            int32_t     m_spiBufferColor;
             
             mraa::Gpio  m_csLCDPinCtx;
             mraa::Gpio  m_csSDPinCtx;
@@ -27,6 +27,7 @@
 #include <stdexcept>
 
 #include "l298.h"
+#include "motionengine.h"
 
 using namespace upm;
 using namespace std;
@@ -36,6 +37,7 @@ L298::L298(int pwmA, int dir1, int dir2)
 {
   // No stepper in this mode
   m_stepper = false;
+  m_axis = 0;
 
   // disable until complete
   m_motor = false;
@@ -80,6 +82,7 @@ L298::L298(int stepsPerRev, int en, int i1, int i2, int i3, int i4)
 
   // disable until complete
   m_stepper = false;
+  m_axis = 0;
 
   m_stepsPerRev = stepsPerRev;
   m_currentStep = 0;
@@ -134,6 +137,20 @@ L298::L298(int stepsPerRev, int en, int i1, int i2, int i3, int i4)
     }
   mraa_gpio_dir(m_stepI4, MRAA_GPIO_OUT);
 
+  try
+    {
+      m_axis = new MotionAxis(&stepCallback, this);
+    }
+  catch (...)
+    {
+      mraa_gpio_close(m_stepEnable);
+      mraa_gpio_close(m_stepI1);
+      mraa_gpio_close(m_stepI2);
+      mraa_gpio_close(m_stepI3);
+      mraa_gpio_close(m_stepI4);
+      throw;
+    }
+
   m_stepper = true;
 }
 
@@ -176,6 +193,7 @@ L298::~L298()
 {
   if (m_stepper)
     {
+      delete m_axis;
       enable(false);
       mraa_gpio_close(m_stepEnable);
       mraa_gpio_close(m_stepI1);
@@ -239,6 +257,7 @@ void L298::setSpeed(int speed)
   if (m_stepper)
     {
       m_stepDelay = 60 * 1000 / m_stepsPerRev / speed;
+      m_axis->setMaxSpeed(double(speed) * m_stepsPerRev / 60.0);
     }
 }
 
@@ -317,29 +336,28 @@ void L298::stepperStep()
 
 void L298::stepperSteps(unsigned int steps)
 {
-  while (steps > 0)
+  if (!m_stepper)
+    return;
+
+  m_axis->waitMove(m_axis->move(m_stepDirection * int(steps)));
+}
+
+void L298::stepCallback(int dir, void *ctx)
+{
+  L298 *This = (L298 *)ctx;
+
+  This->m_currentStep += dir;
+
+  if (dir == 1)
     {
-      if (getMillis() >= m_stepDelay)
-        {
-          // reset the clock
-          initClock();
-
-          m_currentStep += m_stepDirection;
-
-          if (m_stepDirection == 1)
-            {
-              if (m_currentStep >= m_stepsPerRev)
-                m_currentStep = 0;
-            }
-          else
-            {
-              if (m_currentStep <= 0)
-                m_currentStep = m_stepsPerRev;
-            }
-
-          steps--;
-          stepperStep();
-          // cerr << "STEPNUM: " << m_currentStep << endl;
-        }
+      if (This->m_currentStep >= This->m_stepsPerRev)
+        This->m_currentStep = 0;
     }
+  else
+    {
+      if (This->m_currentStep <= 0)
+        This->m_currentStep = This->m_stepsPerRev;
+    }
+
+  This->stepperStep();
 }
@@ -33,6 +33,8 @@
 #define L298_DEFAULT_PWM_PERIOD 4
 
 namespace upm {
+  class MotionAxis;
+
   /**
    * @brief L298 Dual H-Bridge Motor Driver library
    * @defgroup l298 libupm-l298
@@ -149,12 +151,22 @@ namespace upm {
     void setDirection(L298_DIRECTION_T dir);
 
     /**
-     * Steps the stepper motor a specified number of steps
+     * Steps the stepper motor a specified number of steps, sleeping
+     * until the motion engine has taken them
      *
      * @param steps Number of steps to move the stepper motor
      */
     void stepperSteps(unsigned int steps);
 
+    /**
+     * Returns the motion engine axis driving the stepper motor, for
+     * non-blocking moves, acceleration and position.  Speeds on the
+     * axis are in steps per second.
+     *
+     * @return Motion axis, or NULL in DC motor mode
+     */
+    MotionAxis *getMotionAxis() { return m_axis; };
+
   private:
     // DC motor mode enabled
     bool m_motor;
@@ -180,12 +192,17 @@ namespace upm {
     int m_currentStep;
     uint32_t m_stepDelay;
 
+    MotionAxis *m_axis;
+
     /**
      * Steps the motor one tick
      *
      */
     void stepperStep();
 
+    // motion engine step callback
+    static void stepCallback(int dir, void *ctx);
+
     // step direction: - 1 = forward, -1 = backward
     int m_stepDirection;
   };
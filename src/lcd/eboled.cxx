@@ -43,6 +43,7 @@ EBOLED::EBOLED(int spi, int CD, int reset) :
   m_textSize = 1;
   m_cursorX = 0;
   m_cursorY = 0;
+  m_refreshBytes = 0;
 
   m_gpioCD.dir(mraa::DIR_OUT);
   m_gpioRST.dir(mraa::DIR_OUT);
@@ -97,15 +98,11 @@ EBOLED::EBOLED(int spi, int CD, int reset) :
 
   setAddressingMode(HORIZONTAL);
 
-  //Set Page Address range, required for horizontal addressing mode.
-  command(CMD_SETPAGEADDRESS); // triple-byte cmd
-  command(0x00); //Initial page address
-  command(0x05); //Final page address
+  // Page and column ranges are required for horizontal addressing mode
+  setWindow(0, 0, OLED_WIDTH - 1, OLED_HEIGHT / 8 - 1);
 
-  //Set Column Address range, required for horizontal addressing mode.
-  command(CMD_SETCOLUMNADDRESS); // triple-byte cmd
-  command(0x20); // this display has a horizontal offset of 20 columns
-  command(0x5f); // 64 columns wide - 0 based 63 offset
+  // the screen buffer is shared, so the first refresh sends all of it
+  invalidate();
 }
 
 EBOLED::~EBOLED()
@@ -115,16 +112,43 @@ EBOLED::~EBOLED()
 
 mraa::Result EBOLED::refresh()
 {
-  mraa::Result error = mraa::SUCCESS;;
-
-  m_gpioCD.write(1);            // data mode
-  for(int i=0; i<BUFFER_SIZE; i++)
+  mraa::Result error = mraa::SUCCESS;
+  uint8_t buf[BUFFER_SIZE * 2];
+  int len = 0;
+
+  m_refreshBytes = 0;
+  if (m_dirtyX0 > m_dirtyX1)
+    return error;
+
+  // each buffer word holds two columns, so widen to whole words
+  int word0 = m_dirtyX0 / 2;
+  int word1 = m_dirtyX1 / 2;
+  int page0 = m_dirtyY0 / 8;
+  int page1 = m_dirtyY1 / 8;
+
+  error = setWindow(word0 * 2, page0, word1 * 2 + 1, page1);
+  if (error != mraa::SUCCESS)
+    return error;
+  m_refreshBytes += 6;
+
+  // low byte first, as write_word() would send it
+  for (int page = page0; page <= page1; page++)
   {
-    error = data(screenBuffer[i]);
-    if(error != mraa::SUCCESS)
-      return error;
+    for (int word = word0; word <= word1; word++)
+    {
+      uint16_t value = screenBuffer[word + (page * VERT_COLUMNS)];
+      buf[len++] = value & 0xff;
+      buf[len++] = value >> 8;
+    }
   }
 
+  m_gpioCD.write(1);            // data mode
+  m_spi.transfer(buf, NULL, len);
+  m_refreshBytes += len;
+
+  m_dirtyX0 = m_dirtyY0 = OLED_WIDTH;
+  m_dirtyX1 = m_dirtyY1 = -1;
+
   return error;
 }
 
@@ -215,6 +239,9 @@ mraa::Result EBOLED::clear()
 {
   mraa::Result error = mraa::SUCCESS;;
 
+  // a partial refresh may have left a smaller window behind
+  setWindow(0, 0, OLED_WIDTH - 1, OLED_HEIGHT / 8 - 1);
+
   m_gpioCD.write(1);            // data mode
   for(int i=0; i<BUFFER_SIZE; i++)
   {
@@ -223,6 +250,9 @@ mraa::Result EBOLED::clear()
       return error;
   }
 
+  // the screen no longer matches the buffer
+  invalidate();
+
   return mraa::SUCCESS;;
 }
 
@@ -236,6 +266,8 @@ void EBOLED::drawPixel(int8_t x, int8_t y, uint8_t color)
   if(x<0 || x>=OLED_WIDTH || y<0 || y>=OLED_HEIGHT)
     return;
 
+  markDirty(x, y);
+
   /* Screenbuffer is uint16 array, but pages are 8bit high so each buffer
    * index is two columns.  This means the index is based on x/2 and
    * OLED_WIDTH/2 = VERT_COLUMNS.
@@ -564,4 +596,38 @@ void EBOLED::clearScreenBuffer()
 {
   for(int i=0; i<BUFFER_SIZE;i++)
     screenBuffer[i] = 0x0000;
+
+  invalidate();
+}
+
+void EBOLED::invalidate()
+{
+  m_dirtyX0 = 0;
+  m_dirtyY0 = 0;
+  m_dirtyX1 = OLED_WIDTH - 1;
+  m_dirtyY1 = OLED_HEIGHT - 1;
+}
+
+int EBOLED::getRefreshBytes()
+{
+  return m_refreshBytes;
+}
+
+void EBOLED::markDirty(int8_t x, int8_t y)
+{
+  if (x < m_dirtyX0) m_dirtyX0 = x;
+  if (y < m_dirtyY0) m_dirtyY0 = y;
+  if (x > m_dirtyX1) m_dirtyX1 = x;
+  if (y > m_dirtyY1) m_dirtyY1 = y;
+}
+
+mraa::Result EBOLED::setWindow(uint8_t x0, uint8_t page0, uint8_t x1, uint8_t page1)
+{
+  command(CMD_SETPAGEADDRESS); // triple-byte cmd
+  command(page0);
+  command(page1);
+
+  command(CMD_SETCOLUMNADDRESS); // triple-byte cmd
+  command(0x20 + x0); // this display has a horizontal offset of 20 columns
+  return command(0x20 + x1);
 }
@@ -129,7 +129,8 @@ namespace upm
 
     /**
      * Draw the buffer to screen, see examples/python/make_oled_pic.py for an
-     * explanation on how the pixels are mapped to bytes.
+     * explanation on how the pixels are mapped to bytes.  Only the
+     * pages and columns changed since the last refresh are sent.
      *
      * @param data the buffer to write
      * @param bytes the number of bytes to write
@@ -198,6 +199,20 @@ namespace upm
 
     void clearScreenBuffer();
 
+    /**
+     * Mark the whole screen buffer as changed so the next refresh
+     * sends all of it
+     */
+    void invalidate();
+
+    /**
+     * Return the number of bytes sent over SPI by the last refresh,
+     * including the address window setup
+     *
+     * @return bytes transferred
+     */
+    int getRefreshBytes();
+
     /**
      * Return to coordinate 0,0
      *
@@ -361,8 +376,11 @@ namespace upm
     mraa::Result data(uint16_t data);
     mraa::Result writeChar(uint8_t value);
     mraa::Result setAddressingMode(displayAddressingMode mode);
+    mraa::Result setWindow(uint8_t x0, uint8_t page0, uint8_t x1, uint8_t page1);
 
   private:
+    void markDirty(int8_t x, int8_t y);
+
     mraa::Gpio m_gpioCD;        // command(0)/data(1)
     mraa::Gpio m_gpioRST;       // reset pin
 
@@ -373,5 +391,12 @@ namespace upm
     uint8_t m_textSize;
     uint8_t m_textColor;
     uint8_t m_textWrap;
+
+    // region changed since the last refresh, empty when x0 > x1
+    int m_dirtyX0;
+    int m_dirtyY0;
+    int m_dirtyX1;
+    int m_dirtyY1;
+    int m_refreshBytes;
   };
 }
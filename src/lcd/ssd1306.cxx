@@ -34,7 +34,8 @@
 
 using namespace upm;
 
-SSD1306::SSD1306(int bus_in, int addr_in) : m_i2c_lcd_control(bus_in)
+SSD1306::SSD1306(int bus_in, int addr_in) : m_i2c_lcd_control(bus_in),
+    m_framebuffer(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT / 8)
 {
     int vccstate = SSD1306_SWITCHCAPVCC;
     _vccstate = vccstate;
@@ -116,14 +117,10 @@ SSD1306::~SSD1306()
 mraa::Result
 SSD1306::draw(uint8_t* data, int bytes)
 {
-    mraa::Result error = mraa::SUCCESS;
-
     setAddressingMode(HORIZONTAL);
-    for (int idx = 0; idx < bytes; idx++) {
-        m_i2c_lcd_control.writeReg(LCD_DATA, data[idx]);
-    }
+    bytes = m_framebuffer.load(data, bytes);
 
-    return error;
+    return m_framebuffer.flush(m_i2c_lcd_control, LCD_DATA, bytes);
 }
 
 /*
@@ -195,16 +192,11 @@ SSD1306::home()
 mraa::Result
 SSD1306::writeChar(uint8_t value)
 {
-    mraa::Result rv;
     if (value < 0x20 || value > 0x7F) {
         value = 0x20; // space
     }
 
-    for (uint8_t idx = 0; idx < 8; idx++) {
-        rv = m_i2c_lcd_control.writeReg(LCD_DATA, BasicFont[value - 32][idx]);
-    }
-
-    return rv;
+    return ssdWriteBurst(m_i2c_lcd_control, LCD_DATA, BasicFont[value - 32], 8);
 }
 
 mraa::Result
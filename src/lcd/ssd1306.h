@@ -32,6 +32,7 @@
 #include <mraa/i2c.hpp>
 #include "lcd.h"
 #include "ssd.h"
+#include "ssdbuffer.h"
 
 namespace upm
 {
@@ -121,7 +122,9 @@ class SSD1306 : public LCD
     ~SSD1306();
     /**
      * Draws an image; see examples/python/make_oled_pic.py for an
-     * explanation of how pixels are mapped to bytes
+     * explanation of how pixels are mapped to bytes.  The image is
+     * copied into a host-side framebuffer and sent one page per I2C
+     * transaction.
      *
      * @param data Buffer to read
      * @param bytes Number of bytes to read from the pointer
@@ -224,6 +227,7 @@ class SSD1306 : public LCD
 
     int m_lcd_control_address;
     mraa::I2c m_i2c_lcd_control;
+    SSDFrameBuffer m_framebuffer;
 
     int _vccstate;
 };
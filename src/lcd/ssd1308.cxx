@@ -31,7 +31,8 @@
 
 using namespace upm;
 
-SSD1308::SSD1308(int bus_in, int addr_in) : m_i2c_lcd_control(bus_in)
+SSD1308::SSD1308(int bus_in, int addr_in) : m_i2c_lcd_control(bus_in),
+    m_framebuffer(SSD1308_LCDWIDTH, SSD1308_LCDHEIGHT / 8)
 {
     m_lcd_control_address = addr_in;
     m_name = "SSD1308";
@@ -60,14 +61,10 @@ SSD1308::~SSD1308()
 mraa::Result
 SSD1308::draw(uint8_t* data, int bytes)
 {
-    mraa::Result error = mraa::SUCCESS;
-
     setAddressingMode(HORIZONTAL);
-    for (int idx = 0; idx < bytes; idx++) {
-        m_i2c_lcd_control.writeReg(LCD_DATA, data[idx]);
-    }
+    bytes = m_framebuffer.load(data, bytes);
 
-    return error;
+    return m_framebuffer.flush(m_i2c_lcd_control, LCD_DATA, bytes);
 }
 
 /*
@@ -140,16 +137,11 @@ SSD1308::home()
 mraa::Result
 SSD1308::writeChar(uint8_t value)
 {
-    mraa::Result rv;
     if (value < 0x20 || value > 0x7F) {
         value = 0x20; // space
     }
 
-    for (uint8_t idx = 0; idx < 8; idx++) {
-        rv = m_i2c_lcd_control.writeReg(LCD_DATA, BasicFont[value - 32][idx]);
-    }
-
-    return rv;
+    return ssdWriteBurst(m_i2c_lcd_control, LCD_DATA, BasicFont[value - 32], 8);
 }
 
 mraa::Result
@@ -28,10 +28,13 @@
 #include <mraa/i2c.hpp>
 #include "lcd.h"
 #include "ssd.h"
+#include "ssdbuffer.h"
 
 namespace upm
 {
 const uint8_t DISPLAY_CMD_SET_NORMAL_1308 = 0xA6;
+const uint8_t SSD1308_LCDWIDTH = 128;
+const uint8_t SSD1308_LCDHEIGHT = 64;
 
 /**
  * @library i2clcd
@@ -69,7 +72,9 @@ class SSD1308 : public LCD
     ~SSD1308();
     /**
      * Draws an image; see examples/python/make_oled_pic.py for an
-     * explanation of how pixels are mapped to bytes
+     * explanation of how pixels are mapped to bytes.  The image is
+     * copied into a host-side framebuffer and sent one page per I2C
+     * transaction.
      *
      * @param data Buffer to read
      * @param bytes Number of bytes to read from the pointer
@@ -112,5 +117,6 @@ class SSD1308 : public LCD
 
     int m_lcd_control_address;
     mraa::I2c m_i2c_lcd_control;
+    SSDFrameBuffer m_framebuffer;
 };
 }
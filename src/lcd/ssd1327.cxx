@@ -24,6 +24,7 @@
 
 #include <stdexcept>
 #include <string>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include "hd44780_bits.h"
@@ -34,12 +35,46 @@ using namespace upm;
 #define INIT_SLEEP 50000
 #define CMD_SLEEP 10000
 
-SSD1327::SSD1327(int bus_in, int addr_in) : m_i2c_lcd_control(bus_in)
+// Control byte for a run of command bytes (Co = 0, D/C# = 0)
+#define CMD_STREAM 0x00
+
+// Two 4-bit pixels per byte, the left one in the high nibble
+#define ROW_BYTES (SSD1327_LCDWIDTH / 2)
+
+// Builds the lookup table that turns a pair of 1-bit pixels (left
+// pixel in bit 1) into one display byte.
+static void
+makePairTable(uint8_t fg, uint8_t bg, uint8_t table[4])
+{
+    fg &= 0x0F;
+    bg &= 0x0F;
+
+    table[0] = (bg << 4) | bg;
+    table[1] = (bg << 4) | fg;
+    table[2] = (fg << 4) | bg;
+    table[3] = (fg << 4) | fg;
+}
+
+// Expands 8 pixels (MSB is leftmost) into 4 display bytes
+static void
+expandByte(uint8_t bits, const uint8_t table[4], uint8_t* out)
+{
+    out[0] = table[(bits >> 6) & 0x03];
+    out[1] = table[(bits >> 4) & 0x03];
+    out[2] = table[(bits >> 2) & 0x03];
+    out[3] = table[bits & 0x03];
+}
+
+SSD1327::SSD1327(int bus_in, int addr_in) : m_i2c_lcd_control(bus_in),
+    m_framebuffer(SSD1327_LCDWIDTH / 2, SSD1327_LCDHEIGHT)
 {
     mraa::Result error = mraa::SUCCESS;
 
     m_lcd_control_address = addr_in;
     m_name = "SSD1327";
+    m_dirtyFirst = SSD1327_LCDHEIGHT;
+    m_dirtyLast = -1;
+    setGrayLevel(12);
 
     error = m_i2c_lcd_control.address(m_lcd_control_address);
     if (error != mraa::SUCCESS) {
@@ -149,25 +184,21 @@ SSD1327::~SSD1327()
 mraa::Result
 SSD1327::draw(uint8_t* data, int bytes)
 {
-    mraa::Result error = mraa::SUCCESS;
-
-    setHorizontalMode();
-    for (int row = 0; row < bytes; row++) {
-        for (uint8_t col = 0; col < 8; col += 2) {
-            uint8_t value = 0x0;
+    uint8_t* fb = m_framebuffer.data();
+    uint8_t table[4];
 
-            uint8_t bitOne = (data[row] << col) & 0x80;
-            uint8_t bitTwo = (data[row] << (col + 1)) & 0x80;
+    // each source byte expands to 8 pixels, 2 pixels per display byte
+    if (bytes > m_framebuffer.size() / 4)
+        bytes = m_framebuffer.size() / 4;
 
-            value |= (bitOne) ? grayHigh : 0x00;
-            value |= (bitTwo) ? grayLow : 0x00;
-
-            m_i2c_lcd_control.writeReg(LCD_DATA, value);
-            usleep(CMD_SLEEP - 2000);
-        }
+    makePairTable(grayLow, 0, table);
+    for (int i = 0; i < bytes; i++) {
+        expandByte(data[i], table, fb);
+        fb += 4;
     }
 
-    return error;
+    setHorizontalMode();
+    return m_framebuffer.flush(m_i2c_lcd_control, LCD_DATA, bytes * 4);
 }
 
 /*
@@ -191,41 +222,31 @@ SSD1327::write(std::string msg)
 mraa::Result
 SSD1327::setCursor(int row, int column)
 {
-    mraa::Result error = mraa::SUCCESS;
-
-    // Column Address
-    m_i2c_lcd_control.writeReg(LCD_CMD, 0x15); /* Set Column Address */
-    usleep(CMD_SLEEP);
-    m_i2c_lcd_control.writeReg(LCD_CMD, 0x08 + (column * 4)); /* Start Column:
-                                                                                  Start from 8 */
-    usleep(CMD_SLEEP);
-    m_i2c_lcd_control.writeReg(LCD_CMD, 0x37); /* End Column */
-    usleep(CMD_SLEEP);
-    // Row Address
-    m_i2c_lcd_control.writeReg(LCD_CMD, 0x75); /* Set Row Address */
-    usleep(CMD_SLEEP);
-    m_i2c_lcd_control.writeReg(LCD_CMD, 0x00 + (row * 8)); /* Start Row*/
-    usleep(CMD_SLEEP);
-    m_i2c_lcd_control.writeReg(LCD_CMD, 0x07 + (row * 8)); /* End Row*/
-    usleep(CMD_SLEEP);
-
-    return error;
+    uint8_t cmds[] = {
+        0x15,                       // Set Column Address
+        (uint8_t)(0x08 + (column * 4)), // Start Column: Start from 8
+        0x37,                       // End Column
+        0x75,                       // Set Row Address
+        (uint8_t)(0x00 + (row * 8)),    // Start Row
+        (uint8_t)(0x07 + (row * 8)),    // End Row
+    };
+
+    return sendCommands(cmds, sizeof(cmds));
 }
 
 mraa::Result
 SSD1327::clear()
 {
-    mraa::Result error = mraa::SUCCESS;
-    uint8_t columnIdx, rowIdx;
+    mraa::Result rv = mraa::SUCCESS;
 
-    for (rowIdx = 0; rowIdx < 12; rowIdx++) {
-        // clear all columns
-        for (columnIdx = 0; columnIdx < 12; columnIdx++) {
-            writeChar(' ');
-        }
-    }
+    // one pass of whole rows instead of 144 blank characters
+    clearBuffer(0);
+    rv = flush();
+
+    setVerticalMode();
+    home();
 
-    return mraa::SUCCESS;
+    return rv;
 }
 
 mraa::Result
@@ -241,6 +262,216 @@ SSD1327::setGrayLevel(uint8_t level)
     grayLow = level & 0x0F;
 }
 
+void
+SSD1327::clearBuffer(uint8_t gray)
+{
+    gray &= 0x0F;
+    m_framebuffer.fill((gray << 4) | gray);
+    markDirty(0, SSD1327_LCDHEIGHT - 1);
+}
+
+void
+SSD1327::setPixel(int x, int y, uint8_t gray)
+{
+    if (x < 0 || x >= SSD1327_LCDWIDTH || y < 0 || y >= SSD1327_LCDHEIGHT)
+        return;
+
+    uint8_t* p = &m_framebuffer.data()[(y * ROW_BYTES) + (x / 2)];
+
+    if (x & 1)
+        *p = (*p & 0xF0) | (gray & 0x0F);
+    else
+        *p = (*p & 0x0F) | ((gray & 0x0F) << 4);
+
+    markDirty(y, y);
+}
+
+uint8_t
+SSD1327::getPixel(int x, int y)
+{
+    if (x < 0 || x >= SSD1327_LCDWIDTH || y < 0 || y >= SSD1327_LCDHEIGHT)
+        return 0;
+
+    uint8_t value = m_framebuffer.data()[(y * ROW_BYTES) + (x / 2)];
+
+    return (x & 1) ? (value & 0x0F) : (value >> 4);
+}
+
+void
+SSD1327::fillRect(int x, int y, int width, int height, uint8_t gray)
+{
+    int x1 = x + width;
+    int y1 = y + height;
+
+    if (x < 0)
+        x = 0;
+    if (y < 0)
+        y = 0;
+    if (x1 > SSD1327_LCDWIDTH)
+        x1 = SSD1327_LCDWIDTH;
+    if (y1 > SSD1327_LCDHEIGHT)
+        y1 = SSD1327_LCDHEIGHT;
+    if (x >= x1 || y >= y1)
+        return;
+
+    gray &= 0x0F;
+    uint8_t pair = (gray << 4) | gray;
+
+    for (int row = y; row < y1; row++) {
+        uint8_t* line = &m_framebuffer.data()[row * ROW_BYTES];
+        int col = x;
+
+        // odd edge pixels share a byte with their neighbour
+        if (col & 1) {
+            line[col / 2] = (line[col / 2] & 0xF0) | gray;
+            col++;
+        }
+        for (; col + 1 < x1; col += 2)
+            line[col / 2] = pair;
+        if (col < x1)
+            line[col / 2] = (line[col / 2] & 0x0F) | (gray << 4);
+    }
+
+    markDirty(y, y1 - 1);
+}
+
+void
+SSD1327::drawLine(int x0, int y0, int x1, int y1, uint8_t gray)
+{
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx + dy;
+
+    for (;;) {
+        setPixel(x0, y0, gray);
+        if (x0 == x1 && y0 == y1)
+            break;
+
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+void
+SSD1327::drawBitmap(int x, int y, int width, int height,
+                    const uint8_t* bitmap, uint8_t fg, uint8_t bg)
+{
+    int stride = (width + 7) / 8;
+    uint8_t table[4];
+
+    makePairTable(fg, bg, table);
+
+    for (int row = 0; row < height; row++) {
+        const uint8_t* src = &bitmap[row * stride];
+        int py = y + row;
+
+        if (py < 0 || py >= SSD1327_LCDHEIGHT)
+            continue;
+
+        // byte-aligned and fully visible: expand straight into the row
+        if (!(x & 1) && x >= 0 && x + width <= SSD1327_LCDWIDTH) {
+            uint8_t* dst = &m_framebuffer.data()[(py * ROW_BYTES) + (x / 2)];
+            int col = 0;
+
+            for (; col + 8 <= width; col += 8) {
+                expandByte(src[col / 8], table, dst);
+                dst += 4;
+            }
+            for (; col < width; col += 2) {
+                uint8_t pair = ((src[col / 8] << (col % 8)) & 0xFF) >> 6;
+
+                // an odd width leaves the right half of the last byte
+                if (col + 1 < width)
+                    *dst++ = table[pair & 0x03];
+                else
+                    *dst = (*dst & 0x0F) | (table[pair & 0x03] & 0xF0);
+            }
+            markDirty(py, py);
+            continue;
+        }
+
+        for (int col = 0; col < width; col++) {
+            bool set = (src[col / 8] << (col % 8)) & 0x80;
+            setPixel(x + col, py, set ? fg : bg);
+        }
+    }
+}
+
+void
+SSD1327::drawGlyph(int x, int y, int width, int height,
+                   const uint8_t* coverage, uint8_t gray)
+{
+    gray &= 0x0F;
+
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            int alpha = coverage[(row * width) + col] & 0x0F;
+
+            if (alpha == 0)
+                continue;
+
+            int under = getPixel(x + col, y + row);
+            // both terms are non-negative, so the rounding is the same
+            // for dark-on-light and light-on-dark
+            int value = ((under * (15 - alpha)) + (gray * alpha) + 7) / 15;
+
+            setPixel(x + col, y + row, value);
+        }
+    }
+}
+
+void
+SSD1327::drawString(int x, int y, std::string msg, uint8_t fg, uint8_t bg)
+{
+    for (std::string::size_type i = 0; i < msg.size(); i++, x += 8) {
+        uint8_t value = msg[i];
+        uint8_t glyph[8];
+
+        if (value < 0x20 || value > 0x7F)
+            value = 0x20; // space
+
+        // BasicFont is stored a column per byte, LSB at the top
+        for (int row = 0; row < 8; row++) {
+            glyph[row] = 0;
+            for (int col = 0; col < 8; col++) {
+                if ((BasicFont[value - 32][col] >> row) & 0x1)
+                    glyph[row] |= 0x80 >> col;
+            }
+        }
+
+        drawBitmap(x, y, 8, 8, glyph, fg, bg);
+    }
+}
+
+mraa::Result
+SSD1327::flush()
+{
+    mraa::Result rv = mraa::SUCCESS;
+
+    if (m_dirtyFirst > m_dirtyLast)
+        return rv;
+
+    rv = setRowWindow(m_dirtyFirst, m_dirtyLast);
+    if (rv == mraa::SUCCESS)
+        rv = m_framebuffer.flushLines(m_i2c_lcd_control, LCD_DATA,
+                                      m_dirtyFirst,
+                                      m_dirtyLast - m_dirtyFirst + 1);
+
+    m_dirtyFirst = SSD1327_LCDHEIGHT;
+    m_dirtyLast = -1;
+
+    return rv;
+}
+
 /*
  * **************
  *  private area
@@ -254,20 +485,21 @@ SSD1327::writeChar(uint8_t value)
         value = 0x20; // space
     }
 
+    // the whole 8x8 cell goes out as a single 32-byte transaction
+    uint8_t cell[32];
+    uint8_t* data = cell;
+
     for (uint8_t row = 0; row < 8; row = row + 2) {
         for (uint8_t col = 0; col < 8; col++) {
-            uint8_t data = 0x0;
-
             uint8_t bitOne = ((BasicFont[value - 32][row]) >> col) & 0x1;
             uint8_t bitTwo = ((BasicFont[value - 32][row + 1]) >> col) & 0x1;
 
-            data |= (bitOne) ? grayHigh : 0x00;
-            data |= (bitTwo) ? grayLow : 0x00;
-
-            rv = m_i2c_lcd_control.writeReg(LCD_DATA, data);
-            usleep(CMD_SLEEP - 2000);
+            *data = (bitOne) ? grayHigh : 0x00;
+            *data++ |= (bitTwo) ? grayLow : 0x00;
         }
     }
+
+    rv = ssdWriteBurst(m_i2c_lcd_control, LCD_DATA, cell, sizeof(cell));
     return rv;
 }
 
@@ -281,39 +513,51 @@ SSD1327::setNormalDisplay()
 mraa::Result
 SSD1327::setHorizontalMode()
 {
-    mraa::Result rv = mraa::SUCCESS;
-    rv = m_i2c_lcd_control.writeReg(LCD_CMD, 0xA0); // remap to
-    usleep(CMD_SLEEP);
-    rv = m_i2c_lcd_control.writeReg(LCD_CMD, 0x42); // horizontal mode
-    usleep(CMD_SLEEP);
+    return setRowWindow(0, SSD1327_LCDHEIGHT - 1);
+}
 
-    // Row Address
-    rv = m_i2c_lcd_control.writeReg(LCD_CMD, 0x75); // Set Row Address
-    usleep(CMD_SLEEP);
-    rv = m_i2c_lcd_control.writeReg(LCD_CMD, 0x00); // Start 0
-    usleep(CMD_SLEEP);
-    rv = m_i2c_lcd_control.writeReg(LCD_CMD, 0x5f); // End 95
-    usleep(CMD_SLEEP);
+mraa::Result
+SSD1327::setVerticalMode()
+{
+    uint8_t cmds[] = {
+        0xA0, // remap to
+        0x46, // Vertical mode
+    };
 
-    // Column Address
-    rv = m_i2c_lcd_control.writeReg(LCD_CMD, 0x15); // Set Column Address
-    usleep(CMD_SLEEP);
-    rv = m_i2c_lcd_control.writeReg(LCD_CMD, 0x08); // Start from 8th Column of driver
-                                               // IC. This is 0th Column for OLED
-    usleep(CMD_SLEEP);
-    rv = m_i2c_lcd_control.writeReg(LCD_CMD, 0x37); // End at  (8 + 47)th column. Each
-                                               // Column has 2 pixels(or segments)
-    usleep(CMD_SLEEP);
-    return rv;
+    return sendCommands(cmds, sizeof(cmds));
 }
 
 mraa::Result
-SSD1327::setVerticalMode()
+SSD1327::setRowWindow(int first, int last)
 {
-    mraa::Result rv = mraa::SUCCESS;
-    rv = m_i2c_lcd_control.writeReg(LCD_CMD, 0xA0); // remap to
-    usleep(CMD_SLEEP);
-    rv = m_i2c_lcd_control.writeReg(LCD_CMD, 0x46); // Vertical mode
-    usleep(CMD_SLEEP);
-    return rv;
+    uint8_t cmds[] = {
+        0xA0,           // remap to
+        0x42,           // horizontal mode
+        0x75,           // Set Row Address
+        (uint8_t)first, // Start
+        (uint8_t)last,  // End
+        0x15,           // Set Column Address
+        0x08,           // Start from 8th Column of driver IC. This is 0th
+                        // Column for OLED
+        0x37,           // End at (8 + 47)th column. Each Column has 2
+                        // pixels(or segments)
+    };
+
+    return sendCommands(cmds, sizeof(cmds));
+}
+
+mraa::Result
+SSD1327::sendCommands(const uint8_t* cmds, int count)
+{
+    // a command run needs no settling time between bytes
+    return ssdWriteBurst(m_i2c_lcd_control, CMD_STREAM, cmds, count);
+}
+
+void
+SSD1327::markDirty(int y0, int y1)
+{
+    if (y0 < m_dirtyFirst)
+        m_dirtyFirst = y0;
+    if (y1 > m_dirtyLast)
+        m_dirtyLast = y1;
 }
@@ -28,10 +28,13 @@
 #include <mraa/i2c.hpp>
 #include "lcd.h"
 #include "ssd.h"
+#include "ssdbuffer.h"
 
 namespace upm
 {
 const uint8_t DISPLAY_CMD_SET_NORMAL = 0xA4;
+const uint8_t SSD1327_LCDWIDTH = 96;
+const uint8_t SSD1327_LCDHEIGHT = 96;
 
 /**
  * @library i2clcd
@@ -50,8 +53,15 @@ const uint8_t DISPLAY_CMD_SET_NORMAL = 0xA4;
  * This implementation was tested using the Grove LED 96×96 Display module,
  * which is an OLED monochrome display.
  *
+ * The display can also be driven through a host-side 4-bit grayscale
+ * framebuffer: draw into it with setPixel(), fillRect(), drawLine(),
+ * drawBitmap(), drawGlyph() and drawString(), then call flush() to
+ * send the rows that changed.  Text written with write() goes to the
+ * display directly and is not part of the framebuffer.
+ *
  * @image html ssd1327.jpeg
  * @snippet ssd1327-oled.cxx Interesting
+ * @snippet ssd1327-gray.cxx Interesting
  */
 class SSD1327 : public LCD
 {
@@ -69,7 +79,9 @@ class SSD1327 : public LCD
     ~SSD1327();
     /**
      * Draws an image; see examples/python/make_oled_pic.py for an
-     * explanation of how pixels are mapped to bytes
+     * explanation of how pixels are mapped to bytes.  The image is
+     * expanded to 4-bit gray levels in a host-side framebuffer and
+     * sent one pixel row per I2C transaction.
      *
      * @param data Buffer to read
      * @param bytes Number of bytes to read from the pointer
@@ -111,17 +123,112 @@ class SSD1327 : public LCD
      * @return Result of the operation
      */
     mraa::Result home();
+    /**
+     * Fills the framebuffer with one gray level
+     *
+     * @param gray Gray level from 0 to 15
+     */
+    void clearBuffer(uint8_t gray = 0);
+    /**
+     * Sets one pixel in the framebuffer; pixels outside the display
+     * are ignored
+     *
+     * @param x Column, 0 is left
+     * @param y Row, 0 is top
+     * @param gray Gray level from 0 to 15
+     */
+    void setPixel(int x, int y, uint8_t gray);
+    /**
+     * Returns the gray level of a pixel in the framebuffer
+     *
+     * @param x Column, 0 is left
+     * @param y Row, 0 is top
+     * @return Gray level from 0 to 15, 0 outside the display
+     */
+    uint8_t getPixel(int x, int y);
+    /**
+     * Fills a rectangle in the framebuffer
+     *
+     * @param x Left column
+     * @param y Top row
+     * @param width Width in pixels
+     * @param height Height in pixels
+     * @param gray Gray level from 0 to 15
+     */
+    void fillRect(int x, int y, int width, int height, uint8_t gray);
+    /**
+     * Draws a line into the framebuffer
+     *
+     * @param x0 Start column
+     * @param y0 Start row
+     * @param x1 End column
+     * @param y1 End row
+     * @param gray Gray level from 0 to 15
+     */
+    void drawLine(int x0, int y0, int x1, int y1, uint8_t gray);
+    /**
+     * Draws a 1-bit image into the framebuffer.  Rows are packed MSB
+     * first and padded to whole bytes, as for draw()
+     *
+     * @param x Left column
+     * @param y Top row
+     * @param width Width in pixels
+     * @param height Height in pixels
+     * @param bitmap Image data
+     * @param fg Gray level for set bits
+     * @param bg Gray level for clear bits
+     */
+    void drawBitmap(int x, int y, int width, int height,
+                    const uint8_t* bitmap, uint8_t fg, uint8_t bg);
+    /**
+     * Blends an anti-aliased glyph into the framebuffer.  Each
+     * coverage byte (0-15, one per pixel, row by row) mixes the gray
+     * level with the pixel already there
+     *
+     * @param x Left column
+     * @param y Top row
+     * @param width Width in pixels
+     * @param height Height in pixels
+     * @param coverage Coverage values
+     * @param gray Gray level of the glyph
+     */
+    void drawGlyph(int x, int y, int width, int height,
+                   const uint8_t* coverage, uint8_t gray);
+    /**
+     * Draws text into the framebuffer with the built-in 8x8 font
+     *
+     * @param x Left column
+     * @param y Top row
+     * @param msg Text to draw; only ASCII characters are supported
+     * @param fg Gray level of the text
+     * @param bg Gray level of the background
+     */
+    void drawString(int x, int y, std::string msg, uint8_t fg, uint8_t bg);
+    /**
+     * Sends the framebuffer rows changed since the last flush, one
+     * row per I2C transaction
+     *
+     * @return Result of the operation
+     */
+    mraa::Result flush();
 
   private:
     mraa::Result writeChar(uint8_t value);
     mraa::Result setNormalDisplay();
     mraa::Result setHorizontalMode();
     mraa::Result setVerticalMode();
+    mraa::Result setRowWindow(int first, int last);
+    mraa::Result sendCommands(const uint8_t* cmds, int count);
+    void markDirty(int y0, int y1);
 
     uint8_t grayHigh;
     uint8_t grayLow;
 
     int m_lcd_control_address;
     mraa::I2c m_i2c_lcd_control;
+    SSDFrameBuffer m_framebuffer;
+    // rows changed since the last flush(), empty when first > last
+    int m_dirtyFirst;
+    int m_dirtyLast;
 };
 }
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "ssdbuffer.h"
+
+using namespace upm;
+
+SSDFrameBuffer::SSDFrameBuffer(int lineBytes, int lines) :
+    m_lineBytes(lineBytes), m_buffer(lineBytes * lines, 0)
+{
+}
+
+int
+SSDFrameBuffer::load(const uint8_t* data, int bytes)
+{
+    if (bytes > size())
+        bytes = size();
+    if (bytes <= 0)
+        return 0;
+
+    memcpy(&m_buffer[0], data, bytes);
+    return bytes;
+}
+
+void
+SSDFrameBuffer::fill(uint8_t value)
+{
+    memset(&m_buffer[0], value, m_buffer.size());
+}
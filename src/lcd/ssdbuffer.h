@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <mraa/types.hpp>
+
+namespace upm
+{
+// Largest data payload sent behind a single control byte.  The
+// controllers accept any length; this only bounds the stack buffer.
+const int SSD_BURST_MAX = 128;
+
+/**
+ * Writes a block of display RAM data as I2C bursts.  Each transaction
+ * carries one control byte followed by up to SSD_BURST_MAX data
+ * bytes, instead of one control/data pair per byte.
+ *
+ * BUS is any type providing mraa::I2c's write(const uint8_t*, int).
+ *
+ * @param bus I2C context, already addressed to the controller
+ * @param control Control byte (normally LCD_DATA)
+ * @param data Buffer to send
+ * @param bytes Number of bytes to send
+ * @return Result of the last failing transaction, or SUCCESS
+ */
+template <typename BUS>
+mraa::Result
+ssdWriteBurst(BUS& bus, uint8_t control, const uint8_t* data, int bytes)
+{
+    uint8_t burst[SSD_BURST_MAX + 1];
+    mraa::Result rv = mraa::SUCCESS;
+
+    burst[0] = control;
+    while (bytes > 0) {
+        int len = (bytes > SSD_BURST_MAX) ? SSD_BURST_MAX : bytes;
+
+        for (int i = 0; i < len; i++) {
+            burst[i + 1] = data[i];
+        }
+
+        mraa::Result error = bus.write(burst, len + 1);
+        if (error != mraa::SUCCESS) {
+            rv = error;
+        }
+
+        data += len;
+        bytes -= len;
+    }
+
+    return rv;
+}
+
+/**
+ * @brief Host-side framebuffer for the SSD13xx OLED controllers
+ *
+ * Holds a copy of the display RAM as a sequence of lines (pages on
+ * SSD1306/SSD1308, pixel rows on SSD1327) and flushes it one line
+ * per I2C transaction.
+ */
+class SSDFrameBuffer
+{
+  public:
+    /**
+     * SSDFrameBuffer constructor
+     *
+     * @param lineBytes Number of bytes in one page/row of display RAM
+     * @param lines Number of pages/rows
+     */
+    SSDFrameBuffer(int lineBytes, int lines);
+
+    /**
+     * Copies data into the framebuffer starting at offset 0; data
+     * beyond the end of the framebuffer is ignored
+     *
+     * @param data Buffer to read
+     * @param bytes Number of bytes to read from the pointer
+     * @return Number of bytes actually stored
+     */
+    int load(const uint8_t* data, int bytes);
+
+    /**
+     * Fills the whole framebuffer with a value
+     *
+     * @param value Byte to store
+     */
+    void fill(uint8_t value);
+
+    /**
+     * Returns a pointer to the framebuffer memory
+     */
+    uint8_t* data() { return &m_buffer[0]; };
+
+    /**
+     * Returns the framebuffer size in bytes
+     */
+    int size() { return (int)m_buffer.size(); };
+
+    /**
+     * Returns the number of bytes in a page/row
+     */
+    int lineBytes() { return m_lineBytes; };
+
+    /**
+     * Streams the first bytes of the framebuffer to the controller,
+     * one page/row per transaction
+     *
+     * @param bus I2C context, already addressed to the controller
+     * @param control Control byte (normally LCD_DATA)
+     * @param bytes Number of bytes to send, -1 for the whole buffer
+     * @return Result of the operation
+     */
+    template <typename BUS>
+    mraa::Result flush(BUS& bus, uint8_t control, int bytes = -1)
+    {
+        mraa::Result rv = mraa::SUCCESS;
+
+        if (bytes < 0 || bytes > size())
+            bytes = size();
+
+        for (int offset = 0; offset < bytes; offset += m_lineBytes) {
+            int len = bytes - offset;
+            if (len > m_lineBytes)
+                len = m_lineBytes;
+
+            mraa::Result error = ssdWriteBurst(bus, control,
+                                               &m_buffer[offset], len);
+            if (error != mraa::SUCCESS)
+                rv = error;
+        }
+
+        return rv;
+    }
+
+    /**
+     * Streams a range of whole pages/rows to the controller, one per
+     * transaction.  The controller's address window must already
+     * cover exactly these lines.
+     *
+     * @param bus I2C context, already addressed to the controller
+     * @param control Control byte (normally LCD_DATA)
+     * @param first First page/row to send
+     * @param count Number of pages/rows to send
+     * @return Result of the operation
+     */
+    template <typename BUS>
+    mraa::Result flushLines(BUS& bus, uint8_t control, int first, int count)
+    {
+        mraa::Result rv = mraa::SUCCESS;
+        int lines = size() / m_lineBytes;
+
+        if (first < 0)
+            first = 0;
+        if (first + count > lines)
+            count = lines - first;
+
+        for (int line = first; line < first + count; line++) {
+            mraa::Result error = ssdWriteBurst(bus, control,
+                                               &m_buffer[line * m_lineBytes],
+                                               m_lineBytes);
+            if (error != mraa::SUCCESS)
+                rv = error;
+        }
+
+        return rv;
+    }
+
+  private:
+    int m_lineBytes;
+    std::vector<uint8_t> m_buffer;
+};
+}
@@ -34,15 +34,45 @@ Loudness::Loudness(int pin, float aref) :
 {
   m_aRes = m_aio.getBit();
   m_aref = aref;
+
+  m_pin = pin;
+  m_acq = 0;
+  m_acqChannel = -1;
 }
 
 Loudness::~Loudness()
 {
+  detachAcquisition();
 }
 
 float Loudness::loudness()
 {
-  int val = m_aio.read();
+  AioAcquisition::SAMPLE_T sample;
+  int val;
+
+  if (m_acq && m_acq->getLatest(m_acqChannel, &sample))
+    val = sample.value;
+  else
+    val = m_aio.read();
 
   return(val * (m_aref / float(1 << m_aRes)));
 }
+
+void Loudness::attachAcquisition(AioAcquisition *acq, unsigned int periodUs)
+{
+  detachAcquisition();
+
+  m_acqChannel = acq->addChannel(m_pin, periodUs, 0);
+  m_acq = acq;
+  m_acq->start();
+}
+
+void Loudness::detachAcquisition()
+{
+  if (m_acq)
+    {
+      m_acq->removeChannel(m_acqChannel);
+      m_acq = 0;
+      m_acqChannel = -1;
+    }
+}
@@ -27,6 +27,8 @@
 #include <string>
 #include <mraa/aio.hpp>
 
+#include "aioacquire.h"
+
 namespace upm {
   /**
    * @brief Generic loudness sensors
@@ -56,6 +58,9 @@ namespace upm {
    * This driver was developed using the DFRobot Loudness Sensor V2
    * and the Grove Loudness sensor.
    *
+   * With a shared AioAcquisition engine attached, loudness() converts
+   * the latest sample taken by the engine instead of reading the pin.
+   *
    * @image html groveloudness.jpg
    * @snippet loudness.cxx Interesting
    */
@@ -76,6 +81,27 @@ namespace upm {
      */
     ~Loudness();
 
+    /**
+     * Samples the sensor with a shared acquisition engine.
+     * The engine is started if it is not running.
+     *
+     * @param acq Acquisition engine
+     * @param periodUs Sample period in microseconds
+     */
+    void attachAcquisition(AioAcquisition *acq, unsigned int periodUs=10000);
+
+    /**
+     * Stops sampling with the acquisition engine
+     */
+    void detachAcquisition();
+
+    /**
+     * Returns the acquisition channel of the sensor
+     *
+     * @return Channel number, or -1 if not attached
+     */
+    int getAcquisitionChannel() { return m_acqChannel; };
+
     /**
      * Returns the voltage detected on the analog pin
      *
@@ -90,6 +116,10 @@ namespace upm {
     float m_aref;
     // ADC resolution
     int m_aRes;
+
+    int m_pin;
+    AioAcquisition *m_acq;
+    int m_acqChannel;
   };
 }
 
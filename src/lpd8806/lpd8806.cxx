@@ -37,6 +37,15 @@ LPD8806::LPD8806 (uint16_t pixelCount, uint8_t csn) : m_csnPinCtx(csn), m_spi(0)
     m_name = "LPD8806";
 
     m_pixels = NULL;
+    m_frame = NULL;
+    m_frameBytes = 0;
+    m_threadRunning = false;
+    m_pending = false;
+    m_stop = false;
+    m_showResult = mraa::SUCCESS;
+
+    pthread_mutex_init (&m_showLock, NULL);
+    pthread_cond_init (&m_showCond, NULL);
 
     error = m_csnPinCtx.dir (mraa::DIR_OUT);
     if (error != mraa::SUCCESS) {
@@ -58,24 +67,37 @@ LPD8806::LPD8806 (uint16_t pixelCount, uint8_t csn) : m_csnPinCtx(csn), m_spi(0)
 
     m_pixelsCount = pixelCount;
 
-    uint8_t  latchBytes;
-    uint16_t dataBytes, totalBytes;
-    uint16_t numBytes = 0;
+    int latchBytes, dataBytes, totalBytes;
 
     dataBytes  = m_pixelsCount * 3;
     latchBytes = (m_pixelsCount + 31) / 32;
     totalBytes = dataBytes + latchBytes;
     if ((m_pixels = (uint8_t *) malloc(totalBytes))) {
-        numBytes = totalBytes;
+        m_frameBytes = totalBytes;
         memset ( m_pixels           , 0x80, dataBytes);  // Init to RGB 'off' state
         memset (&m_pixels[dataBytes], 0   , latchBytes); // Clear latch bytes
     }
 }
 
 LPD8806::~LPD8806() {
+    if (m_threadRunning) {
+        pthread_mutex_lock (&m_showLock);
+        m_stop = true;
+        pthread_cond_broadcast (&m_showCond);
+        pthread_mutex_unlock (&m_showLock);
+
+        pthread_join (m_showThread, NULL);
+    }
+
+    pthread_cond_destroy (&m_showCond);
+    pthread_mutex_destroy (&m_showLock);
+
     if (m_pixels) {
         free(m_pixels);
     }
+    if (m_frame) {
+        free(m_frame);
+    }
 }
 
 void
@@ -90,12 +112,58 @@ LPD8806::setPixelColor (uint16_t pixelOffset, uint8_t r, uint8_t g, uint8_t b) {
 
 void
 LPD8806::show (void) {
-    uint8_t  *ptr   = m_pixels;
-    uint16_t byte   = (m_pixelsCount * 3) + ((m_pixelsCount + 31) / 32);
-    
-    while (byte--) {
-        m_spi.writeByte (*ptr++);
+    // don't overtake a frame still going out from showAsync()
+    waitShow ();
+
+    if (writeFrame (m_pixels) != mraa::SUCCESS) {
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": Spi.transfer() failed");
+    }
+}
+
+void
+LPD8806::showAsync (void) {
+    if (m_pixels == NULL) {
+        return;
+    }
+
+    if (!m_threadRunning) {
+        if (!(m_frame = (uint8_t *) malloc(m_frameBytes))) {
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": unable to allocate frame buffer");
+        }
+        if (pthread_create (&m_showThread, NULL, showThread, this)) {
+            free (m_frame);
+            m_frame = NULL;
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": pthread_create() failed");
+        }
+        m_threadRunning = true;
+    }
+
+    pthread_mutex_lock (&m_showLock);
+    while (m_pending) {
+        pthread_cond_wait (&m_showCond, &m_showLock);
     }
+
+    // copying keeps m_pixels intact for incremental updates
+    memcpy (m_frame, m_pixels, m_frameBytes);
+    m_pending = true;
+    pthread_cond_broadcast (&m_showCond);
+    pthread_mutex_unlock (&m_showLock);
+}
+
+mraa::Result
+LPD8806::waitShow (void) {
+    pthread_mutex_lock (&m_showLock);
+    while (m_pending) {
+        pthread_cond_wait (&m_showCond, &m_showLock);
+    }
+    mraa::Result rv = m_showResult;
+    m_showResult = mraa::SUCCESS;
+    pthread_mutex_unlock (&m_showLock);
+
+    return rv;
 }
 
 uint16_t
@@ -109,6 +177,56 @@ LPD8806::getStripLength (void) {
  * **************
  */
 
+mraa::Result
+LPD8806::writeFrame (uint8_t * frame) {
+    mraa::Result rv = mraa::SUCCESS;
+
+    // one transfer per fragment rather than a writeByte() per byte
+    for (int offset = 0; offset < m_frameBytes; offset += LPD8806_FRAGMENT_SIZE) {
+        int len = m_frameBytes - offset;
+        if (len > LPD8806_FRAGMENT_SIZE) {
+            len = LPD8806_FRAGMENT_SIZE;
+        }
+
+        mraa::Result error = m_spi.transfer (frame + offset, NULL, len);
+        if (error != mraa::SUCCESS) {
+            rv = error;
+        }
+    }
+
+    return rv;
+}
+
+void *
+LPD8806::showThread (void * ctx) {
+    LPD8806 * This = (LPD8806 *)ctx;
+
+    pthread_mutex_lock (&This->m_showLock);
+    for (;;) {
+        while (!This->m_pending && !This->m_stop) {
+            pthread_cond_wait (&This->m_showCond, &This->m_showLock);
+        }
+
+        // a queued frame still goes out before stopping
+        if (!This->m_pending) {
+            break;
+        }
+
+        pthread_mutex_unlock (&This->m_showLock);
+        mraa::Result rv = This->writeFrame (This->m_frame);
+        pthread_mutex_lock (&This->m_showLock);
+
+        if (rv != mraa::SUCCESS) {
+            This->m_showResult = rv;
+        }
+        This->m_pending = false;
+        pthread_cond_broadcast (&This->m_showCond);
+    }
+    pthread_mutex_unlock (&This->m_showLock);
+
+    return NULL;
+}
+
 mraa::Result
 LPD8806::CSOn () {
     return m_csnPinCtx.write (HIGH);
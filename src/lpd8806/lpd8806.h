@@ -24,6 +24,7 @@
 #pragma once
 
 #include <string>
+#include <pthread.h>
 #include <mraa/aio.hpp>
 
 #include <mraa/gpio.hpp>
@@ -33,6 +34,9 @@
 #define HIGH                    1
 #define LOW                     0
 
+/* largest single SPI transfer (default spidev bufsiz) */
+#define LPD8806_FRAGMENT_SIZE   4096
+
 namespace upm {
 
 /**
@@ -86,6 +90,20 @@ class LPD8806 {
          */
         void show (void);
 
+        /**
+         * Hands the current pixels to a background thread for sending
+         * and returns at once, so the next frame can be composed while
+         * this one is on the wire. Waits for the previous frame first
+         */
+        void showAsync (void);
+
+        /**
+         * Waits until the frame passed to showAsync() has been sent
+         *
+         * @return Result of sending it
+         */
+        mraa::Result waitShow (void);
+
         /**
          * Returns the length of the LED strip
          */
@@ -104,7 +122,28 @@ class LPD8806 {
         mraa::Gpio       m_csnPinCtx;
 
         uint8_t*                m_pixels;
-        uint8_t                 m_pixelsCount;
+        uint16_t                m_pixelsCount;
+        int                     m_frameBytes;
+
+        /* front buffer, owned by the show thread while m_pending */
+        uint8_t*                m_frame;
+        pthread_t               m_showThread;
+        bool                    m_threadRunning;
+        pthread_mutex_t         m_showLock;
+        pthread_cond_t          m_showCond;
+        bool                    m_pending;
+        bool                    m_stop;
+        mraa::Result            m_showResult;
+
+        /**
+         * Sends a whole frame (pixels and latch bytes)
+         */
+        mraa::Result writeFrame (uint8_t * frame);
+
+        /**
+         * Background thread behind showAsync()
+         */
+        static void * showThread (void * ctx);
 
         uint8_t readRegister (uint8_t reg);
         void writeRegister (uint8_t reg, uint8_t data);
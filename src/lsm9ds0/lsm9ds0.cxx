@@ -204,10 +204,82 @@ bool LSM9DS0::init()
 
 void LSM9DS0::update()
 {
-  updateGyroscope();
-  updateAccelerometer();
-  updateMagnetometer();
-  updateTemperature();
+  updateBurst();
+}
+
+uint8_t LSM9DS0::updateBurst()
+{
+  // STATUS_REG_G/STATUS_REG_A (0x27) are immediately followed by the
+  // outputs (0x28-0x2d), and on the XM the temperature (0x05-0x06)
+  // is followed by STATUS_REG_M (0x07) and the mag outputs
+  // (0x08-0x0d), so three reads cover every sub-sensor.
+  uint8_t buffer[9];
+  uint8_t updated = 0;
+  int16_t x, y, z;
+
+  memset(buffer, 0, 9);
+  readRegs(DEV_GYRO, REG_STATUS_REG_G, buffer, 7);
+
+  if (buffer[0] & (STATUS_REG_G_XDA | STATUS_REG_G_YDA | STATUS_REG_G_ZDA |
+                   STATUS_REG_G_ZYXDA))
+    {
+      x =  ( (buffer[2] << 8) | buffer[1] );
+      y =  ( (buffer[4] << 8) | buffer[3] );
+      z =  ( (buffer[6] << 8) | buffer[5] );
+
+      m_gyroX = float(x);
+      m_gyroY = float(y);
+      m_gyroZ = float(z);
+
+      updated |= UPDATED_GYRO;
+    }
+
+  memset(buffer, 0, 9);
+  readRegs(DEV_XM, REG_STATUS_REG_A, buffer, 7);
+
+  if (buffer[0] & (STATUS_REG_A_XADA | STATUS_REG_A_YADA | STATUS_REG_A_ZADA |
+                   STATUS_REG_A_ZYXADA))
+    {
+      x =  ( (buffer[2] << 8) | buffer[1] );
+      y =  ( (buffer[4] << 8) | buffer[3] );
+      z =  ( (buffer[6] << 8) | buffer[5] );
+
+      m_accelX = float(x);
+      m_accelY = float(y);
+      m_accelZ = float(z);
+
+      updated |= UPDATED_ACCEL;
+    }
+
+  memset(buffer, 0, 9);
+  readRegs(DEV_XM, REG_OUT_TEMP_L_XM, buffer, 9);
+
+  // the temperature has no status bit, so always take it
+  int16_t temp = ( (buffer[1] << 8) | (buffer[0] ) );
+  if (temp & 0x0800)
+    {
+      temp &= ~0x0800;
+      temp *= -1;
+    }
+
+  m_temp = float(temp);
+  updated |= UPDATED_TEMP;
+
+  if (buffer[2] & (STATUS_REG_M_XMDA | STATUS_REG_M_YMDA | STATUS_REG_M_ZMDA |
+                   STATUS_REG_M_ZYXMDA))
+    {
+      x =  ( (buffer[4] << 8) | buffer[3] );
+      y =  ( (buffer[6] << 8) | buffer[5] );
+      z =  ( (buffer[8] << 8) | buffer[7] );
+
+      m_magX = float(x);
+      m_magY = float(y);
+      m_magZ = float(z);
+
+      updated |= UPDATED_MAG;
+    }
+
+  return updated;
 }
 
 void LSM9DS0::updateGyroscope()
@@ -741,6 +813,126 @@ uint8_t LSM9DS0::getInterruptGen2Src()
   return readReg(DEV_XM, REG_INT_GEN_2_SRC);
 }
 
+bool LSM9DS0::enableGyroscopeFIFO(bool enable)
+{
+  uint8_t reg = readReg(DEV_GYRO, REG_CTRL_REG5_G);
+
+  if (enable)
+    reg |= CTRL_REG5_G_FIFO_EN;
+  else
+    reg &= ~CTRL_REG5_G_FIFO_EN;
+
+  return writeReg(DEV_GYRO, REG_CTRL_REG5_G, reg);
+}
+
+bool LSM9DS0::setGyroscopeFIFOMode(G_FM_T mode, uint8_t watermark)
+{
+  uint8_t reg = ( ((mode & _FIFO_CTRL_REG_G_FM_MASK)
+                   << _FIFO_CTRL_REG_G_FM_SHIFT) |
+                  ((watermark & _FIFO_CTRL_REG_G_WTM_MASK)
+                   << _FIFO_CTRL_REG_G_WTM_SHIFT) );
+
+  return writeReg(DEV_GYRO, REG_FIFO_CTRL_REG_G, reg);
+}
+
+uint8_t LSM9DS0::getGyroscopeFIFOStatus()
+{
+  return readReg(DEV_GYRO, REG_FIFO_SRC_REG_G);
+}
+
+int LSM9DS0::readGyroscopeFIFO(float *buffer, int maxSamples)
+{
+  return readFIFO(DEV_GYRO, REG_FIFO_SRC_REG_G, REG_OUT_X_L_G, m_gyroScale,
+                  buffer, maxSamples, &m_gyroX, &m_gyroY, &m_gyroZ);
+}
+
+bool LSM9DS0::enableAccelerometerFIFO(bool enable)
+{
+  uint8_t reg = readReg(DEV_XM, REG_CTRL_REG0_XM);
+
+  if (enable)
+    reg |= CTRL_REG0_XM_FIFO_EN;
+  else
+    reg &= ~CTRL_REG0_XM_FIFO_EN;
+
+  return writeReg(DEV_XM, REG_CTRL_REG0_XM, reg);
+}
+
+bool LSM9DS0::setAccelerometerFIFOMode(FM_T mode, uint8_t threshold)
+{
+  uint8_t reg = ( ((mode & _FIFO_CTRL_REG_FM_MASK)
+                   << _FIFO_CTRL_REG_FM_SHIFT) |
+                  ((threshold & _FIFO_CTRL_REG_FTH_MASK)
+                   << _FIFO_CTRL_REG_FTH_SHIFT) );
+
+  return writeReg(DEV_XM, REG_FIFO_CTRL_REG, reg);
+}
+
+uint8_t LSM9DS0::getAccelerometerFIFOStatus()
+{
+  return readReg(DEV_XM, REG_FIFO_SRC_REG);
+}
+
+int LSM9DS0::readAccelerometerFIFO(float *buffer, int maxSamples)
+{
+  return readFIFO(DEV_XM, REG_FIFO_SRC_REG, REG_OUT_X_L_A, m_accelScale,
+                  buffer, maxSamples, &m_accelX, &m_accelY, &m_accelZ);
+}
+
+int LSM9DS0::readFIFO(DEVICE_T dev, uint8_t srcReg, uint8_t outReg,
+                      float scale, float *buffer, int maxSamples,
+                      float *x, float *y, float *z)
+{
+  // FIFO_SRC_REG_G and FIFO_SRC_REG share the same layout
+  uint8_t src = readReg(dev, srcReg);
+  int level;
+
+  if (src & FIFO_CTRL_REG_G_EMPTY)
+    return 0;
+
+  // the stored level only has 5 bits, a full FIFO sets the overrun bit
+  if (src & FIFO_CTRL_REG_G_OVRN)
+    level = LSM9DS0_FIFO_SIZE;
+  else
+    level = (src >> _FIFO_CTRL_REG_G_FSS_SHIFT) & _FIFO_CTRL_REG_G_FSS_MASK;
+
+  if (level > maxSamples)
+    level = maxSamples;
+
+  if (level <= 0)
+    return 0;
+
+  // With the FIFO enabled, auto-increment wraps from OUT_Z_H back to
+  // OUT_X_L, so the whole FIFO can be drained in one read.
+  uint8_t data[LSM9DS0_FIFO_SIZE * 6];
+
+  memset(data, 0, level * 6);
+  readRegs(dev, outReg, data, level * 6);
+
+  int16_t sx = 0, sy = 0, sz = 0;
+  for (int i = 0; i < level; i++)
+    {
+      uint8_t *sample = &data[i * 6];
+
+      sx =  ( (sample[1] << 8) | sample[0] );
+      sy =  ( (sample[3] << 8) | sample[2] );
+      sz =  ( (sample[5] << 8) | sample[4] );
+
+      if (buffer)
+        {
+          buffer[i * 3] = (float(sx) * scale) / 1000.0;
+          buffer[i * 3 + 1] = (float(sy) * scale) / 1000.0;
+          buffer[i * 3 + 2] = (float(sz) * scale) / 1000.0;
+        }
+    }
+
+  *x = float(sx);
+  *y = float(sy);
+  *z = float(sz);
+
+  return level;
+}
+
 #ifdef SWIGJAVA
 void LSM9DS0::installISR(INTERRUPT_PINS_T intr, int gpio, mraa::Edge level,
 			 IsrCallback *cb)
@@ -37,6 +37,9 @@
 #define LSM9DS0_DEFAULT_XM_ADDR 0x1d
 #define LSM9DS0_DEFAULT_GYRO_ADDR 0x6b
 
+// depth of the gyroscope and accelerometer FIFOs, in samples
+#define LSM9DS0_FIFO_SIZE 32
+
 namespace upm {
   
   /**
@@ -1052,6 +1055,14 @@ namespace upm {
       INTERRUPT_XM_GEN2  // XM interrupt generator 2
     } INTERRUPT_PINS_T;
 
+    // sub-sensors refreshed by updateBurst()
+    typedef enum {
+      UPDATED_GYRO              = 0x01,
+      UPDATED_ACCEL             = 0x02,
+      UPDATED_MAG               = 0x04,
+      UPDATED_TEMP              = 0x08
+    } UPDATED_BITS_T;
+
 
     /**
      * lsm9ds0 constructor
@@ -1081,6 +1092,18 @@ namespace upm {
      */
     void update();
 
+    /**
+     * update all sub-sensors using one auto-increment read per
+     * register block: gyro status and outputs, accelerometer status
+     * and outputs, and temperature, magnetometer status and
+     * outputs.  A sub-sensor whose status register reports no new
+     * data keeps its previous values.
+     *
+     * @return bitmask of UPDATED_BITS_T values for the sub-sensors
+     * that were refreshed
+     */
+    uint8_t updateBurst();
+
     /**
      * update the gyroscope values only
      */
@@ -1411,6 +1434,79 @@ namespace upm {
      */
     uint8_t getInterruptGen2Src();
 
+    /**
+     * enable or disable the gyroscope FIFO
+     *
+     * @param enable true to enable the FIFO, false to disable
+     * @return true if successful, false otherwise
+     */
+    bool enableGyroscopeFIFO(bool enable);
+
+    /**
+     * set the gyroscope FIFO mode and watermark level
+     *
+     * @param mode one of the G_FM_T values
+     * @param watermark FIFO watermark level (0-31)
+     * @return true if successful, false otherwise
+     */
+    bool setGyroscopeFIFOMode(G_FM_T mode, uint8_t watermark=0);
+
+    /**
+     * return the gyroscope FIFO source register
+     *
+     * @return bitmask of FIFO_SRC_REG_G_BITS_T bits
+     */
+    uint8_t getGyroscopeFIFOStatus();
+
+    /**
+     * read all samples currently stored in the gyroscope FIFO with a
+     * single burst read.  Each sample is stored as an x, y, z triple
+     * in degrees per second.  The most recent sample also becomes
+     * the current gyroscope value.
+     *
+     * @param buffer storage for at least 3 * maxSamples floats
+     * @param maxSamples maximum number of samples to read
+     * @return the number of samples read
+     */
+    int readGyroscopeFIFO(float *buffer, int maxSamples=LSM9DS0_FIFO_SIZE);
+
+    /**
+     * enable or disable the accelerometer FIFO
+     *
+     * @param enable true to enable the FIFO, false to disable
+     * @return true if successful, false otherwise
+     */
+    bool enableAccelerometerFIFO(bool enable);
+
+    /**
+     * set the accelerometer FIFO mode and watermark threshold
+     *
+     * @param mode one of the FM_T values
+     * @param threshold FIFO watermark threshold (0-31)
+     * @return true if successful, false otherwise
+     */
+    bool setAccelerometerFIFOMode(FM_T mode, uint8_t threshold=0);
+
+    /**
+     * return the accelerometer FIFO source register
+     *
+     * @return bitmask of FIFO_SRC_REG_BITS_T bits
+     */
+    uint8_t getAccelerometerFIFOStatus();
+
+    /**
+     * read all samples currently stored in the accelerometer FIFO
+     * with a single burst read.  Each sample is stored as an x, y, z
+     * triple in gravities.  The most recent sample also becomes the
+     * current accelerometer value.
+     *
+     * @param buffer storage for at least 3 * maxSamples floats
+     * @param maxSamples maximum number of samples to read
+     * @return the number of samples read
+     */
+    int readAccelerometerFIFO(float *buffer,
+                              int maxSamples=LSM9DS0_FIFO_SIZE);
+
 #if defined(SWIGJAVA) || defined(JAVACALLBACK)
     void installISR(INTERRUPT_PINS_T intr, int gpio, mraa::Edge level,
 		    IsrCallback *cb);
@@ -1471,6 +1567,13 @@ namespace upm {
 
     static const uint8_t m_autoIncrementMode = 0x80;
 
+    // burst read the samples stored in a gyro or accel FIFO into
+    // buffer, scaled by scale, and leave the raw value of the most
+    // recent sample in x, y and z.  Returns the number of samples read.
+    int readFIFO(DEVICE_T dev, uint8_t srcReg, uint8_t outReg, float scale,
+                 float *buffer, int maxSamples,
+                 float *x, float *y, float *z);
+
     mraa::I2c m_i2cG;
     mraa::I2c m_i2cXM;
     uint8_t m_gAddr;
@@ -24,6 +24,8 @@
 
 #include <unistd.h>
 #include <math.h>
+#include <string.h>
+#include <time.h>
 #include <iostream>
 #include <string>
 
@@ -36,6 +38,8 @@ using namespace std;
 M24LR64E::M24LR64E(int bus, AccessMode mode):
   m_i2c(bus)
 {
+  m_ackPolls = 0;
+
   if (mode == USER_MODE)
     m_addr = M24LR64E_DEFAULT_I2C_ADDR;
   else
@@ -133,7 +137,7 @@ void M24LR64E::sectorProtectConfig(unsigned int sectorNumber,
 void M24LR64E::clearSectorProtect(void)
 {
   uint8_t buf[64]={0x0};
-  EEPROM_Write_Bytes(0, buf, 64);
+  writeBytes(0, buf, 64);
 }
 
 
@@ -184,8 +188,11 @@ uint32_t M24LR64E::getMemorySize()
 
 void M24LR64E::clearMemory()
 {
-  for(int i = 0; i < EEPROM_I2C_LENGTH; i++){
-    writeByte(i,0x0);
+  uint8_t zeros[PAGE_SIZE];
+  memset(zeros, 0, PAGE_SIZE);
+
+  for(int i = 0; i < EEPROM_I2C_LENGTH; i += PAGE_SIZE){
+    writeBytes(i, zeros, PAGE_SIZE);
   }
 }
 
@@ -196,7 +203,24 @@ mraa::Result M24LR64E::writeByte(unsigned int address, uint8_t data)
 
 mraa::Result M24LR64E::writeBytes(unsigned int address, uint8_t* buffer, int len)
 {
-  return EEPROM_Write_Bytes(address, buffer, len);
+  mraa::Result rv = mraa::SUCCESS;
+
+  while (len > 0)
+    {
+      // never cross a page boundary, the address would wrap within
+      // the page
+      int chunk = PAGE_SIZE - (address % PAGE_SIZE);
+      if (chunk > len)
+        chunk = len;
+
+      rv = EEPROM_Write_Bytes(address, buffer, chunk);
+
+      address += chunk;
+      buffer += chunk;
+      len -= chunk;
+    }
+
+  return rv;
 }
 
 uint8_t M24LR64E::readByte(unsigned int address)
@@ -206,7 +230,20 @@ uint8_t M24LR64E::readByte(unsigned int address)
 
 int M24LR64E::readBytes(unsigned int address, uint8_t* buffer, int len)
 {
-  return EEPROM_Read_Bytes(address, buffer, len);
+  int total = 0;
+
+  while (len > 0)
+    {
+      int chunk = (len > READ_CHUNK_LENGTH) ? READ_CHUNK_LENGTH : len;
+
+      total += EEPROM_Read_Bytes(address, buffer, chunk);
+
+      address += chunk;
+      buffer += chunk;
+      len -= chunk;
+    }
+
+  return total;
 }
 
 mraa::Result M24LR64E::EEPROM_Write_Byte(unsigned int address, uint8_t data)
@@ -223,15 +260,22 @@ mraa::Result M24LR64E::EEPROM_Write_Byte(unsigned int address, uint8_t data)
     throw std::runtime_error(std::string(__FUNCTION__) +
                              ": I2c.write() failed");
 
-  usleep(I2C_WRITE_TIME * 1000);
+  EEPROM_Wait_Write(address);
   return rv;
 }
 
 mraa::Result M24LR64E::EEPROM_Write_Bytes(unsigned int address, uint8_t* data,
                                   int len)
 {
+  if (len > PAGE_SIZE)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": len must not exceed PAGE_SIZE");
+      return mraa::ERROR_INVALID_PARAMETER;
+    }
+
   const int pktLen = 2 + len;
-  uint8_t buf[pktLen];
+  uint8_t buf[2 + PAGE_SIZE];
   mraa::Result rv;
   
   buf[0] = ((address >> 8) & 0xff);
@@ -244,11 +288,45 @@ mraa::Result M24LR64E::EEPROM_Write_Bytes(unsigned int address, uint8_t* data,
     throw std::runtime_error(std::string(__FUNCTION__) +
                              ": I2c.write() failed");
 
-  usleep(I2C_WRITE_TIME * 1000);
+  EEPROM_Wait_Write(address);
 
   return rv;
 }
 
+void M24LR64E::EEPROM_Wait_Write(unsigned int address)
+{
+  // While a write cycle is in progress the device does not
+  // acknowledge its address.  Poll by setting the address pointer
+  // (harmless) until it does, giving up after twice the maximum
+  // write time.
+  const int apktLen = 2;
+  uint8_t abuf[apktLen];
+
+  abuf[0] = ((address >> 8) & 0xff);
+  abuf[1] = (address & 0xff);
+
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (;;)
+    {
+      m_ackPolls++;
+      if (m_i2c.write(abuf, apktLen) == mraa::SUCCESS)
+        return;
+
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      long elapsedUs = (now.tv_sec - start.tv_sec) * 1000000 +
+        (now.tv_nsec - start.tv_nsec) / 1000;
+
+      if (elapsedUs > (long)I2C_WRITE_TIME * 2000)
+        {
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": timeout waiting for write to complete");
+          return;
+        }
+    }
+}
+
 uint8_t M24LR64E::EEPROM_Read_Byte(unsigned int address)
 {
   const int apktLen = 2;
@@ -92,6 +92,11 @@ namespace upm {
 
     static const unsigned int I2C_WRITE_TIME    = 5; // 5ms
 
+    // a single write may only program bytes within one page
+    static const int PAGE_SIZE                  = 4;
+    // largest single I2C read issued by readBytes()
+    static const int READ_CHUNK_LENGTH          = 256;
+
     /**
      * M24LR64E addresses, accessible only in the root mode
      */
@@ -243,11 +248,14 @@ namespace upm {
     mraa::Result writeByte(unsigned int address, uint8_t data);
 
     /**
-     * Writes bytes to the EEPROM
+     * Writes bytes to the EEPROM.  The data may be of any length; it
+     * is split on PAGE_SIZE boundaries and each page write returns as
+     * soon as the device acknowledges again (ACK polling), rather than
+     * after a fixed I2C_WRITE_TIME delay.
      *
      * @param address Address to write to
-     * @param data Data to write
-     * @param data Length of the data buffer
+     * @param buffer Data to write
+     * @param len Length of the data buffer
      */
     mraa::Result writeBytes(unsigned int address, uint8_t* buffer, int len);
 
@@ -260,7 +268,8 @@ namespace upm {
     uint8_t readByte(unsigned int address);
 
     /**
-     * Reads multiple bytes from the EEPROM
+     * Reads multiple bytes from the EEPROM.  Large reads are issued
+     * as sequential reads of at most READ_CHUNK_LENGTH bytes.
      *
      * @param address Address to read from
      * @param buffer Buffer to store data
@@ -268,6 +277,14 @@ namespace upm {
      */
     int readBytes(unsigned int address, uint8_t* buffer, int len);
 
+    /**
+     * Returns the number of ACK polls issued while waiting for
+     * writes to complete, since the object was created
+     *
+     * @return Number of polls
+     */
+    unsigned int getAckPollCount() { return m_ackPolls; };
+
   protected:
     mraa::I2c m_i2c;
     mraa::Result EEPROM_Write_Byte(unsigned int address, uint8_t data);
@@ -276,9 +293,11 @@ namespace upm {
     uint8_t EEPROM_Read_Byte(unsigned int address);
     int EEPROM_Read_Bytes(unsigned int address, 
                                    uint8_t* buffer, int len);
+    void EEPROM_Wait_Write(unsigned int address);
 
   private:
     uint8_t m_addr;
+    unsigned int m_ackPolls;
   };
 }
 
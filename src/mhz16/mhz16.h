@@ -47,6 +47,8 @@ const uint8_t MHZ16_START = 0x7e;
 const uint8_t MHZ16_END   = 0x7e;
 
 namespace upm {
+  class UartPort;
+
     /**
      * @brief MHZ16 Serial CO2 Sensor library
      * @defgroup mhz16 libupm-mhz16
@@ -164,11 +166,10 @@ namespace upm {
     void calibrateZeroPoint();
 
   protected:
-    int ttyFd() { return m_ttyFd; };
+    int ttyFd();
 
   private:
-    mraa_uart_context m_uart;
-    int m_ttyFd;
+    UartPort *m_port;
     int gas;
     int temp;
   };
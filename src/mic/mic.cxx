@@ -29,11 +29,15 @@
 #include <stdlib.h>
 #include <functional>
 #include <string.h>
+#include <limits.h>
 #include "mic.h"
 
 using namespace upm;
 
 Microphone::Microphone(int micPin) {
+    m_acq = NULL;
+    m_acqChannel = -1;
+
     // initialise analog mic input
     
     if ( !(m_micCtx = mraa_aio_init(micPin)) ) 
@@ -45,6 +49,8 @@ Microphone::Microphone(int micPin) {
 }
 
 Microphone::~Microphone() {
+    detachAcquisition ();
+
     // close analog input
     mraa_result_t error;
     error = mraa_aio_close(m_micCtx);
@@ -58,8 +64,9 @@ Microphone::getSampledWindow (unsigned int freqMS, int numberOfSamples,
                             uint16_t * buffer) {
     int sampleIdx = 0;
 
-    // must have freq
-    if (!freqMS) {
+    // must have freq, and a period in microseconds that fits; a
+    // wrapped period of 0 would make the engine's setPeriod() throw
+    if (!freqMS || freqMS > UINT_MAX / 1000) {
         return 0;
     }
 
@@ -68,6 +75,14 @@ Microphone::getSampledWindow (unsigned int freqMS, int numberOfSamples,
         return 0;
     }
 
+    if (m_acq) {
+        if (m_acq->getPeriod (m_acqChannel) != freqMS * 1000) {
+            m_acq->setPeriod (m_acqChannel, freqMS * 1000);
+        }
+
+        return m_acq->readWindow (m_acqChannel, buffer, numberOfSamples);
+    }
+
     while (sampleIdx < numberOfSamples) {
         buffer[sampleIdx++] = mraa_aio_read (m_micCtx);
         usleep(freqMS * 1000);
@@ -76,15 +91,28 @@ Microphone::getSampledWindow (unsigned int freqMS, int numberOfSamples,
     return sampleIdx;
 }
 
+void
+Microphone::attachAcquisition (AioAcquisition* acq, unsigned int periodUs) {
+    detachAcquisition ();
+
+    m_acqChannel = acq->addChannel (m_micCtx, periodUs);
+    m_acq = acq;
+    m_acq->start ();
+}
+
+void
+Microphone::detachAcquisition () {
+    if (m_acq) {
+        m_acq->removeChannel (m_acqChannel);
+        m_acq = NULL;
+        m_acqChannel = -1;
+    }
+}
+
 int
 Microphone::findThreshold (thresholdContext* ctx, unsigned int threshold,
                                 uint16_t * buffer, int len) {
-    long sum = 0;
-    for (unsigned int i = 0; i < len; i++) {
-        sum += buffer[i];
-    }
-
-    ctx->averageReading = sum / len;
+    ctx->averageReading = Dsp::sum (buffer, len) / len;
     ctx->runningAverage = (((ctx->averagedOver-1) * ctx->runningAverage) + ctx->averageReading) / ctx->averagedOver;
 
     if (ctx->runningAverage > threshold) {
@@ -94,6 +122,34 @@ Microphone::findThreshold (thresholdContext* ctx, unsigned int threshold,
     }
 }
 
+float
+Microphone::getRMS (uint16_t * buffer, int len) {
+    if (len <= 0) {
+        return 0;
+    }
+
+    m_block.resize (len);
+    Dsp::toFloat (buffer, &m_block[0], len);
+    return Dsp::rmsAC (&m_block[0], len);
+}
+
+float
+Microphone::getToneAmplitude (uint16_t * buffer, int len, float freqHz,
+                              float sampleRateHz) {
+    if (len <= 0) {
+        return 0;
+    }
+
+    // the bias would leak into a low tone
+    m_block.resize (len);
+    Dsp::toFloat (buffer, &m_block[0], len);
+    Dsp::removeDC (&m_block[0], len);
+
+    Goertzel tone (sampleRateHz, freqHz);
+    tone.process (&m_block[0], len);
+    return tone.amplitude (0);
+}
+
 void
 Microphone::printGraph (thresholdContext* ctx) {
     for (int i = 0; i < ctx->runningAverage; i++)
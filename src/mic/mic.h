@@ -24,9 +24,13 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <mraa/gpio.h>
 #include <mraa/aio.h>
 
+#include "aioacquire.h"
+#include "dsp.h"
+
 struct thresholdContext {
     long averageReading;
     long runningAverage;
@@ -55,6 +59,10 @@ namespace upm {
  *
  * This module defines the Analog Microphone sensor
  *
+ * When attached to an AioAcquisition engine, windows are taken from
+ * the engine's ring buffer at its precise rate instead of a sleep
+ * loop, and the engine reports the sampling jitter.
+ *
  * @image html mic.jpg
  * @snippet mic.cxx Interesting
  */
@@ -79,9 +87,32 @@ class Microphone {
          * @param freqMS Time between each sample (in microseconds)
          * @param numberOfSamples Number of sample to sample for this window
          * @param buffer Buffer with sampled data
+         * @return Number of samples taken, 0 if freqMS is 0 or too large
          */
         int getSampledWindow (unsigned int freqMS, int numberOfSamples, uint16_t * buffer);
 
+        /**
+         * Samples the microphone with a shared acquisition engine.
+         * The engine is started if it is not running.
+         *
+         * @param acq Acquisition engine
+         * @param periodUs Initial sample period in microseconds;
+         * getSampledWindow() changes it as needed
+         */
+        void attachAcquisition (AioAcquisition* acq, unsigned int periodUs = 1000);
+
+        /**
+         * Stops sampling with the acquisition engine
+         */
+        void detachAcquisition ();
+
+        /**
+         * Returns the acquisition channel of the microphone
+         *
+         * @return Channel number, or -1 if not attached
+         */
+        int getAcquisitionChannel () { return m_acqChannel; }
+
         /**
          * Given the sampled buffer, this method returns TRUE/FALSE if threshold
          * is reached
@@ -93,6 +124,29 @@ class Microphone {
          */
         int findThreshold (thresholdContext* ctx, unsigned int threshold, uint16_t * buffer, int len);
 
+        /**
+         * Returns the sound level of a sampled buffer: the RMS of the
+         * samples around their mean, so the microphone bias does not
+         * count
+         *
+         * @param buffer Buffer with samples
+         * @param len Buffer length
+         * @return Level in ADC counts
+         */
+        float getRMS (uint16_t * buffer, int len);
+
+        /**
+         * Returns the amplitude of one tone in a sampled buffer
+         *
+         * @param buffer Buffer with samples
+         * @param len Buffer length
+         * @param freqHz Frequency of the tone, in Hz
+         * @param sampleRateHz Rate the buffer was sampled at, in Hz
+         * @return Amplitude of the tone in ADC counts
+         */
+        float getToneAmplitude (uint16_t * buffer, int len, float freqHz,
+                                float sampleRateHz);
+
         /**
          *
          * Prints a running average of the threshold context
@@ -103,6 +157,9 @@ class Microphone {
 
     private:
         mraa_aio_context    m_micCtx;
+        AioAcquisition*     m_acq;
+        int                 m_acqChannel;
+        std::vector<float>  m_block;
 };
 
 }
@@ -0,0 +1,20 @@
+%module javaupm_motionengine
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "motionengine.h"
+%}
+
+%include "motionengine.h"
+
+%pragma(java) jniclasscode=%{
+    static {
+        try {
+            System.loadLibrary("javaupm_motionengine");
+        } catch (UnsatisfiedLinkError e) {
+            System.err.println("Native code library failed to load. \n" + e);
+            System.exit(1);
+        }
+    }
+%}
@@ -0,0 +1,9 @@
+%module jsupm_motionengine
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "motionengine.h"
+%}
+
+%include "motionengine.h"
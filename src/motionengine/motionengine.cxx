@@ -0,0 +1,587 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include "motionengine.h"
+
+using namespace upm;
+using namespace std;
+
+pthread_mutex_t MotionAxis::s_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t MotionAxis::s_threadLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t MotionAxis::s_wakeCond;
+pthread_cond_t MotionAxis::s_doneCond;
+bool MotionAxis::s_condInit = false;
+std::vector<MotionAxis *> MotionAxis::s_axes;
+pthread_t MotionAxis::s_thread;
+bool MotionAxis::s_running = false;
+bool MotionAxis::s_dispatching = false;
+unsigned int MotionAxis::s_dispatchSeq = 0;
+
+static void toTimespec(uint64_t ns, struct timespec *ts)
+{
+  ts->tv_sec = ns / 1000000000;
+  ts->tv_nsec = ns % 1000000000;
+}
+
+MotionAxis::MotionAxis(STEP_T step, void *ctx) :
+  m_step(step), m_stepCtx(ctx)
+{
+  if (!m_step)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": step callback is NULL");
+      return;
+    }
+
+  m_maxSpeed = 100.0;
+  m_accel = 0.0;
+
+  m_moving = false;
+  m_stopping = false;
+  m_stopId = 0;
+  m_remaining = 0;
+  m_dir = 1;
+  m_speed = 0.0;
+  m_due = 0;
+
+  m_position = 0;
+  m_endPosition = 0;
+  m_lastId = 0;
+  m_doneId = 0;
+  m_lateSteps = 0;
+  m_stepErrors = 0;
+
+  registerAxis(this);
+}
+
+MotionAxis::~MotionAxis()
+{
+  unregisterAxis(this);
+}
+
+uint64_t MotionAxis::getNanos()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void MotionAxis::setMaxSpeed(double stepsPerSec)
+{
+  if (stepsPerSec <= 0.0)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": speed must be greater than 0");
+      return;
+    }
+
+  pthread_mutex_lock(&s_lock);
+  m_maxSpeed = stepsPerSec;
+  pthread_mutex_unlock(&s_lock);
+}
+
+double MotionAxis::getMaxSpeed()
+{
+  pthread_mutex_lock(&s_lock);
+  double rv = m_maxSpeed;
+  pthread_mutex_unlock(&s_lock);
+
+  return rv;
+}
+
+void MotionAxis::setAcceleration(double stepsPerSec2)
+{
+  if (stepsPerSec2 < 0.0)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": acceleration must not be negative");
+      return;
+    }
+
+  pthread_mutex_lock(&s_lock);
+  m_accel = stepsPerSec2;
+  pthread_mutex_unlock(&s_lock);
+}
+
+double MotionAxis::getAcceleration()
+{
+  pthread_mutex_lock(&s_lock);
+  double rv = m_accel;
+  pthread_mutex_unlock(&s_lock);
+
+  return rv;
+}
+
+unsigned int MotionAxis::move(int steps, MOVE_DONE_T done, void *doneCtx)
+{
+  MOVE_T mv;
+
+  pthread_mutex_lock(&s_lock);
+  mv.id = ++m_lastId;
+  mv.steps = steps;
+  mv.done = done;
+  mv.doneCtx = doneCtx;
+
+  m_moves.push_back(mv);
+  m_endPosition += steps;
+
+  pthread_cond_signal(&s_wakeCond);
+  pthread_mutex_unlock(&s_lock);
+
+  return mv.id;
+}
+
+unsigned int MotionAxis::moveTo(int position, MOVE_DONE_T done,
+                                void *doneCtx)
+{
+  // m_endPosition could change between reading it and queueing the
+  // move only if another thread queues moves on this axis as well
+  pthread_mutex_lock(&s_lock);
+  int steps = position - m_endPosition;
+  pthread_mutex_unlock(&s_lock);
+
+  return move(steps, done, doneCtx);
+}
+
+bool MotionAxis::waitDone(unsigned int id, int millis)
+{
+  struct timespec deadline;
+
+  if (millis >= 0)
+    toTimespec(getNanos() + (uint64_t)millis * 1000000, &deadline);
+
+  pthread_mutex_lock(&s_lock);
+  while (m_doneId < id)
+    {
+      if (millis < 0)
+        pthread_cond_wait(&s_doneCond, &s_lock);
+      else if (pthread_cond_timedwait(&s_doneCond, &s_lock, &deadline)
+               == ETIMEDOUT)
+        break;
+    }
+  bool rv = (m_doneId >= id);
+  pthread_mutex_unlock(&s_lock);
+
+  return rv;
+}
+
+bool MotionAxis::waitMove(unsigned int id, int millis)
+{
+  return waitDone(id, millis);
+}
+
+bool MotionAxis::waitIdle(int millis)
+{
+  pthread_mutex_lock(&s_lock);
+  unsigned int id = m_lastId;
+  pthread_mutex_unlock(&s_lock);
+
+  return waitDone(id, millis);
+}
+
+void MotionAxis::stop()
+{
+  pthread_mutex_lock(&s_lock);
+
+  // everything queued so far is cancelled when the current move ends
+  m_stopping = true;
+  m_stopId = m_lastId;
+
+  if (m_moving)
+    {
+      int stopSteps = 0;
+
+      if (m_accel > 0.0)
+        stopSteps = (int)ceil((m_speed * m_speed) / (2.0 * m_accel));
+
+      if (stopSteps < m_remaining)
+        m_remaining = stopSteps;
+
+      m_endPosition = m_position + m_dir * m_remaining;
+    }
+  else
+    m_endPosition = m_position;
+
+  pthread_cond_signal(&s_wakeCond);
+  pthread_mutex_unlock(&s_lock);
+}
+
+void MotionAxis::abort()
+{
+  pthread_mutex_lock(&s_lock);
+
+  m_stopping = true;
+  m_stopId = m_lastId;
+  m_remaining = 0;
+  m_endPosition = m_position;
+
+  pthread_cond_signal(&s_wakeCond);
+  pthread_mutex_unlock(&s_lock);
+}
+
+bool MotionAxis::busy()
+{
+  pthread_mutex_lock(&s_lock);
+  bool rv = (m_doneId != m_lastId);
+  pthread_mutex_unlock(&s_lock);
+
+  return rv;
+}
+
+int MotionAxis::getQueueLength()
+{
+  pthread_mutex_lock(&s_lock);
+  int rv = m_lastId - m_doneId;
+  pthread_mutex_unlock(&s_lock);
+
+  return rv;
+}
+
+int MotionAxis::getPosition()
+{
+  pthread_mutex_lock(&s_lock);
+  int rv = m_position;
+  pthread_mutex_unlock(&s_lock);
+
+  return rv;
+}
+
+void MotionAxis::setPosition(int position)
+{
+  pthread_mutex_lock(&s_lock);
+  if (m_doneId != m_lastId)
+    {
+      pthread_mutex_unlock(&s_lock);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": axis is moving");
+      return;
+    }
+
+  m_position = position;
+  m_endPosition = position;
+  pthread_mutex_unlock(&s_lock);
+}
+
+double MotionAxis::getSpeed()
+{
+  pthread_mutex_lock(&s_lock);
+  double rv = m_moving ? m_dir * m_speed : 0.0;
+  pthread_mutex_unlock(&s_lock);
+
+  return rv;
+}
+
+unsigned int MotionAxis::getLateStepCount()
+{
+  pthread_mutex_lock(&s_lock);
+  unsigned int rv = m_lateSteps;
+  pthread_mutex_unlock(&s_lock);
+
+  return rv;
+}
+
+unsigned int MotionAxis::getStepErrorCount()
+{
+  pthread_mutex_lock(&s_lock);
+  unsigned int rv = m_stepErrors;
+  pthread_mutex_unlock(&s_lock);
+
+  return rv;
+}
+
+void MotionAxis::finishMove(bool completed, std::vector<EVENT_T> &events)
+{
+  EVENT_T ev;
+  MOVE_T &mv = m_moves.front();
+
+  ev.axis = this;
+  ev.dir = 0;
+  ev.id = mv.id;
+  ev.completed = completed;
+  ev.failed = false;
+  ev.done = mv.done;
+  ev.doneCtx = mv.doneCtx;
+  events.push_back(ev);
+
+  m_moves.pop_front();
+  m_moving = false;
+  m_speed = 0.0;
+}
+
+// returns true if a move with steps left is now executing
+bool MotionAxis::loadMove(uint64_t now, std::vector<EVENT_T> &events)
+{
+  while (!m_moves.empty())
+    {
+      MOVE_T &mv = m_moves.front();
+
+      if (m_stopping && mv.id <= m_stopId)
+        {
+          finishMove(false, events);
+          continue;
+        }
+
+      if (mv.steps == 0)
+        {
+          finishMove(true, events);
+          continue;
+        }
+
+      m_moving = true;
+      m_remaining = abs(mv.steps);
+      m_dir = (mv.steps < 0) ? -1 : 1;
+      m_speed = 0.0;
+      if (m_due < now)
+        m_due = now;
+
+      return true;
+    }
+
+  m_stopping = false;
+  return false;
+}
+
+void MotionAxis::service(uint64_t now, std::vector<EVENT_T> &events)
+{
+  if (m_moving && m_remaining == 0)
+    {
+      // stopped or aborted before the end of the move
+      finishMove(false, events);
+    }
+
+  if (!m_moving && !loadMove(now, events))
+    return;
+
+  if (m_due > now)
+    return;
+
+  // if we fell behind by more than a step interval, do not try to
+  // catch up with a burst of steps the motor could not follow
+  if (m_speed > 0.0 && (now - m_due) > (uint64_t)(1.0e9 / m_speed))
+    {
+      m_lateSteps++;
+      m_due = now;
+    }
+
+  EVENT_T ev;
+  ev.axis = this;
+  ev.dir = m_dir;
+  ev.id = 0;
+  ev.completed = false;
+  ev.failed = false;
+  ev.done = 0;
+  ev.doneCtx = 0;
+  events.push_back(ev);
+
+  m_position += m_dir;
+  m_remaining--;
+
+  // speed for the next step: no more than the maximum, no more than
+  // one step's worth of acceleration above the current speed, and no
+  // more than what still allows stopping within the remaining steps
+  double v = m_maxSpeed;
+  if (m_accel > 0.0)
+    {
+      double up = sqrt(m_speed * m_speed + 2.0 * m_accel);
+      double down = sqrt(2.0 * m_accel * (m_remaining ? m_remaining : 1));
+
+      v = min(v, min(up, down));
+    }
+  m_speed = v;
+  m_due += (uint64_t)(1.0e9 / m_speed);
+
+  if (!m_remaining)
+    {
+      bool completed = !(m_stopping && m_moves.front().id <= m_stopId);
+
+      finishMove(completed, events);
+    }
+}
+
+void *MotionAxis::engineThread(void *)
+{
+  std::vector<EVENT_T> events;
+
+  pthread_mutex_lock(&s_lock);
+  while (s_running)
+    {
+      uint64_t now = getNanos();
+      uint64_t next = 0;
+      bool haveNext = false;
+
+      events.clear();
+      for (size_t i = 0; i < s_axes.size(); i++)
+        {
+          MotionAxis *axis = s_axes[i];
+
+          axis->service(now, events);
+
+          if (axis->m_moving || !axis->m_moves.empty())
+            {
+              if (!haveNext || axis->m_due < next)
+                next = axis->m_due;
+              haveNext = true;
+            }
+        }
+
+      if (!events.empty())
+        {
+          // drive the outputs and run the callbacks without the lock,
+          // so callbacks can queue new moves
+          s_dispatching = true;
+          pthread_mutex_unlock(&s_lock);
+
+          for (size_t i = 0; i < events.size(); i++)
+            {
+              EVENT_T &ev = events[i];
+
+              // an exception must not escape this thread; a driver
+              // failing to step cancels the moves on its axis
+              try
+                {
+                  if (ev.dir)
+                    ev.axis->m_step(ev.dir, ev.axis->m_stepCtx);
+                  else if (ev.done)
+                    ev.done(ev.id, ev.completed, ev.doneCtx);
+                }
+              catch (std::exception& e)
+                {
+                  cerr << __FUNCTION__ << ": " << e.what() << endl;
+                  ev.failed = true;
+                }
+            }
+
+          pthread_mutex_lock(&s_lock);
+          s_dispatching = false;
+          s_dispatchSeq++;
+
+          for (size_t i = 0; i < events.size(); i++)
+            {
+              EVENT_T &ev = events[i];
+
+              if (!ev.dir && ev.id > ev.axis->m_doneId)
+                ev.axis->m_doneId = ev.id;
+
+              if (ev.dir && ev.failed)
+                {
+                  ev.axis->m_stopping = true;
+                  ev.axis->m_stopId = ev.axis->m_lastId;
+                  ev.axis->m_remaining = 0;
+                  ev.axis->m_endPosition = ev.axis->m_position;
+                  ev.axis->m_stepErrors++;
+                }
+            }
+
+          pthread_cond_broadcast(&s_doneCond);
+          continue;
+        }
+
+      if (haveNext)
+        {
+          struct timespec deadline;
+          toTimespec(next, &deadline);
+          pthread_cond_timedwait(&s_wakeCond, &s_lock, &deadline);
+        }
+      else
+        pthread_cond_wait(&s_wakeCond, &s_lock);
+    }
+  pthread_mutex_unlock(&s_lock);
+
+  return NULL;
+}
+
+void MotionAxis::registerAxis(MotionAxis *axis)
+{
+  pthread_mutex_lock(&s_threadLock);
+
+  if (!s_condInit)
+    {
+      pthread_condattr_t attr;
+      pthread_condattr_init(&attr);
+      pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+      pthread_cond_init(&s_wakeCond, &attr);
+      pthread_cond_init(&s_doneCond, &attr);
+
+      pthread_condattr_destroy(&attr);
+      s_condInit = true;
+    }
+
+  if (!s_running)
+    {
+      s_running = true;
+      if (pthread_create(&s_thread, NULL, engineThread, NULL))
+        {
+          s_running = false;
+          pthread_mutex_unlock(&s_threadLock);
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": pthread_create() failed");
+        }
+    }
+
+  pthread_mutex_lock(&s_lock);
+  s_axes.push_back(axis);
+  pthread_mutex_unlock(&s_lock);
+
+  pthread_mutex_unlock(&s_threadLock);
+}
+
+void MotionAxis::unregisterAxis(MotionAxis *axis)
+{
+  pthread_mutex_lock(&s_threadLock);
+
+  pthread_mutex_lock(&s_lock);
+  s_axes.erase(std::remove(s_axes.begin(), s_axes.end(), axis),
+               s_axes.end());
+
+  // the engine may be stepping this axis right now
+  unsigned int seq = s_dispatchSeq;
+  while (s_dispatching && seq == s_dispatchSeq)
+    pthread_cond_wait(&s_doneCond, &s_lock);
+
+  bool last = s_axes.empty();
+  if (last)
+    {
+      s_running = false;
+      pthread_cond_signal(&s_wakeCond);
+    }
+  pthread_mutex_unlock(&s_lock);
+
+  if (last)
+    pthread_join(s_thread, NULL);
+
+  pthread_mutex_unlock(&s_threadLock);
+}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <stdint.h>
+#include <pthread.h>
+
+namespace upm {
+  /**
+   * @brief Stepper motion engine
+   * @defgroup motionengine libupm-motionengine
+   * @ingroup gpio i2c
+   */
+
+  /**
+   * @library motionengine
+   * @sensor motionengine
+   * @comname Stepper motion engine
+   *
+   * @brief Asynchronous step generator shared by the stepper drivers
+   *
+   * A MotionAxis represents one stepper motor.  Moves are queued with
+   * move() and executed in the background, one after the other, with
+   * a trapezoidal speed profile: each move starts from rest,
+   * accelerates up to the maximum speed, cruises and decelerates so
+   * that the last step is taken at the starting speed.  With an
+   * acceleration of 0, all steps are taken at the maximum speed.
+   *
+   * All axes in a process are serviced by a single engine thread
+   * that sleeps on a CLOCK_MONOTONIC deadline until the next step of
+   * any axis is due, so any number of motors move concurrently
+   * without a thread or a polling loop per motor.  Step deadlines are
+   * absolute, so the step rate does not drift with the time spent
+   * driving the outputs.
+   *
+   * Completion is reported by move id, either through waitMove()
+   * or a callback.
+   */
+  class MotionAxis {
+  public:
+    /**
+     * Step callback.  Called from the engine thread to take one step.
+     * If it throws, all moves on the axis are cancelled.
+     *
+     * @param dir Direction of the step, 1 or -1
+     */
+    typedef void (*STEP_T)(int dir, void *ctx);
+
+    /**
+     * Move completion callback.  Called from the engine thread once a
+     * move has finished or was cancelled.  New moves may be queued
+     * from it, but the axis must not be destroyed.
+     *
+     * @param id Id of the move, as returned by move()
+     * @param completed False if the move was stopped or aborted
+     */
+    typedef void (*MOVE_DONE_T)(unsigned int id, bool completed, void *ctx);
+
+    /**
+     * MotionAxis constructor
+     *
+     * @param step Step callback
+     * @param ctx Argument passed to the step callback
+     */
+    MotionAxis(STEP_T step, void *ctx);
+
+    /**
+     * MotionAxis destructor.  Pending moves are dropped without
+     * calling their callbacks.
+     */
+    ~MotionAxis();
+
+    /**
+     * Sets the maximum (cruising) speed.  Takes effect with the next
+     * step.
+     *
+     * @param stepsPerSec Speed in steps per second, greater than 0
+     */
+    void setMaxSpeed(double stepsPerSec);
+
+    /**
+     * Returns the maximum speed
+     *
+     * @return Speed in steps per second
+     */
+    double getMaxSpeed();
+
+    /**
+     * Sets the acceleration and deceleration rate
+     *
+     * @param stepsPerSec2 Rate in steps per second per second, or 0
+     * to always step at the maximum speed
+     */
+    void setAcceleration(double stepsPerSec2);
+
+    /**
+     * Returns the acceleration rate
+     *
+     * @return Rate in steps per second per second
+     */
+    double getAcceleration();
+
+    /**
+     * Queues a relative move.  Returns immediately.
+     *
+     * @param steps Number of steps, negative to move backward
+     * @param done Optional completion callback
+     * @param doneCtx Argument passed to the completion callback
+     * @return Id of the move, for waitMove()
+     */
+    unsigned int move(int steps, MOVE_DONE_T done=0, void *doneCtx=0);
+
+    /**
+     * Queues a move to an absolute position, relative to the
+     * position at the end of the moves already queued
+     *
+     * @param position Target position, in steps
+     * @param done Optional completion callback
+     * @param doneCtx Argument passed to the completion callback
+     * @return Id of the move, for waitMove()
+     */
+    unsigned int moveTo(int position, MOVE_DONE_T done=0, void *doneCtx=0);
+
+    /**
+     * Waits for a move to finish
+     *
+     * @param id Id of the move
+     * @param millis Number of milliseconds to wait, or -1 to wait
+     * forever
+     * @return True if the move has finished
+     */
+    bool waitMove(unsigned int id, int millis=-1);
+
+    /**
+     * Waits for all queued moves to finish
+     *
+     * @param millis Number of milliseconds to wait, or -1 to wait
+     * forever
+     * @return True if the axis is idle
+     */
+    bool waitIdle(int millis=-1);
+
+    /**
+     * Decelerates the current move to a stop and cancels all queued
+     * moves.  Returns immediately.
+     */
+    void stop();
+
+    /**
+     * Stops immediately and cancels all moves
+     */
+    void abort();
+
+    /**
+     * Returns true while moves are queued or executing
+     */
+    bool busy();
+
+    /**
+     * Returns the number of moves queued or executing
+     */
+    int getQueueLength();
+
+    /**
+     * Returns the current position.  This is the sum of all the
+     * steps taken.
+     *
+     * @return Position, in steps
+     */
+    int getPosition();
+
+    /**
+     * Sets the current position.  Only allowed while idle.
+     *
+     * @param position Position, in steps
+     */
+    void setPosition(int position);
+
+    /**
+     * Returns the current speed
+     *
+     * @return Speed in steps per second, negative when moving backward
+     */
+    double getSpeed();
+
+    /**
+     * Returns the number of steps that were due more than one step
+     * interval earlier than the engine could take them
+     *
+     * @return Number of late steps
+     */
+    unsigned int getLateStepCount();
+
+    /**
+     * Returns the number of times the step callback threw an
+     * exception.  Each time, all moves on the axis were cancelled.
+     *
+     * @return Number of step errors
+     */
+    unsigned int getStepErrorCount();
+
+  private:
+    typedef struct {
+      unsigned int id;
+      int steps;
+      MOVE_DONE_T done;
+      void *doneCtx;
+    } MOVE_T;
+
+    typedef struct {
+      MotionAxis *axis;
+      int dir;                  // 0 for a completion event
+      unsigned int id;
+      bool completed;
+      bool failed;
+      MOVE_DONE_T done;
+      void *doneCtx;
+    } EVENT_T;
+
+    // called from the engine thread with s_lock held
+    void service(uint64_t now, std::vector<EVENT_T> &events);
+    bool loadMove(uint64_t now, std::vector<EVENT_T> &events);
+    void finishMove(bool completed, std::vector<EVENT_T> &events);
+    bool waitDone(unsigned int id, int millis);
+
+    static uint64_t getNanos();
+    static void registerAxis(MotionAxis *axis);
+    static void unregisterAxis(MotionAxis *axis);
+    static void *engineThread(void *ctx);
+
+    STEP_T m_step;
+    void *m_stepCtx;
+
+    // everything below is protected by s_lock
+    double m_maxSpeed;
+    double m_accel;
+
+    std::deque<MOVE_T> m_moves;
+    bool m_moving;              // front of m_moves is executing
+    bool m_stopping;            // cancel moves up to m_stopId
+    unsigned int m_stopId;
+    int m_remaining;            // steps left in the current move
+    int m_dir;
+    double m_speed;
+    uint64_t m_due;             // CLOCK_MONOTONIC, ns
+
+    int m_position;
+    int m_endPosition;          // position after the queued moves
+    unsigned int m_lastId;
+    unsigned int m_doneId;
+    unsigned int m_lateSteps;
+    unsigned int m_stepErrors;
+
+    // shared engine thread state
+    static pthread_mutex_t s_lock;
+    static pthread_mutex_t s_threadLock;
+    static pthread_cond_t s_wakeCond;
+    static pthread_cond_t s_doneCond;
+    static bool s_condInit;
+    static std::vector<MotionAxis *> s_axes;
+    static pthread_t s_thread;
+    static bool s_running;
+    static bool s_dispatching;
+    static unsigned int s_dispatchSeq;
+  };
+}
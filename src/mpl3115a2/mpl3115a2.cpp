@@ -31,11 +31,20 @@
 #include <stdexcept>
 #include <unistd.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "mpl3115a2.h"
 
 using namespace upm;
 
+static uint64_t getMonotonicUs()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
 MPL3115A2::MPL3115A2 (int bus, int devAddr, uint8_t mode) : m_i2ControlCtx(bus)
 {
     int id;
@@ -45,6 +54,11 @@ MPL3115A2::MPL3115A2 (int bus, int devAddr, uint8_t mode) : m_i2ControlCtx(bus)
     m_controlAddr = devAddr;
     m_bus = bus;
 
+    m_iPressure = 0;
+    m_iTemperature = 0;
+    m_converting = false;
+    m_convDeadline = 0;
+
     mraa::Result ret = m_i2ControlCtx.address(m_controlAddr);
     if (ret != mraa::SUCCESS) {
         throw std::runtime_error(std::string(__FUNCTION__) +
@@ -146,39 +160,77 @@ MPL3115A2::resetSensor(void)
 int
 MPL3115A2::sampleData(void)
 {
-    int val;
-    mraa::Result ret;
-    int tries = 15;
-    uint32_t us_delay;
-
     // trigger measurement
-    ret = i2cWriteReg(MPL3115A2_CTRL_REG1,
-            MPL3115A2_CTRL_OST | MPL3115A2_SETOVERSAMPLE(m_oversampling));
-    if (mraa::SUCCESS != ret) {
+    if (!startConversion()) {
         fprintf(stdout, "Write to trigger measurement failed\n");
         return -1;
     }
 
-    // Calculate and delay the appopriate time for the measurement
-    us_delay = ((1 << m_oversampling) * 4 + 2) * 1000;
-    usleep(us_delay);
+    // sleep for the appropriate time, then poll the ready bit
+    while (!conversionReady()) {
+        uint64_t now = getMonotonicUs();
 
-    // Loop waiting for the ready bit to become active
-    while (tries-- > 0) {
-        val = i2cReadReg_8(MPL3115A2_CTRL_REG1);
-
-        /* wait for data ready, i.e. OST cleared */
-        if (!(val & MPL3115A2_CTRL_OST))
-            break;
-        usleep(20000);
+        if (now < m_convDeadline)
+            usleep(m_convDeadline - now);
+        else
+            usleep(20000);
     }
-    if (tries < 0) {
+    m_converting = false;
+
+    return 0;
+}
+
+bool
+MPL3115A2::startConversion(void)
+{
+    mraa::Result ret;
+
+    ret = i2cWriteReg(MPL3115A2_CTRL_REG1,
+            MPL3115A2_CTRL_OST | MPL3115A2_SETOVERSAMPLE(m_oversampling));
+    if (mraa::SUCCESS != ret)
+        return false;
+
+    m_convDeadline = getMonotonicUs() +
+        ((1 << m_oversampling) * 4 + 2) * 1000;
+    m_converting = true;
+
+    return true;
+}
+
+bool
+MPL3115A2::conversionReady(void)
+{
+    if (!m_converting)
+        return false;
+
+    uint64_t now = getMonotonicUs();
+    if (now < m_convDeadline)
+        return false;
+
+    /* data ready, i.e. OST cleared */
+    if (!(i2cReadReg_8(MPL3115A2_CTRL_REG1) & MPL3115A2_CTRL_OST))
+        return true;
+
+    if (now > m_convDeadline + MPL3115A2_CONV_TIMEOUT_US) {
+        m_converting = false;
         throw std::runtime_error(std::string(__FUNCTION__) +
                                  ": timeout during measurement");
-        return -1;
     }
 
-    return 0;
+    return false;
+}
+
+bool
+MPL3115A2::collect(void)
+{
+    if (!conversionReady())
+        return false;
+
+    m_converting = false;
+    m_iPressure = getPressureReg(MPL3115A2_OUT_PRESS);
+    m_iTemperature = getTempReg(MPL3115A2_OUT_TEMP);
+
+    return true;
 }
 
 int32_t
@@ -53,6 +53,8 @@
 #define MPL3115A2_GETOVERSAMPLE(a) ((a >> 3) & 7)
 #define MPL3115A2_MAXOVERSAMPLE   7
 
+#define MPL3115A2_CONV_TIMEOUT_US 300000 /* past the nominal time */
+
 namespace upm {
 
 /**
@@ -76,6 +78,10 @@ namespace upm {
  * is a high-precision, ultra-low power consumption pressure sensor. Its operating
  * range is 50-110 kPa.
  *
+ * A measurement can also be run in phases with startConversion(),
+ * conversionReady() and collect(), so one thread can keep
+ * conversions running on many sensors without sleeping on each.
+ *
  * @image html mpl3115a2.jpg
  * @snippet mpl3115a2.cxx Interesting
  */
@@ -122,6 +128,42 @@ class MPL3115A2 {
          */
         int sampleData(void);
 
+        /**
+         * Triggers a one-shot temperature/pressure measurement and
+         * returns immediately
+         *
+         * @return True if the measurement was started
+         */
+        bool startConversion(void);
+
+        /**
+         * Checks whether the measurement started by startConversion()
+         * has finished.  The device is only polled once the nominal
+         * conversion time has elapsed.
+         *
+         * @return True if collect() can be called
+         */
+        bool conversionReady(void);
+
+        /**
+         * Reads the result of a finished measurement.  The values are
+         * then available from getLastPressure() and getLastTemperature().
+         *
+         * @return True if a result was collected, false if the
+         * measurement is still in progress or none was started
+         */
+        bool collect(void);
+
+        /**
+         * Returns the pressure from the last collect() [Pa]
+         */
+        float getLastPressure(void) { return (float)m_iPressure / 100; };
+
+        /**
+         * Returns the temperature from the last collect() [degC]
+         */
+        float getLastTemperature(void) { return (float)m_iTemperature / 1000; };
+
         /**
          * Reads the pressure value from MPL3115A2 [Pa * 100]
          *
@@ -250,6 +292,9 @@ class MPL3115A2 {
         uint8_t m_oversampling;
         int32_t m_iPressure;
         int32_t m_iTemperature;
+
+        bool m_converting;
+        uint64_t m_convDeadline;
 };
 
 }
@@ -24,7 +24,9 @@
 
 #include <unistd.h>
 #include <iostream>
+#include <stdexcept>
 #include <string.h>
+#include <time.h>
 
 #include "mpu60x0.h"
 
@@ -50,6 +52,24 @@ MPU60X0::MPU60X0(int bus, uint8_t address) :
   m_accelScale = 1.0;
   m_gyroScale = 1.0;
 
+  m_ring = 0;
+  m_ringSize = 0;
+  m_ringHead = 0;
+  m_ringCount = 0;
+  m_fifoWatermark = 1;
+  m_fifoPending = 0;
+  m_samplePeriodUs = 1000;
+  m_fifoOverflows = 0;
+  m_ringOverflows = 0;
+  m_fifoSamples = 0;
+
+  if (pthread_mutex_init(&m_ringLock, NULL))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_mutex_init(ringLock) failed");
+      return;
+    }
+
   mraa::Result rv;
   if ( (rv = m_i2c.address(m_addr)) != mraa::SUCCESS)
     {
@@ -62,6 +82,7 @@ MPU60X0::MPU60X0(int bus, uint8_t address) :
 MPU60X0::~MPU60X0()
 {
   uninstallISR();
+  pthread_mutex_destroy(&m_ringLock);
 }
 
 bool MPU60X0::init()
@@ -415,3 +436,214 @@ void MPU60X0::uninstallISR()
       m_gpioIRQ = 0;
     }
 }
+
+uint16_t MPU60X0::getFIFOCount()
+{
+  uint8_t buffer[2];
+
+  readRegs(REG_FIFO_COUNTH, buffer, 2);
+
+  return ( (buffer[0] << 8) | buffer[1] );
+}
+
+bool MPU60X0::resetFIFO()
+{
+  uint8_t reg = readReg(REG_USER_CTRL);
+
+  return writeReg(REG_USER_CTRL, reg | FIFO_RESET);
+}
+
+uint32_t MPU60X0::samplePeriodUs()
+{
+  // the gyro output rate is 8Khz with the DLPF disabled, 1Khz otherwise
+  uint8_t dlpf = (readReg(REG_CONFIG) >> _CONFIG_DLPF_SHIFT) &
+    _CONFIG_DLPF_MASK;
+  uint32_t rate = (dlpf == DLPF_260_256 || dlpf == DLPF_RESERVED) ?
+    8000 : 1000;
+
+  return (1000000 * (1 + getSampleRateDivider())) / rate;
+}
+
+bool MPU60X0::enableFIFOStreaming(FIFO_SAMPLE_T *ring, int size,
+                                  int watermark, int gpio, mraa::Edge level)
+{
+  if (!ring || size <= 0)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": a ring buffer is required");
+      return false;
+    }
+
+  disableFIFOStreaming();
+
+  // leave room in the FIFO for the samples that arrive while draining
+  int maxWatermark = (MPU60X0_FIFO_SIZE / MPU60X0_FIFO_SAMPLE_BYTES) / 2;
+  if (watermark < 1)
+    watermark = 1;
+  if (watermark > maxWatermark)
+    watermark = maxWatermark;
+
+  pthread_mutex_lock(&m_ringLock);
+  m_ring = ring;
+  m_ringSize = size;
+  m_ringHead = 0;
+  m_ringCount = 0;
+  m_fifoWatermark = watermark;
+  m_fifoPending = 0;
+  m_fifoOverflows = 0;
+  m_ringOverflows = 0;
+  m_fifoSamples = 0;
+  pthread_mutex_unlock(&m_ringLock);
+
+  m_samplePeriodUs = samplePeriodUs();
+
+  // stop and flush the FIFO before changing what goes into it
+  uint8_t reg = readReg(REG_USER_CTRL);
+  writeReg(REG_USER_CTRL, (reg & ~FIFO_EN) | FIFO_RESET);
+
+  if (!writeReg(REG_FIFO_EN, ACCEL_FIFO_EN | TEMP_FIFO_EN |
+                XG_FIFO_EN | YG_FIFO_EN | ZG_FIFO_EN))
+    return false;
+
+  reg = readReg(REG_USER_CTRL);
+  if (!writeReg(REG_USER_CTRL, reg | FIFO_EN))
+    return false;
+
+  if (gpio >= 0)
+    {
+      setInterruptEnables(DATA_RDY_EN | FIFO_OFLOW_EN);
+      installISR(gpio, level, &fifoISR, this);
+    }
+
+  return true;
+}
+
+void MPU60X0::disableFIFOStreaming()
+{
+  if (!m_ring)
+    return;
+
+  uninstallISR();
+  setInterruptEnables(0);
+
+  writeReg(REG_FIFO_EN, 0);
+  uint8_t reg = readReg(REG_USER_CTRL);
+  writeReg(REG_USER_CTRL, (reg & ~FIFO_EN) | FIFO_RESET);
+
+  // keep the ring so queued samples can still be retrieved
+}
+
+int MPU60X0::drainFIFO()
+{
+  if (!m_ring)
+    return 0;
+
+  m_fifoPending = 0;
+
+  // reading the status also clears a latched interrupt
+  if (getInterruptStatus() & FIFO_OFLOW_INT)
+    {
+      // the oldest data was overwritten, so sample boundaries are lost
+      m_fifoOverflows++;
+      resetFIFO();
+      return 0;
+    }
+
+  int samples = getFIFOCount() / MPU60X0_FIFO_SAMPLE_BYTES;
+  if (!samples)
+    return 0;
+
+  // the newest sample in the FIFO was taken approximately now
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  uint64_t newest = ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+
+  uint8_t buffer[MPU60X0_FIFO_BURST * MPU60X0_FIFO_SAMPLE_BYTES];
+  int done = 0;
+
+  while (done < samples)
+    {
+      int burst = samples - done;
+      if (burst > MPU60X0_FIFO_BURST)
+        burst = MPU60X0_FIFO_BURST;
+
+      readRegs(REG_FIFO_R_W, buffer, burst * MPU60X0_FIFO_SAMPLE_BYTES);
+
+      pthread_mutex_lock(&m_ringLock);
+      for (int i = 0; i < burst; i++)
+        {
+          uint8_t *b = &buffer[i * MPU60X0_FIFO_SAMPLE_BYTES];
+          FIFO_SAMPLE_T *s = &m_ring[m_ringHead];
+
+          s->timestamp = newest -
+            (uint64_t)(samples - 1 - (done + i)) * m_samplePeriodUs;
+
+          s->accelX = float(int16_t((b[0] << 8) | b[1])) / m_accelScale;
+          s->accelY = float(int16_t((b[2] << 8) | b[3])) / m_accelScale;
+          s->accelZ = float(int16_t((b[4] << 8) | b[5])) / m_accelScale;
+
+          // this equation is taken from the datasheet
+          s->temperature = (float(int16_t((b[6] << 8) | b[7])) / 340.0)
+            + 36.53;
+
+          s->gyroX = float(int16_t((b[8] << 8) | b[9])) / m_gyroScale;
+          s->gyroY = float(int16_t((b[10] << 8) | b[11])) / m_gyroScale;
+          s->gyroZ = float(int16_t((b[12] << 8) | b[13])) / m_gyroScale;
+
+          m_ringHead = (m_ringHead + 1) % m_ringSize;
+          if (m_ringCount < m_ringSize)
+            m_ringCount++;
+          else
+            m_ringOverflows++;  // overwrote the oldest sample
+        }
+      pthread_mutex_unlock(&m_ringLock);
+
+      done += burst;
+    }
+
+  m_fifoSamples += samples;
+
+  return samples;
+}
+
+int MPU60X0::getFIFOSamples(FIFO_SAMPLE_T *buffer, int len)
+{
+  int copied = 0;
+
+  pthread_mutex_lock(&m_ringLock);
+  if (m_ring)
+    {
+      int tail = (m_ringHead - m_ringCount + m_ringSize) % m_ringSize;
+
+      while (copied < len && m_ringCount > 0)
+        {
+          buffer[copied++] = m_ring[tail];
+          tail = (tail + 1) % m_ringSize;
+          m_ringCount--;
+        }
+    }
+  pthread_mutex_unlock(&m_ringLock);
+
+  return copied;
+}
+
+int MPU60X0::getFIFOSamplesAvailable()
+{
+  int count;
+
+  pthread_mutex_lock(&m_ringLock);
+  count = m_ringCount;
+  pthread_mutex_unlock(&m_ringLock);
+
+  return count;
+}
+
+void MPU60X0::fifoISR(void *ctx)
+{
+  upm::MPU60X0 *This = (upm::MPU60X0 *)ctx;
+
+  // one data ready interrupt per sample; only touch the bus once
+  // enough samples have accumulated in the FIFO
+  if (++This->m_fifoPending >= This->m_fifoWatermark)
+    This->drainFIFO();
+}
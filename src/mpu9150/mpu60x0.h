@@ -24,6 +24,7 @@
 #pragma once
 
 #include <string>
+#include <pthread.h>
 #include <mraa/common.hpp>
 #include <mraa/i2c.hpp>
 
@@ -36,6 +37,13 @@
 #define MPU60X0_I2C_BUS 0
 #define MPU60X0_DEFAULT_I2C_ADDR 0x68
 
+// size of the on-chip FIFO in bytes
+#define MPU60X0_FIFO_SIZE 1024
+// bytes per FIFO sample: accel (6), temp (2), gyro (6)
+#define MPU60X0_FIFO_SAMPLE_BYTES 14
+// maximum number of samples read in one I2C burst
+#define MPU60X0_FIFO_BURST 32
+
 namespace upm {
   
   /**
@@ -653,6 +661,22 @@ namespace upm {
     } LP_WAKE_CRTL_T;
 
 
+    /**
+     * One sample delivered by FIFO streaming, scaled the same way as
+     * getAccelerometer(), getGyroscope() and getTemperature()
+     */
+    typedef struct {
+      uint64_t timestamp;               // CLOCK_MONOTONIC, microseconds
+      float accelX;
+      float accelY;
+      float accelZ;
+      float gyroX;
+      float gyroY;
+      float gyroZ;
+      float temperature;
+    } FIFO_SAMPLE_T;
+
+
     /**
      * mpu60x0 constructor
      *
@@ -932,6 +956,102 @@ namespace upm {
      */
     void uninstallISR();
 
+    /**
+     * start streaming accelerometer, temperature and gyroscope
+     * samples through the on-chip FIFO into a ring buffer supplied by
+     * the caller.  The device has no FIFO watermark interrupt, so the
+     * data ready interrupt is used to count samples, and the FIFO is
+     * drained with burst reads once watermark samples have been
+     * counted.  If gpio is negative no interrupt handler is
+     * installed, and drainFIFO() must be called periodically instead.
+     *
+     * update() must not be called while streaming is enabled, since
+     * the interrupt handler uses the I2C bus from its own thread.
+     *
+     * @param ring storage for the ring buffer, must remain valid
+     * until streaming is disabled
+     * @param size the number of samples ring can hold
+     * @param watermark the number of samples to collect in the FIFO
+     * before draining it
+     * @param gpio gpio pin connected to the INT pin, or -1
+     * @param level the interrupt trigger level (one of mraa::Edge
+     * values)
+     * @return true if successful
+     */
+    bool enableFIFOStreaming(FIFO_SAMPLE_T *ring, int size, int watermark,
+                             int gpio, mraa::Edge level=mraa::EDGE_RISING);
+
+    /**
+     * stop FIFO streaming, remove the interrupt handler and disable
+     * the FIFO.  Samples still in the ring buffer can be retrieved
+     * with getFIFOSamples().
+     */
+    void disableFIFOStreaming();
+
+    /**
+     * read every complete sample currently in the FIFO into the ring
+     * buffer.  If the FIFO has overflowed, it is reset and the
+     * overflow counter incremented instead.
+     *
+     * @return the number of samples transferred
+     */
+    int drainFIFO();
+
+    /**
+     * copy the oldest samples out of the ring buffer
+     *
+     * @param buffer the buffer to store the samples in
+     * @param len the maximum number of samples to copy
+     * @return the number of samples copied
+     */
+    int getFIFOSamples(FIFO_SAMPLE_T *buffer, int len);
+
+    /**
+     * get the number of samples waiting in the ring buffer
+     *
+     * @return the number of samples available
+     */
+    int getFIFOSamplesAvailable();
+
+    /**
+     * get the number of bytes currently stored in the on-chip FIFO
+     *
+     * @return the FIFO count
+     */
+    uint16_t getFIFOCount();
+
+    /**
+     * discard the contents of the on-chip FIFO
+     *
+     * @return true if successful, false otherwise
+     */
+    bool resetFIFO();
+
+    /**
+     * get the number of times the on-chip FIFO overflowed and was
+     * reset since streaming was enabled
+     *
+     * @return the overflow count
+     */
+    unsigned int getFIFOOverflowCount() { return m_fifoOverflows; };
+
+    /**
+     * get the number of samples discarded because the ring buffer
+     * was full since streaming was enabled.  The oldest samples are
+     * dropped first.
+     *
+     * @return the dropped sample count
+     */
+    unsigned int getRingOverflowCount() { return m_ringOverflows; };
+
+    /**
+     * get the total number of samples read from the FIFO since
+     * streaming was enabled
+     *
+     * @return the sample count
+     */
+    unsigned long getFIFOSampleCount() { return m_fifoSamples; };
+
   protected:
     // uncompensated accelerometer and gyroscope values
     float m_accelX;
@@ -959,6 +1079,24 @@ namespace upm {
     uint8_t m_addr;
 
     mraa::Gpio *m_gpioIRQ;
+
+    // FIFO streaming state
+    static void fifoISR(void *ctx);
+    uint32_t samplePeriodUs();
+
+    FIFO_SAMPLE_T *m_ring;
+    int m_ringSize;
+    int m_ringHead;
+    int m_ringCount;
+    int m_fifoWatermark;
+    volatile int m_fifoPending;
+    uint32_t m_samplePeriodUs;
+
+    volatile unsigned int m_fifoOverflows;
+    volatile unsigned int m_ringOverflows;
+    volatile unsigned long m_fifoSamples;
+
+    pthread_mutex_t m_ringLock;
   };
 }
 
@@ -47,6 +47,19 @@ MY9221::MY9221 (uint8_t di, uint8_t dcki)
     if (error != mraa::SUCCESS) {
         mraa::printError(error);
     }
+
+    // memory-mapped GPIO where the platform has it, sysfs otherwise
+    m_mmap = (m_clkPinCtx.useMmap(true) == mraa::SUCCESS &&
+              m_dataPinCtx.useMmap(true) == mraa::SUCCESS);
+    if (!m_mmap) {
+        m_clkPinCtx.useMmap(false);
+        m_dataPinCtx.useMmap(false);
+    }
+
+    m_clkState = LOW;
+    m_dataState = LOW;
+    m_clkPinCtx.write(m_clkState);
+    m_dataPinCtx.write(m_dataState);
 }
 
 mraa::Result
@@ -55,20 +68,30 @@ MY9221::setBarLevel (uint8_t level, bool direction) {
         return mraa::ERROR_INVALID_PARAMETER;
     }
 
-    send16bitBlock (CMDMODE);
+    uint16_t frame[BLOCKS_PER_CHIP];
+    int idx = 0;
+
+    frame[idx++] = CMDMODE;
     if (direction) {
         level += 3;
         for(uint8_t block_idx = 12; block_idx > 0; block_idx--) {
-            uint32_t state = (block_idx < level) ? BIT_HIGH : BIT_LOW;
-            send16bitBlock (state);
+            frame[idx++] = (block_idx < level) ? BIT_HIGH : BIT_LOW;
         }
     } else {
         for(uint8_t block_idx = 0; block_idx < 12; block_idx++) {
-            uint32_t state = (block_idx < level) ? BIT_HIGH : BIT_LOW;
-            send16bitBlock (state);
+            frame[idx++] = (block_idx < level) ? BIT_HIGH : BIT_LOW;
         }
     }
-    return lockData ();
+
+    return setData (frame, BLOCKS_PER_CHIP);
+}
+
+mraa::Result
+MY9221::setData (uint16_t * blocks, int count) {
+    mraa::Result error = writeBlocks (blocks, count);
+    mraa::Result latch = lockData ();
+
+    return (error != mraa::SUCCESS) ? error : latch;
 }
 
 mraa::Result
@@ -81,26 +104,39 @@ MY9221::lockData () {
         error = m_dataPinCtx.write(HIGH);
         error = m_dataPinCtx.write(LOW);
     }
+    m_dataState = LOW;
     return error;
 }
 
 mraa::Result
-MY9221::send16bitBlock (short data) {
-    mraa::Result error = mraa::SUCCESS;
-    for (uint8_t bit_idx = 0; bit_idx < MAX_BIT_PER_BLOCK; bit_idx++) {
-        uint32_t state = (data & 0x8000) ? HIGH : LOW;
-        error = m_dataPinCtx.write(state);
-        state = m_clkPinCtx.read();
-
-        if (state) {
-            state = LOW;
-        } else {
-            state = HIGH;
-        }
+MY9221::writeBlocks (const uint16_t * blocks, int count) {
+    mraa::Result rv = mraa::SUCCESS;
+    mraa::Result error;
+
+    for (int block = 0; block < count; block++) {
+        uint16_t data = blocks[block];
 
-        error = m_clkPinCtx.write(state);
+        for (uint8_t bit_idx = 0; bit_idx < MAX_BIT_PER_BLOCK; bit_idx++) {
+            int state = (data & 0x8000) ? HIGH : LOW;
 
-        data <<= 1;
+            // runs of equal bits only need the clock edge
+            if (state != m_dataState) {
+                error = m_dataPinCtx.write(state);
+                if (error != mraa::SUCCESS) {
+                    rv = error;
+                }
+                m_dataState = state;
+            }
+
+            // data is latched on both clock edges
+            m_clkState = (m_clkState == HIGH) ? LOW : HIGH;
+            error = m_clkPinCtx.write(m_clkState);
+            if (error != mraa::SUCCESS) {
+                rv = error;
+            }
+
+            data <<= 1;
+        }
     }
-    return error;
+    return rv;
 }
@@ -33,6 +33,7 @@
 #define CMDMODE               0x0000
 #define BIT_HIGH              0x00ff
 #define BIT_LOW               0x0000
+#define BLOCKS_PER_CHIP       13
 
 #define HIGH                  1
 #define LOW                   0
@@ -81,6 +82,26 @@ class MY9221 {
          */
         mraa::Result setBarLevel (uint8_t level, bool direction=true);
 
+        /**
+         * Sends raw 16-bit blocks down a chain of MY9221s and latches
+         * them. Each chip takes BLOCKS_PER_CHIP blocks: a command word
+         * followed by 12 greyscale values; the block for the last chip
+         * in the chain goes first
+         *
+         * @param blocks Blocks to send
+         * @param count Number of blocks
+         */
+        mraa::Result setData (uint16_t * blocks, int count);
+
+        /**
+         * Returns true if the pins are driven through memory-mapped
+         * GPIO rather than sysfs
+         */
+        bool isMmap ()
+        {
+            return m_mmap;
+        }
+
         /**
          * Returns the name of the component
          */
@@ -90,11 +111,16 @@ class MY9221 {
         }
     private:
         mraa::Result lockData ();
-        mraa::Result send16bitBlock (short data);
+        mraa::Result writeBlocks (const uint16_t * blocks, int count);
 
         std::string m_name;
         mraa::Gpio m_clkPinCtx;
         mraa::Gpio m_dataPinCtx;
+
+        /* last level written to each pin, so neither is read back */
+        int m_clkState;
+        int m_dataState;
+        bool m_mmap;
 };
 
 }
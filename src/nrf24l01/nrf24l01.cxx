@@ -28,18 +28,69 @@
 #include <string>
 #include <stdexcept>
 #include <stdlib.h>
+#include <time.h>
+#include <errno.h>
 
 #include "nrf24l01.h"
 
 using namespace upm;
 
+/* how often waitTxEvent() re-checks STATUS in case an IRQ edge was missed */
+#define TX_EVENT_SLICE_US   10000
+
+static uint64_t
+getMonotonicUs () {
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void
+toTimespec (uint64_t us, struct timespec * ts) {
+    ts->tv_sec = us / 1000000;
+    ts->tv_nsec = (us % 1000000) * 1000;
+}
 
 NRF24L01::NRF24L01 (uint8_t cs, uint8_t ce)
                             : m_csnPinCtx(cs), m_cePinCtx(ce), m_spi(0)
 {
+    pthread_condattr_t condAttr;
+
+    m_irqPinCtx         = NULL;
+    m_dynamicPayload    = false;
+    m_feature           = 0;
+    m_streamCmd         = 0;
+    m_rxHead            = 0;
+    m_rxCount           = 0;
+    m_rxEnabled         = false;
+    m_rxOverflows       = 0;
+    m_txEvents          = 0;
+    m_streamMaxRetries  = 0;
+    m_payload           = MAX_BUFFER;
+    memset (m_pipeWidth, 0, sizeof (m_pipeWidth));
+
+    pthread_mutex_init (&m_spiLock, NULL);
+    pthread_mutex_init (&m_serviceLock, NULL);
+    pthread_mutex_init (&m_eventLock, NULL);
+    pthread_condattr_init (&condAttr);
+    pthread_condattr_setclock (&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init (&m_eventCond, &condAttr);
+    pthread_condattr_destroy (&condAttr);
+
     init (cs, ce);
 }
 
+NRF24L01::~NRF24L01 ()
+{
+    detachIrq ();
+
+    pthread_cond_destroy (&m_eventCond);
+    pthread_mutex_destroy (&m_eventLock);
+    pthread_mutex_destroy (&m_serviceLock);
+    pthread_mutex_destroy (&m_spiLock);
+}
+
 void
 NRF24L01::init (uint8_t chip_select, uint8_t chip_enable) {
     mraa::Result error = mraa::SUCCESS;
@@ -72,6 +123,8 @@ NRF24L01::configure () {
 
     /* Set length of incoming payload for broadcast */
     setRegister (RX_PW_P1, m_payload);
+    m_pipeWidth[0] = m_payload;
+    m_pipeWidth[1] = m_payload;
 
     /* Start receiver */
     rxPowerUp ();
@@ -96,10 +149,7 @@ NRF24L01::send (uint8_t * value) {
     txPowerUp (); // Set to transmitter mode , Power up
     txFlushBuffer ();
 
-    csOn ();
-    m_spi.writeByte(W_TX_PAYLOAD); // Write cmd to write payload
-    writeBytes (value, NULL, m_payload); // Write payload
-    csOff ();
+    command (W_TX_PAYLOAD, value, NULL, m_payload); // Write payload
     ceHigh(); // Start transmission
 
     while (dataSending ()) { }
@@ -179,12 +229,8 @@ NRF24L01::dataSending () {
 
 void
 NRF24L01::getData (uint8_t * data)  {
-    csOn ();
-    /* Send cmd to read rx payload */
-    m_spi.writeByte(R_RX_PAYLOAD);
-    /* Read payload */
-    writeBytes (data, data, m_payload);
-    csOff ();
+    /* Read rx payload */
+    command (R_RX_PAYLOAD, NULL, data, m_payload);
     /* NVI: per product spec, p 67, note c:
      * "The RX_DR IRQ is asserted by a new packet arrival event. The procedure
      * for handling this interrupt should be: 1) read payload through SPI,
@@ -340,6 +386,8 @@ NRF24L01::setBeaconingMode () {
     setRegister (STATUS,     0x3E); // clear various flags
     setRegister (DYNPD,      0x00); // no dynamic payloads
     setRegister (FEATURE,    0x00); // no features
+    m_feature = 0;
+    m_dynamicPayload = false;
     setRegister (RX_PW_P0,   32);   // always RX 32 bytes
     setRegister (EN_RXADDR,  0x01); // RX on pipe 0
 
@@ -387,10 +435,7 @@ NRF24L01::sendBeaconingMsg (uint8_t * msg) {
         sendCommand (FLUSH_TX); // Clear RX Fifo
         sendCommand (FLUSH_RX); // Clear TX Fifo
 
-        csOn ();
-        m_spi.writeByte(W_TX_PAYLOAD);        // Write cmd to write payload
-        writeBytes (m_bleBuffer, NULL, 32);     // Write payload
-        csOff ();
+        command (W_TX_PAYLOAD, m_bleBuffer, NULL, 32); // Write payload
 
         setRegister (CONFIG, 0x12);             // tx on
         ceHigh ();                              // Start transmission
@@ -399,67 +444,550 @@ NRF24L01::sendBeaconingMsg (uint8_t * msg) {
     }
 }
 
-/*
- * ---------------
- * PRIVATE SECTION
- * ---------------
- */
+void
+NRF24L01::setPipeAddress (uint8_t pipe, uint8_t * addr) {
+    if (pipe >= NRF_MAX_PIPES) {
+        throw std::out_of_range(std::string(__FUNCTION__) +
+                                ": pipe must be between 0 and 5");
+    }
+
+    if (pipe < 2) {
+        writeRegister (RX_ADDR_P0 + pipe, addr, ADDR_LEN);
+    } else {
+        setRegister (RX_ADDR_P0 + pipe, addr[0]);
+    }
+}
 
 void
-NRF24L01::writeBytes (uint8_t * dataout, uint8_t * datain, uint8_t len) {
-    if(len > MAX_BUFFER){
+NRF24L01::enablePipe (uint8_t pipe, bool autoAck) {
+    if (pipe >= NRF_MAX_PIPES) {
+        throw std::out_of_range(std::string(__FUNCTION__) +
+                                ": pipe must be between 0 and 5");
+    }
+
+    uint8_t bit = (1 << pipe);
+
+    m_pipeWidth[pipe] = m_payload;
+    setRegister (RX_PW_P0 + pipe, m_payload);
+
+    uint8_t enAA = getRegister (EN_AA);
+    setRegister (EN_AA, autoAck ? (enAA | bit) : (enAA & ~bit));
+
+    if (m_dynamicPayload) {
+        setRegister (DYNPD, getRegister (DYNPD) | bit);
+    }
+
+    setRegister (EN_RXADDR, getRegister (EN_RXADDR) | bit);
+}
+
+void
+NRF24L01::disablePipe (uint8_t pipe) {
+    if (pipe >= NRF_MAX_PIPES) {
+        throw std::out_of_range(std::string(__FUNCTION__) +
+                                ": pipe must be between 0 and 5");
+    }
+
+    uint8_t bit = (1 << pipe);
+
+    setRegister (EN_RXADDR, getRegister (EN_RXADDR) & ~bit);
+    setRegister (DYNPD, getRegister (DYNPD) & ~bit);
+}
+
+void
+NRF24L01::setDynamicPayload (bool enable) {
+    m_dynamicPayload = enable;
+
+    if (enable) {
+        setFeature (1 << EN_DPL);
+        /* DYNPD needs auto-acknowledge, so only the pipes using it */
+        setRegister (DYNPD, getRegister (EN_RXADDR) & getRegister (EN_AA));
+    } else {
+        setRegister (DYNPD, 0x00);
+        m_feature &= ~((1 << EN_DPL) | (1 << EN_ACK_PAY));
+        setRegister (FEATURE, m_feature);
+    }
+}
+
+void
+NRF24L01::setAckPayload (uint8_t pipe, uint8_t * data, uint8_t len) {
+    if (pipe >= NRF_MAX_PIPES) {
+        throw std::out_of_range(std::string(__FUNCTION__) +
+                                ": pipe must be between 0 and 5");
+    }
+
+    if (!m_dynamicPayload) {
+        setDynamicPayload (true);
+    }
+
+    if (!(m_feature & (1 << EN_ACK_PAY))) {
+        setFeature (1 << EN_ACK_PAY);
+    }
+
+    command (W_ACK_PAYLOAD | pipe, data, NULL, len);
+}
+
+void
+NRF24L01::attachIrq (int pin) {
+    detachIrq ();
+
+    m_irqPinCtx = new mraa::Gpio (pin);
+
+    mraa::Result error = m_irqPinCtx->dir (mraa::DIR_IN);
+    if (error == mraa::SUCCESS) {
+        /* IRQ is active low and stays low while any flag is set */
+        error = m_irqPinCtx->isr (mraa::EDGE_FALLING, &irqHandler, this);
+    }
+
+    if (error != mraa::SUCCESS) {
+        delete m_irqPinCtx;
+        m_irqPinCtx = NULL;
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": unable to install IRQ handler");
+    }
+}
+
+void
+NRF24L01::detachIrq () {
+    if (m_irqPinCtx != NULL) {
+        m_irqPinCtx->isrExit ();
+        delete m_irqPinCtx;
+        m_irqPinCtx = NULL;
+    }
+}
+
+void
+NRF24L01::serviceIrq () {
+    uint64_t now = getMonotonicUs ();
+
+    pthread_mutex_lock (&m_serviceLock);
+
+    uint8_t status = command (NOP, NULL, NULL, 0);
+    uint8_t txFlags = status & ((1 << TX_DS) | (1 << MAX_RT));
+
+    pthread_mutex_lock (&m_eventLock);
+    /* send() polls TX_DS itself, so only claim it while streaming */
+    bool streaming = (m_streamCmd != 0);
+    pthread_mutex_unlock (&m_eventLock);
+
+    if (txFlags && streaming) {
+        setRegister (STATUS, txFlags);
+
+        pthread_mutex_lock (&m_eventLock);
+        if (txFlags & (1 << MAX_RT)) {
+            m_streamMaxRetries++;
+        }
+        m_txEvents++;
+        pthread_cond_broadcast (&m_eventCond);
+        pthread_mutex_unlock (&m_eventLock);
+    }
+
+    drainRx (now);
+
+    pthread_mutex_unlock (&m_serviceLock);
+}
+
+void
+NRF24L01::startReceiver (int depth) {
+    if (depth < 1) {
+        depth = 1;
+    }
+
+    pthread_mutex_lock (&m_eventLock);
+    m_rxQueue.resize (depth);
+    m_rxHead = 0;
+    m_rxCount = 0;
+    m_rxOverflows = 0;
+    m_rxEnabled = true;
+    bool streaming = (m_streamCmd != 0);
+    pthread_mutex_unlock (&m_eventLock);
+
+    /* while streaming, the queue collects ACK payloads instead */
+    if (!streaming) {
+        rxPowerUp ();
+    }
+
+    /* pick up anything that arrived before the queue existed */
+    serviceIrq ();
+}
+
+void
+NRF24L01::stopReceiver () {
+    pthread_mutex_lock (&m_eventLock);
+    m_rxEnabled = false;
+    pthread_cond_broadcast (&m_eventCond);
+    pthread_mutex_unlock (&m_eventLock);
+}
+
+int
+NRF24L01::rxAvailable () {
+    pthread_mutex_lock (&m_eventLock);
+    int count = m_rxCount;
+    pthread_mutex_unlock (&m_eventLock);
+
+    return count;
+}
+
+bool
+NRF24L01::readPacket (nrf_packet_t * pkt) {
+    pthread_mutex_lock (&m_eventLock);
+    bool rv = popPacket (pkt);
+    pthread_mutex_unlock (&m_eventLock);
+
+    return rv;
+}
+
+bool
+NRF24L01::waitPacket (nrf_packet_t * pkt, int timeout) {
+    struct timespec ts;
+
+    toTimespec (getMonotonicUs () + (uint64_t)timeout * 1000, &ts);
+
+    pthread_mutex_lock (&m_eventLock);
+    while (m_rxCount == 0 && m_rxEnabled) {
+        if (pthread_cond_timedwait (&m_eventCond, &m_eventLock, &ts)
+            == ETIMEDOUT) {
+            break;
+        }
+    }
+    bool rv = popPacket (pkt);
+    pthread_mutex_unlock (&m_eventLock);
+
+    return rv;
+}
+
+uint32_t
+NRF24L01::getRxOverflowCount () {
+    pthread_mutex_lock (&m_eventLock);
+    uint32_t count = m_rxOverflows;
+    pthread_mutex_unlock (&m_eventLock);
+
+    return count;
+}
+
+void
+NRF24L01::streamStart (bool noAck) {
+    ceLow ();
+    txPowerUp ();
+    setRegister (STATUS, (1 << TX_DS) | (1 << MAX_RT));
+    txFlushBuffer ();
+
+    if (noAck && !(m_feature & (1 << EN_DYN_ACK))) {
+        setFeature (1 << EN_DYN_ACK);
+    }
+
+    pthread_mutex_lock (&m_eventLock);
+    m_streamCmd = noAck ? W_TX_PAYLOAD_NOACK : W_TX_PAYLOAD;
+    m_streamMaxRetries = 0;
+    pthread_mutex_unlock (&m_eventLock);
+
+    /* CE stays high: the radio sends whatever reaches the TX FIFO and
+     * idles in standby-II when it runs dry */
+    ceHigh ();
+}
+
+int
+NRF24L01::streamWrite (uint8_t * data, int count, uint8_t len, int timeout) {
+    if (m_streamCmd == 0) {
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": streamStart() has not been called");
+    }
+
+    if (len == 0) {
+        len = m_payload;
+    }
+    if (len > MAX_BUFFER) {
         len = MAX_BUFFER;
     }
-    for (uint8_t i = 0; i < len; i++) {
-        if (datain != NULL) {
-            datain[i] = m_spi.writeByte(dataout[i]);
-        } else {
-            m_spi.writeByte(dataout[i]);
+
+    uint32_t retries = 0;
+    int written = nrfStreamWrite (*this, m_streamCmd, data, len, count,
+                                  timeout, &retries);
+
+    pthread_mutex_lock (&m_eventLock);
+    m_streamMaxRetries += retries;
+    pthread_mutex_unlock (&m_eventLock);
+
+    return written;
+}
+
+bool
+NRF24L01::streamFlush (int timeout) {
+    uint64_t deadline = getMonotonicUs () + (uint64_t)timeout * 1000;
+
+    for (;;) {
+        uint8_t fifo = 0;
+        uint8_t status = command (R_REGISTER | FIFO_STATUS, NULL, &fifo, 1);
+
+        if (fifo & (1 << TX_EMPTY)) {
+            return true;
+        }
+
+        if (status & (1 << MAX_RT)) {
+            setRegister (STATUS, (1 << MAX_RT));
+
+            pthread_mutex_lock (&m_eventLock);
+            m_streamMaxRetries++;
+            pthread_mutex_unlock (&m_eventLock);
+        }
+
+        uint64_t now = getMonotonicUs ();
+        if (now >= deadline) {
+            return false;
         }
+
+        waitTxEvent ((deadline - now) / 1000 + 1);
     }
 }
 
 void
-NRF24L01::setRegister (uint8_t reg, uint8_t value) {
+NRF24L01::streamStop () {
+    ceLow ();
+    txFlushBuffer ();
+
+    pthread_mutex_lock (&m_eventLock);
+    m_streamCmd = 0;
+    pthread_mutex_unlock (&m_eventLock);
+
+    /* back to listening, as send() does once it is done */
+    rxPowerUp ();
+}
+
+uint32_t
+NRF24L01::getStreamMaxRetries () {
+    pthread_mutex_lock (&m_eventLock);
+    uint32_t count = m_streamMaxRetries;
+    pthread_mutex_unlock (&m_eventLock);
+
+    return count;
+}
+
+uint8_t
+NRF24L01::command (uint8_t cmd, const uint8_t * out, uint8_t * in, int len) {
+    uint8_t buffer[MAX_BUFFER + 1];
+
+    if (len > MAX_BUFFER) {
+        len = MAX_BUFFER;
+    }
+    if (len < 0) {
+        len = 0;
+    }
+
+    /* command and payload go out as one transfer, not a call per byte */
+    buffer[0] = cmd;
+    for (int i = 0; i < len; i++) {
+        buffer[i + 1] = (out != NULL) ? out[i] : NOP;
+    }
+
+    pthread_mutex_lock (&m_spiLock);
     csOn ();
-    m_spi.writeByte(W_REGISTER | (REGISTER_MASK & reg));
-    m_spi.writeByte(value);
+    mraa::Result error = m_spi.transfer (buffer, buffer, len + 1);
     csOff ();
+    pthread_mutex_unlock (&m_spiLock);
+
+    if (error != mraa::SUCCESS) {
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": Spi.transfer() failed");
+    }
+
+    if (in != NULL) {
+        memcpy (in, &buffer[1], len);
+    }
+
+    return buffer[0];
+}
+
+bool
+NRF24L01::waitTxEvent (int timeout) {
+    uint64_t deadline = getMonotonicUs () + (uint64_t)timeout * 1000;
+
+    if (m_irqPinCtx != NULL) {
+        pthread_mutex_lock (&m_eventLock);
+        uint32_t events = m_txEvents;
+
+        while (m_txEvents == events) {
+            uint64_t now = getMonotonicUs ();
+            if (now >= deadline) {
+                break;
+            }
+
+            uint64_t slice = now + TX_EVENT_SLICE_US;
+            if (slice > deadline) {
+                slice = deadline;
+            }
+
+            struct timespec ts;
+            toTimespec (slice, &ts);
+
+            if (pthread_cond_timedwait (&m_eventCond, &m_eventLock, &ts)
+                == ETIMEDOUT && m_txEvents == events) {
+                /* IRQ only has edges while every flag gets cleared; if
+                 * one was missed the line is stuck low, so look */
+                pthread_mutex_unlock (&m_eventLock);
+                serviceIrq ();
+                pthread_mutex_lock (&m_eventLock);
+            }
+        }
+
+        bool rv = (m_txEvents != events);
+        pthread_mutex_unlock (&m_eventLock);
+
+        return rv;
+    }
+
+    for (;;) {
+        uint8_t status = command (NOP, NULL, NULL, 0);
+
+        if (status & (1 << MAX_RT)) {
+            /* left set for the caller to count and clear */
+            return true;
+        }
+
+        if (status & (1 << TX_DS)) {
+            setRegister (STATUS, (1 << TX_DS));
+            return true;
+        }
+
+        if (getMonotonicUs () >= deadline) {
+            return false;
+        }
+
+        usleep (50);
+    }
+}
+
+/*
+ * ---------------
+ * PRIVATE SECTION
+ * ---------------
+ */
+
+void
+NRF24L01::setRegister (uint8_t reg, uint8_t value) {
+    command (W_REGISTER | (REGISTER_MASK & reg), &value, NULL, 1);
 }
 
 uint8_t
 NRF24L01::getRegister (uint8_t reg) {
     uint8_t data = 0;
 
-    csOn ();
-    m_spi.writeByte(R_REGISTER | (REGISTER_MASK & reg));
-    data = m_spi.writeByte(data);
-    csOff ();
+    command (R_REGISTER | (REGISTER_MASK & reg), NULL, &data, 1);
 
     return data;
 }
 
 void
 NRF24L01::readRegister (uint8_t reg, uint8_t * value, uint8_t len) {
-    csOn ();
-    m_spi.writeByte(R_REGISTER | (REGISTER_MASK & reg));
-    writeBytes (value, value, len);
-    csOff ();
+    command (R_REGISTER | (REGISTER_MASK & reg), NULL, value, len);
 }
 
 void
 NRF24L01::writeRegister (uint8_t reg, uint8_t * value, uint8_t len) {
-    csOn ();
-    m_spi.writeByte(W_REGISTER | (REGISTER_MASK & reg));
-    writeBytes (value, NULL, len);
-    csOff ();
+    command (W_REGISTER | (REGISTER_MASK & reg), value, NULL, len);
 }
 
 void
 NRF24L01::sendCommand (uint8_t cmd) {
-    csOn ();
-    m_spi.writeByte(cmd);
-    csOff ();
+    command (cmd, NULL, NULL, 0);
+}
+
+void
+NRF24L01::irqHandler (void * ctx) {
+    NRF24L01 * This = (NRF24L01 *)ctx;
+
+    try {
+        This->serviceIrq ();
+    } catch (std::exception& e) {
+        std::cerr << "NRF24L01: " << e.what() << std::endl;
+    }
+}
+
+void
+NRF24L01::drainRx (uint64_t timestamp) {
+    pthread_mutex_lock (&m_eventLock);
+    bool enabled = m_rxEnabled;
+    pthread_mutex_unlock (&m_eventLock);
+
+    /* without a queue, RX_DR is left for pollListener() */
+    if (!enabled) {
+        return;
+    }
+
+    /* Per product spec, p 67, note c: read payloads until the FIFO is
+     * empty, then clear RX_DR and check nothing arrived meanwhile.  The
+     * bound only guards against a dead bus returning 0xFF forever */
+    for (int guard = 0; guard < 16; guard++) {
+        uint8_t len = 0;
+        uint8_t status;
+
+        /* with dynamic payloads the width read also returns STATUS */
+        if (m_dynamicPayload) {
+            status = command (R_RX_PL_WID, NULL, &len, 1);
+        } else {
+            status = command (NOP, NULL, NULL, 0);
+        }
+
+        uint8_t pipe = (status >> RX_P_NO) & 0x07;
+        if (pipe >= NRF_MAX_PIPES) {
+            if (!(status & (1 << RX_DR))) {
+                break;
+            }
+            setRegister (STATUS, (1 << RX_DR));
+            continue;
+        }
+
+        if (!m_dynamicPayload) {
+            len = m_pipeWidth[pipe] ? m_pipeWidth[pipe] : m_payload;
+        }
+
+        if (len > MAX_BUFFER) {
+            /* corrupt width, the payload must be discarded */
+            rxFlushBuffer ();
+            continue;
+        }
+
+        nrf_packet_t pkt;
+        pkt.pipe = pipe;
+        pkt.len = len;
+        pkt.timestamp = timestamp;
+        command (R_RX_PAYLOAD, NULL, pkt.data, len);
+
+        pthread_mutex_lock (&m_eventLock);
+        if (m_rxCount >= (int)m_rxQueue.size ()) {
+            m_rxOverflows++;
+        } else {
+            int tail = (m_rxHead + m_rxCount) % m_rxQueue.size ();
+            m_rxQueue[tail] = pkt;
+            m_rxCount++;
+            pthread_cond_broadcast (&m_eventCond);
+        }
+        pthread_mutex_unlock (&m_eventLock);
+    }
+}
+
+bool
+NRF24L01::popPacket (nrf_packet_t * pkt) {
+    if (m_rxCount == 0) {
+        return false;
+    }
+
+    *pkt = m_rxQueue[m_rxHead];
+    m_rxHead = (m_rxHead + 1) % m_rxQueue.size ();
+    m_rxCount--;
+
+    return true;
+}
+
+void
+NRF24L01::setFeature (uint8_t bits) {
+    m_feature = getRegister (FEATURE) | bits;
+    setRegister (FEATURE, m_feature);
+
+    if (getRegister (FEATURE) != m_feature) {
+        /* the original nRF24L01 ignores FEATURE until it is activated */
+        uint8_t key = 0x73;
+        command (ACTIVATE, &key, NULL, 1);
+        setRegister (FEATURE, m_feature);
+    }
 }
 
 void
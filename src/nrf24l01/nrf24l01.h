@@ -32,6 +32,8 @@
 
 #include <mraa/spi.hpp>
 #include <cstring>
+#include <vector>
+#include <pthread.h>
 
 #if defined(SWIGJAVA) || defined(JAVACALLBACK)
 #include "Callback.h"
@@ -104,6 +106,9 @@
 #define TX_EMPTY            4
 #define RX_FULL             1
 #define RX_EMPTY            0
+#define EN_DPL              2
+#define EN_ACK_PAY          1
+#define EN_DYN_ACK          0
 
 /* Instruction Mnemonics */
 #define R_REGISTER            0x00
@@ -114,6 +119,10 @@
 #define FLUSH_TX              0xE1
 #define FLUSH_RX              0xE2
 #define REUSE_TX_PL           0xE3
+#define ACTIVATE              0x50
+#define R_RX_PL_WID           0x60
+#define W_ACK_PAYLOAD         0xA8
+#define W_TX_PAYLOAD_NOACK    0xB0
 #define NOP                   0xFF
 
 #define RF_DR_LOW   5
@@ -127,6 +136,9 @@
 
 #define MAX_BUFFER            32
 
+#define NRF_MAX_PIPES         6
+#define NRF_TX_FIFO_DEPTH     3
+
 #define HIGH                  1
 #define LOW                    0
 
@@ -161,6 +173,81 @@ typedef enum {
     NRF_18DBM   = 3,
 } power_t;
 
+/**
+ * A payload taken from the RX FIFO by the interrupt handler
+ */
+typedef struct {
+    uint8_t     pipe;               /**< Pipe the payload arrived on (0-5) */
+    uint8_t     len;                /**< Payload length in bytes */
+    uint8_t     data[MAX_BUFFER];   /**< Payload */
+    uint64_t    timestamp;          /**< CLOCK_MONOTONIC time of the IRQ (us) */
+} nrf_packet_t;
+
+/**
+ * Writes payloads into the TX FIFO of a radio that is already in
+ * PTX mode with CE held high, so that the next payload is always
+ * waiting when the current one leaves the air.  FIFO_STATUS is only
+ * read when the last known free space has been used up.
+ *
+ * DEV is any type providing
+ *   uint8_t command (uint8_t cmd, const uint8_t * out, uint8_t * in, int len)
+ * which runs one SPI command and returns the STATUS byte, and
+ *   bool waitTxEvent (int timeout)
+ * which blocks until the next TX_DS/MAX_RT event, false on timeout.
+ *
+ * @param dev Radio to write to
+ * @param writeCmd W_TX_PAYLOAD or W_TX_PAYLOAD_NOACK
+ * @param data count payloads of len bytes, back to back
+ * @param len Size of each payload
+ * @param count Number of payloads
+ * @param timeout Time to wait for FIFO space, in milliseconds
+ * @param maxRetries Incremented for every MAX_RT seen, may be NULL
+ * @return Number of payloads written
+ */
+template <typename DEV>
+int
+nrfStreamWrite (DEV& dev, uint8_t writeCmd, const uint8_t * data,
+                uint8_t len, int count, int timeout, uint32_t * maxRetries)
+{
+    int written = 0;
+    int room = 0;
+
+    while (written < count) {
+        if (room == 0) {
+            uint8_t fifo = 0;
+            uint8_t status = dev.command (R_REGISTER | FIFO_STATUS,
+                                          NULL, &fifo, 1);
+
+            if (status & (1 << MAX_RT)) {
+                /* The head payload ran out of retries; clearing the
+                 * flag makes the radio start over with it */
+                uint8_t clear = (1 << MAX_RT);
+                dev.command (W_REGISTER | STATUS, &clear, NULL, 1);
+                if (maxRetries != NULL) {
+                    (*maxRetries)++;
+                }
+            }
+
+            if (fifo & (1 << TX_EMPTY)) {
+                room = NRF_TX_FIFO_DEPTH;
+            } else if (!(fifo & (1 << FIFO_FULL))) {
+                room = 1;
+            } else {
+                if (!dev.waitTxEvent (timeout)) {
+                    break;
+                }
+                continue;
+            }
+        }
+
+        dev.command (writeCmd, data + written * len, NULL, len);
+        written++;
+        room--;
+    }
+
+    return written;
+}
+
 /**
  * @brief NRF24L01 Transceiver library
  * @defgroup nrf24l01 libupm-nrf24l01
@@ -184,6 +271,7 @@ typedef enum {
  * @snippet nrf24l01-receiver.cxx Interesting
  * @snippet nrf24l01-transmitter.cxx Interesting
  * @snippet nrf24l01-broadcast.cxx Interesting
+ * @snippet nrf24l01-multipipe.cxx Interesting
  */
 class NRF24L01 {
     public:
@@ -194,6 +282,11 @@ class NRF24L01 {
          */
         NRF24L01 (uint8_t cs, uint8_t ce);
 
+        /**
+         * NRF24L01 destructor
+         */
+        ~NRF24L01 ();
+
         /**
          * Returns the name of the component
          */
@@ -369,6 +462,182 @@ class NRF24L01 {
          */
         void sendBeaconingMsg (uint8_t * msg);
 
+        /**
+         * Sets the receive address of a pipe. Pipes 0 and 1 take a full
+         * 5-byte address; pipes 2-5 share bytes 1-4 with pipe 1, so only
+         * addr[0] is used for them
+         *
+         * @param pipe Pipe number (0-5)
+         * @param addr Address, LSB first
+         */
+        void setPipeAddress (uint8_t pipe, uint8_t * addr);
+
+        /**
+         * Enables reception on a pipe. With static payloads, the pipe
+         * uses the current payload size (see setPayload())
+         *
+         * @param pipe Pipe number (0-5)
+         * @param autoAck Enables Enhanced ShockBurst auto-acknowledgment
+         */
+        void enablePipe (uint8_t pipe, bool autoAck = true);
+
+        /**
+         * Disables reception on a pipe
+         *
+         * @param pipe Pipe number (0-5)
+         */
+        void disablePipe (uint8_t pipe);
+
+        /**
+         * Enables or disables dynamic payload lengths on every enabled
+         * pipe. Both ends must agree
+         *
+         * @param enable True to enable
+         */
+        void setDynamicPayload (bool enable);
+
+        /**
+         * Loads a payload that is returned with the next ACK sent on a
+         * pipe. Enables ACK payloads (and dynamic payload lengths) on
+         * first use
+         *
+         * @param pipe Pipe number (0-5)
+         * @param data Payload
+         * @param len Payload length (MAX 32)
+         */
+        void setAckPayload (uint8_t pipe, uint8_t * data, uint8_t len);
+
+        /**
+         * Attaches an interrupt handler to the IRQ pin. Received
+         * payloads are queued (see startReceiver()) and streaming
+         * transmissions wake up on TX_DS/MAX_RT instead of polling
+         *
+         * @param pin GPIO pin connected to IRQ
+         */
+        void attachIrq (int pin);
+
+        /**
+         * Detaches the IRQ pin interrupt handler
+         */
+        void detachIrq ();
+
+        /**
+         * Runs the interrupt handler by hand, for boards where IRQ is
+         * not wired
+         */
+        void serviceIrq ();
+
+        /**
+         * Starts queueing received payloads. Each interrupt drains the
+         * whole RX FIFO, recording the pipe and arrival time of each
+         * payload. This also picks up ACK payloads while transmitting
+         *
+         * @param depth Number of payloads to hold; when full, new
+         * payloads are dropped and counted
+         */
+        void startReceiver (int depth = 32);
+
+        /**
+         * Stops queueing received payloads. Payloads already queued
+         * can still be read
+         */
+        void stopReceiver ();
+
+        /**
+         * Returns the number of queued payloads
+         */
+        int rxAvailable ();
+
+        /**
+         * Takes the oldest payload off the queue
+         *
+         * @param pkt Filled in with the payload
+         * @return True if a payload was returned
+         */
+        bool readPacket (nrf_packet_t * pkt);
+
+        /**
+         * Waits for a payload and takes it off the queue
+         *
+         * @param pkt Filled in with the payload
+         * @param timeout Maximum time to wait, in milliseconds
+         * @return True if a payload was returned
+         *
+         * Without attachIrq(), payloads are only queued when
+         * serviceIrq() is called.
+         */
+        bool waitPacket (nrf_packet_t * pkt, int timeout);
+
+        /**
+         * Returns the number of payloads dropped because the queue was
+         * full
+         */
+        uint32_t getRxOverflowCount ();
+
+        /**
+         * Enters streaming transmit mode: PTX with CE held high, so
+         * payloads leave back to back as long as the TX FIFO is kept
+         * full by streamWrite()
+         *
+         * @param noAck Sends with W_TX_PAYLOAD_NOACK; no retransmits,
+         * highest throughput
+         *
+         * The original nRF24L01 (not the '+' part) must not be held in
+         * TX mode for more than 4ms; stream to it in short bursts.
+         */
+        void streamStart (bool noAck = false);
+
+        /**
+         * Writes payloads into the TX FIFO, waiting for room as needed
+         *
+         * @param data count payloads of len bytes, back to back
+         * @param count Number of payloads
+         * @param len Size of each payload, 0 for the current payload size
+         * @param timeout Time to wait for FIFO space, in milliseconds
+         * @return Number of payloads written
+         */
+        int streamWrite (uint8_t * data, int count, uint8_t len = 0,
+                         int timeout = 1000);
+
+        /**
+         * Waits for the TX FIFO to empty
+         *
+         * @param timeout Maximum time to wait, in milliseconds
+         * @return True if every payload has been sent
+         */
+        bool streamFlush (int timeout = 1000);
+
+        /**
+         * Leaves streaming mode, dropping anything still in the TX FIFO
+         */
+        void streamStop ();
+
+        /**
+         * Returns the number of MAX_RT events seen while streaming
+         */
+        uint32_t getStreamMaxRetries ();
+
+        /**
+         * Runs one SPI command: cmd, followed by len bytes from out (or
+         * NOPs), with the bytes clocked back stored into in
+         *
+         * @param cmd Command byte
+         * @param out Bytes to send, may be NULL
+         * @param in Buffer for the bytes received, may be NULL
+         * @param len Number of bytes after the command (MAX 32)
+         * @return The STATUS register, clocked out with the command
+         */
+        uint8_t command (uint8_t cmd, const uint8_t * out, uint8_t * in,
+                         int len);
+
+        /**
+         * Waits for the next TX_DS or MAX_RT event
+         *
+         * @param timeout Maximum time to wait, in milliseconds
+         * @return False on timeout
+         */
+        bool waitTxEvent (int timeout);
+
         uint8_t     m_rxBuffer[MAX_BUFFER]; /**< Receive buffer */
         uint8_t     m_txBuffer[MAX_BUFFER]; /**< Transmit buffer */
         uint8_t     m_bleBuffer [32];       /**< BLE buffer */
@@ -380,10 +649,6 @@ class NRF24L01 {
 #endif
         funcPtrVoidVoid dataReceivedHandler; /**< Data arrived handler */
 
-        /**
-         * Writes bytes to an SPI device
-         */
-        void    writeBytes (uint8_t * dataout, uint8_t * datain, uint8_t len);
         /**
          * Sets the register value on an SPI device [one byte]
          */
@@ -413,6 +678,26 @@ class NRF24L01 {
 
         uint8_t swapbits (uint8_t a);
 
+        /**
+         * Interrupt handler for the IRQ pin
+         */
+        static void irqHandler (void * ctx);
+
+        /**
+         * Moves everything in the RX FIFO into the queue
+         */
+        void    drainRx (uint64_t timestamp);
+
+        /**
+         * Takes the oldest payload off the queue, m_eventLock held
+         */
+        bool    popPacket (nrf_packet_t * pkt);
+
+        /**
+         * Sets bits in FEATURE, activating it on parts that need it
+         */
+        void    setFeature (uint8_t bits);
+
         mraa::Spi               m_spi;
         uint8_t                 m_ce;
         uint8_t                 m_csn;
@@ -424,6 +709,26 @@ class NRF24L01 {
 
         mraa::Gpio              m_csnPinCtx;
         mraa::Gpio              m_cePinCtx;
+        mraa::Gpio *            m_irqPinCtx;
+
+        uint8_t                 m_pipeWidth[NRF_MAX_PIPES];
+        bool                    m_dynamicPayload;
+        uint8_t                 m_feature;
+        uint8_t                 m_streamCmd;
+
+        pthread_mutex_t         m_spiLock;
+        pthread_mutex_t         m_serviceLock;
+        pthread_mutex_t         m_eventLock;
+        pthread_cond_t          m_eventCond;
+
+        /* protected by m_eventLock */
+        std::vector<nrf_packet_t> m_rxQueue;
+        int                     m_rxHead;
+        int                     m_rxCount;
+        bool                    m_rxEnabled;
+        uint32_t                m_rxOverflows;
+        uint32_t                m_txEvents;
+        uint32_t                m_streamMaxRetries;
 
         std::string             m_name;
 };
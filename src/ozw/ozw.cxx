@@ -23,6 +23,8 @@
  */
 
 #include <unistd.h>
+#include <errno.h>
+#include <time.h>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -38,12 +40,24 @@ using namespace upm;
 using namespace std;
 using namespace OpenZWave;
 
+// Lookup the cached content of a value.  The cache lock must be held.
+static const zwNode::value_t *findCachedValue(OZW::zwNodeMap_t &nodes,
+                                              int nodeId, int index)
+{
+  OZW::zwNodeMap_t::iterator it = nodes.find(nodeId & 0xff);
+
+  if (it == nodes.end())
+    return NULL;
+
+  return (*it).second->cachedValue(index);
+}
 
 OZW::OZW()
 {
   m_mgrCreated = false;
   m_driverFailed = false;
   m_homeId = 0;
+  m_nextSubscription = 1;
 
   pthread_mutexattr_t mutexAttrib;
   pthread_mutexattr_init(&mutexAttrib);
@@ -70,6 +84,31 @@ OZW::OZW()
                                ": pthread_cond_init() failed");
     }
 
+  if (pthread_rwlock_init(&m_cacheLock, NULL))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_rwlock_init(cacheLock) failed");
+    }
+
+  if (pthread_mutex_init(&m_subLock, NULL))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_mutex_init(subLock) failed");
+    }
+
+  // waitEvent() timeouts are measured against CLOCK_MONOTONIC
+  pthread_condattr_t condAttrib;
+  pthread_condattr_init(&condAttrib);
+  pthread_condattr_setclock(&condAttrib, CLOCK_MONOTONIC);
+
+  if (pthread_cond_init(&m_subCond, &condAttrib))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_cond_init(subCond) failed");
+    }
+
+  pthread_condattr_destroy(&condAttrib);
+
   setDebug(false);
 }
 
@@ -95,6 +134,9 @@ OZW::~OZW()
   pthread_mutex_destroy(&m_nodeLock);
   pthread_mutex_destroy(&m_initLock);
   pthread_cond_destroy(&m_initCond);
+  pthread_rwlock_destroy(&m_cacheLock);
+  pthread_mutex_destroy(&m_subLock);
+  pthread_cond_destroy(&m_subCond);
 
   // delete any nodes.  This should be safe after deleting the node
   // mutex since the handler is no longer registered.
@@ -202,7 +244,9 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
         if (This->m_debugging)
           cerr << "### ### ADDING NODE: " << int(nodeId) << endl;
         zwNode *node = new zwNode(homeId, nodeId);
+        This->lockCacheWrite();
         This->m_zwNodeMap.insert(std::pair<uint8_t, zwNode *>(nodeId, node));
+        This->unlockCache();
 
         break;
       }
@@ -213,8 +257,10 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
           cerr << "### ### REMOVING NODE: " << int(nodeId) << endl;
         if (This->m_zwNodeMap.count(nodeId) != 0)
           {
+            This->lockCacheWrite();
             delete This->m_zwNodeMap[nodeId];
             This->m_zwNodeMap.erase(nodeId);
+            This->unlockCache();
           }
 
         break;
@@ -224,7 +270,17 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
       {
         if (This->m_debugging)
           cerr << "### ### VALUE ADDED " << endl;
-        This->m_zwNodeMap[nodeId]->addValueID(notification->GetValueID());
+
+        // query OpenZWave before taking the cache lock, so readers are
+        // only held off while the cache itself changes
+        zwNode::value_t value;
+        zwNode::readValue(notification->GetValueID(), &value);
+
+        This->lockCacheWrite();
+        zwNode *node = This->m_zwNodeMap[nodeId];
+        int index = node->addValueID(notification->GetValueID());
+        node->setCachedValue(index, value);
+        This->unlockCache();
 
         break;
       }
@@ -233,14 +289,38 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
       {
         if (This->m_debugging)
           cerr << "### ### VALUE DELETED " << endl;
+        This->lockCacheWrite();
         This->m_zwNodeMap[nodeId]->removeValueID(notification->GetValueID());
+        This->unlockCache();
 
         break;
       }
 
     case Notification::Type_ValueChanged:
+    case Notification::Type_ValueRefreshed:
       {
-        // might be able to do something with this someday...
+        zwNodeMap_t::iterator it = This->m_zwNodeMap.find(nodeId);
+        if (it == This->m_zwNodeMap.end())
+          break;
+
+        zwNode::value_t value;
+        zwNode::readValue(notification->GetValueID(), &value);
+
+        This->lockCacheWrite();
+        int index = (*it).second->valueIDToIndex(notification->GetValueID());
+        if (index >= 0)
+          (*it).second->setCachedValue(index, value);
+        This->unlockCache();
+
+        if (This->m_debugging)
+          cerr << "### ### VALUE CHANGED: node " << int(nodeId)
+               << " index " << index << ": " << value.asString << endl;
+
+        // a refresh that didn't change anything is not news
+        if (index >= 0 &&
+            notification->GetType() == Notification::Type_ValueChanged)
+          This->postEvent(nodeId, index, value.asString);
+
         break;
       }
 
@@ -249,6 +329,7 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
         // all nodes deleted.  According to OZW docs, this happens
         // when a driver is reset, instead of sending potentially
         // hundreds of ValueRemoved/NodeRemoved events.
+        This->lockCacheWrite();
         for (zwNodeMap_t::iterator it = This->m_zwNodeMap.begin();
              it != This->m_zwNodeMap.end(); ++it)
           {
@@ -257,6 +338,7 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
           }
         // empty the map
         This->m_zwNodeMap.clear();
+        This->unlockCache();
 
         break;
       }
@@ -366,11 +448,22 @@ bool OZW::getValueID(int nodeId, int index, ValueID *vid)
 
 string OZW::getValueAsString(int nodeId, int index)
 {
+  string rv;
+
+  // answer from the cache if we can
+  lockCacheRead();
+  const zwNode::value_t *value = findCachedValue(m_zwNodeMap, nodeId, index);
+  if (value && value->valid)
+    {
+      rv = value->asString;
+      unlockCache();
+      return rv;
+    }
+  unlockCache();
+
   // we have to play this game since there is no default ctor for ValueID
   ValueID vid(m_homeId, (uint64)0);
 
-  string rv;
-
   lockNodes();
 
   if (getValueID(nodeId, index, &vid))
@@ -729,6 +822,18 @@ bool OZW::isValuePolled(int nodeId, int index)
 
 bool OZW::getValueAsBool(int nodeId, int index)
 {
+  // answer from the cache if we can
+  lockCacheRead();
+  const zwNode::value_t *value = findCachedValue(m_zwNodeMap, nodeId, index);
+  if (value && value->valid && !value->writeOnly &&
+      value->type == ValueID::ValueType_Bool)
+    {
+      bool rv = value->asBool;
+      unlockCache();
+      return rv;
+    }
+  unlockCache();
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -756,6 +861,18 @@ bool OZW::getValueAsBool(int nodeId, int index)
 
 uint8_t OZW::getValueAsByte(int nodeId, int index)
 {
+  // answer from the cache if we can
+  lockCacheRead();
+  const zwNode::value_t *value = findCachedValue(m_zwNodeMap, nodeId, index);
+  if (value && value->valid && !value->writeOnly &&
+      value->type == ValueID::ValueType_Byte)
+    {
+      uint8_t rv = value->asByte;
+      unlockCache();
+      return rv;
+    }
+  unlockCache();
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -783,6 +900,18 @@ uint8_t OZW::getValueAsByte(int nodeId, int index)
 
 float OZW::getValueAsFloat(int nodeId, int index)
 {
+  // answer from the cache if we can
+  lockCacheRead();
+  const zwNode::value_t *value = findCachedValue(m_zwNodeMap, nodeId, index);
+  if (value && value->valid && !value->writeOnly &&
+      value->type == ValueID::ValueType_Decimal)
+    {
+      float rv = value->asFloat;
+      unlockCache();
+      return rv;
+    }
+  unlockCache();
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -810,6 +939,18 @@ float OZW::getValueAsFloat(int nodeId, int index)
 
 int OZW::getValueAsInt32(int nodeId, int index)
 {
+  // answer from the cache if we can
+  lockCacheRead();
+  const zwNode::value_t *value = findCachedValue(m_zwNodeMap, nodeId, index);
+  if (value && value->valid && !value->writeOnly &&
+      value->type == ValueID::ValueType_Int)
+    {
+      int rv = value->asInt32;
+      unlockCache();
+      return rv;
+    }
+  unlockCache();
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -837,6 +978,18 @@ int OZW::getValueAsInt32(int nodeId, int index)
 
 int OZW::getValueAsInt16(int nodeId, int index)
 {
+  // answer from the cache if we can
+  lockCacheRead();
+  const zwNode::value_t *value = findCachedValue(m_zwNodeMap, nodeId, index);
+  if (value && value->valid && !value->writeOnly &&
+      value->type == ValueID::ValueType_Short)
+    {
+      int rv = value->asInt16;
+      unlockCache();
+      return rv;
+    }
+  unlockCache();
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -898,6 +1051,141 @@ bool OZW::isNodeAwake(int nodeId)
   return rv;
 }
 
+int OZW::subscribe(int nodeId, int index, unsigned int queueSize)
+{
+  if (!queueSize)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": queueSize must be at least 1");
+      return -1;
+    }
+
+  pthread_mutex_lock(&m_subLock);
+
+  int id = m_nextSubscription++;
+  SUBSCRIPTION_T &sub = m_subscriptions[id];
+
+  sub.nodeId = (nodeId < 0) ? -1 : (nodeId & 0xff);
+  sub.index = (index < 0) ? -1 : index;
+  sub.queueSize = queueSize;
+  sub.dropped = 0;
+
+  pthread_mutex_unlock(&m_subLock);
+
+  return id;
+}
+
+void OZW::unsubscribe(int id)
+{
+  pthread_mutex_lock(&m_subLock);
+
+  m_subscriptions.erase(id);
+
+  // let any waiters know it's gone
+  pthread_cond_broadcast(&m_subCond);
+
+  pthread_mutex_unlock(&m_subLock);
+}
+
+bool OZW::waitEvent(int id, VALUE_EVENT_T *event, unsigned int millis)
+{
+  struct timespec deadline;
+
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += millis / 1000;
+  deadline.tv_nsec += (millis % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000)
+    {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+
+  bool rv = false;
+
+  pthread_mutex_lock(&m_subLock);
+
+  for (;;)
+    {
+      // look it up every time, it may be unsubscribed while we wait
+      std::map<int, SUBSCRIPTION_T>::iterator it = m_subscriptions.find(id);
+
+      if (it == m_subscriptions.end())
+        break;
+
+      if (!(*it).second.events.empty())
+        {
+          *event = (*it).second.events.front();
+          (*it).second.events.pop_front();
+          rv = true;
+          break;
+        }
+
+      if (!millis)
+        break;
+
+      // one last look after a timeout
+      if (pthread_cond_timedwait(&m_subCond, &m_subLock, &deadline)
+          == ETIMEDOUT)
+        millis = 0;
+    }
+
+  pthread_mutex_unlock(&m_subLock);
+
+  return rv;
+}
+
+unsigned int OZW::getDroppedEvents(int id)
+{
+  unsigned int rv = 0;
+
+  pthread_mutex_lock(&m_subLock);
+
+  std::map<int, SUBSCRIPTION_T>::iterator it = m_subscriptions.find(id);
+  if (it != m_subscriptions.end())
+    rv = (*it).second.dropped;
+
+  pthread_mutex_unlock(&m_subLock);
+
+  return rv;
+}
+
+void OZW::postEvent(int nodeId, int index, const string &value)
+{
+  VALUE_EVENT_T event;
+
+  event.nodeId = nodeId;
+  event.index = index;
+  event.value = value;
+
+  pthread_mutex_lock(&m_subLock);
+
+  bool queued = false;
+  for (std::map<int, SUBSCRIPTION_T>::iterator it = m_subscriptions.begin();
+       it != m_subscriptions.end(); ++it)
+    {
+      SUBSCRIPTION_T &sub = (*it).second;
+
+      if ((sub.nodeId >= 0 && sub.nodeId != nodeId) ||
+          (sub.index >= 0 && sub.index != index))
+        continue;
+
+      // bounded: a slow reader loses the oldest changes, not the newest
+      if (sub.events.size() >= sub.queueSize)
+        {
+          sub.events.pop_front();
+          sub.dropped++;
+        }
+
+      sub.events.push_back(event);
+      queued = true;
+    }
+
+  if (queued)
+    pthread_cond_broadcast(&m_subCond);
+
+  pthread_mutex_unlock(&m_subLock);
+}
+
 void OZW::setDebug(bool enable)
 { 
   m_debugging = enable; 
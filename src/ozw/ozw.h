@@ -25,6 +25,8 @@
 
 #include <string>
 #include <map>
+#include <deque>
+#include <pthread.h>
 
 #include "Manager.h"
 #include "Notification.h"
@@ -34,6 +36,10 @@
 #include "Group.h"
 #include "platform/Log.h"
 
+// default number of events a subscription holds before dropping the
+// oldest
+#define OZW_EVENT_QUEUE_SIZE 64
+
 namespace upm {
   
   /**
@@ -93,6 +99,14 @@ namespace upm {
    * number), and the Index number to access or otherwise affect these
    * values.
    *
+   * The content of every value is cached, and kept current from the
+   * change notifications OpenZWave sends.  The getValueAs*() methods
+   * are answered from this cache under a shared read lock, so any
+   * number of threads can read values at once without waiting on
+   * OpenZWave.  To be told when values change instead of polling
+   * them, subscribe() to a node or a value and collect the changes
+   * with waitEvent().
+   *
    * @snippet openzwave.cxx Interesting
    */
 
@@ -104,6 +118,15 @@ namespace upm {
 
     typedef std::map<uint8_t, zwNode *> zwNodeMap_t;
 
+    /**
+     * A value change delivered to a subscription
+     */
+    typedef struct {
+      int nodeId;
+      int index;
+      std::string value;                // the new content, as a string
+    } VALUE_EVENT_T;
+
     /**
      * OZW constructor
      */
@@ -519,6 +542,51 @@ namespace upm {
      */
     bool isNodeAwake(int nodeId);
 
+    /**
+     * Subscribe to value changes.  Each change reported by OpenZWave
+     * for a matching value is queued for the subscription until it is
+     * collected with waitEvent().  When the queue is full, the oldest
+     * change is dropped.
+     *
+     * @param nodeId The node ID, or -1 for all nodes
+     * @param index The value index (see dumpNodes()), or -1 for all
+     * values of the node(s)
+     * @param queueSize The number of changes to hold
+     * @return The subscription ID
+     */
+    int subscribe(int nodeId=-1, int index=-1,
+                  unsigned int queueSize=OZW_EVENT_QUEUE_SIZE);
+
+    /**
+     * Cancel a subscription.  Any thread waiting in waitEvent() for it
+     * returns false.
+     *
+     * @param id The subscription ID returned by subscribe()
+     */
+    void unsubscribe(int id);
+
+    /**
+     * Remove the oldest queued change from a subscription, waiting for
+     * one if none is queued.
+     *
+     * @param id The subscription ID returned by subscribe()
+     * @param event A pointer to the returned change
+     * @param millis The number of milliseconds to wait, 0 to return
+     * immediately
+     * @return true if a change was returned, false on timeout or if
+     * the subscription does not exist
+     */
+    bool waitEvent(int id, VALUE_EVENT_T *event, unsigned int millis=0);
+
+    /**
+     * Return the number of changes dropped by a subscription because
+     * its queue was full.
+     *
+     * @param id The subscription ID returned by subscribe()
+     * @return The number of changes dropped
+     */
+    unsigned int getDroppedEvents(int id);
+
   protected:
     /**
      * Based on a nodeId and a value index, lookup the corresponding
@@ -543,6 +611,26 @@ namespace upm {
      */
     void unlockNodes() { pthread_mutex_unlock(&m_nodeLock); };
 
+    /**
+     * Take the value cache lock for reading.  Any number of readers
+     * may hold it at once.  It also protects the m_zwNodeMap map
+     * against changes, so only the value cache may be used while
+     * holding it.
+     */
+    void lockCacheRead() { pthread_rwlock_rdlock(&m_cacheLock); };
+
+    /**
+     * Take the value cache lock for writing.  This is done by the
+     * notification handler, with m_nodeLock held, when it changes the
+     * m_zwNodeMap map or a cached value.
+     */
+    void lockCacheWrite() { pthread_rwlock_wrlock(&m_cacheLock); };
+
+    /**
+     * Release the value cache lock.
+     */
+    void unlockCache() { pthread_rwlock_unlock(&m_cacheLock); };
+
   private:
     uint32_t m_homeId;
     bool m_mgrCreated;
@@ -558,12 +646,33 @@ namespace upm {
                                     const* notification, 
                                     void *ctx);
 
+    // queue a change for the matching subscriptions
+    void postEvent(int nodeId, int index, const std::string &value);
+
     // a map of added nodes
     zwNodeMap_t m_zwNodeMap;
 
     // for coordinating access to the node list
     pthread_mutex_t m_nodeLock;
 
+    // for readers of the value cache
+    pthread_rwlock_t m_cacheLock;
+
+    typedef struct {
+      int nodeId;
+      int index;
+      unsigned int queueSize;
+      unsigned int dropped;
+      std::deque<VALUE_EVENT_T> events;
+    } SUBSCRIPTION_T;
+
+    // subscriptions by ID, protected by m_subLock.  m_subCond is
+    // signaled when an event is queued or a subscription removed.
+    std::map<int, SUBSCRIPTION_T> m_subscriptions;
+    int m_nextSubscription;
+    pthread_mutex_t m_subLock;
+    pthread_cond_t m_subCond;
+
     // We use these to determine init failure or success (if OpenZWave
     // has successfully queried essential data about the network).
     pthread_mutex_t m_initLock;
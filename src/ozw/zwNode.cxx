@@ -54,10 +54,14 @@ uint32_t zwNode::homeId()
   return m_homeId;
 }
 
-void zwNode::addValueID(ValueID vid) 
+int zwNode::addValueID(ValueID vid) 
 {
+  int index = m_vindex++;
+
   // We need to use insert since ValueID's default ctor is private
-  m_values.insert(std::pair<int, ValueID>(m_vindex++, vid));
+  m_values.insert(std::pair<int, ValueID>(index, vid));
+
+  return index;
 }
 
 void zwNode::removeValueID(ValueID vid) 
@@ -69,12 +73,82 @@ void zwNode::removeValueID(ValueID vid)
     {
       if ((*it).second == vid)
         {
+          m_cache.erase((*it).first);
           m_values.erase((*it).first);
           break;
         }
     }
 }
 
+int zwNode::valueIDToIndex(ValueID vid)
+{
+  for (valueMap_t::iterator it = m_values.begin();
+       it != m_values.end(); ++it)
+    {
+      if ((*it).second == vid)
+        return (*it).first;
+    }
+
+  return -1;
+}
+
+void zwNode::readValue(ValueID vid, value_t *value)
+{
+  value->type = vid.GetType();
+  value->writeOnly = Manager::Get()->IsValueWriteOnly(vid);
+  value->asBool = false;
+  value->asByte = 0;
+  value->asFloat = 0.0;
+  value->asInt32 = 0;
+  value->asInt16 = 0;
+
+  // any value can be represented as a string
+  value->valid = Manager::Get()->GetValueAsString(vid, &value->asString);
+
+  switch (value->type)
+    {
+    case ValueID::ValueType_Bool:
+      value->valid &= Manager::Get()->GetValueAsBool(vid, &value->asBool);
+      break;
+
+    case ValueID::ValueType_Byte:
+      value->valid &= Manager::Get()->GetValueAsByte(vid, &value->asByte);
+      break;
+
+    case ValueID::ValueType_Decimal:
+      value->valid &= Manager::Get()->GetValueAsFloat(vid, &value->asFloat);
+      break;
+
+    case ValueID::ValueType_Int:
+      value->valid &= Manager::Get()->GetValueAsInt(vid, &value->asInt32);
+      break;
+
+    case ValueID::ValueType_Short:
+      value->valid &= Manager::Get()->GetValueAsShort(vid, &value->asInt16);
+      break;
+
+    default:
+      break;
+    }
+}
+
+void zwNode::setCachedValue(int index, const value_t &value)
+{
+  m_cache[index] = value;
+}
+
+const zwNode::value_t *zwNode::cachedValue(int index)
+{
+  valueCache_t::iterator it;
+
+  it = m_cache.find(index);
+
+  if (it == m_cache.end())
+    return NULL;
+
+  return &(*it).second;
+}
+
 bool zwNode::indexToValueID(int index, ValueID *vid)
 {
   valueMap_t::iterator it;
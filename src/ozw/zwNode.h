@@ -24,6 +24,7 @@
 #pragma once
 
 #include <map>
+#include <string>
 
 #include "Manager.h"
 
@@ -33,6 +34,22 @@ namespace upm {
   public:
     typedef std::map<int, OpenZWave::ValueID> valueMap_t;
 
+    // the last known content of a value, as reported by OpenZWave.
+    // Only the member matching the type is meaningful.
+    typedef struct {
+      OpenZWave::ValueID::ValueType type;
+      bool valid;                       // OpenZWave returned the content
+      bool writeOnly;
+      std::string asString;
+      bool asBool;
+      uint8_t asByte;
+      float asFloat;
+      int32_t asInt32;
+      int16_t asInt16;
+    } value_t;
+
+    typedef std::map<int, value_t> valueCache_t;
+
     /**
      * zwNode contructor.
      *
@@ -62,16 +79,51 @@ namespace upm {
      * incrementing m_vindex.
      *
      * @param vid The OpenZWave ValueID
+     * @return The index assigned to the ValueID
      */
-    void addValueID(OpenZWave::ValueID vid);
+    int addValueID(OpenZWave::ValueID vid);
 
     /**
-     * Remove an OpenZWave ValueID from the value map.
+     * Remove an OpenZWave ValueID, and its cached content, from the
+     * value map.
      *
      * @param vid The OpenZWave ValueID
      */
     void removeValueID(OpenZWave::ValueID vid);
 
+    /**
+     * Lookup and return the index corresponding to a ValueID.
+     *
+     * @param vid The OpenZWave ValueID
+     * @return The index, or -1 if the ValueID is not in the map
+     */
+    int valueIDToIndex(OpenZWave::ValueID vid);
+
+    /**
+     * Query OpenZWave for the current content of a value.
+     *
+     * @param vid The OpenZWave ValueID
+     * @param value The pointer to the returned content
+     */
+    static void readValue(OpenZWave::ValueID vid, value_t *value);
+
+    /**
+     * Store the content of a value in the cache.
+     *
+     * @param index The index of the value
+     * @param value The content, from readValue()
+     */
+    void setCachedValue(int index, const value_t &value);
+
+    /**
+     * Lookup the cached content of a value.
+     *
+     * @param index The index of the value
+     * @return A pointer to the content, or NULL if it is not cached.
+     * It remains valid until the value is removed or updated.
+     */
+    const value_t *cachedValue(int index);
+
     /**
      * Lookup and return a ValueID corresponding to an index.
      *
@@ -97,6 +149,7 @@ namespace upm {
     uint8_t m_nodeId;
 
     valueMap_t m_values;
+    valueCache_t m_cache;
 
     // we increment this index for every ValueID we add
     unsigned int m_vindex;
@@ -24,6 +24,7 @@
 
 #include <unistd.h>
 #include <math.h>
+#include <string.h>
 #include <iostream>
 #include <string>
 #include <stdexcept>
@@ -37,6 +38,17 @@ using namespace std;
 PCA9685::PCA9685(int bus, uint8_t address, bool raw)
 {
   m_addr = address;
+  m_dirty = 0;
+  m_txnDepth = 0;
+  memset(m_ledRegs, 0, sizeof(m_ledRegs));
+  memset(m_allRegs, 0, sizeof(m_allRegs));
+
+  // recursive, so the LED methods can be used inside a transaction
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&m_lock, &attr);
+  pthread_mutexattr_destroy(&attr);
 
   // setup our i2c link
   if ( raw )
@@ -67,6 +79,8 @@ PCA9685::PCA9685(int bus, uint8_t address, bool raw)
   // enable auto-increment mode by default
   enableAutoIncrement(true);
 
+  refreshShadow();
+
   // enable restart by default.
   enableRestart(true);
 }
@@ -75,6 +89,7 @@ PCA9685::~PCA9685()
 {
   setModeSleep(true);
   mraa_i2c_stop(m_i2c);
+  pthread_mutex_destroy(&m_lock);
 }
 
 bool PCA9685::writeByte(uint8_t reg, uint8_t byte)
@@ -88,6 +103,8 @@ bool PCA9685::writeByte(uint8_t reg, uint8_t byte)
       return false;
     }
 
+  updateShadow(reg, byte);
+
   return true;
 }
 
@@ -102,9 +119,208 @@ bool PCA9685::writeWord(uint8_t reg, uint16_t word)
       return false;
     }
 
+  updateShadow(reg, word & 0xff);
+  updateShadow(reg + 1, (word >> 8) & 0xff);
+
   return true;
 }
 
+void PCA9685::updateShadow(uint8_t reg, uint8_t value)
+{
+  pthread_mutex_lock(&m_lock);
+
+  if (reg >= REG_LED0_ON_L && reg <= REG_LED15_OFF_H)
+    {
+      int off = reg - REG_LED0_ON_L;
+      m_ledRegs[off / 4][off % 4] = value;
+    }
+  else if (reg >= REG_ALL_LED_ON_L && reg <= REG_ALL_LED_OFF_H)
+    {
+      int off = reg - REG_ALL_LED_ON_L;
+      m_allRegs[off] = value;
+      for (int i = 0; i < 16; i++)
+        m_ledRegs[i][off] = value;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+void PCA9685::refreshShadow()
+{
+  uint8_t buf[16 * 4];
+
+  pthread_mutex_lock(&m_lock);
+
+  // auto-increment is enabled by the constructor
+  if (mraa_i2c_read_bytes_data(m_i2c, REG_LED0_ON_L, buf, sizeof(buf))
+      != (int)sizeof(buf))
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": mraa_i2c_read_bytes_data() failed");
+      return;
+    }
+
+  memcpy(m_ledRegs, buf, sizeof(buf));
+  pthread_mutex_unlock(&m_lock);
+}
+
+void PCA9685::begin()
+{
+  pthread_mutex_lock(&m_lock);
+  m_txnDepth++;
+}
+
+bool PCA9685::commit()
+{
+  if (m_txnDepth <= 0)
+    {
+      throw std::logic_error(std::string(__FUNCTION__) +
+                             ": commit() without begin()");
+      return false;
+    }
+
+  bool rv = true;
+
+  if (--m_txnDepth == 0)
+    {
+      try
+        {
+          rv = flush();
+        }
+      catch (...)
+        {
+          pthread_mutex_unlock(&m_lock);
+          throw;
+        }
+    }
+
+  pthread_mutex_unlock(&m_lock);
+  return rv;
+}
+
+bool PCA9685::writeLeds(int first, int count)
+{
+  uint8_t buf[1 + 16 * 4];
+
+  buf[0] = REG_LED0_ON_L + (first * 4);
+  memcpy(&buf[1], m_ledRegs[first], count * 4);
+
+  if (mraa_i2c_write(m_i2c, buf, 1 + (count * 4)) != MRAA_SUCCESS)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": mraa_i2c_write() failed");
+      return false;
+    }
+
+  return true;
+}
+
+// called with m_lock held
+bool PCA9685::flush()
+{
+  uint16_t dirty = m_dirty;
+  m_dirty = 0;
+
+  if (!dirty)
+    return true;
+
+  if (dirty == 0xffff)
+    {
+      bool same = true;
+      for (int i = 1; i < 16 && same; i++)
+        same = (memcmp(m_ledRegs[i], m_ledRegs[0], 4) == 0);
+
+      if (same)
+        {
+          uint8_t buf[5];
+
+          buf[0] = REG_ALL_LED_ON_L;
+          memcpy(&buf[1], m_ledRegs[0], 4);
+
+          if (mraa_i2c_write(m_i2c, buf, 5) != MRAA_SUCCESS)
+            {
+              throw std::runtime_error(std::string(__FUNCTION__) +
+                                       ": mraa_i2c_write() failed");
+              return false;
+            }
+
+          memcpy(m_allRegs, m_ledRegs[0], 4);
+          return true;
+        }
+    }
+
+  // one burst per run of changed channels.  A single unchanged
+  // channel between two runs is cheaper to rewrite than to skip with
+  // a new transaction.
+  int ch = 0;
+  while (ch < 16)
+    {
+      if (!(dirty & (1 << ch)))
+        {
+          ch++;
+          continue;
+        }
+
+      int last = ch;
+      for (int i = ch + 1; i < 16; i++)
+        {
+          if (dirty & (1 << i))
+            last = i;
+          else if (i + 1 >= 16 || !(dirty & (1 << (i + 1))))
+            break;
+        }
+
+      writeLeds(ch, last - ch + 1);
+      ch = last + 1;
+    }
+
+  return true;
+}
+
+bool PCA9685::setLedByte(uint8_t led, int offset, uint8_t value)
+{
+  if (led == PCA9685_ALL_LED)
+    {
+      if (m_txnDepth)
+        {
+          m_allRegs[offset] = value;
+          for (int i = 0; i < 16; i++)
+            m_ledRegs[i][offset] = value;
+          m_dirty = 0xffff;
+          return true;
+        }
+
+      return writeByte(REG_ALL_LED_ON_L + offset, value);
+    }
+
+  if (m_txnDepth)
+    {
+      if (m_ledRegs[led][offset] != value)
+        {
+          m_ledRegs[led][offset] = value;
+          m_dirty |= (1 << led);
+        }
+      return true;
+    }
+
+  return writeByte(REG_LED0_ON_L + (led * 4) + offset, value);
+}
+
+bool PCA9685::setLedWord(uint8_t led, int offset, uint16_t value)
+{
+  if (m_txnDepth)
+    {
+      return (setLedByte(led, offset, value & 0xff) &&
+              setLedByte(led, offset + 1, (value >> 8) & 0xff));
+    }
+
+  if (led == PCA9685_ALL_LED)
+    return writeWord(REG_ALL_LED_ON_L + offset, value);
+
+  return writeWord(REG_LED0_ON_L + (led * 4) + offset, value);
+}
+
 uint8_t PCA9685::readByte(uint8_t reg)
 {
   return mraa_i2c_read_byte_data(m_i2c, reg);
@@ -168,22 +384,29 @@ bool PCA9685::ledFullOn(uint8_t led, bool val)
       return false;
     }
 
-  // figure out the register offset (*_ON_H)
-  uint8_t regoff;
-
-  if (led == PCA9685_ALL_LED)
-    regoff = REG_ALL_LED_ON_H;
-  else
-    regoff = REG_LED0_ON_L + (led * 4) + 1;
+  pthread_mutex_lock(&m_lock);
 
-  uint8_t bits = readByte(regoff);
+  // *_ON_H, from the shadow copy
+  uint8_t bits = ((led == PCA9685_ALL_LED) ? m_allRegs[1] : m_ledRegs[led][1]);
 
   if (val)
     bits |= 0x10;
   else
     bits &= ~0x10;
 
-  return writeByte(regoff, bits);
+  bool rv;
+  try
+    {
+      rv = setLedByte(led, 1, bits);
+    }
+  catch (...)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+  return rv;
 }
 
 bool PCA9685::ledFullOff(uint8_t led, bool val)
@@ -196,22 +419,29 @@ bool PCA9685::ledFullOff(uint8_t led, bool val)
       return false;
     }
 
-  // figure out the register offset (*_OFF_H)
-  uint8_t regoff;
+  pthread_mutex_lock(&m_lock);
 
-  if (led == PCA9685_ALL_LED)
-    regoff = REG_ALL_LED_OFF_H;
-  else
-    regoff = REG_LED0_ON_L + (led * 4) + 3;
-
-  uint8_t bits = readByte(regoff);
+  // *_OFF_H, from the shadow copy
+  uint8_t bits = ((led == PCA9685_ALL_LED) ? m_allRegs[3] : m_ledRegs[led][3]);
 
   if (val)
     bits |= 0x10;
   else
     bits &= ~0x10;
 
-  return writeByte(regoff, bits);
+  bool rv;
+  try
+    {
+      rv = setLedByte(led, 3, bits);
+    }
+  catch (...)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+  return rv;
 }
 
 bool PCA9685::ledOnTime(uint8_t led, uint16_t time)
@@ -231,20 +461,27 @@ bool PCA9685::ledOnTime(uint8_t led, uint16_t time)
       return false;
     }
 
-  // figure out the register offset (*_ON_L)
-  uint8_t regoff;
-
-  if (led == PCA9685_ALL_LED)
-    regoff = REG_ALL_LED_ON_L;
-  else
-    regoff = REG_LED0_ON_L + (led * 4);
+  pthread_mutex_lock(&m_lock);
 
   // we need to preserve the full ON bit in *_ON_H
-  uint8_t onbit = (readByte(regoff + 1) & 0x10);
+  uint8_t onbit = (((led == PCA9685_ALL_LED) ? m_allRegs[1] :
+                    m_ledRegs[led][1]) & 0x10);
 
   time = (time & 0x0fff) | (onbit << 8);
 
-  return writeWord(regoff, time);
+  bool rv;
+  try
+    {
+      rv = setLedWord(led, 0, time);
+    }
+  catch (...)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+  return rv;
 }
 
 bool PCA9685::ledOffTime(uint8_t led, uint16_t time)
@@ -264,20 +501,27 @@ bool PCA9685::ledOffTime(uint8_t led, uint16_t time)
       return false;
     }
 
-  // figure out the register offset (*_OFF_L)
-  uint8_t regoff;
-
-  if (led == PCA9685_ALL_LED)
-    regoff = REG_ALL_LED_OFF_L;
-  else
-    regoff = REG_LED0_ON_L + (led * 4) + 2;
+  pthread_mutex_lock(&m_lock);
 
   // we need to preserve the full OFF bit in *_OFF_H
-  uint8_t offbit = (readByte(regoff + 1) & 0x10);
+  uint8_t offbit = (((led == PCA9685_ALL_LED) ? m_allRegs[3] :
+                     m_ledRegs[led][3]) & 0x10);
 
   time = (time & 0x0fff) | (offbit << 8);
 
-  return writeWord(regoff, time);
+  bool rv;
+  try
+    {
+      rv = setLedWord(led, 2, time);
+    }
+  catch (...)
+    {
+      pthread_mutex_unlock(&m_lock);
+      throw;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+  return rv;
 }
 
 bool PCA9685::setPrescale(uint8_t prescale)
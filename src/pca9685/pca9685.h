@@ -24,6 +24,7 @@
 #pragma once
 
 #include <string>
+#include <pthread.h>
 #include <mraa/i2c.h>
 #include <mraa/gpio.h>
 
@@ -60,6 +61,13 @@ namespace upm {
    *
    * This module was tested with the Adafruit Motor Shield v2.3
    *
+   * The LED registers are mirrored in a shadow copy, so changing a
+   * single bit or time value no longer needs to read the register
+   * back first.  Changes made between begin() and commit() are only
+   * stored in the shadow copy, and are then written with as few
+   * auto-increment bursts as possible (a single ALL_LED write if every
+   * channel ends up identical).
+   *
    * @image html pca9685.jpg
    * @snippet pca9685.cxx Interesting
    */
@@ -301,6 +309,29 @@ namespace upm {
      */
     void enableRestart(bool enabled) { m_restartEnabled = enabled; };
 
+    /**
+     * Starts a transaction.  Until the matching commit(), LED changes
+     * are only recorded.  Transactions can be nested; only the
+     * outermost commit() writes to the device.  Other threads using
+     * this object are blocked until commit().
+     */
+    void begin();
+
+    /**
+     * Ends a transaction, writing all LED channels changed since
+     * begin() to the device
+     *
+     * @return True if successful
+     */
+    bool commit();
+
+    /**
+     * Reloads the LED register shadow copy from the device.  Only
+     * needed if the LED registers were changed by something other
+     * than this object.
+     */
+    void refreshShadow();
+
   private:
     /**
      * Enables the I2C register auto-increment. This needs to be enabled
@@ -311,9 +342,26 @@ namespace upm {
      */
     bool enableAutoIncrement(bool ai);
 
+    // update the shadow copy, and the device unless in a transaction.
+    // offset is the register offset within the channel (0-3).
+    bool setLedByte(uint8_t led, int offset, uint8_t value);
+    bool setLedWord(uint8_t led, int offset, uint16_t value);
+    void updateShadow(uint8_t reg, uint8_t value);
+    bool flush();
+    bool writeLeds(int first, int count);
+
     bool m_restartEnabled;
     mraa_i2c_context m_i2c;
     uint8_t m_addr;
+
+    // LEDn_ON_L, LEDn_ON_H, LEDn_OFF_L, LEDn_OFF_H for each channel,
+    // and the last values written to the (write-only) ALL_LED registers
+    uint8_t m_ledRegs[16][4];
+    uint8_t m_allRegs[4];
+    // channels changed in the current transaction
+    uint16_t m_dirty;
+    int m_txnDepth;
+    pthread_mutex_t m_lock;
   };
 }
 
@@ -28,6 +28,8 @@
 
 #include <unistd.h>
 #include <math.h>
+#include <errno.h>
+#include <time.h>
 #include <iostream>
 #include <string>
 #include <stdexcept>
@@ -38,8 +40,12 @@ using namespace upm;
 using namespace std;
 
 
+// size of the response reads that predate the bulk commands
 #define PN532_PACKBUFFSIZ 64
-static uint8_t pn532_packetbuffer[PN532_PACKBUFFSIZ];
+// largest normal information frame: preamble, start code, LEN, LCS,
+// 255 byte payload, DCS and postamble
+#define PN532_MAXFRAMESIZ 262
+static uint8_t pn532_packetbuffer[PN532_MAXFRAMESIZ];
 
 static uint8_t pn532ack[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
 static uint32_t pn532_firmwarerev = 0x00320106;
@@ -53,7 +59,10 @@ PN532::PN532(int irq, int reset, int bus, uint8_t address):
   m_SAK = 0;
   m_ATQA = 0;
   m_isrInstalled = false;
-  m_irqRcvd = false;
+  m_irqPending = 0;
+  m_targetCount = 0;
+  m_authSector = -1;
+  m_authKeyNumber = 0;
 
   memset(m_uid, 0, 7);
   memset(m_key, 0, 6);
@@ -70,6 +79,20 @@ PN532::PN532(int irq, int reset, int bus, uint8_t address):
       return;
     }
 
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+  if (pthread_mutex_init(&m_irqLock, NULL) ||
+      pthread_cond_init(&m_irqCond, &attr))
+    {
+      pthread_condattr_destroy(&attr);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_mutex/cond_init() failed");
+      return;
+    }
+  pthread_condattr_destroy(&attr);
+
   m_gpioIRQ.dir(mraa::DIR_IN);
   m_gpioReset.dir(mraa::DIR_OUT);
 }
@@ -78,6 +101,9 @@ PN532::~PN532()
 {
   if (m_isrInstalled)
     m_gpioIRQ.isrExit();
+
+  pthread_cond_destroy(&m_irqCond);
+  pthread_mutex_destroy(&m_irqLock);
 }
 
 bool PN532::init()
@@ -160,7 +186,8 @@ uint32_t PN532::getFirmwareVersion()
     return 0;
   
   // read data packet
-  readData(pn532_packetbuffer, 12);
+  if (!readResponse(pn532_packetbuffer, 12))
+    return 0;
   
   int offset = 7;  // Skip the ready byte when using I2C
 
@@ -196,10 +223,8 @@ uint32_t PN532::getFirmwareVersion()
 bool PN532::sendCommandCheckAck(uint8_t *cmd, uint8_t cmdlen, 
                                 uint16_t timeout)
 {
-  uint16_t timer = 0;
-
   // clear any outstanding irq's
-  isReady();
+  clearReady();
   
   // write the command
   writeCommand(cmd, cmdlen);
@@ -240,7 +265,8 @@ bool PN532::SAMConfig(void)
     return false;
 
   // read data packet
-  readData(pn532_packetbuffer, 8);
+  if (!readResponse(pn532_packetbuffer, 8))
+    return false;
   
   int offset = 6;
   return  (pn532_packetbuffer[offset] == 0x15);
@@ -270,8 +296,10 @@ bool PN532::setPassiveActivationRetries(uint8_t maxRetries)
   
   if (! sendCommandCheckAck(pn532_packetbuffer, 5))
     return false;  // no ACK
-  
-  return true;
+
+  // consume the (empty) response so it can't be mistaken for the
+  // next command's
+  return (readFrame(RSP_RFCONFIGURATION, 9) >= 0);
 }
 
 /***** ISO14443A Commands ******/
@@ -292,6 +320,10 @@ bool PN532::setPassiveActivationRetries(uint8_t maxRetries)
 bool PN532::readPassiveTargetID(BAUD_T cardbaudrate, uint8_t * uid, 
                                 uint8_t * uidLength, uint16_t timeout)
 {
+  // a new card may be in the field, any previous authentication is gone
+  m_authSector = -1;
+  m_targetCount = 0;
+
   pn532_packetbuffer[0] = CMD_INLISTPASSIVETARGET;
   pn532_packetbuffer[1] = 1;  // max 1 cards at once (we can set this
                               // to 2 later)
@@ -345,6 +377,9 @@ bool PN532::readPassiveTargetID(BAUD_T cardbaudrate, uint8_t * uid,
   // only one card can be handled currently
   if (pn532_packetbuffer[7] != 1) 
     return false;
+
+  // the inlisted tag is the target of the commands that follow
+  m_inListedTag = pn532_packetbuffer[8];
     
   uint16_t sens_res = pn532_packetbuffer[9];
   sens_res <<= 8;
@@ -378,6 +413,9 @@ bool PN532::readPassiveTargetID(BAUD_T cardbaudrate, uint8_t * uid,
   if (m_mifareDebug)
     fprintf(stderr, "\n");
 
+  m_uidLen = (*uidLength > 7) ? 7 : *uidLength;
+  memcpy(m_uid, uid, m_uidLen);
+
   return true;
 }
 
@@ -423,7 +461,7 @@ bool PN532::inDataExchange(uint8_t * send, uint8_t sendLength,
     return false;
   }
 
-  readData(pn532_packetbuffer, sizeof(pn532_packetbuffer));
+  readData(pn532_packetbuffer, PN532_PACKBUFFSIZ);
   
   if (pn532_packetbuffer[0] == 0 && pn532_packetbuffer[1] == 0 &&
       pn532_packetbuffer[2] == 0xff)
@@ -484,6 +522,8 @@ bool PN532::inDataExchange(uint8_t * send, uint8_t sendLength,
 bool PN532::inListPassiveTarget() 
 {
   m_inListedTag = 0;
+  m_authSector = -1;
+  m_targetCount = 0;
 
   pn532_packetbuffer[0] = CMD_INLISTPASSIVETARGET;
   pn532_packetbuffer[1] = 1;
@@ -503,7 +543,7 @@ bool PN532::inListPassiveTarget()
     return false;
   }
 
-  readData(pn532_packetbuffer, sizeof(pn532_packetbuffer));
+  readData(pn532_packetbuffer, PN532_PACKBUFFSIZ);
   
   if (pn532_packetbuffer[0] == 0 && pn532_packetbuffer[1] == 0 && 
       pn532_packetbuffer[2] == 0xff) {
@@ -548,6 +588,167 @@ bool PN532::inListPassiveTarget()
 }
 
 
+/**************************************************************************/
+/*! 
+  @brief  'InLists' up to PN532_MAX_TARGETS ISO14443A targets.  The
+  first one found is selected.
+
+  @param  maxTargets  1 or 2
+  @param  timeout     timeout in ms waiting for a target, 0 forever
+
+  @returns  the number of targets found
+*/
+/**************************************************************************/
+int PN532::inListPassiveTargets(uint8_t maxTargets, uint16_t timeout)
+{
+  m_inListedTag = 0;
+  m_authSector = -1;
+  m_targetCount = 0;
+
+  if (maxTargets < 1 || maxTargets > PN532_MAX_TARGETS)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": maxTargets must be 1 or 2");
+      return 0;
+    }
+
+  pn532_packetbuffer[0] = CMD_INLISTPASSIVETARGET;
+  pn532_packetbuffer[1] = maxTargets;
+  pn532_packetbuffer[2] = BAUD_MIFARE_ISO14443A;
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, 3, timeout))
+    return 0;
+
+  // room for two targets with 10 byte UIDs and an ATS each
+  int len = readFrame(RSP_INLISTPASSIVETARGET,
+                      PN532_PACKBUFFSIZ * maxTargets, timeout);
+  if (len < 1)
+    return 0;
+
+  /* Each target is reported as:
+   
+     byte            Description
+     -------------   ------------------------------------------
+     b0              Tag Number
+     b1..2           SENS_RES
+     b3              SEL_RES
+     b4              NFCID Length
+     b5..NFCIDLen    NFCID
+     ...             ATS (only if SEL_RES bit 5 is set), the
+                     first byte is its length                   */
+
+  uint8_t *ptr = pn532_packetbuffer + 8;
+  uint8_t *end = pn532_packetbuffer + 7 + len;
+  int found = pn532_packetbuffer[7];
+
+  for (int i=0; i<found && i<PN532_MAX_TARGETS; i++)
+    {
+      TARGET_T *target = &m_targets[i];
+
+      if (end - ptr < 5)
+        break;
+
+      target->tg = ptr[0];
+      target->atqa = (ptr[1] << 8) | ptr[2];
+      target->sak = ptr[3];
+      target->uidLen = ptr[4];
+      ptr += 5;
+
+      if (target->uidLen > sizeof(target->uid) || end - ptr < target->uidLen)
+        break;
+
+      memcpy(target->uid, ptr, target->uidLen);
+      ptr += target->uidLen;
+
+      if (target->sak & 0x20)
+        {
+          if (ptr >= end || ptr[0] == 0)
+            break;
+          ptr += ptr[0];
+        }
+
+      m_targetCount++;
+
+      if (m_mifareDebug)
+        {
+          fprintf(stderr, "Target %d: Tg %d ATQA 0x%04x SAK 0x%02x UID: ",
+                  i, target->tg, target->atqa, target->sak);
+          PrintHex(target->uid, target->uidLen);
+        }
+    }
+
+  if (m_targetCount)
+    selectTarget(0);
+
+  return m_targetCount;
+}
+
+bool PN532::getTarget(int index, TARGET_T *target)
+{
+  if (index < 0 || index >= m_targetCount)
+    return false;
+
+  *target = m_targets[index];
+  return true;
+}
+
+bool PN532::selectTarget(int index)
+{
+  if (index < 0 || index >= m_targetCount)
+    return false;
+
+  const TARGET_T *target = &m_targets[index];
+
+  m_inListedTag = target->tg;
+  m_ATQA = target->atqa;
+  m_SAK = target->sak;
+  m_uidLen = (target->uidLen > 7) ? 7 : target->uidLen;
+  memcpy(m_uid, target->uid, m_uidLen);
+
+  // authentication belongs to the card it was done with
+  m_authSector = -1;
+
+  // InCommunicateThru has no target number, it goes to the target
+  // the PN532 activated last
+  if (m_targetCount > 1)
+    return inSelect(target->tg);
+
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Selects (and wakes up if needed) an inlisted target in the
+  PN532 by its Tg number
+
+  @param  tg  Tg number of the target
+
+  @returns  true if the target was selected
+*/
+/**************************************************************************/
+bool PN532::inSelect(uint8_t tg)
+{
+  pn532_packetbuffer[0] = CMD_INSELECT;
+  pn532_packetbuffer[1] = tg;
+
+  if (!sendCommandCheckAck(pn532_packetbuffer, 2))
+    return false;
+
+  // status byte only
+  if (readFrame(RSP_INSELECT, 7 + 1 + 2) != 1 ||
+      (pn532_packetbuffer[7] & 0x3f) != 0x00)
+    {
+      if (m_pn532Debug)
+        fprintf(stderr, "%s: InSelect of Tg %d failed: 0x%02x\n",
+                __FUNCTION__, tg, pn532_packetbuffer[7]);
+
+      return false;
+    }
+
+  return true;
+}
+
+
 /***** Mifare Classic Functions ******/
 /*  MIFARE CLASSIC DESCRIPTION
     ==========================
@@ -743,9 +944,11 @@ bool PN532::mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen,
                                              uint8_t keyNumber,
                                              uint8_t * keyData)
 {
-  uint8_t len;
   uint8_t i;
   
+  // whatever the card was authenticated for is lost on a new attempt
+  m_authSector = -1;
+
   // Hang on to the key and uid data
   memcpy (m_key, keyData, 6);
   memcpy (m_uid, uid, uidLen);
@@ -762,7 +965,7 @@ bool PN532::mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen,
   
   // Prepare the authentication command //
   pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;   /* Data Exchange Header */
-  pn532_packetbuffer[1] = 1;                              /* Max card numbers */
+  pn532_packetbuffer[1] = targetNumber();                 /* Card number */
   pn532_packetbuffer[2] = (keyNumber) ? MIFARE_CMD_AUTH_B : MIFARE_CMD_AUTH_A;
   pn532_packetbuffer[3] = blockNumber;                    /* Block
                                                              Number
@@ -779,15 +982,13 @@ bool PN532::mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen,
   if (! sendCommandCheckAck(pn532_packetbuffer, 10+m_uidLen))
     return false;
   
-  if (!waitForReady(1000)) {
+  // Read the response packet
+  if (!readResponse(pn532_packetbuffer, 12)) {
     if (m_pn532Debug)
       cerr << __FUNCTION__ << ": timeout waiting auth..." << endl;
 
     return false;
   }
-
-  // Read the response packet
-  readData(pn532_packetbuffer, 12);
   
   // check if the response is valid and we are authenticated???
   // for an auth success it should be bytes 5-7: 0xD5 0x41 0x00
@@ -803,6 +1004,9 @@ bool PN532::mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen,
 
       return false;
     }
+
+  m_authSector = mifareclassic_SectorOf(blockNumber);
+  m_authKeyNumber = keyNumber;
   
   return true;
 }
@@ -828,7 +1032,7 @@ bool PN532::mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data)
   
   /* Prepare the command */
   pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;                      /* Card number */
+  pn532_packetbuffer[1] = targetNumber();         /* Card number */
   pn532_packetbuffer[2] = MIFARE_CMD_READ;        /* Mifare Read
                                                      command = 0x30 */
   pn532_packetbuffer[3] = blockNumber;            /* Block Number
@@ -846,7 +1050,11 @@ bool PN532::mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data)
     }
   
   /* Read the response packet */
-  readData(pn532_packetbuffer, 26);
+  if (!readResponse(pn532_packetbuffer, 26))
+    {
+      m_authSector = -1;
+      return false;
+    }
   
   /* If byte 8 isn't 0x00 we probably have an error */
   if (pn532_packetbuffer[7] != 0x00)
@@ -856,6 +1064,9 @@ bool PN532::mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data)
           fprintf(stderr, "Unexpected response: ");
           PrintHexChar(pn532_packetbuffer, 26);
         }
+
+      // the card drops its authentication on any error
+      m_authSector = -1;
       return false;
     }
   
@@ -892,7 +1103,7 @@ bool PN532::mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t * data)
   
   /* Prepare the first command */
   pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;                      /* Card number */
+  pn532_packetbuffer[1] = targetNumber();         /* Card number */
   pn532_packetbuffer[2] = MIFARE_CMD_WRITE;       /* Mifare Write
                                                      command = 0xA0 */
   pn532_packetbuffer[3] = blockNumber;            /* Block Number
@@ -909,14 +1120,144 @@ bool PN532::mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t * data)
 
       return false;
     }  
-  usleep(10000);
   
   /* Read the response packet */
-  readData(pn532_packetbuffer, 26);
+  if (!readResponse(pn532_packetbuffer, 26) || pn532_packetbuffer[7] != 0x00)
+    {
+      m_authSector = -1;
+      return false;
+    }
+
+  // a new trailer may change the keys or access bits
+  if (mifareclassic_IsTrailerBlock(blockNumber))
+    m_authSector = -1;
   
   return true;
 }
 
+/**************************************************************************/
+/*! 
+  Returns the sector holding a block
+*/
+/**************************************************************************/
+uint8_t PN532::mifareclassic_SectorOf (uint8_t block)
+{
+  if (block < 128)
+    return block / 4;
+  else
+    return 32 + (block - 128) / 16;
+}
+
+/**************************************************************************/
+/*! 
+  Returns true if the selected card is still authenticated for a
+  sector with the same key
+*/
+/**************************************************************************/
+bool PN532::authCached(uint8_t * uid, uint8_t uidLen, uint8_t sector,
+                       uint8_t keyNumber, uint8_t * keyData)
+{
+  return (m_authSector == sector && m_authKeyNumber == keyNumber &&
+          m_uidLen == uidLen && !memcmp(m_uid, uid, uidLen) &&
+          !memcmp(m_key, keyData, 6));
+}
+
+/**************************************************************************/
+/*! 
+  Reads consecutive 16-byte blocks, authenticating each sector only
+  once.
+
+  @param  uid           Pointer to a byte array containing the card UID
+  @param  uidLen        The length (in bytes) of the card's UID
+  @param  firstBlock    The first block to read
+  @param  count         The number of blocks to read
+  @param  keyNumber     Which key type to use during authentication
+  (0 = MIFARE_CMD_AUTH_A, 1 = MIFARE_CMD_AUTH_B)
+  @param  keyData       Pointer to a byte array containing the 6 byte
+  key value
+  @param  data          Pointer to the byte array that will hold
+  count * 16 bytes
+
+  @returns the number of blocks read
+*/
+/**************************************************************************/
+int PN532::mifareclassic_ReadBlocks (uint8_t * uid, uint8_t uidLen,
+                                     uint8_t firstBlock, uint8_t count,
+                                     uint8_t keyNumber, uint8_t * keyData,
+                                     uint8_t * data)
+{
+  int blocks = 0;
+
+  if (firstBlock + count > 256)
+    {
+      cerr << __FUNCTION__ << ": Block value out of range" << endl;
+      return 0;
+    }
+
+  for (int i=0; i<count; i++)
+    {
+      uint8_t block = firstBlock + i;
+
+      if (!authCached(uid, uidLen, mifareclassic_SectorOf(block),
+                      keyNumber, keyData) &&
+          !mifareclassic_AuthenticateBlock(uid, uidLen, block, keyNumber,
+                                           keyData))
+        break;
+
+      if (!mifareclassic_ReadDataBlock(block, data + (i * 16)))
+        break;
+
+      blocks++;
+    }
+
+  return blocks;
+}
+
+/**************************************************************************/
+/*! 
+  Reads a whole sector, trailer included.
+
+  @param  uid           Pointer to a byte array containing the card UID
+  @param  uidLen        The length (in bytes) of the card's UID
+  @param  sector        The sector (0..15 for 1KB cards, 0..39 for 4KB
+  cards)
+  @param  keyNumber     Which key type to use during authentication
+  (0 = MIFARE_CMD_AUTH_A, 1 = MIFARE_CMD_AUTH_B)
+  @param  keyData       Pointer to a byte array containing the 6 byte
+  key value
+  @param  data          Pointer to the byte array that will hold the
+  sector, 64 bytes for sectors 0..31 and 256 bytes for 32..39
+
+  @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+bool PN532::mifareclassic_ReadSector (uint8_t * uid, uint8_t uidLen,
+                                      uint8_t sector, uint8_t keyNumber,
+                                      uint8_t * keyData, uint8_t * data)
+{
+  uint8_t firstBlock;
+  uint8_t count;
+
+  if (sector < 32)
+    {
+      firstBlock = sector * 4;
+      count = 4;
+    }
+  else if (sector < 40)
+    {
+      firstBlock = 128 + (sector - 32) * 16;
+      count = 16;
+    }
+  else
+    {
+      cerr << __FUNCTION__ << ": Sector value out of range" << endl;
+      return false;
+    }
+
+  return (mifareclassic_ReadBlocks(uid, uidLen, firstBlock, count, keyNumber,
+                                   keyData, data) == count);
+}
+
 /**************************************************************************/
 /*! 
   Formats a Mifare Classic card to store NDEF Records 
@@ -1165,7 +1506,7 @@ bool PN532::ntag2xx_ReadPage (uint8_t page, uint8_t * buffer)
 
   /* Prepare the command */
   pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;                   /* Card number */
+  pn532_packetbuffer[1] = targetNumber();      /* Card number */
   pn532_packetbuffer[2] = MIFARE_CMD_READ;     /* Mifare Read command = 0x30 */
   pn532_packetbuffer[3] = page;                /* Page Number (0..63
                                                   in most cases) */
@@ -1181,7 +1522,8 @@ bool PN532::ntag2xx_ReadPage (uint8_t page, uint8_t * buffer)
     }
   
   /* Read the response packet */
-  readData(pn532_packetbuffer, 26);
+  if (!readResponse(pn532_packetbuffer, 26))
+    return false;
 
   if (m_mifareDebug)
     {
@@ -1253,7 +1595,7 @@ bool PN532::ntag2xx_WritePage (uint8_t page, uint8_t * data)
   
   /* Prepare the first command */
   pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;    /* Card number */
+  pn532_packetbuffer[1] = targetNumber(); /* Card number */
   pn532_packetbuffer[2] = MIFARE_ULTRALIGHT_CMD_WRITE; /* Mifare
                                                           Ultralight
                                                           Write
@@ -1272,15 +1614,116 @@ bool PN532::ntag2xx_WritePage (uint8_t page, uint8_t * data)
       // Return Failed Signal
       return false;
     }  
-  usleep(10000);
   
   /* Read the response packet */
-  readData(pn532_packetbuffer, 26);
+  if (!readResponse(pn532_packetbuffer, 26) || pn532_packetbuffer[7] != 0x00)
+    return false;
  
   // Return OK Signal
   return true;
 }
 
+/**************************************************************************/
+/*! 
+  Reads consecutive 4-byte pages.  FAST_READ (NTAG21x) is used to get
+  up to PN532_FASTREAD_MAX_PAGES pages per command.  If the tag
+  rejects it, it is re-activated and read with READ, 4 pages at a
+  time.
+
+  @param  startPage   The first page
+  @param  pageCount   The number of pages to read
+  @param  buffer      Pointer to the byte array that will hold
+  pageCount * 4 bytes
+
+  @returns the number of pages read
+*/
+/**************************************************************************/
+int PN532::ntag2xx_ReadPages (uint8_t startPage, uint8_t pageCount,
+                              uint8_t * buffer)
+{
+  int pages = 0;
+  bool fastRead = true;
+
+  if (startPage + pageCount > 231)
+    {
+      cerr << __FUNCTION__ << ": Page value out of range" << endl;
+      return 0;
+    }
+
+  while (pages < pageCount)
+    {
+      uint8_t page = startPage + pages;
+      int remaining = pageCount - pages;
+
+      if (fastRead)
+        {
+          int count = (remaining > PN532_FASTREAD_MAX_PAGES) ?
+            PN532_FASTREAD_MAX_PAGES : remaining;
+
+          if (m_mifareDebug)
+            fprintf(stderr, "Fast reading pages %d..%d\n", page,
+                    page + count - 1);
+
+          // FAST_READ is sent straight through, the PN532 doesn't
+          // know how long its answer is
+          pn532_packetbuffer[0] = CMD_INCOMMUNICATETHRU;
+          pn532_packetbuffer[1] = NTAG2XX_CMD_FAST_READ;
+          pn532_packetbuffer[2] = page;
+          pn532_packetbuffer[3] = page + count - 1;
+
+          if (sendCommandCheckAck(pn532_packetbuffer, 4))
+            {
+              // status byte followed by the pages
+              int len = readFrame(RSP_INCOMMUNICATETHRU, 7 + 1 + count * 4 + 2);
+
+              if (len == 1 + count * 4 && pn532_packetbuffer[7] == 0x00)
+                {
+                  memcpy(buffer + (pages * 4), pn532_packetbuffer + 8,
+                         count * 4);
+                  pages += count;
+                  continue;
+                }
+            }
+
+          if (m_mifareDebug)
+            cerr << __FUNCTION__ << ": FAST_READ failed, using READ" << endl;
+
+          // a tag NAKing a command goes back to idle, wake the same
+          // tag up again and leave the inlisted targets alone
+          fastRead = false;
+          if (!inSelect(targetNumber()))
+            break;
+
+          continue;
+        }
+
+      pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;
+      pn532_packetbuffer[1] = targetNumber();
+      pn532_packetbuffer[2] = MIFARE_CMD_READ;
+      pn532_packetbuffer[3] = page;
+
+      if (!sendCommandCheckAck(pn532_packetbuffer, 4))
+        break;
+
+      // status byte followed by 16 bytes (4 pages)
+      if (readFrame(RSP_INDATAEXCHANGE, 7 + 1 + 16 + 2) != 17 ||
+          pn532_packetbuffer[7] != 0x00)
+        break;
+
+      int count = (remaining > 4) ? 4 : remaining;
+      memcpy(buffer + (pages * 4), pn532_packetbuffer + 8, count * 4);
+      pages += count;
+    }
+
+  if (m_mifareDebug)
+    {
+      fprintf(stderr, "Read %d pages from page %d:\n", pages, startPage);
+      PrintHexChar(buffer, pages * 4);
+    }
+
+  return pages;
+}
+
 /**************************************************************************/
 /*! 
   Writes an NDEF URI Record starting at the specified page (4..nn)
@@ -1413,41 +1856,187 @@ bool PN532::readAck()
 /**************************************************************************/
 bool PN532::isReady()
 {
-  // ALWAYS clear the m_irqRcvd flag if set.
-  if (m_irqRcvd)
+  bool ready = false;
+
+  // ALWAYS consume the interrupt if one was received.
+  pthread_mutex_lock(&m_irqLock);
+  if (m_irqPending)
     {
-      m_irqRcvd = false;
-      return true;
+      m_irqPending--;
+      ready = true;
     }
+  pthread_mutex_unlock(&m_irqLock);
+
+  return ready;
+}
 
-  return false;
+/**************************************************************************/
+/*! 
+  @brief  Discards any interrupts received so far.
+*/
+/**************************************************************************/
+void PN532::clearReady()
+{
+  pthread_mutex_lock(&m_irqLock);
+  m_irqPending = 0;
+  pthread_mutex_unlock(&m_irqLock);
 }
 
 /**************************************************************************/
 /*! 
-  @brief  Waits until the PN532 is ready.
+  @brief  Waits until the PN532 is ready.  The caller sleeps until the
+  interrupt handler signals that IRQ went low.
 
-  @param  timeout   Timeout before giving up
+  @param  timeout   Timeout in ms before giving up, 0 to wait forever
 */
 /**************************************************************************/
 bool PN532::waitForReady(uint16_t timeout)
 {
-  uint16_t timer = 0;
-  while(!isReady())
+  // without an interrupt handler, poll the IRQ line.  It is held low
+  // while a frame is waiting to be read.
+  if (!m_isrInstalled)
     {
-      if (timeout != 0)
+      uint32_t timer = 0;
+      while (m_gpioIRQ.read() != 0)
         {
-          timer += 10;
-          if (timer > timeout)
-            {
-              return false;
-            }
+          if (timeout != 0 && ++timer > timeout)
+            return false;
+          usleep(1000);
         }
-      usleep(10000);
+      return true;
+    }
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += timeout / 1000;
+  deadline.tv_nsec += (timeout % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000)
+    {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+
+  bool ready = false;
+
+  pthread_mutex_lock(&m_irqLock);
+  while (!m_irqPending)
+    {
+      if (timeout == 0)
+        pthread_cond_wait(&m_irqCond, &m_irqLock);
+      else if (pthread_cond_timedwait(&m_irqCond, &m_irqLock,
+                                      &deadline) == ETIMEDOUT)
+        break;
+    }
+  if (m_irqPending)
+    {
+      m_irqPending--;
+      ready = true;
     }
+  pthread_mutex_unlock(&m_irqLock);
+
+  // an edge can be missed if it arrives while the handler is still
+  // being armed; the level tells the truth
+  if (!ready && m_gpioIRQ.read() == 0)
+    ready = true;
+
+  return ready;
+}
+
+/**************************************************************************/
+/*! 
+  @brief  Waits for the PN532 to be ready, then reads n bytes.
+
+  @param  buff      Pointer to the buffer where data will be written
+  @param  n         Number of bytes to be read
+  @param  timeout   Timeout in ms before giving up, 0 to wait forever
+*/
+/**************************************************************************/
+bool PN532::readResponse(uint8_t* buff, uint8_t n, uint16_t timeout)
+{
+  if (!waitForReady(timeout))
+    {
+      if (m_pn532Debug)
+        cerr << __FUNCTION__ << ": Response never received" << endl;
+
+      return false;
+    }
+
+  readData(buff, n);
   return true;
 }
 
+/**************************************************************************/
+/*! 
+  @brief  Reads a response frame of up to n bytes into the packet
+  buffer and checks it.  The payload following the response code
+  starts at byte 7.
+
+  @param  rsp       The expected response code
+  @param  n         Number of bytes to read
+  @param  timeout   Timeout in ms before giving up, 0 to wait forever
+
+  @returns  the payload length, or -1 for an error
+*/
+/**************************************************************************/
+int PN532::readFrame(uint8_t rsp, uint8_t n, uint16_t timeout)
+{
+  if (!readResponse(pn532_packetbuffer, n, timeout))
+    return -1;
+
+  if (pn532_packetbuffer[0] != 0 || pn532_packetbuffer[1] != 0 ||
+      pn532_packetbuffer[2] != 0xff)
+    {
+      if (m_pn532Debug)
+        cerr << __FUNCTION__ << ": Preamble missing" << endl;
+
+      return -1;
+    }
+
+  uint8_t length = pn532_packetbuffer[3];
+  if (pn532_packetbuffer[4] != (uint8_t)(~length + 1) || length < 2)
+    {
+      if (m_pn532Debug)
+        fprintf(stderr, "Length check invalid: 0x%02x != 0x%02x\n", length,
+                (~length)+1);
+
+      return -1;
+    }
+
+  // the frame, up to and including the data checksum, must fit
+  if (5 + length + 1 > n)
+    {
+      if (m_pn532Debug)
+        cerr << __FUNCTION__ << ": Frame of " << (int)length
+             << " bytes truncated" << endl;
+
+      return -1;
+    }
+
+  uint8_t checksum = 0;
+  for (int i=0; i<length + 1; i++)
+    checksum += pn532_packetbuffer[5 + i];
+
+  if (checksum != 0)
+    {
+      if (m_pn532Debug)
+        cerr << __FUNCTION__ << ": Data checksum invalid" << endl;
+
+      return -1;
+    }
+
+  if (pn532_packetbuffer[5] != PN532_PN532TOHOST ||
+      pn532_packetbuffer[6] != rsp)
+    {
+      if (m_pn532Debug)
+        fprintf(stderr, "Unexpected response: 0x%02x\n",
+                pn532_packetbuffer[6]);
+
+      return -1;
+    }
+
+  return length - 2;
+}
+
 /**************************************************************************/
 /*! 
   @brief  Reads n bytes of data from the PN532 via SPI or I2C.
@@ -1462,7 +2051,6 @@ void PN532::readData(uint8_t* buff, uint8_t n)
   int rv;
 
   memset(buf, 0, n+2);
-  usleep(2000); 
   if (m_i2c.address(m_addr) != mraa::SUCCESS)
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
@@ -1507,8 +2095,6 @@ void PN532::writeCommand(uint8_t* cmd, uint8_t cmdlen)
 
   cmdlen++;
 
-  usleep(2000);     // 2ms max in case board needs to wake up
-
   // command + packet wrapper
   uint8_t buf[cmdlen + 8];
   memset(buf, 0, cmdlen + 8);
@@ -1544,7 +2130,16 @@ void PN532::writeCommand(uint8_t* cmd, uint8_t cmdlen)
       return;
     }
 
-  if (m_i2c.write(buf, cmdlen + 8 - 1) != mraa::SUCCESS)
+  mraa::Result rv = m_i2c.write(buf, cmdlen + 8 - 1);
+
+  // the board may NAK while it wakes up (2ms max), so retry once
+  if (rv != mraa::SUCCESS)
+    {
+      usleep(2000);
+      rv = m_i2c.write(buf, cmdlen + 8 - 1);
+    }
+
+  if (rv != mraa::SUCCESS)
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": mraa_i2c_write() failed");
@@ -1564,13 +2159,17 @@ void PN532::dataReadyISR(void *ctx)
 {
   upm::PN532 *This = (upm::PN532 *)ctx;
 
+  pthread_mutex_lock(&This->m_irqLock);
+
   // if debugging is enabled, indicate when an interrupt occurred, and
   // a previously triggered interrupt was still set.
   if (This->m_pn532Debug)
-    if (This->m_irqRcvd)
+    if (This->m_irqPending)
       cerr << __FUNCTION__ << ": INFO: Unhandled IRQ detected." << endl;
 
-  This->m_irqRcvd = true;
+  This->m_irqPending++;
+  pthread_cond_broadcast(&This->m_irqCond);
+  pthread_mutex_unlock(&This->m_irqLock);
 }
 
 PN532::TAG_TYPE_T PN532::tagType()
@@ -31,6 +31,7 @@
 
 #include <string.h>
 #include <string>
+#include <pthread.h>
 #include <mraa/common.hpp>
 #include <mraa/i2c.hpp>
 
@@ -47,6 +48,12 @@
 #define PN532_HOSTTOPN532                   (0xD4)
 #define PN532_PN532TOHOST                   (0xD5)
 
+// the PN532 can inlist at most 2 ISO14443A targets at once
+#define PN532_MAX_TARGETS                   2
+
+// pages per NTAG2xx FAST_READ, limited by the 255 byte frame
+#define PN532_FASTREAD_MAX_PAGES            60
+
 namespace upm {
   
   /**
@@ -70,6 +77,9 @@ namespace upm {
    * @snippet pn532.cxx Interesting
    * Add a URI to an already NDEF formatted ultralight or NTAG2XX tag
    * @snippet pn532-writeurl.cxx Interesting
+   * Read whole MIFARE Classic sectors and NTAG2XX tags from up to two
+   * cards in the field
+   * @snippet pn532-bulkread.cxx Interesting
    */
   class PN532 {
   public:
@@ -116,8 +126,11 @@ namespace upm {
      * Response bytes
      */
     typedef enum {
+      RSP_RFCONFIGURATION       = 0x33,
       RSP_INDATAEXCHANGE        = 0x41,
-      RSP_INLISTPASSIVETARGET   = 0x4B
+      RSP_INCOMMUNICATETHRU     = 0x43,
+      RSP_INLISTPASSIVETARGET   = 0x4B,
+      RSP_INSELECT              = 0x55
     } PN532_RSP_T;
 
     /**
@@ -132,7 +145,8 @@ namespace upm {
       MIFARE_CMD_DECREMENT                = 0xC0,
       MIFARE_CMD_INCREMENT                = 0xC1,
       MIFARE_CMD_STORE                    = 0xC2,
-      MIFARE_ULTRALIGHT_CMD_WRITE         = 0xA2
+      MIFARE_ULTRALIGHT_CMD_WRITE         = 0xA2,
+      NTAG2XX_CMD_FAST_READ               = 0x3A
     } MIFARE_CMD_T;
 
     /**
@@ -194,6 +208,17 @@ namespace upm {
       TAG_TYPE_NFC2                       = 2 /* ultralight or NTAG2XX */
     } TAG_TYPE_T;
 
+    /**
+     * A target found by inListPassiveTargets()
+     */
+    typedef struct {
+      uint8_t  tg;                      // PN532 target number
+      uint16_t atqa;                    // SENS_RES
+      uint8_t  sak;                     // SEL_RES
+      uint8_t  uidLen;
+      uint8_t  uid[10];
+    } TARGET_T;
+
     /**
      * pn532 constructor
      *
@@ -292,6 +317,39 @@ namespace upm {
      */
     bool inListPassiveTarget();
 
+    /**
+     * 'InLists' up to 2 passive ISO14443A targets at once, so two
+     * cards in the field can be told apart.  The first target found
+     * is selected for the commands that follow; use selectTarget()
+     * to talk to the other.
+     *
+     * @param maxTargets 1 or 2
+     * @param timeout Milliseconds to wait for a target, 0 forever
+     * @return Number of targets found
+     */
+    int inListPassiveTargets(uint8_t maxTargets, uint16_t timeout);
+
+    /**
+     * Returns a target found by the last inListPassiveTargets()
+     *
+     * @param index Index of the target, 0 or 1
+     * @param target Pointer to hold the target
+     * @return true if there is such a target
+     */
+    bool getTarget(int index, TARGET_T *target);
+
+    /**
+     * Directs the commands that follow to a target found by the last
+     * inListPassiveTargets().  The UID, ATQA and SAK of the target
+     * become the current ones.  When two targets were found, the
+     * target is also selected in the PN532 (InSelect), so commands
+     * passed straight through to the card reach this one.
+     *
+     * @param index Index of the target, 0 or 1
+     * @return true if there is such a target and it could be selected
+     */
+    bool selectTarget(int index);
+
     /**
      *  Indicates whether the specified block number is the first block
      *  in the sector (block 0 relative to the current sector)
@@ -342,6 +400,45 @@ namespace upm {
      */
     bool mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data);
 
+    /**
+     *  Reads consecutive blocks, authenticating each sector they
+     *  cross.  Sectors already authenticated with the same card and
+     *  key are not authenticated again, so reading a sector block by
+     *  block costs one authentication.
+     *
+     *  @param  uid           Card UID
+     *  @param  uidLen        Length of the UID
+     *  @param  firstBlock    First block to read
+     *  @param  count         Number of blocks to read
+     *  @param  keyNumber     0 for key A, 1 for key B
+     *  @param  keyData       The 6 byte key
+     *  @param  data          Buffer for count * 16 bytes
+     *
+     *  @return Number of blocks read
+     */
+    int mifareclassic_ReadBlocks (uint8_t * uid, uint8_t uidLen,
+                                  uint8_t firstBlock, uint8_t count,
+                                  uint8_t keyNumber, uint8_t * keyData,
+                                  uint8_t * data);
+
+    /**
+     *  Reads a whole sector, including its trailer: 4 blocks (64
+     *  bytes) for sectors 0..31, 16 blocks (256 bytes) for sectors
+     *  32..39 of a 4K card.
+     *
+     *  @param  uid           Card UID
+     *  @param  uidLen        Length of the UID
+     *  @param  sector        Sector number
+     *  @param  keyNumber     0 for key A, 1 for key B
+     *  @param  keyData       The 6 byte key
+     *  @param  data          Buffer for the sector
+     *
+     *  @return true if every block was read
+     */
+    bool mifareclassic_ReadSector (uint8_t * uid, uint8_t uidLen,
+                                   uint8_t sector, uint8_t keyNumber,
+                                   uint8_t * keyData, uint8_t * data);
+
     /**
      *  tries to write an entire 16-byte data block at the specified block
      *  address.
@@ -392,6 +489,21 @@ namespace upm {
      */
     bool ntag2xx_ReadPage (uint8_t page, uint8_t * buffer);
 
+    /**
+     * reads consecutive 4-byte pages.  NTAG21x tags return up to
+     * PN532_FASTREAD_MAX_PAGES pages per FAST_READ command; tags
+     * without FAST_READ (Ultralight, NTAG203) are read 4 pages per
+     * READ command instead.
+     *
+     * @param  startPage   The first page
+     * @param  pageCount   The number of pages
+     * @param  buffer      Buffer for pageCount * 4 bytes
+     *
+     * @return Number of pages read
+     */
+    int ntag2xx_ReadPages (uint8_t startPage, uint8_t pageCount,
+                           uint8_t * buffer);
+
     /**
      *  write an entire 4-byte page at the specified block address
      *
@@ -474,14 +586,26 @@ namespace upm {
 
     bool readAck();
     bool isReady();
+    void clearReady();
     bool waitForReady(uint16_t timeout);
+    bool readResponse(uint8_t* buff, uint8_t n, uint16_t timeout=1000);
+    int readFrame(uint8_t rsp, uint8_t n, uint16_t timeout=1000);
     void readData(uint8_t* buff, uint8_t n);
     void writeCommand(uint8_t* cmd, uint8_t cmdlen);
 
   private:
     static void dataReadyISR(void *ctx);
+    uint8_t targetNumber() { return (m_inListedTag) ? m_inListedTag : 1; };
+    bool inSelect(uint8_t tg);
+    bool authCached(uint8_t * uid, uint8_t uidLen, uint8_t sector,
+                    uint8_t keyNumber, uint8_t * keyData);
+    static uint8_t mifareclassic_SectorOf (uint8_t block);
     bool m_isrInstalled;
-    volatile bool m_irqRcvd;
+
+    // IRQ edges not yet consumed by isReady()/waitForReady()
+    unsigned int m_irqPending;
+    pthread_mutex_t m_irqLock;
+    pthread_cond_t m_irqCond;
 
     uint8_t m_addr;
 
@@ -490,6 +614,13 @@ namespace upm {
     uint8_t m_key[6];       // Mifare Classic key
     uint8_t m_inListedTag;  // Tg number of inlisted tag.
 
+    TARGET_T m_targets[PN532_MAX_TARGETS];
+    int m_targetCount;
+
+    // the sector the selected card is authenticated for, -1 if none
+    int m_authSector;
+    uint8_t m_authKeyNumber;
+
     uint16_t m_ATQA;        // ATQA (Answer to Request Acknowlege - ISO14443)
                             // for currently inlisted card
     uint8_t m_SAK;          // SAK (Select Acknowlege) 
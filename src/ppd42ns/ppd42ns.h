@@ -26,8 +26,13 @@
 #include <string>
 #include <time.h>
 #include <mraa/aio.h>
+#include <mraa/gpio.h>
+
+// length of the sampling window used by getData(), in seconds
+#define PPD42NS_SAMPLE_TIME 30
 
 namespace upm {
+class EdgeCapture;
 
 typedef struct
 {
@@ -72,22 +77,38 @@ typedef struct
      */
     ~PPD42NS();
     /**
-     * Prints dust concentration
+     * Prints dust concentration.  Starts a new sample and sleeps for
+     * PPD42NS_SAMPLE_TIME seconds while the low pulse occupancy is
+     * accumulated from pin interrupts.
      *
      * @return struct dustData  Contains data from the dust sensor
      */
      dustData getData();
 
+    /**
+     * Starts a new sampling window without blocking.  The low pulse
+     * occupancy is accumulated from pin interrupts until getSample()
+     * is called.
+     */
+    void beginSample();
+
+    /**
+     * Returns true once the current sampling window has lasted
+     * PPD42NS_SAMPLE_TIME seconds
+     */
+    bool sampleReady();
+
+    /**
+     * Returns the dust concentration measured over the current
+     * sampling window, whatever its length so far.  The window keeps
+     * running until beginSample() is called again.
+     *
+     * @return struct dustData  Contains data from the dust sensor
+     */
+    dustData getSample();
+
   private:
         mraa_gpio_context m_gpio;
-		/**
-		 * Returns the amount of time it takes a pin to go from HIGH to LOW or from LOW to HIGH
-		 *
-		 * @param highLowValue int Do we measure movements from HIGH to LOW or from LOW to HIGH? highLowValue is the "from" value
-		 */
-		double pulseIn_polyfill(bool highLowValue, double endTime);
-		double m_timediff(timespec time1, timespec time2);
+        EdgeCapture *m_capture;
 	};
 }
-
-
@@ -36,6 +36,7 @@ Pulsensor::Pulsensor (Callback *obj_call) : pin_ctx(0)
     obj_callback = obj_call;
 
     sample_counter = 0;
+    sample_base    = 0;
     last_beat_time = 0;
     threshold      = 512;
     ibi            = 600;
@@ -46,6 +47,9 @@ Pulsensor::Pulsensor (Callback *obj_call) : pin_ctx(0)
     bpm            = 0;
     qs             = FALSE;
     apmlitude      = 100;
+    ctx_counter    = 0;
+    acquisition    = NULL;
+    acq_channel    = -1;
 }
 #else
 Pulsensor::Pulsensor (callback_handler handler) : pin_ctx(0)
@@ -53,6 +57,7 @@ Pulsensor::Pulsensor (callback_handler handler) : pin_ctx(0)
     callback = handler;
 
     sample_counter = 0;
+    sample_base    = 0;
     last_beat_time = 0;
     threshold      = 512;
     ibi            = 600;
@@ -63,12 +68,31 @@ Pulsensor::Pulsensor (callback_handler handler) : pin_ctx(0)
     bpm            = 0;
     qs             = FALSE;
     apmlitude      = 100;
+    ctx_counter    = 0;
+    acquisition    = NULL;
+    acq_channel    = -1;
 }
 #endif
 
+void Pulsensor::attach_acquisition (upm::AioAcquisition *acq) {
+    acquisition = acq;
+}
+
 void Pulsensor::start_sampler ()
 {
     int error;
+
+    if (acquisition) {
+        if (acq_channel < 0) {
+            sample_base = 0;
+            acq_channel = acquisition->addChannel (0, 2000, 0,
+                                                   &Pulsensor::sample_handler,
+                                                   this);
+            acquisition->start ();
+        }
+        return;
+    }
+
     ctx_counter++;
     usleep (100000);
     error = pthread_create (&(sample_thread), NULL, &Pulsensor::do_sample, this);
@@ -78,105 +102,134 @@ void Pulsensor::start_sampler ()
 }
 
 void Pulsensor::stop_sampler () {
+    if (acq_channel >= 0) {
+        acquisition->removeChannel (acq_channel);
+        acq_channel = -1;
+        return;
+    }
+
     ctx_counter--;
 }
 
 void *Pulsensor::do_sample (void *arg) {
     int data_from_sensor;
-    clbk_data callback_data;
 
     Pulsensor *pulsensor = static_cast<Pulsensor *>(arg);
 
     while (pulsensor->ctx_counter) {
         data_from_sensor = pulsensor->pin_ctx.read ();
-        pulsensor->ret = FALSE;
+        pulsensor->process_sample (data_from_sensor,
+                                   pulsensor->sample_counter + 2);
+        usleep (2000);
+    }
+    return NULL;
+}
 
-        pulsensor->sample_counter += 2;
-        int N = pulsensor->sample_counter - pulsensor->last_beat_time;
+void Pulsensor::sample_handler (int,
+                                const upm::AioAcquisition::SAMPLE_T *sample,
+                                void *ctx) {
+    Pulsensor *pulsensor = static_cast<Pulsensor *>(ctx);
 
-        if (data_from_sensor < pulsensor->threshold &&
-            N > ( pulsensor->ibi / 5)* 3) {
-            if (data_from_sensor < pulsensor->trough) {
-                pulsensor->trough = data_from_sensor;
-            }
-        }
+    // time the beats from the sample timestamps, so slots the engine
+    // skipped don't slow the clock down
+    if (!pulsensor->sample_base)
+        pulsensor->sample_base = sample->timestamp -
+            (uint64_t)(pulsensor->sample_counter + 2) * 1000000;
+
+    pulsensor->process_sample (sample->value,
+                               (sample->timestamp - pulsensor->sample_base) /
+                               1000000);
+}
 
-        if (data_from_sensor > pulsensor->threshold &&
-            data_from_sensor > pulsensor->peak) {
-            pulsensor->peak = data_from_sensor;
+// beat detection for one sample taken at now_ms, nominally 2ms after
+// the previous one
+void Pulsensor::process_sample (int data_from_sensor, uint32_t now_ms) {
+    clbk_data callback_data;
+
+    ret = FALSE;
+
+    sample_counter = now_ms;
+    int N = sample_counter - last_beat_time;
+
+    if (data_from_sensor < threshold &&
+        N > ( ibi / 5)* 3) {
+        if (data_from_sensor < trough) {
+            trough = data_from_sensor;
         }
+    }
+
+    if (data_from_sensor > threshold &&
+        data_from_sensor > peak) {
+        peak = data_from_sensor;
+    }
 
-        if (N > 250) {
-            // printf ("(NO_GDB) DEBUG\n");
-            if ( (data_from_sensor > pulsensor->threshold) &&
-                    (pulsensor->is_pulse == FALSE) &&
-                    (N > (pulsensor->ibi / 5)* 3) ) {
-                pulsensor->is_pulse = callback_data.is_heart_beat = TRUE;
+    if (N > 250) {
+        // printf ("(NO_GDB) DEBUG\n");
+        if ( (data_from_sensor > threshold) &&
+                (is_pulse == FALSE) &&
+                (N > (ibi / 5)* 3) ) {
+            is_pulse = callback_data.is_heart_beat = TRUE;
 #if defined(JAVACALLBACK)
-                pulsensor->obj_callback->run(callback_data);
+            obj_callback->run(callback_data);
 #else
-                pulsensor->callback(callback_data);
+            callback(callback_data);
 #endif
 
-                pulsensor->ibi = pulsensor->sample_counter - pulsensor->last_beat_time;
-                pulsensor->last_beat_time = pulsensor->sample_counter;
+            ibi = sample_counter - last_beat_time;
+            last_beat_time = sample_counter;
 
-                // second beat
-                if (pulsensor->second_beat) {
-                    pulsensor->second_beat = FALSE;
-                    for (int i = 0; i <= 9; i++) {
-                        pulsensor->ibi_rate[i] = pulsensor->ibi;
-                    }
+            // second beat
+            if (second_beat) {
+                second_beat = FALSE;
+                for (int i = 0; i <= 9; i++) {
+                    ibi_rate[i] = ibi;
                 }
+            }
 
-                // first beat
-                if (pulsensor->first_beat) {
-                    pulsensor->first_beat  = FALSE;
-                    pulsensor->second_beat = TRUE;
-                    pulsensor->ret = TRUE;
-                } else {
-                    uint32_t running_total = 0;
-                    for(int i = 0; i <= 8; i++){
-                        pulsensor->ibi_rate[i] = pulsensor->ibi_rate[i+1];
-                        running_total += pulsensor->ibi_rate[i];
-                    }
-
-                    pulsensor->ibi_rate[9] = pulsensor->ibi;
-                    running_total += pulsensor->ibi_rate[9];
-                    running_total /= 10;
-                    pulsensor->bpm = 60000 / running_total;
-                    pulsensor->qs = TRUE;
+            // first beat
+            if (first_beat) {
+                first_beat  = FALSE;
+                second_beat = TRUE;
+                ret = TRUE;
+            } else {
+                uint32_t running_total = 0;
+                for(int i = 0; i <= 8; i++){
+                    ibi_rate[i] = ibi_rate[i+1];
+                    running_total += ibi_rate[i];
                 }
+
+                ibi_rate[9] = ibi;
+                running_total += ibi_rate[9];
+                running_total /= 10;
+                bpm = 60000 / running_total;
+                qs = TRUE;
             }
         }
+    }
 
-        if (pulsensor->ret == FALSE) {
-            if (data_from_sensor < pulsensor->threshold &&
-                pulsensor->is_pulse == TRUE) {
-                pulsensor->is_pulse = callback_data.is_heart_beat = FALSE;
+    if (ret == FALSE) {
+        if (data_from_sensor < threshold &&
+            is_pulse == TRUE) {
+            is_pulse = callback_data.is_heart_beat = FALSE;
 #if defined(JAVACALLBACK)
-                pulsensor->obj_callback->run(callback_data);
+            obj_callback->run(callback_data);
 #else
-                pulsensor->callback(callback_data);
+            callback(callback_data);
 #endif
-                pulsensor->is_pulse   = FALSE;
-                pulsensor->apmlitude  = pulsensor->peak - pulsensor->trough;
-                pulsensor->threshold  = pulsensor->apmlitude / 2 + pulsensor->trough;
-                pulsensor->peak       = pulsensor->threshold;
-                pulsensor->trough     = pulsensor->threshold;
-            }
-
-            if (N > 2500) {
-                pulsensor->threshold      = 512;
-                pulsensor->peak           = 512;
-                pulsensor->trough         = 512;
-                pulsensor->last_beat_time = pulsensor->sample_counter;
-                pulsensor->first_beat     = TRUE;
-                pulsensor->second_beat    = FALSE;
-            }
+            is_pulse   = FALSE;
+            apmlitude  = peak - trough;
+            threshold  = apmlitude / 2 + trough;
+            peak       = threshold;
+            trough     = threshold;
         }
 
-        usleep (2000);
+        if (N > 2500) {
+            threshold      = 512;
+            peak           = 512;
+            trough         = 512;
+            last_beat_time = sample_counter;
+            first_beat     = TRUE;
+            second_beat    = FALSE;
+        }
     }
-    return NULL;
 }
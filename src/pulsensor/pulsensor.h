@@ -34,6 +34,8 @@
 #include <mraa/gpio.hpp>
 #include <pthread.h>
 
+#include "aioacquire.h"
+
 #define HIGH               1
 #define LOW                0
 
@@ -60,6 +62,10 @@
  * Usually, you can identify the sensor based on the round breakout and the
  * distinctive heart symbol.
  *
+ * The sensor is sampled every 2ms by a thread of its own, or by a
+ * shared AioAcquisition engine passed to attach_acquisition() before
+ * start_sampler().
+ *
  * @image html pulsensor.jpg
  * @snippet pulsensor.cxx Interesting
  */
@@ -91,13 +97,19 @@ public:
 #else
     Pulsensor(callback_handler handler);
 #endif
+    void attach_acquisition(upm::AioAcquisition *acq);
     void start_sampler();
     void stop_sampler();
 
 private:
     static void      *do_sample(void *arg);
+    static void      sample_handler(int,
+                                    const upm::AioAcquisition::SAMPLE_T *sample,
+                                    void *ctx);
+    void             process_sample(int data_from_sensor, uint32_t now_ms);
     pthread_t        sample_thread; /**< Thread for the code sample */
     uint32_t         sample_counter; /**< Counter for the code sample */
+    uint64_t         sample_base; /**< Timestamp of sample_counter 0, ns */
     uint32_t         last_beat_time; /**< Last heartbeat time */
     int              threshold; /**< Threshold */
     int              ibi_rate[10]; /**< ibi rate */
@@ -119,5 +131,7 @@ private:
     callback_handler callback; /**< The callback function */
 #endif
     volatile uint16_t ctx_counter;
+    upm::AioAcquisition *acquisition; /**< Shared acquisition engine */
+    int              acq_channel; /**< Channel on the engine, or -1 */
 };
 
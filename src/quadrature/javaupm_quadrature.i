@@ -0,0 +1,20 @@
+%module javaupm_quadrature
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "quadrature.h"
+%}
+
+%include "quadrature.h"
+
+%pragma(java) jniclasscode=%{
+    static {
+        try {
+            System.loadLibrary("javaupm_quadrature");
+        } catch (UnsatisfiedLinkError e) {
+            System.err.println("Native code library failed to load. \n" + e);
+            System.exit(1);
+        }
+    }
+%}
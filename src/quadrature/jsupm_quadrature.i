@@ -0,0 +1,9 @@
+%module jsupm_quadrature
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "quadrature.h"
+%}
+
+%include "quadrature.h"
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+#include <time.h>
+
+#include "quadrature.h"
+
+using namespace upm;
+using namespace std;
+
+// marks a transition where both channels changed
+#define ILLEGAL 2
+
+// indexed by (old state << 2) | new state, where a state is (A << 1) | B.
+// Forward is 00 -> 01 -> 11 -> 10 -> 00, i.e. B leads A.
+static const int8_t transitionTable[16] = {
+   0,        1,       -1,  ILLEGAL,
+  -1,        0,  ILLEGAL,        1,
+   1,  ILLEGAL,        0,       -1,
+  ILLEGAL,  -1,        1,        0
+};
+
+QuadratureDecoder::QuadratureDecoder(int pinA, int pinB, bool pullup)
+{
+  m_gpioB = 0;
+  m_running = false;
+
+  if ( !(m_gpioA = mraa_gpio_init(pinA)) )
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": mraa_gpio_init(pinA) failed, invalid pin?");
+      return;
+    }
+
+  mraa_gpio_dir(m_gpioA, MRAA_GPIO_IN);
+  if (pullup)
+    mraa_gpio_mode(m_gpioA, MRAA_GPIO_PULLUP);
+
+  if (pinB >= 0)
+    {
+      if ( !(m_gpioB = mraa_gpio_init(pinB)) )
+        {
+          mraa_gpio_close(m_gpioA);
+          throw std::invalid_argument(std::string(__FUNCTION__) +
+                                      ": mraa_gpio_init(pinB) failed, invalid pin?");
+          return;
+        }
+
+      mraa_gpio_dir(m_gpioB, MRAA_GPIO_IN);
+      if (pullup)
+        mraa_gpio_mode(m_gpioB, MRAA_GPIO_PULLUP);
+    }
+
+  if (pthread_mutex_init(&m_lock, NULL))
+    {
+      mraa_gpio_close(m_gpioA);
+      if (m_gpioB)
+        mraa_gpio_close(m_gpioB);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_mutex_init() failed");
+      return;
+    }
+
+  m_windowNs = 20 * 1000000ULL;
+  m_stopNs = 500 * 1000000ULL;
+  m_seq = 0;
+
+  m_work.transitions = 0;
+  m_work.glitches = 0;
+  m_state = readState();
+  setPosition(0);
+}
+
+QuadratureDecoder::~QuadratureDecoder()
+{
+  stop();
+
+  mraa_gpio_close(m_gpioA);
+  if (m_gpioB)
+    mraa_gpio_close(m_gpioB);
+
+  pthread_mutex_destroy(&m_lock);
+}
+
+uint64_t QuadratureDecoder::getNanos()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void QuadratureDecoder::start()
+{
+  if (m_running)
+    return;
+
+  pthread_mutex_lock(&m_lock);
+  m_state = readState();
+  pthread_mutex_unlock(&m_lock);
+
+  if (mraa_gpio_isr(m_gpioA, MRAA_GPIO_EDGE_BOTH, &channelISR, this)
+      != MRAA_SUCCESS)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": mraa_gpio_isr(A) failed");
+      return;
+    }
+
+  if (m_gpioB &&
+      mraa_gpio_isr(m_gpioB, MRAA_GPIO_EDGE_BOTH, &channelISR, this)
+      != MRAA_SUCCESS)
+    {
+      mraa_gpio_isr_exit(m_gpioA);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": mraa_gpio_isr(B) failed");
+      return;
+    }
+
+  m_running = true;
+}
+
+void QuadratureDecoder::stop()
+{
+  if (!m_running)
+    return;
+
+  mraa_gpio_isr_exit(m_gpioA);
+  if (m_gpioB)
+    mraa_gpio_isr_exit(m_gpioB);
+
+  m_running = false;
+}
+
+void QuadratureDecoder::setPosition(int64_t position)
+{
+  pthread_mutex_lock(&m_lock);
+
+  m_work.position = position;
+  m_work.velocity = 0.0;
+  m_work.acceleration = 0.0;
+  m_work.direction = 0;
+  m_work.lastTransition = getNanos();
+  m_work.period = 0;
+  m_head = m_tail = 0;
+
+  publish();
+  pthread_mutex_unlock(&m_lock);
+}
+
+int64_t QuadratureDecoder::getPosition()
+{
+  STATE_T state;
+
+  getState(&state);
+  return state.position;
+}
+
+double QuadratureDecoder::getVelocity()
+{
+  STATE_T state;
+
+  getState(&state);
+  return state.velocity;
+}
+
+double QuadratureDecoder::getAcceleration()
+{
+  STATE_T state;
+
+  getState(&state);
+  return state.acceleration;
+}
+
+double QuadratureDecoder::getRPM(double countsPerRev)
+{
+  return getVelocity() * 60.0 / countsPerRev;
+}
+
+unsigned int QuadratureDecoder::getGlitchCount()
+{
+  STATE_T state;
+
+  getState(&state);
+  return state.glitches;
+}
+
+void QuadratureDecoder::setVelocityWindow(unsigned int millis)
+{
+  m_windowNs = (uint64_t)millis * 1000000;
+}
+
+void QuadratureDecoder::setStopTimeout(unsigned int millis)
+{
+  m_stopNs = (uint64_t)millis * 1000000;
+}
+
+void QuadratureDecoder::getState(STATE_T *state)
+{
+  unsigned int seq;
+
+  // retry until no publish() overlapped the copy
+  do
+    {
+      while ((seq = m_seq) & 1)
+        ;
+      __sync_synchronize();
+      *state = m_published;
+      __sync_synchronize();
+    }
+  while (seq != m_seq);
+
+  uint64_t now = getNanos();
+  state->timestamp = now;
+
+  if (state->direction == 0)
+    return;
+
+  // no count for a while bounds how fast the encoder can be turning
+  uint64_t age = (now > state->lastTransition) ?
+    now - state->lastTransition : 0;
+
+  if (age > m_stopNs)
+    {
+      state->velocity = 0.0;
+      state->acceleration = 0.0;
+    }
+  else if (age > 0)
+    {
+      double limit = 1000000000.0 / age;
+
+      if (state->velocity > limit)
+        state->velocity = limit;
+      else if (state->velocity < -limit)
+        state->velocity = -limit;
+    }
+}
+
+void QuadratureDecoder::channelISR(void *ctx)
+{
+  QuadratureDecoder *This = (QuadratureDecoder *)ctx;
+
+  This->transition(getNanos());
+}
+
+int QuadratureDecoder::readState()
+{
+  int a = (mraa_gpio_read(m_gpioA) > 0) ? 1 : 0;
+
+  if (!m_gpioB)
+    return a;
+
+  return (a << 1) | ((mraa_gpio_read(m_gpioB) > 0) ? 1 : 0);
+}
+
+// called from the interrupt thread of either channel
+void QuadratureDecoder::transition(uint64_t now)
+{
+  pthread_mutex_lock(&m_lock);
+
+  // read under the lock so the A and B threads see states in order
+  int state = readState();
+  int step;
+
+  if (m_gpioB)
+    step = transitionTable[(m_state << 2) | state];
+  else
+    step = (state && !m_state) ? 1 : 0;
+
+  m_state = state;
+
+  if (step == ILLEGAL)
+    {
+      m_work.glitches++;
+      publish();
+    }
+  else if (step != 0)
+    count(now, step);
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+// called with m_lock held
+void QuadratureDecoder::count(uint64_t now, int step)
+{
+  m_work.position += step;
+  m_work.transitions++;
+
+  if (step != m_work.direction)
+    {
+      // starting or reversing: the history says nothing about this
+      // direction, so start over from this count
+      m_work.direction = step;
+      m_work.velocity = 0.0;
+      m_work.acceleration = 0.0;
+      m_work.period = 0;
+      m_head = m_tail = 0;
+    }
+  else
+    m_work.period = now - m_work.lastTransition;
+
+  m_work.lastTransition = now;
+
+  // keep the oldest sample inside the window, plus always one to
+  // measure against
+  if (m_head - m_tail >= QUADRATURE_HISTORY)
+    m_tail++;
+  while (m_head - m_tail > 1 &&
+         now - m_history[(m_tail + 1) % QUADRATURE_HISTORY].timestamp
+         >= m_windowNs)
+    m_tail++;
+
+  if (m_head != m_tail)
+    {
+      SAMPLE_T *ref = &m_history[m_tail % QUADRATURE_HISTORY];
+      double dt = (now - ref->timestamp) / 1000000000.0;
+
+      if (dt > 0.0)
+        {
+          m_work.velocity = (m_work.position - ref->position) / dt;
+          m_work.acceleration = (m_work.velocity - ref->velocity) / dt;
+        }
+    }
+
+  SAMPLE_T *sample = &m_history[m_head % QUADRATURE_HISTORY];
+  sample->timestamp = now;
+  sample->position = m_work.position;
+  sample->velocity = m_work.velocity;
+  m_head++;
+
+  publish();
+}
+
+// called with m_lock held
+void QuadratureDecoder::publish()
+{
+  m_seq++;
+  __sync_synchronize();
+  m_published = m_work;
+  __sync_synchronize();
+  m_seq++;
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <mraa/gpio.h>
+
+// number of transitions kept for the count-based velocity estimate
+#define QUADRATURE_HISTORY 64
+
+namespace upm {
+  /**
+   * @brief Quadrature decoder engine
+   * @defgroup quadrature libupm-quadrature
+   * @ingroup gpio
+   */
+
+  /**
+   * @library quadrature
+   * @sensor quadrature
+   * @comname Quadrature encoder decoder
+   * @con gpio
+   *
+   * @brief Interrupt driven encoder decoding shared by the encoder drivers
+   *
+   * A QuadratureDecoder installs interrupt handlers for both edges of
+   * both encoder channels.  Every interrupt reads the two levels and
+   * looks the old and new states up in a transition table, giving 4
+   * counts per encoder cycle.  A transition where both channels
+   * changed at once cannot be decoded; it is counted as a glitch and
+   * the position is left alone.  With only channel A, each rising
+   * edge counts one step forward.
+   *
+   * Each valid transition is timestamped with CLOCK_MONOTONIC.  The
+   * velocity is the number of counts over the time spanned by the
+   * transitions of the last velocity window (20ms by default), so it
+   * averages many counts at high speed and falls back to the period
+   * of the last count at low speed.  Between counts the velocity is
+   * capped by the time since the last transition, so it decays to 0
+   * when the encoder stops.  Acceleration is the change of velocity
+   * over the same span.
+   *
+   * The interrupt threads publish their results through a sequence
+   * counter, so getState() and the other readers never block them.
+   *
+   * @snippet quadrature.cxx Interesting
+   */
+  class QuadratureDecoder {
+  public:
+    // a consistent view of the decoder
+    typedef struct {
+      int64_t      position;            // counts
+      double       velocity;            // counts per second
+      double       acceleration;        // counts per second^2
+      int          direction;           // 1, -1 or 0 before the first count
+      uint64_t     lastTransition;      // CLOCK_MONOTONIC, nanoseconds
+      uint64_t     period;              // time between the last 2 counts, ns
+      unsigned int transitions;         // valid transitions seen
+      unsigned int glitches;            // illegal transitions rejected
+      uint64_t     timestamp;           // when the view was taken, ns
+    } STATE_T;
+
+    /**
+     * QuadratureDecoder constructor
+     *
+     * @param pinA Digital pin for channel A
+     * @param pinB Digital pin for channel B, or -1 for a single channel
+     * @param pullup Enables the internal pullups on the pins
+     */
+    QuadratureDecoder(int pinA, int pinB=-1, bool pullup=false);
+
+    /**
+     * QuadratureDecoder destructor.  Removes the interrupt handlers.
+     */
+    ~QuadratureDecoder();
+
+    /**
+     * Reads the current channel levels and installs the interrupt
+     * handlers
+     */
+    void start();
+
+    /**
+     * Removes the interrupt handlers.  The position is kept.
+     */
+    void stop();
+
+    /**
+     * Sets the position and clears the velocity history
+     *
+     * @param position New position, in counts
+     */
+    void setPosition(int64_t position=0);
+
+    /**
+     * Returns the position
+     *
+     * @return Position in counts
+     */
+    int64_t getPosition();
+
+    /**
+     * Returns the velocity
+     *
+     * @return Counts per second; positive is forward
+     */
+    double getVelocity();
+
+    /**
+     * Returns the acceleration
+     *
+     * @return Counts per second per second
+     */
+    double getAcceleration();
+
+    /**
+     * Returns the velocity as revolutions per minute
+     *
+     * @param countsPerRev Counts per revolution (4 times the cycles
+     * per revolution with 2 channels)
+     * @return Revolutions per minute
+     */
+    double getRPM(double countsPerRev);
+
+    /**
+     * Takes a consistent snapshot of position, velocity and
+     * acceleration without blocking the interrupt handlers
+     *
+     * @param state Filled in with the snapshot
+     */
+    void getState(STATE_T *state);
+
+    /**
+     * Returns the number of illegal transitions rejected
+     *
+     * @return Number of glitches
+     */
+    unsigned int getGlitchCount();
+
+    /**
+     * Sets the span of transitions averaged by the velocity estimate.
+     * Longer windows are smoother, shorter windows react faster.
+     *
+     * @param millis Window in milliseconds
+     */
+    void setVelocityWindow(unsigned int millis);
+
+    /**
+     * Sets the time without transitions after which the encoder is
+     * considered stopped
+     *
+     * @param millis Timeout in milliseconds
+     */
+    void setStopTimeout(unsigned int millis);
+
+    /**
+     * Returns the current CLOCK_MONOTONIC time
+     *
+     * @return Time in nanoseconds
+     */
+    static uint64_t getNanos();
+
+  private:
+    // one counted transition
+    typedef struct {
+      uint64_t timestamp;
+      int64_t  position;
+      double   velocity;
+    } SAMPLE_T;
+
+    static void channelISR(void *ctx);
+    void transition(uint64_t now);
+    void count(uint64_t now, int step);
+    int readState();
+    void publish();
+
+    mraa_gpio_context m_gpioA;
+    mraa_gpio_context m_gpioB;
+    bool m_running;
+
+    uint64_t m_windowNs;
+    uint64_t m_stopNs;
+
+    // everything below is owned by whoever holds m_lock
+    pthread_mutex_t m_lock;
+    int m_state;
+    STATE_T m_work;
+    SAMPLE_T m_history[QUADRATURE_HISTORY];
+    unsigned int m_head;
+    unsigned int m_tail;
+
+    // published copy of m_work, odd m_seq while it is being written
+    volatile unsigned int m_seq;
+    STATE_T m_published;
+  };
+}
@@ -32,6 +32,8 @@
 
 #include <mraa/pwm.hpp>
 
+#include "quadrature.h"
+
 
 namespace upm {
   /**
@@ -106,16 +108,25 @@ namespace upm {
     bool getButtonState();
 
     /* 
-     * Gets the current rotary encoder counter value
+     * Gets the current rotary encoder counter value, 4 counts per
+     * encoder cycle
      *
      * @return Current counter value
      */
-    int getEncoderPosition() { return m_counter; };
+    int getEncoderPosition() { return (int)m_decoder.getPosition(); };
 
     /* 
      * Sets the encoder counter to 0
      */
-    void clearEncoderPosition() { m_counter = 0; };
+    void clearEncoderPosition() { m_decoder.setPosition(0); };
+
+    /*
+     * Returns the encoder decoder, for velocity, acceleration and
+     * glitch statistics
+     *
+     * @return The quadrature decoder
+     */
+    QuadratureDecoder& getEncoder() { return m_decoder; };
 
     /* 
      * Sets the intensity of the red, green, and blue LEDs. Values can
@@ -142,11 +153,7 @@ namespace upm {
     mraa::Pwm m_pwmGreen;
     mraa::Pwm m_pwmBlue;
 
-    mraa::Gpio m_gpioEncA;
-    mraa::Gpio m_gpioEncB;
-
-    static void interruptHandler(void *ctx);
-    volatile int m_counter;
+    QuadratureDecoder m_decoder;
 
   };
 }
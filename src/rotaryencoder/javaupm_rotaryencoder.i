@@ -1,7 +1,6 @@
 %module javaupm_rotaryencoder
 %include "../upm.i"
-
-%ignore signalAISR;
+%include "stdint.i"
 
 %{
     #include "rotaryencoder.h"
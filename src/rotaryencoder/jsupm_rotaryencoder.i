@@ -1,5 +1,6 @@
 %module jsupm_rotaryencoder
 %include "../upm.i"
+%include "stdint.i"
 
 %{
     #include "rotaryencoder.h"
@@ -2,6 +2,7 @@
 %include "pyupm_doxy2swig.i"
 %module pyupm_rotaryencoder
 %include "../upm.i"
+%include "stdint.i"
 
 %feature("autodoc", "3");
 
@@ -31,65 +31,38 @@
 using namespace upm;
 using namespace std;
 
-RotaryEncoder::RotaryEncoder(int pinA, int pinB)
+RotaryEncoder::RotaryEncoder(int pinA, int pinB) :
+  m_decoder(pinA, pinB)
 {
-  if ( !(m_gpioA = mraa_gpio_init(pinA)) )
-    {
-      throw std::invalid_argument(std::string(__FUNCTION__) +
-                                  ": mraa_gpio_init(pinA) failed, invalid pin?");
-      return;
-    }
-
-  mraa_gpio_dir(m_gpioA, MRAA_GPIO_IN);
-
-  if ( !(m_gpioB = mraa_gpio_init(pinB)) )
-    {
-      throw std::invalid_argument(std::string(__FUNCTION__) +
-                                  ": mraa_gpio_init(pinB) failed, invalid pin?");
-      return;
-    }
-
-  mraa_gpio_dir(m_gpioB, MRAA_GPIO_IN);
-
-  m_position = 0;
-
-  // setup the ISR
-
-  // We would prefer to use MRAA_GPIO_EDGE_BOTH for better resolution,
-  // but that does not appear to be supported
-  mraa_gpio_isr(m_gpioA, MRAA_GPIO_EDGE_RISING, 
-                &signalAISR, this);
+  m_decoder.start();
 }
 
 RotaryEncoder::~RotaryEncoder()
 {
-  mraa_gpio_isr_exit(m_gpioA);
-
-  mraa_gpio_close(m_gpioA);
-  mraa_gpio_close(m_gpioB);
 }
 
 void RotaryEncoder::initPosition(int count)
 {
-  m_position = count;
+  m_decoder.setPosition((int64_t)count * 4);
 }
 
 int RotaryEncoder::position()
 {
-  return m_position;
-}
+  int64_t counts = m_decoder.getPosition();
 
-void RotaryEncoder::signalAISR(void *ctx)
-{
-  upm::RotaryEncoder *This = (upm::RotaryEncoder *)ctx;
+  // one position step per full cycle, rounding toward -infinity
+  if (counts < 0)
+    return (int)-((-counts + 3) / 4);
 
-  if (mraa_gpio_read(This->m_gpioA))
-    {
-      if (mraa_gpio_read(This->m_gpioB))
-        This->m_position++;      // CW
-      else
-        This->m_position--;      // CCW
-    }
+  return (int)(counts / 4);
 }
 
+int64_t RotaryEncoder::counts()
+{
+  return m_decoder.getPosition();
+}
 
+double RotaryEncoder::rpm(int cyclesPerRev)
+{
+  return m_decoder.getRPM(cyclesPerRev * 4.0);
+}
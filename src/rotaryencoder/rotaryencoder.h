@@ -28,6 +28,8 @@
 #include <sys/time.h>
 #include <mraa/gpio.h>
 
+#include "quadrature.h"
+
 namespace upm {
 
 /**
@@ -56,7 +58,9 @@ namespace upm {
  * circuit, as is the case with a potentiometer.
  *
  * This module maintains a position that is incremented or
- * decremented according to the rotation on the encoder.
+ * decremented according to the rotation on the encoder.  Both edges
+ * of both signals are decoded, so counts() has 4 times the
+ * resolution of position().
  *
  * @image html rotaryencoder.jpg
  * @snippet rotaryencoder.cxx Interesting
@@ -88,17 +92,31 @@ namespace upm {
      */
     int position();
 
-  private:
     /**
-     * Interrupt service routine (ISR) for signal A
+     * Gets the position in quadrature counts, 4 per encoder cycle
+     *
+     * @return Position in counts
+     */
+    int64_t counts();
+
+    /**
+     * Gets the rotation speed
      *
-     * @param ctx User context for the ISR (*this pointer)
+     * @param cyclesPerRev Encoder cycles per revolution
+     * @return Revolutions per minute; positive is clockwise
      */
-    static void signalAISR(void *ctx);
-  
-    volatile int m_position;
-    mraa_gpio_context m_gpioA;
-    mraa_gpio_context m_gpioB;
+    double rpm(int cyclesPerRev);
+
+    /**
+     * Returns the decoder, for velocity, acceleration and glitch
+     * statistics
+     *
+     * @return The quadrature decoder
+     */
+    QuadratureDecoder& decoder() { return m_decoder; };
+
+  private:
+    QuadratureDecoder m_decoder;
   };
 }
 
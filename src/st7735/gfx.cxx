@@ -35,6 +35,9 @@ GFX::GFX (int width, int height, uint8_t * screenBuffer, const unsigned char * f
     m_width  = width;
     m_font   = font;
     m_map    = screenBuffer;
+    m_refreshBytes = 0;
+
+    clearDirty ();
 }
 
 GFX::~GFX () {
@@ -50,6 +53,8 @@ GFX::setPixel (int x, int y, uint16_t color) {
     m_map[index] = (uint8_t) (color >> 8);
     m_map[++index] = (uint8_t)(color);
 
+    markDirty (x, y, x, y);
+
     return mraa::SUCCESS;
 }
 
@@ -175,6 +180,36 @@ GFX::setTextWrap (uint8_t wrap) {
     m_wrap = wrap;
 }
 
+void
+GFX::invalidate () {
+    markDirty (0, 0, m_width - 1, m_height - 1);
+}
+
+bool
+GFX::isDirty () {
+    return (m_dirtyX0 <= m_dirtyX1);
+}
+
+int
+GFX::getRefreshBytes () {
+    return m_refreshBytes;
+}
+
+void
+GFX::markDirty (int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+    if (x0 < m_dirtyX0) m_dirtyX0 = x0;
+    if (y0 < m_dirtyY0) m_dirtyY0 = y0;
+    if (x1 > m_dirtyX1) m_dirtyX1 = x1;
+    if (y1 > m_dirtyY1) m_dirtyY1 = y1;
+}
+
+void
+GFX::clearDirty () {
+    // an empty region: any markDirty() call replaces both corners
+    m_dirtyX0 = m_dirtyY0 = 0x7fff;
+    m_dirtyX1 = m_dirtyY1 = -1;
+}
+
 void
 GFX::drawChar (int16_t x, int16_t y, uint8_t data, uint16_t color, uint16_t bg, uint8_t size) {
     if( (x >= m_width)            || // Clip right
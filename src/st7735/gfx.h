@@ -201,6 +201,23 @@ class GFX {
          */
         void setTextWrap (uint8_t wrap);
 
+        /**
+         * Marks the whole screen as changed so the next refresh sends
+         * the entire buffer
+         */
+        void invalidate ();
+
+        /**
+         * Returns true if the buffer has changed since the last refresh
+         */
+        bool isDirty ();
+
+        /**
+         * Returns the number of bytes sent over SPI by the last
+         * refresh, including the address window setup
+         */
+        int getRefreshBytes ();
+
         int m_height; /**< Screen height */
         int m_width; /**< Screen width */
         int m_textSize; /**< Printed text size */
@@ -213,6 +230,27 @@ class GFX {
         uint8_t * m_map; /**< Screens buffer */
 
     protected:
+        /**
+         * Grows the changed region to include a rectangle
+         *
+         * @param x0 Left column
+         * @param y0 Top row
+         * @param x1 Right column
+         * @param y1 Bottom row
+         */
+        void markDirty (int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+
+        /**
+         * Empties the changed region; called once a refresh is done
+         */
+        void clearDirty ();
+
+        int m_dirtyX0; /**< Changed region, left column */
+        int m_dirtyY0; /**< Changed region, top row */
+        int m_dirtyX1; /**< Changed region, right column */
+        int m_dirtyY1; /**< Changed region, bottom row */
+        int m_refreshBytes; /**< Bytes sent by the last refresh */
+
         const int16_t   WIDTH, HEIGHT;
         const unsigned char * m_font;
     };
@@ -153,12 +153,39 @@ ST7735::drawPixel(int16_t x, int16_t y, uint16_t color) {
 
 void
 ST7735::refresh () {
+    m_refreshBytes = 0;
+    if (!isDirty ()) {
+        return;
+    }
+
+    // only the rectangle touched since the last refresh is sent
+    setAddrWindow (m_dirtyX0, m_dirtyY0, m_dirtyX1, m_dirtyY1);
+    m_refreshBytes += 3 + 8;
+
     rsHIGH ();
 
-    int fragmentSize = m_height * m_width * 2 / 20;
-    for (int fragment = 0; fragment < 20; fragment++) {
-        m_spi.write(&m_map[fragment * fragmentSize], fragmentSize);
+    int rowBytes = (m_dirtyX1 - m_dirtyX0 + 1) * 2;
+    if (rowBytes == m_width * 2) {
+        // full-width rows are contiguous in the buffer
+        uint8_t * start = &m_map[m_dirtyY0 * rowBytes];
+        int size = (m_dirtyY1 - m_dirtyY0 + 1) * rowBytes;
+
+        for (int offset = 0; offset < size; offset += ST7735_FRAGMENT_SIZE) {
+            int len = size - offset;
+            if (len > ST7735_FRAGMENT_SIZE) {
+                len = ST7735_FRAGMENT_SIZE;
+            }
+            m_spi.transfer(start + offset, NULL, len);
+        }
+        m_refreshBytes += size;
+    } else {
+        for (int y = m_dirtyY0; y <= m_dirtyY1; y++) {
+            m_spi.transfer(&m_map[((y * m_width) + m_dirtyX0) * 2], NULL, rowBytes);
+            m_refreshBytes += rowBytes;
+        }
     }
+
+    clearDirty ();
 }
 
 void
@@ -42,6 +42,9 @@
 #define ST7735_TFTWIDTH     128
 #define ST7735_TFTHEIGHT    160
 
+// largest single SPI transfer used by refresh()
+#define ST7735_FRAGMENT_SIZE 2048
+
 #define ST7735_NOP          0x00
 #define ST7735_SWRESET      0x01
 #define ST7735_RDDID        0x04
@@ -589,7 +592,8 @@ class ST7735 : public GFX {
         void drawPixel (int16_t x, int16_t y, uint16_t color);
 
         /**
-         * Copies the buffer to the chip via the SPI.
+         * Copies the part of the buffer changed since the last refresh
+         * to the chip via the SPI.
          */
         void refresh ();
 
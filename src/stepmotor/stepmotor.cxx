@@ -28,7 +28,9 @@
 #include <stdexcept>
 #include <stdlib.h>
 #include <time.h>
+#include <errno.h>
 #include "stepmotor.h"
+#include "motionengine.h"
 
 using namespace upm;
 using namespace std;
@@ -37,10 +39,11 @@ StepMotor::StepMotor (int dirPin, int stePin, int steps, int enPin)
                     : m_dirPinCtx(dirPin),
                       m_stePinCtx(stePin),
                       m_enPinCtx(0),
-                      m_steps(steps) {
+                      m_steps(steps),
+                      m_position(0),
+                      m_dir(0),
+                      m_axis(0) {
     m_name = "StepMotor";
-    setSpeed(60);
-    setPosition(0);
 
     if (m_dirPinCtx.dir(mraa::DIR_OUT) != mraa::SUCCESS) {
         throw std::runtime_error(string(__FUNCTION__) +
@@ -68,9 +71,14 @@ StepMotor::StepMotor (int dirPin, int stePin, int steps, int enPin)
         m_enPinCtx->useMmap(true);
         enable(true);
     }
+
+    m_axis = new MotionAxis(&stepCallback, this);
+    setSpeed(60);
+    setPosition(0);
 }
 
 StepMotor::~StepMotor () {
+    delete m_axis;
     if (m_enPinCtx)
         delete m_enPinCtx;
 }
@@ -89,6 +97,7 @@ void
 StepMotor::setSpeed (int speed) {
     if (speed > 0) {
         m_delay = 60000000 / (speed * m_steps);
+        m_axis->setMaxSpeed(double(speed) * m_steps / 60.0);
     } else {
         throw std::invalid_argument(string(__FUNCTION__) +
                                     ": Parameter must be greater than 0");
@@ -106,28 +115,19 @@ StepMotor::step (int ticks) {
 
 mraa::Result
 StepMotor::stepForward (int ticks) {
-    dirForward();
-    for (int i = 0; i < ticks; i++) {
-        move();
-        m_position++;
-        delayus(m_delay - MINPULSE_US - OVERHEAD_US);
-    }
+    m_axis->waitMove(m_axis->move(ticks));
     return mraa::SUCCESS;
 }
 
 mraa::Result
 StepMotor::stepBackward (int ticks) {
-    dirBackward();
-    for (int i = 0; i < ticks; i++) {
-        move();
-        m_position--;
-        delayus(m_delay - MINPULSE_US - OVERHEAD_US);
-    }
+    m_axis->waitMove(m_axis->move(-ticks));
     return mraa::SUCCESS;
 }
 
 void
 StepMotor::setPosition (int pos) {
+    m_axis->setPosition(pos);
     m_position = pos;
 }
 
@@ -149,6 +149,22 @@ StepMotor::move () {
     m_stePinCtx.write(0);
 }
 
+void
+StepMotor::stepCallback (int dir, void *ctx) {
+    StepMotor *This = (StepMotor *)ctx;
+
+    if (dir != This->m_dir) {
+        if (dir > 0)
+            This->dirForward();
+        else
+            This->dirBackward();
+        This->m_dir = dir;
+    }
+
+    This->move();
+    This->m_position += dir;
+}
+
 mraa::Result
 StepMotor::dirForward () {
     mraa::Result error = m_dirPinCtx.write(HIGH);
@@ -170,16 +186,11 @@ StepMotor::dirBackward () {
 }
 
 void upm::StepMotor::delayus (int us) {
-    int diff = 0;
-    struct timespec gettime_now;
-
-    clock_gettime(CLOCK_REALTIME, &gettime_now);
-    int start = gettime_now.tv_nsec;
-    while (diff < us * 1000)
-    {
-        clock_gettime(CLOCK_REALTIME, &gettime_now);
-        diff = gettime_now.tv_nsec - start;
-        if (diff < 0)
-            diff += 1000000000;
-    }
+    // sleeps at least us microseconds, instead of spinning
+    struct timespec ts;
+
+    ts.tv_sec = us / 1000000;
+    ts.tv_nsec = (us % 1000000) * 1000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR)
+        ;
 }
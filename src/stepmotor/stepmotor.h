@@ -39,6 +39,8 @@
 #define LOW             0
 
 namespace upm {
+class MotionAxis;
+
 /**
  * @brief Stepper Motor library
  * @defgroup stepmotor libupm-stepmotor
@@ -61,12 +63,13 @@ namespace upm {
  * Driver from Brian Schmalz or the STR driver series from Applied Motion. It
  * can also control an enable pin if one is available and connected.
  *
- * The implementation is synchronous and thus blocking while the stepper motor
- * is in motion. However it is possible to send the commands via threading and
- * the performance of the library will be very good given a low CPU load. On a
- * busy system though you will notice some jitter especially at higher speeds.
- * It is possible to reduce this effect to some extent by using smoothing
- * and/or microstepping on stepper drivers that support such features.
+ * The step pulses are generated by the shared motion engine thread.
+ * The step() methods sleep until the move is complete; moves can
+ * also be queued without blocking, with acceleration, through
+ * getMotionAxis(). On a busy system you will notice some jitter
+ * especially at higher speeds. It is possible to reduce this effect
+ * to some extent by using smoothing and/or microstepping on stepper
+ * drivers that support such features.
  *
  * @image html stepmotor.jpg
  * <br><em>EasyDriver Sensor image provided by SparkFun* under
@@ -153,6 +156,15 @@ class StepMotor {
          */
         int getStep ();
 
+        /**
+         * Returns the motion engine axis driving the motor.  Moves
+         * queued on it do not block, and can use an acceleration
+         * ramp.  Speeds on the axis are in steps per second.
+         *
+         * @return Motion axis
+         */
+        MotionAxis *getMotionAxis () { return m_axis; };
+
     private:
         std::string         m_name;
 
@@ -163,10 +175,13 @@ class StepMotor {
         int                 m_delay;
         int                 m_steps;
         int                 m_position;
+        int                 m_dir;
+        MotionAxis          *m_axis;
 
         mraa::Result dirForward ();
         mraa::Result dirBackward ();
         void move ();
         void delayus (int us);
+        static void stepCallback (int dir, void *ctx);
     };
 }
@@ -28,6 +28,8 @@
 #include <sstream>
 #include <string>
 #include <string.h>
+#include <time.h>
+#include <errno.h>
 
 #include "sx1276.h"
 
@@ -43,6 +45,24 @@ typedef struct
   uint8_t  RegValue;
 } FskBandwidth_t;
 
+// how long the FSK receiver is given to settle before its RSSI is
+// used for listen-before-talk
+static const uint64_t FSK_LBT_SETTLE_US = 1000;
+
+static uint64_t getMonotonicUs()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void toTimespec(uint64_t us, struct timespec *ts)
+{
+  ts->tv_sec = us / 1000000;
+  ts->tv_nsec = (us % 1000000) * 1000;
+}
+
 static const FskBandwidth_t FskBandwidths[] =
 {       
   { 2600  , 0x17 },   
@@ -88,6 +108,23 @@ SX1276::SX1276(uint8_t chipRev, int bus, int cs, int resetPin, int dio0,
   // 10ms for POR
   usleep(10000);
 
+  m_capture = NULL;
+  invalidateShadow();
+
+  m_async = false;
+  m_rxHead = 0;
+  m_rxCount = 0;
+  m_txHead = 0;
+  m_txCount = 0;
+  m_txActive = false;
+  m_lbtEnabled = false;
+  m_lbtRssiThresh = -90;
+  m_lbtBackoffUs = 10000;
+  m_lbtRetryUs = 0;
+  m_asyncTxTimeoutUs = 3000000;
+  m_txDeadlineUs = 0;
+  memset(&m_asyncStats, 0, sizeof(ASYNC_STATS_T));
+
   // setup the interrupt handlers.  All 6 of them.
   m_gpioDIO0.dir(mraa::DIR_IN);
   if (m_gpioDIO0.isr(mraa::EDGE_RISING, onDio0Irq, this))
@@ -153,16 +190,45 @@ SX1276::SX1276(uint8_t chipRev, int bus, int cs, int resetPin, int dio0,
 
   pthread_mutexattr_destroy(&mutexAttrib);
 
+  pthread_condattr_t condAttrib;
+  pthread_condattr_init(&condAttrib);
+  pthread_condattr_setclock(&condAttrib, CLOCK_MONOTONIC);
+
+  if (pthread_cond_init(&m_asyncCond, &condAttrib))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_cond_init(asyncCond) failed");
+    }
+
+  pthread_condattr_destroy(&condAttrib);
+
   init();
 }
 
 SX1276::~SX1276()
 {
+  stopAsync();
+
+  pthread_cond_destroy(&m_asyncCond);
   pthread_mutex_destroy(&m_intrLock);
 }
 
 uint8_t SX1276::readReg(uint8_t reg)
 {
+  bool lora = (m_capture) ? m_captureLora : m_loraPage;
+  int idx = shadowIndex(reg, lora);
+
+  if (m_capture && m_capture->dirty[idx])
+    return m_capture->regs[idx];
+
+  // recording a profile for the other modem, the device can't be
+  // asked, so use what we last saw
+  if (lora != m_loraPage && isBankedReg(reg))
+    return m_regShadow[idx];
+
+  if (m_regCached[idx] && !isVolatileReg(reg, lora))
+    return m_regShadow[idx];
+
   uint8_t pkt[2] = {(reg & 0x7f), 0};
 
   csOn();
@@ -175,11 +241,36 @@ uint8_t SX1276::readReg(uint8_t reg)
     }
   csOff();
 
+  m_regShadow[idx] = pkt[1];
+  m_regCached[idx] = true;
+
+  if (reg == COM_RegOpMode)
+    m_loraPage = isLoraPage(pkt[1]);
+
   return pkt[1];
 }
-
 bool SX1276::writeReg(uint8_t reg, uint8_t val)
 {
+  if (m_capture)
+    {
+      int idx = shadowIndex(reg, m_captureLora);
+
+      m_capture->regs[idx] = val;
+      m_capture->dirty[idx] = true;
+
+      if (reg == COM_RegOpMode)
+        m_captureLora = isLoraPage(val);
+
+      return true;
+    }
+
+  int idx = shadowIndex(reg, m_loraPage);
+
+  // already there
+  if (m_regCached[idx] && m_regShadow[idx] == val &&
+      !isVolatileReg(reg, m_loraPage))
+    return true;
+
   uint8_t pkt[2] = {reg | m_writeMode, val};
 
   csOn();
@@ -192,9 +283,259 @@ bool SX1276::writeReg(uint8_t reg, uint8_t val)
     }
   csOff();
 
+  m_regShadow[idx] = val;
+  m_regCached[idx] = true;
+
+  if (reg == COM_RegOpMode)
+    {
+      m_loraPage = isLoraPage(val);
+      if (!m_pageLoaded[m_loraPage])
+        loadPage(m_loraPage);
+    }
+
   return true;
 }
 
+void SX1276::readRegs(uint8_t reg, uint8_t *buffer, int len)
+{
+  uint8_t pkt = (reg & 0x7f);
+
+  csOn();
+  if (m_spi.transfer(&pkt, NULL, 1))
+    {
+      csOff();
+      throw std::runtime_error(string(__FUNCTION__) +
+                               ": Spi.transfer(0) failed");
+      return;
+    }
+
+  if (m_spi.transfer(NULL, buffer, len))
+    {
+      csOff();
+      throw std::runtime_error(string(__FUNCTION__) +
+                               ": Spi.transfer(buf) failed");
+      return;
+    }
+  csOff();
+}
+
+void SX1276::writeRegs(uint8_t reg, uint8_t *buffer, int len)
+{
+  // a modem switch part way through would move the bank under us
+  if (m_capture || 
+      (reg <= COM_RegOpMode && (reg + len) > COM_RegOpMode))
+    {
+      for (int i = 0; i < len; i++)
+        writeReg(reg + i, buffer[i]);
+      return;
+    }
+
+  bool changed = false;
+  for (int i = 0; i < len; i++)
+    {
+      int idx = shadowIndex(reg + i, m_loraPage);
+
+      if (!m_regCached[idx] || m_regShadow[idx] != buffer[i] ||
+          isVolatileReg(reg + i, m_loraPage))
+        {
+          changed = true;
+          break;
+        }
+    }
+
+  if (!changed)
+    return;
+
+  uint8_t pkt = (reg | m_writeMode);
+
+  csOn();
+  if (m_spi.transfer(&pkt, NULL, 1))
+    {
+      csOff();
+      throw std::runtime_error(string(__FUNCTION__) +
+                               ": Spi.transfer(0) failed");
+      return;
+    }
+
+  if (m_spi.transfer(buffer, NULL, len))
+    {
+      csOff();
+      throw std::runtime_error(string(__FUNCTION__) +
+                               ": Spi.transfer(buf) failed");
+      return;
+    }
+  csOff();
+
+  for (int i = 0; i < len; i++)
+    {
+      int idx = shadowIndex(reg + i, m_loraPage);
+
+      m_regShadow[idx] = buffer[i];
+      m_regCached[idx] = true;
+    }
+}
+
+bool SX1276::isBankedReg(uint8_t reg)
+{
+  return ( (reg >= FSK_RegBitrateMsb && reg <= FSK_RegFdevLsb) ||
+           (reg >= FSK_RegRxConfig && reg <= FSK_RegIrqFlags2) );
+}
+
+bool SX1276::isVolatileReg(uint8_t reg, bool lora)
+{
+  switch (reg)
+    {
+    case COM_RegFifo:
+    case COM_RegOpMode:         // the mode changes on its own after tx/rx
+    case COM_RegVersion:
+    case COM_RegFormerTemp:
+      return true;
+
+    default:
+      break;
+    }
+
+  if (!isBankedReg(reg))
+    return false;
+
+  if (lora)
+    {
+      switch (reg)
+        {
+        case LOR_RegFifoAddrPtr:
+        case LOR_RegFifoRxCurrentAddr:
+        case LOR_RegIrqFlags:
+        case LOR_RegRxNbBytes:
+        case LOR_RegRxHeaderCntValueMsb:
+        case LOR_RegRxHeaderCntValueLsb:
+        case LOR_RegRxPacketCntValueMsb:
+        case LOR_RegRxPacketCntValueLsb:
+        case LOR_RegModemStat:
+        case LOR_RegPktSnrValue:
+        case LOR_RegPktRssiValue:
+        case LOR_RegRssiValue:
+        case LOR_RegHopChannel:
+        case LOR_RegFifoRxByteAddr:
+        case LOR_RegFeiMsb:
+        case LOR_RegFeiMid:
+        case LOR_RegFeiLsb:
+        case LOR_RegRssiWideband:
+          return true;
+
+        default:
+          return false;
+        }
+    }
+
+  switch (reg)
+    {
+    case FSK_RegRxConfig:       // RestartRx* bits are triggers
+    case FSK_RegRssiValue:
+    case FSK_RegAfcFei:         // AfcClear/AgcStart are triggers
+    case FSK_RegAfcMsb:
+    case FSK_RegAfcLsb:
+    case FSK_RegFeiMsb:
+    case FSK_RegFeiLsb:
+    case FSK_RegSeqConfig1:     // sequencer start/stop are triggers
+    case FSK_RegImageCal:
+    case FSK_RegTemp:
+    case FSK_RegIrqFlags1:
+    case FSK_RegIrqFlags2:
+      return true;
+
+    default:
+      return false;
+    }
+}
+
+int SX1276::shadowIndex(uint8_t reg, bool lora)
+{
+  reg &= 0x7f;
+
+  if (lora && isBankedReg(reg))
+    return (0x80 | reg);
+
+  return reg;
+}
+
+bool SX1276::isLoraPage(uint8_t opMode)
+{
+  return ( (opMode & OPMODE_LongRangeMode) &&
+           !(opMode & OPMODE_LOR_AccessSharedReg) );
+}
+
+void SX1276::invalidateShadow()
+{
+  memset(m_regShadow, 0, sizeof(m_regShadow));
+  memset(m_regCached, 0, sizeof(m_regCached));
+
+  // the device comes out of reset in FSK mode
+  m_loraPage = false;
+  m_pageLoaded[0] = false;
+  m_pageLoaded[1] = false;
+}
+
+void SX1276::loadPage(bool lora)
+{
+  uint8_t buf[COM_RegVersion];
+
+  if (!lora)
+    {
+      // everything from RegOpMode to RegVersion is defined in FSK
+      // mode, so grab it in one go
+      int len = COM_RegVersion - COM_RegOpMode + 1;
+
+      readRegs(COM_RegOpMode, buf, len);
+      for (int i = 0; i < len; i++)
+        {
+          m_regShadow[COM_RegOpMode + i] = buf[i];
+          m_regCached[COM_RegOpMode + i] = true;
+        }
+    }
+  else
+    {
+      // the LoRa bank has reserved holes past RegModemConfig3, so
+      // only the documented registers there are read individually
+      static const uint8_t sparse[] = {
+        LOR_Reserved2f, LOR_RegDetectOptimize, LOR_RegInvertIQ,
+        LOR_RegDetectionThreshold, LOR_RegSyncWord, LOR_RegInvertIQ2
+      };
+      int len = LOR_RegModemConfig3 - LOR_RegFifoAddrPtr + 1;
+
+      readRegs(LOR_RegFifoAddrPtr, buf, len);
+      for (int i = 0; i < len; i++)
+        {
+          int idx = shadowIndex(LOR_RegFifoAddrPtr + i, true);
+
+          m_regShadow[idx] = buf[i];
+          m_regCached[idx] = true;
+        }
+
+      for (unsigned int i = 0; i < sizeof(sparse); i++)
+        {
+          int idx = shadowIndex(sparse[i], true);
+
+          m_regShadow[idx] = readReg(sparse[i]);
+          m_regCached[idx] = true;
+        }
+    }
+
+  m_pageLoaded[lora] = true;
+}
+
+uint8_t SX1276::shadowReg(uint8_t reg)
+{
+  bool lora = (m_capture) ? m_captureLora : m_loraPage;
+  int idx = shadowIndex(reg, lora);
+
+  if (m_capture && m_capture->dirty[idx])
+    return m_capture->regs[idx];
+
+  if (m_regCached[idx])
+    return m_regShadow[idx];
+
+  return readReg(reg);
+}
 void SX1276::readFifo(uint8_t *buffer, int len)
 {
   // can't read more than 256 bytes
@@ -270,6 +611,9 @@ void SX1276::reset()
   usleep(1000); // 1ms
   m_gpioReset.dir(mraa::DIR_IN);
   usleep(10000); // 10ms
+
+  // every register is back at its default
+  invalidateShadow();
 }
 
 
@@ -303,6 +647,8 @@ void SX1276::init()
 
   reset();
 
+  loadPage(isLoraPage(readReg(COM_RegOpMode)));
+
   rxChainCalibration();
 
   setOpMode(MODE_Sleep);
@@ -371,26 +717,29 @@ void SX1276::setChannel(uint32_t freq)
 
   freq = ( uint32_t )( ( double )freq / FXOSC_STEP );
 
-  writeReg(COM_RegFrfMsb, ( uint8_t )( ( freq >> 16 ) & 0xff ) );
-  writeReg(COM_RegFrfMid, ( uint8_t )( ( freq >> 8 ) & 0xff ) );
-  writeReg(COM_RegFrfLsb, ( uint8_t )( freq & 0xff ) );
+  // one burst, the new frequency takes effect when FrfLsb is written
+  uint8_t frf[3] = {
+    ( uint8_t )( ( freq >> 16 ) & 0xff ),
+    ( uint8_t )( ( freq >> 8 ) & 0xff ),
+    ( uint8_t )( freq & 0xff )
+  };
+
+  writeRegs(COM_RegFrfMsb, frf, 3);
 }
 
 void SX1276::setOpMode(MODE_T opMode)
 {
-  static uint8_t opModePrev = MODE_Standby;
-  
-  if(opMode != opModePrev)
+  // only the mode bits change, the rest come from the shadow
+  uint8_t reg = shadowReg(COM_RegOpMode);
+
+  if ((reg & (_OPMODE_Mode_MASK << _OPMODE_Mode_SHIFT)) != 
+      (opMode << _OPMODE_Mode_SHIFT))
     {
-      opModePrev = opMode;
+      reg &= ~(_OPMODE_Mode_MASK << _OPMODE_Mode_SHIFT);
 
-      uint8_t reg = readReg(COM_RegOpMode) & 
-        ~(_OPMODE_Mode_MASK << _OPMODE_Mode_SHIFT);
-      
       writeReg(COM_RegOpMode, (reg | (opMode << _OPMODE_Mode_SHIFT)) );
     }
 }
-
 void SX1276::setModem(RADIO_MODEM_T modem)
 {
   if (m_settings.modem == modem )
@@ -409,7 +758,7 @@ void SX1276::setModem(RADIO_MODEM_T modem)
       setOpMode(MODE_Sleep);
 
       // turn off lora
-      reg = (readReg(COM_RegOpMode) & ~OPMODE_LongRangeMode);
+      reg = (shadowReg(COM_RegOpMode) & ~OPMODE_LongRangeMode);
       writeReg(COM_RegOpMode, reg);
       
       writeReg(COM_RegDioMapping1, 0x00);
@@ -420,7 +769,7 @@ void SX1276::setModem(RADIO_MODEM_T modem)
     case MODEM_LORA:
       setOpMode(MODE_Sleep);
       // turn lora on
-      reg = (readReg(COM_RegOpMode) | OPMODE_LongRangeMode);
+      reg = (shadowReg(COM_RegOpMode) | OPMODE_LongRangeMode);
       writeReg(COM_RegOpMode, reg);
       
       writeReg(COM_RegDioMapping1, 0x00);
@@ -547,6 +896,16 @@ SX1276::RADIO_EVENT_T SX1276::sendStr(string buffer, int timeout)
 SX1276::RADIO_EVENT_T SX1276::send(uint8_t *buffer, uint8_t size, 
                                    int txTimeout)
 {
+  loadTx(buffer, size);
+
+  return setTx(txTimeout);
+}
+
+void SX1276::loadTx(uint8_t *buffer, uint8_t size)
+{
+  // keep a copy, the FSK FifoLevel interrupt refills the FIFO from it
+  memcpy(m_txBuffer, buffer, size);
+
   switch (m_settings.modem)
     {
     case MODEM_FSK:
@@ -573,7 +932,7 @@ SX1276::RADIO_EVENT_T SX1276::send(uint8_t *buffer, uint8_t size,
           }
 
         // Write payload buffer
-        writeFifo(buffer, m_settings.fskPacketHandler.ChunkSize);
+        writeFifo(m_txBuffer, m_settings.fskPacketHandler.ChunkSize);
         m_settings.fskPacketHandler.NbBytes += 
           m_settings.fskPacketHandler.ChunkSize;
       }
@@ -623,13 +982,11 @@ SX1276::RADIO_EVENT_T SX1276::send(uint8_t *buffer, uint8_t size,
           }
 
         // Write payload buffer
-        writeFifo(buffer, size);
+        writeFifo(m_txBuffer, size);
       }
 
       break;
     }
-
-  return setTx(txTimeout);
 }
 
 
@@ -1165,6 +1522,23 @@ void SX1276::setTxConfig(RADIO_MODEM_T modem, int8_t power,
 }
 
 SX1276::RADIO_EVENT_T SX1276::setTx(int timeout)
+{
+  armTx();
+
+  initClock();
+  while ((getMillis() < timeout) && m_radioEvent == REVENT_EXEC)
+    usleep(100);
+
+  if (m_radioEvent == REVENT_EXEC)
+    {
+      // timeout
+      m_radioEvent = REVENT_TIMEOUT;
+    }
+
+  return m_radioEvent;
+}
+
+void SX1276::armTx()
 {
   uint8_t reg = 0;
 
@@ -1256,6 +1630,11 @@ SX1276::RADIO_EVENT_T SX1276::setTx(int timeout)
   m_radioEvent = REVENT_EXEC;
 
   setOpMode(MODE_TxMode);
+}
+
+SX1276::RADIO_EVENT_T SX1276::setRx(uint32_t timeout)
+{
+  armRx();
 
   initClock();
   while ((getMillis() < timeout) && m_radioEvent == REVENT_EXEC)
@@ -1270,7 +1649,7 @@ SX1276::RADIO_EVENT_T SX1276::setTx(int timeout)
   return m_radioEvent;
 }
 
-SX1276::RADIO_EVENT_T SX1276::setRx(uint32_t timeout)
+void SX1276::armRx()
 {
   bool rxContinuous = false;
   uint8_t reg = 0;
@@ -1494,18 +1873,6 @@ SX1276::RADIO_EVENT_T SX1276::setRx(uint32_t timeout)
           setOpMode(MODE_LOR_RxSingle);
         }
     }
-
-  initClock();
-  while ((getMillis() < timeout) && m_radioEvent == REVENT_EXEC)
-    usleep(100);
-
-  if (m_radioEvent == REVENT_EXEC)
-    {
-      // timeout
-      m_radioEvent = REVENT_TIMEOUT;
-    }
-
-  return m_radioEvent;
 }
 
 
@@ -1573,6 +1940,7 @@ void SX1276::setMaxPayloadLength(RADIO_MODEM_T modem, uint8_t max)
 void SX1276::onDio0Irq(void *ctx)
 {
   upm::SX1276 *This = (upm::SX1276 *)ctx;
+  uint64_t now = getMonotonicUs();
 
   This->lockIntrs();
 
@@ -1617,6 +1985,8 @@ void SX1276::onDio0Irq(void *ctx)
                   // RxError radio event
                   //                  cerr << __FUNCTION__ << ": RxError crc/sync timeout" << endl;
                   This->m_radioEvent = REVENT_ERROR;
+                  if (This->m_async)
+                    This->m_asyncStats.rxErrors++;
 
                   This->m_settings.fskPacketHandler.PreambleDetected = false;
                   This->m_settings.fskPacketHandler.SyncWordDetected = false;
@@ -1678,6 +2048,10 @@ void SX1276::onDio0Irq(void *ctx)
           This->m_rxRSSI = This->m_settings.fskPacketHandler.RssiValue;
           This->m_rxLen = This->m_settings.fskPacketHandler.Size;
           This->m_radioEvent = REVENT_DONE;
+          if (This->m_async)
+            This->pushRxPacket(now, 
+                               This->m_settings.fskPacketHandler.RssiValue,
+                               0);
           // cerr << __FUNCTION__ << ": FSK RxDone" << endl;
           // fprintf(stderr, "### %s: RX(%d): %s\n", 
           //         __FUNCTION__, 
@@ -1713,6 +2087,8 @@ void SX1276::onDio0Irq(void *ctx)
                 // RxError radio event
                 // cerr << __FUNCTION__ << ": RxError (payload crc error)" << endl;
                 This->m_radioEvent = REVENT_ERROR;
+                if (This->m_async)
+                  This->m_asyncStats.rxErrors++;
 
                 break;
               }
@@ -1772,6 +2148,11 @@ void SX1276::onDio0Irq(void *ctx)
             // cerr << "LORA MAXPAYLOAD = " 
             //      <<  (int)This->readReg(LOR_RegMaxPayloadLength) << endl;
 
+            // in continuous mode, each packet lands wherever the
+            // previous one left off in the FIFO
+            This->writeReg(LOR_RegFifoAddrPtr, 
+                           This->readReg(LOR_RegFifoRxCurrentAddr));
+
             This->readFifo(This->m_rxBuffer, 
                            This->m_settings.loraPacketHandler.Size);
 
@@ -1790,6 +2171,10 @@ void SX1276::onDio0Irq(void *ctx)
             This->m_rxSNR = (int)snr;
             This->m_rxLen = This->m_settings.loraPacketHandler.Size;
             This->m_radioEvent = REVENT_DONE;
+            if (This->m_async)
+              This->pushRxPacket(now,
+                                 This->m_settings.loraPacketHandler.RssiValue,
+                                 (int)snr);
             // if (This->m_settings.state == STATE_RX_RUNNING)
             //   fprintf(stderr, "### %s: snr = %d rssi = %d RX(%d): %s\n", 
             //           __FUNCTION__, 
@@ -1809,6 +2194,10 @@ void SX1276::onDio0Irq(void *ctx)
 
         }
 
+      // the end of a packet is a good time to send a deferred one
+      if (This->m_async && This->m_txCount)
+        This->kickTx(now);
+
       break;
 
     case STATE_TX_RUNNING:
@@ -1831,6 +2220,10 @@ void SX1276::onDio0Irq(void *ctx)
           This->m_radioEvent = REVENT_DONE;
           //          cerr << __FUNCTION__ << ": TxDone" << endl;
 
+          // send the next queued packet, or go back to receiving
+          if (This->m_async)
+            This->finishTx(now, true);
+
           break;
         }
       break;
@@ -1922,7 +2315,7 @@ void SX1276::onDio1Irq(void *ctx)
                 This->m_settings.fskPacketHandler.NbBytes) > 
                This->m_settings.fskPacketHandler.ChunkSize)
             {
-              This->writeFifo((This->m_rxBuffer + 
+              This->writeFifo((This->m_txBuffer + 
                                This->m_settings.fskPacketHandler.NbBytes), 
                               This->m_settings.fskPacketHandler.ChunkSize);
               This->m_settings.fskPacketHandler.NbBytes += 
@@ -1931,7 +2324,7 @@ void SX1276::onDio1Irq(void *ctx)
           else 
             {
               // Write the last chunk of data
-              This->writeFifo((This->m_rxBuffer +
+              This->writeFifo((This->m_txBuffer +
                                This->m_settings.fskPacketHandler.NbBytes),
                               This->m_settings.fskPacketHandler.Size - 
                               This->m_settings.fskPacketHandler.NbBytes);
@@ -2039,6 +2432,7 @@ void SX1276::onDio2Irq(void *ctx)
 void SX1276::onDio3Irq(void *ctx)
 {
   upm::SX1276 *This = (upm::SX1276 *)ctx;
+  uint64_t now = getMonotonicUs();
 
   This->lockIntrs();
   //  cerr << __FUNCTION__ << ": Enter" << endl;
@@ -2057,6 +2451,18 @@ void SX1276::onDio3Irq(void *ctx)
           // CADDetected radio event (true)
           // cerr << __FUNCTION__ << ": CadDetected (LORA)" << endl;
 
+          // someone is talking, listen and retry after the backoff
+          if (This->m_async && This->m_txActive &&
+              This->m_settings.state == STATE_CAD)
+            {
+              This->m_txActive = false;
+              This->m_asyncStats.lbtBusy++;
+              This->m_lbtRetryUs = now + This->m_lbtBackoffUs;
+              This->m_settings.state = STATE_IDLE;
+              This->kickTx(now);
+              pthread_cond_broadcast(&This->m_asyncCond);
+            }
+
         }
       else
         {
@@ -2064,6 +2470,11 @@ void SX1276::onDio3Irq(void *ctx)
           This->writeReg(LOR_RegIrqFlags, LOR_IRQFLAG_CadDone);
           // CADDetected radio event (false)
           //cerr << __FUNCTION__ << ": CadDone (LORA)" << endl;
+
+          // channel is clear
+          if (This->m_async && This->m_txActive &&
+              This->m_settings.state == STATE_CAD)
+            This->startQueuedTx();
         }
 
       break;
@@ -2158,3 +2569,530 @@ uint32_t SX1276::getMillis()
 }
 
 
+
+void SX1276::startAsync(int rxDepth, int txDepth)
+{
+  if (rxDepth < 1 || txDepth < 1)
+    throw std::range_error(string(__FUNCTION__) +
+                           ": rxDepth and txDepth must be at least 1");
+
+  stopAsync();
+
+  lockIntrs();
+
+  m_rxQueue.assign(rxDepth, RX_PACKET_T());
+  m_rxHead = 0;
+  m_rxCount = 0;
+  m_txQueue.assign(txDepth, TX_PACKET_T());
+  m_txHead = 0;
+  m_txCount = 0;
+  m_txActive = false;
+  m_lbtRetryUs = 0;
+
+  // the receiver must stay up between packets
+  m_fskRxContinuous = m_settings.fskSettings.RxContinuous;
+  m_loraRxContinuous = m_settings.loraSettings.RxContinuous;
+  m_settings.fskSettings.RxContinuous = true;
+  m_settings.loraSettings.RxContinuous = true;
+
+  setStandby();
+  m_async = true;
+  armRx();
+
+  unlockIntrs();
+
+  if (pthread_create(&m_asyncThread, NULL, asyncThread, this))
+    {
+      lockIntrs();
+      m_async = false;
+      m_settings.fskSettings.RxContinuous = m_fskRxContinuous;
+      m_settings.loraSettings.RxContinuous = m_loraRxContinuous;
+      setStandby();
+      unlockIntrs();
+
+      throw std::runtime_error(string(__FUNCTION__) +
+                               ": pthread_create() failed");
+    }
+}
+
+void SX1276::stopAsync()
+{
+  lockIntrs();
+
+  if (!m_async)
+    {
+      unlockIntrs();
+      return;
+    }
+
+  m_async = false;
+  pthread_cond_broadcast(&m_asyncCond);
+
+  unlockIntrs();
+
+  pthread_join(m_asyncThread, NULL);
+
+  lockIntrs();
+
+  m_txCount = 0;
+  m_txActive = false;
+  m_settings.fskSettings.RxContinuous = m_fskRxContinuous;
+  m_settings.loraSettings.RxContinuous = m_loraRxContinuous;
+  setStandby();
+
+  // release anyone still in waitPacket()/waitTxIdle()
+  pthread_cond_broadcast(&m_asyncCond);
+
+  unlockIntrs();
+}
+
+void SX1276::setListenBeforeTalk(bool enable, int16_t rssiThresh,
+                                 int backoffMs)
+{
+  if (backoffMs < 0)
+    backoffMs = 0;
+
+  lockIntrs();
+  m_lbtEnabled = enable;
+  m_lbtRssiThresh = rssiThresh;
+  m_lbtBackoffUs = (uint64_t)backoffMs * 1000;
+  unlockIntrs();
+}
+
+void SX1276::setAsyncTxTimeout(int timeout)
+{
+  if (timeout < 1)
+    throw std::range_error(string(__FUNCTION__) +
+                           ": timeout must be at least 1ms");
+
+  lockIntrs();
+  m_asyncTxTimeoutUs = (uint64_t)timeout * 1000;
+  unlockIntrs();
+}
+
+bool SX1276::queueTx(uint8_t *buffer, uint8_t size)
+{
+  lockIntrs();
+
+  if (!m_async)
+    {
+      unlockIntrs();
+      throw std::logic_error(string(__FUNCTION__) +
+                             ": startAsync() has not been called");
+    }
+
+  if (m_txCount >= (int)m_txQueue.size())
+    {
+      unlockIntrs();
+      return false;
+    }
+
+  TX_PACKET_T *pkt = &m_txQueue[(m_txHead + m_txCount) % m_txQueue.size()];
+
+  memcpy(pkt->data, buffer, size);
+  pkt->len = size;
+  m_txCount++;
+
+  kickTx(getMonotonicUs());
+  pthread_cond_broadcast(&m_asyncCond);
+
+  unlockIntrs();
+
+  return true;
+}
+
+bool SX1276::queueTxStr(string buffer)
+{
+  if (buffer.size() > (FIFO_SIZE - 1))
+    throw std::range_error(string(__FUNCTION__) +
+                           ": buffer size must be less than 256");
+
+  // same padding as sendStr()
+  while (buffer.size() < 64)
+    buffer.push_back(0);
+
+  return queueTx((uint8_t *)buffer.c_str(), buffer.size());
+}
+
+int SX1276::rxAvailable()
+{
+  lockIntrs();
+  int count = m_rxCount;
+  unlockIntrs();
+
+  return count;
+}
+
+bool SX1276::readPacket(RX_PACKET_T *pkt)
+{
+  lockIntrs();
+
+  if (!m_rxCount)
+    {
+      unlockIntrs();
+      return false;
+    }
+
+  *pkt = m_rxQueue[m_rxHead];
+  m_rxHead = (m_rxHead + 1) % m_rxQueue.size();
+  m_rxCount--;
+
+  unlockIntrs();
+
+  return true;
+}
+
+bool SX1276::waitPacket(RX_PACKET_T *pkt, int timeout)
+{
+  struct timespec deadline;
+  toTimespec(getMonotonicUs() + (uint64_t)timeout * 1000, &deadline);
+
+  lockIntrs();
+
+  while (!m_rxCount && m_async)
+    {
+      if (pthread_cond_timedwait(&m_asyncCond, &m_intrLock, &deadline)
+          == ETIMEDOUT)
+        break;
+    }
+
+  unlockIntrs();
+
+  return readPacket(pkt);
+}
+
+int SX1276::txPending()
+{
+  lockIntrs();
+  int count = m_txCount;
+  unlockIntrs();
+
+  return count;
+}
+
+bool SX1276::waitTxIdle(int timeout)
+{
+  struct timespec deadline;
+  toTimespec(getMonotonicUs() + (uint64_t)timeout * 1000, &deadline);
+
+  lockIntrs();
+
+  while (m_txCount && m_async)
+    {
+      if (pthread_cond_timedwait(&m_asyncCond, &m_intrLock, &deadline)
+          == ETIMEDOUT)
+        break;
+    }
+
+  bool idle = (m_txCount == 0);
+
+  unlockIntrs();
+
+  return idle;
+}
+
+SX1276::ASYNC_STATS_T SX1276::getAsyncStats()
+{
+  lockIntrs();
+  ASYNC_STATS_T stats = m_asyncStats;
+  unlockIntrs();
+
+  return stats;
+}
+
+void SX1276::resetAsyncStats()
+{
+  lockIntrs();
+  memset(&m_asyncStats, 0, sizeof(ASYNC_STATS_T));
+  unlockIntrs();
+}
+
+void SX1276::pushRxPacket(uint64_t timestamp, int rssi, int snr)
+{
+  if (m_rxCount >= (int)m_rxQueue.size())
+    {
+      // drop the newest, the application hasn't kept up
+      m_asyncStats.rxOverflows++;
+      return;
+    }
+
+  RX_PACKET_T *pkt = &m_rxQueue[(m_rxHead + m_rxCount) % m_rxQueue.size()];
+
+  memcpy(pkt->data, m_rxBuffer, m_rxLen);
+  pkt->len = m_rxLen;
+  pkt->rssi = rssi;
+  pkt->snr = snr;
+  pkt->timestamp = timestamp;
+
+  m_rxCount++;
+  m_asyncStats.rxPackets++;
+
+  pthread_cond_broadcast(&m_asyncCond);
+}
+
+void SX1276::kickTx(uint64_t now)
+{
+  // a transmission (or its CAD) is already in progress
+  if (m_txActive)
+    return;
+
+  if (m_txCount && now >= m_lbtRetryUs)
+    {
+      if (!m_lbtEnabled)
+        {
+          startQueuedTx();
+          return;
+        }
+
+      if (m_settings.modem == MODEM_LORA)
+        {
+          // the deadline also covers a CadDone that never arrives
+          m_txActive = true;
+          m_txDeadlineUs = now + m_asyncTxTimeoutUs;
+          setStandby();
+          startCAD();
+          return;
+        }
+
+      // FSK, the RSSI is only meaningful once the receiver has settled
+      if (m_settings.state != STATE_RX_RUNNING)
+        {
+          armRx();
+          m_lbtRetryUs = now + FSK_LBT_SETTLE_US;
+          return;
+        }
+
+      if (-(readReg(FSK_RegRssiValue) >> 1) > m_lbtRssiThresh)
+        {
+          m_asyncStats.lbtBusy++;
+          m_lbtRetryUs = now + m_lbtBackoffUs;
+          return;
+        }
+
+      startQueuedTx();
+      return;
+    }
+
+  // nothing to send (yet), keep listening
+  if (m_settings.state == STATE_IDLE)
+    armRx();
+}
+
+void SX1276::startQueuedTx()
+{
+  TX_PACKET_T *pkt = &m_txQueue[m_txHead];
+
+  // the FIFO can't be loaded while the receiver owns it
+  setStandby();
+  loadTx(pkt->data, pkt->len);
+  armTx();
+
+  m_txActive = true;
+  m_txDeadlineUs = getMonotonicUs() + m_asyncTxTimeoutUs;
+}
+
+void SX1276::finishTx(uint64_t now, bool sent)
+{
+  if (m_txActive)
+    {
+      m_txActive = false;
+      m_txHead = (m_txHead + 1) % m_txQueue.size();
+      m_txCount--;
+
+      if (sent)
+        m_asyncStats.txPackets++;
+      else
+        m_asyncStats.txTimeouts++;
+
+      pthread_cond_broadcast(&m_asyncCond);
+    }
+
+  kickTx(now);
+}
+
+void SX1276::serviceAsync()
+{
+  uint64_t now = getMonotonicUs();
+
+  if (m_txActive && now >= m_txDeadlineUs)
+    {
+      if (m_settings.state == STATE_CAD)
+        {
+          // lost the CadDone interrupt, treat the channel as busy
+          m_txActive = false;
+          m_lbtRetryUs = now + m_lbtBackoffUs;
+          setStandby();
+        }
+      else
+        {
+          setStandby();
+          finishTx(now, false);
+          return;
+        }
+    }
+
+  kickTx(now);
+}
+
+void *SX1276::asyncThread(void *ctx)
+{
+  upm::SX1276 *This = (upm::SX1276 *)ctx;
+
+  This->lockIntrs();
+
+  while (This->m_async)
+    {
+      This->serviceAsync();
+
+      // sleep until the next deadline, the ISRs and queueTx() wake
+      // us early whenever that changes
+      uint64_t wakeup = getMonotonicUs() + 1000000;
+
+      if (This->m_txActive && This->m_txDeadlineUs < wakeup)
+        wakeup = This->m_txDeadlineUs;
+
+      if (!This->m_txActive && This->m_txCount &&
+          This->m_lbtRetryUs < wakeup)
+        wakeup = This->m_lbtRetryUs;
+
+      struct timespec deadline;
+      toTimespec(wakeup, &deadline);
+      pthread_cond_timedwait(&This->m_asyncCond, &This->m_intrLock,
+                             &deadline);
+    }
+
+  This->unlockIntrs();
+
+  return NULL;
+}
+
+void SX1276::beginProfile(PROFILE_T *profile)
+{
+  if (m_capture)
+    throw std::logic_error(string(__FUNCTION__) +
+                           ": a profile is already being recorded");
+
+  memset(profile->dirty, 0, sizeof(profile->dirty));
+
+  m_savedConfig.modem = m_settings.modem;
+  m_savedConfig.channel = m_settings.channel;
+  m_savedConfig.fskSettings = m_settings.fskSettings;
+  m_savedConfig.loraSettings = m_settings.loraSettings;
+  m_savedState = m_settings.state;
+
+  m_captureLora = m_loraPage;
+  m_capture = profile;
+}
+
+void SX1276::endProfile()
+{
+  if (!m_capture)
+    throw std::logic_error(string(__FUNCTION__) +
+                           ": no profile is being recorded");
+
+  m_capture->config.modem = m_settings.modem;
+  m_capture->config.channel = m_settings.channel;
+  m_capture->config.fskSettings = m_settings.fskSettings;
+  m_capture->config.loraSettings = m_settings.loraSettings;
+
+  m_settings.modem = m_savedConfig.modem;
+  m_settings.channel = m_savedConfig.channel;
+  m_settings.fskSettings = m_savedConfig.fskSettings;
+  m_settings.loraSettings = m_savedConfig.loraSettings;
+  m_settings.state = m_savedState;
+
+  m_capture = NULL;
+}
+
+void SX1276::applyProfile(PROFILE_T *profile)
+{
+  if (m_capture)
+    throw std::logic_error(string(__FUNCTION__) +
+                           ": cannot apply a profile while recording one");
+
+  bool lora = (profile->config.modem == MODEM_LORA);
+
+  lockIntrs();
+
+  // registers recorded for the other modem's bank can only be
+  // written while that modem is selected
+  for (int reg = 0; reg < 0x80; reg++)
+    {
+      if (isBankedReg(reg) && profile->dirty[shadowIndex(reg, !lora)])
+        {
+          setModem((lora) ? MODEM_FSK : MODEM_LORA);
+          writeProfileBank(profile, !lora, false);
+          break;
+        }
+    }
+
+  setModem(profile->config.modem);
+  writeProfileBank(profile, lora, true);
+
+  m_settings.channel = profile->config.channel;
+  m_settings.fskSettings = profile->config.fskSettings;
+  m_settings.loraSettings = profile->config.loraSettings;
+
+  unlockIntrs();
+}
+
+void SX1276::writeProfileBank(PROFILE_T *profile, bool lora, bool common)
+{
+  // gaps of up to this many clean registers are filled in from the
+  // shadow rather than starting a new burst
+  static const int maxGap = 2;
+
+  uint8_t buf[0x80];
+  int start = -1;
+  int last = -1;
+
+  // RegFifo and RegOpMode (setModem() handled that) are never part
+  // of a burst
+  for (int reg = COM_RegOpMode + 1; reg < 0x80; reg++)
+    {
+      int idx = shadowIndex(reg, lora);
+
+      if (!profile->dirty[idx] || (!common && !isBankedReg(reg)))
+        continue;
+
+      // already there
+      if (m_regCached[idx] && m_regShadow[idx] == profile->regs[idx] &&
+          !isVolatileReg(reg, lora))
+        continue;
+
+      if (start >= 0 && (reg - last - 1) <= maxGap)
+        {
+          bool fillable = true;
+
+          for (int gap = last + 1; gap < reg; gap++)
+            {
+              int gidx = shadowIndex(gap, lora);
+
+              if (!m_regCached[gidx] || isVolatileReg(gap, lora))
+                {
+                  fillable = false;
+                  break;
+                }
+            }
+
+          if (fillable)
+            {
+              for (int gap = last + 1; gap < reg; gap++)
+                buf[gap - start] = m_regShadow[shadowIndex(gap, lora)];
+
+              buf[reg - start] = profile->regs[idx];
+              last = reg;
+              continue;
+            }
+        }
+
+      if (start >= 0)
+        writeRegs(start, buf, last - start + 1);
+
+      start = last = reg;
+      buf[0] = profile->regs[idx];
+    }
+
+  if (start >= 0)
+    writeRegs(start, buf, last - start + 1);
+}
@@ -31,6 +31,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <sys/time.h>
 #include <sys/select.h>
@@ -78,6 +79,10 @@ namespace upm {
    * @snippet sx1276-fsk.cxx Interesting
    * LORA send/receive example
    * @snippet sx1276-lora.cxx Interesting
+   * LORA asynchronous gateway example
+   * @snippet sx1276-async.cxx Interesting
+   * LORA channel hopping with precomputed profiles
+   * @snippet sx1276-profile.cxx Interesting
    */
 
   class SX1276 {
@@ -131,6 +136,32 @@ namespace upm {
       REVENT_TIMEOUT                         // timed out
     } RADIO_EVENT_T;
 
+    /**
+     * A packet captured by the asynchronous receiver (see
+     * startAsync()).  rssi is in dBm, snr in dB (LoRa only, 0 for
+     * FSK), and timestamp is the CLOCK_MONOTONIC time in microseconds
+     * at which the RxDone interrupt fired.
+     */
+    typedef struct {
+      uint8_t  data[FIFO_SIZE];
+      int      len;
+      int      rssi;
+      int      snr;
+      uint64_t timestamp;
+    } RX_PACKET_T;
+
+    /**
+     * Counters maintained while in asynchronous mode
+     */
+    typedef struct {
+      uint32_t rxPackets;                    // packets queued
+      uint32_t rxErrors;                     // packets dropped, crc error
+      uint32_t rxOverflows;                  // packets dropped, queue full
+      uint32_t txPackets;                    // packets sent
+      uint32_t txTimeouts;                   // packets abandoned, no TxDone
+      uint32_t lbtBusy;                      // transmissions deferred by LBT
+    } ASYNC_STATS_T;
+
     /**
      * SX1276 registers
      *
@@ -1594,7 +1625,10 @@ namespace upm {
     ~SX1276();
 
     /**
-     * read a register
+     * read a register.  Configuration registers are served from a
+     * shadow copy of the register file kept up to date by writeReg();
+     * status registers (IRQ flags, RSSI, FIFO pointers, etc) are
+     * always read from the device.
      *
      * @param reg the register to read
      * @return the value of the register
@@ -1602,7 +1636,8 @@ namespace upm {
     uint8_t readReg(uint8_t reg);
 
     /**
-     * write to a register
+     * write to a register.  Writes to configuration registers that
+     * would not change the shadowed value are skipped.
      *
      * @param reg the register to write to
      * @param val the value to write
@@ -1610,6 +1645,26 @@ namespace upm {
      */
     bool writeReg(uint8_t reg, uint8_t val);
 
+    /**
+     * read a block of consecutive registers in a single SPI
+     * transaction
+     *
+     * @param reg the first register to read
+     * @param buffer The buffer to read data into
+     * @param len The number of registers to read
+     */
+    void readRegs(uint8_t reg, uint8_t *buffer, int len);
+
+    /**
+     * write a block of consecutive registers in a single SPI
+     * transaction, updating the shadow copy
+     *
+     * @param reg the first register to write to
+     * @param buffer The buffer containing the values to write
+     * @param len The number of registers to write
+     */
+    void writeRegs(uint8_t reg, uint8_t *buffer, int len);
+
     /**
      * return the chip revision
      *
@@ -1874,6 +1929,146 @@ namespace upm {
       return m_rxLen;
     };
 
+    /**
+     * Enter asynchronous mode.  The receiver is placed in continuous
+     * mode and every packet received is copied by the RxDone
+     * interrupt handler into a queue, along with its RSSI, SNR and
+     * arrival time, so nothing is lost while the application is busy
+     * with an earlier packet.  Packets handed to queueTx() are sent
+     * back to back from the TxDone interrupt handler, and the
+     * receiver is re-armed once the transmit queue is empty.
+     *
+     * The modem must already be configured with setRxConfig() and
+     * setTxConfig().  The blocking send()/setRx() methods must not be
+     * used until stopAsync() is called.
+     *
+     * @param rxDepth The number of received packets to hold.  When
+     * the queue is full, new packets are dropped and counted in
+     * ASYNC_STATS_T::rxOverflows.
+     * @param txDepth The number of packets that can wait for
+     * transmission.
+     */
+    void startAsync(int rxDepth=16, int txDepth=8);
+
+    /**
+     * Leave asynchronous mode and put the radio in standby.  Packets
+     * still waiting for transmission are discarded, while packets
+     * already received remain available through readPacket().
+     */
+    void stopAsync();
+
+    /**
+     * Determine whether asynchronous mode is active
+     *
+     * @return true if startAsync() has been called
+     */
+    bool isAsync()
+    {
+      return m_async;
+    };
+
+    /**
+     * Enable or disable listen-before-talk for queued transmissions.
+     * With LoRa, a Channel Activity Detection (CAD) is run before
+     * each packet.  With FSK, the RSSI measured by the running
+     * receiver is compared against rssiThresh.  When the channel is
+     * busy, the receiver is re-armed and the transmission retried
+     * after backoffMs.
+     *
+     * @param enable true to enable listen-before-talk
+     * @param rssiThresh The RSSI (dBm) above which the channel is
+     * considered busy (FSK only)
+     * @param backoffMs The delay before retrying a deferred
+     * transmission, in milliseconds
+     */
+    void setListenBeforeTalk(bool enable, int16_t rssiThresh=-90,
+                             int backoffMs=10);
+
+    /**
+     * Set how long a queued transmission may run before it is
+     * abandoned and the next one started.  The default is 3000ms.
+     *
+     * @param timeout The timeout in milliseconds
+     */
+    void setAsyncTxTimeout(int timeout);
+
+    /**
+     * Queue a buffer for transmission in asynchronous mode.  The data
+     * is copied, so the buffer may be reused as soon as this returns.
+     *
+     * @param buffer The buffer to send
+     * @param size The size of the buffer
+     * @return true if the packet was queued, false if the transmit
+     * queue is full
+     */
+    bool queueTx(uint8_t *buffer, uint8_t size);
+
+    /**
+     * Queue a string for transmission in asynchronous mode.  As with
+     * sendStr(), strings shorter than 64 bytes are padded out to 64
+     * bytes.
+     *
+     * @param buffer The string to send
+     * @return true if the packet was queued, false if the transmit
+     * queue is full
+     */
+    bool queueTxStr(std::string buffer);
+
+    /**
+     * Return the number of received packets waiting in the queue
+     *
+     * @return the number of packets available via readPacket()
+     */
+    int rxAvailable();
+
+    /**
+     * Remove the oldest packet from the receive queue
+     *
+     * @param pkt The RX_PACKET_T to fill in
+     * @return true if a packet was returned, false if the queue was
+     * empty
+     */
+    bool readPacket(RX_PACKET_T *pkt);
+
+    /**
+     * Wait for a packet to arrive and remove it from the receive
+     * queue
+     *
+     * @param pkt The RX_PACKET_T to fill in
+     * @param timeout The maximum time to wait in milliseconds
+     * @return true if a packet was returned, false on timeout
+     */
+    bool waitPacket(RX_PACKET_T *pkt, int timeout);
+
+    /**
+     * Return the number of packets not yet transmitted, including the
+     * one currently on the air
+     *
+     * @return the number of pending transmissions
+     */
+    int txPending();
+
+    /**
+     * Wait for the transmit queue to drain
+     *
+     * @param timeout The maximum time to wait in milliseconds
+     * @return true if every queued packet has been sent (or
+     * abandoned), false on timeout
+     */
+    bool waitTxIdle(int timeout);
+
+    /**
+     * Return the asynchronous mode counters
+     *
+     * @return a copy of the counters
+     */
+    ASYNC_STATS_T getAsyncStats();
+
+    /**
+     * Reset the asynchronous mode counters to 0
+     */
+    void resetAsyncStats();
+
 
   protected:
     // I/O
@@ -1919,6 +2114,13 @@ namespace upm {
     // rather than call this function directly.
     RADIO_EVENT_T setTx(int timeout);
 
+    // write a packet into the FIFO, ready for armTx()
+    void loadTx(uint8_t *buffer, uint8_t size);
+
+    // map the DIOs and start the transmitter/receiver without waiting
+    void armTx();
+    void armRx();
+
     void startCAD(); // non-functional/non-tested
 
     // not really used, maybe it should be
@@ -2016,6 +2218,28 @@ namespace upm {
     volatile int m_rxLen;
     uint8_t m_rxBuffer[FIFO_SIZE];
 
+    // packet being transmitted (FSK refills the FIFO from here)
+    uint8_t m_txBuffer[FIFO_SIZE];
+
+    // write-through shadow of the register file.  Registers
+    // 0x02-0x05 and 0x0d-0x3f are banked between the FSK and LoRa
+    // modems, the LoRa bank is stored at 0x80 + reg.
+    static const int SHADOW_SIZE = 256;
+
+    uint8_t m_regShadow[SHADOW_SIZE];
+    bool m_regCached[SHADOW_SIZE];
+    bool m_loraPage;
+    bool m_pageLoaded[2];
+
+    static bool isBankedReg(uint8_t reg);
+    static bool isVolatileReg(uint8_t reg, bool lora);
+    static int shadowIndex(uint8_t reg, bool lora);
+    static bool isLoraPage(uint8_t opMode);
+
+    void invalidateShadow();
+    void loadPage(bool lora);
+    uint8_t shadowReg(uint8_t reg);
+
     // for coordinating interrupt access
     pthread_mutex_t m_intrLock;
 
@@ -2025,10 +2249,110 @@ namespace upm {
     // current radio event status
     volatile RADIO_EVENT_T m_radioEvent;
 
+    // asynchronous mode.  Everything below is protected by m_intrLock.
+    typedef struct {
+      uint8_t data[FIFO_SIZE];
+      uint8_t len;
+    } TX_PACKET_T;
+
+    volatile bool m_async;
+    std::vector<RX_PACKET_T> m_rxQueue;
+    int m_rxHead;
+    int m_rxCount;
+    std::vector<TX_PACKET_T> m_txQueue;
+    int m_txHead;
+    int m_txCount;
+    bool m_txActive;
+
+    bool m_lbtEnabled;
+    int16_t m_lbtRssiThresh;
+    uint64_t m_lbtBackoffUs;
+    uint64_t m_lbtRetryUs;
+
+    uint64_t m_asyncTxTimeoutUs;
+    uint64_t m_txDeadlineUs;
+
+    // RxContinuous settings to restore in stopAsync()
+    bool m_fskRxContinuous;
+    bool m_loraRxContinuous;
+
+    ASYNC_STATS_T m_asyncStats;
+    pthread_cond_t m_asyncCond;
+    pthread_t m_asyncThread;
+
+    // handles tx timeouts and listen-before-talk retries
+    static void *asyncThread(void *ctx);
+
+    // called with m_intrLock held
+    void pushRxPacket(uint64_t timestamp, int rssi, int snr);
+    void kickTx(uint64_t now);
+    void startQueuedTx();
+    void finishTx(uint64_t now, bool sent);
+    void serviceAsync();
+
     // timer support
     struct timeval m_startTime;
     void initClock();
     uint32_t getMillis();
+
+    // modem configuration carried by a profile
+    typedef struct {
+      RADIO_MODEM_T       modem;
+      uint32_t            channel;
+      radioFskSettings_t  fskSettings;
+      radioLoRaSettings_t loraSettings;
+    } radioConfig_t;
+
+  public:
+    /**
+     * A precomputed set of register values and modem settings,
+     * recorded with beginProfile()/endProfile() and written to the
+     * radio by applyProfile().
+     */
+    typedef struct {
+      uint8_t       regs[SHADOW_SIZE];
+      bool          dirty[SHADOW_SIZE];
+      radioConfig_t config;
+    } PROFILE_T;
+
+    /**
+     * Start recording a profile.  Until endProfile() is called, the
+     * configuration methods (setChannel(), setModem(), setRxConfig(),
+     * setTxConfig(), setOpMode(), writeReg(), etc) only update the
+     * profile; nothing is sent to the radio and the current
+     * configuration is left untouched.
+     *
+     * The profile starts out empty, so only the registers written
+     * while recording are part of it.
+     *
+     * @param profile The profile to record into
+     */
+    void beginProfile(PROFILE_T *profile);
+
+    /**
+     * Stop recording a profile started with beginProfile()
+     */
+    void endProfile();
+
+    /**
+     * Apply a recorded profile.  The radio is switched to the
+     * profile's modem if required, then the registers that differ
+     * from the current configuration are written, with runs of
+     * consecutive registers sent as a single SPI burst.
+     *
+     * @param profile The profile to apply
+     */
+    void applyProfile(PROFILE_T *profile);
+
+  private:
+    // profile being recorded, or NULL
+    PROFILE_T *m_capture;
+    bool m_captureLora;
+    radioConfig_t m_savedConfig;
+
+    RADIO_STATES_T m_savedState;
+
+    void writeProfileBank(PROFILE_T *profile, bool lora, bool common);
   };
 }
 
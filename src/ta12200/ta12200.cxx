@@ -33,6 +33,9 @@ using namespace std;
 
 TA12200::TA12200(int pin)
 {
+  m_acq = 0;
+  m_acqChannel = -1;
+
   initClock();
 
   if ( !(m_aio = mraa_aio_init(pin)) )
@@ -45,6 +48,7 @@ TA12200::TA12200(int pin)
 
 TA12200::~TA12200()
 {
+  detachAcquisition();
   mraa_aio_close(m_aio);
 }
 
@@ -86,6 +90,40 @@ unsigned int TA12200::highestValue()
 {
   unsigned int hiVal = 0;
   unsigned int val;
+
+  if (m_acq)
+    {
+      // take the peak of the samples stamped within the next second
+      AioAcquisition::SAMPLE_T samples[32];
+      uint64_t end = AioAcquisition::getNanos() + 1000000000;
+
+      m_acq->flush(m_acqChannel);
+
+      while (m_acq->isRunning())
+        {
+          uint64_t now = AioAcquisition::getNanos();
+          unsigned int millis = (now < end) ? (end - now) / 1000000 + 1 : 0;
+
+          m_acq->waitSamples(m_acqChannel, 32, millis);
+
+          int count = m_acq->read(m_acqChannel, samples, 32);
+
+          for (int i = 0; i < count; i++)
+            {
+              if (samples[i].timestamp >= end)
+                return hiVal;
+
+              if (samples[i].value > hiVal)
+                hiVal = samples[i].value;
+            }
+
+          if (!count && AioAcquisition::getNanos() >= end)
+            break;
+        }
+
+      return hiVal;
+    }
+
   uint32_t start = getMillis();
 
   // 1 second
@@ -99,6 +137,34 @@ unsigned int TA12200::highestValue()
   return hiVal;
 }
 
+void TA12200::attachAcquisition(AioAcquisition *acq, unsigned int periodUs)
+{
+  detachAcquisition();
+
+  m_acqChannel = acq->addChannel(m_aio, periodUs);
+  m_acq = acq;
+  m_acq->start();
+}
+
+void TA12200::detachAcquisition()
+{
+  if (m_acq)
+    {
+      m_acq->removeChannel(m_acqChannel);
+      m_acq = 0;
+      m_acqChannel = -1;
+    }
+}
+
+unsigned int TA12200::highestValue(uint16_t *buffer, int len)
+{
+  uint16_t lo, hi;
+
+  Dsp::peak(buffer, len, &lo, &hi);
+
+  return hi;
+}
+
 float TA12200::milliAmps(unsigned int val, int res)
 {
   float ampCurrent;
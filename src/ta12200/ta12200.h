@@ -29,6 +29,9 @@
 #include <sys/time.h>
 #include <mraa/aio.h>
 
+#include "aioacquire.h"
+#include "dsp.h"
+
 // default ADC resolution. 
 #define TA12200_ADC_RES 1024
 
@@ -55,6 +58,10 @@ namespace upm {
  *   This module can measure AC moving through a wire at up 
  *   to 5 A.
  *
+ *   highestValue() polls the sensor for a second.  With a shared
+ *   AioAcquisition engine attached it takes the peak of the samples
+ *   the engine collected over that second instead.
+ *
  * @image html ta12200.jpg
  * @snippet ta12200.cxx Interesting
  */
@@ -86,6 +93,27 @@ namespace upm {
      */
     void initClock();
 
+    /**
+     * Samples the sensor with a shared acquisition engine.
+     * The engine is started if it is not running.
+     *
+     * @param acq Acquisition engine
+     * @param periodUs Sample period in microseconds
+     */
+    void attachAcquisition(AioAcquisition *acq, unsigned int periodUs=1000);
+
+    /**
+     * Stops sampling with the acquisition engine
+     */
+    void detachAcquisition();
+
+    /**
+     * Returns the acquisition channel of the sensor
+     *
+     * @return Channel number, or -1 if not attached
+     */
+    int getAcquisitionChannel() { return m_acqChannel; };
+
     /**
      * Gets the conversion value from the sensor
      *
@@ -93,6 +121,16 @@ namespace upm {
      */
     unsigned int highestValue();
 
+    /**
+     * Gets the highest conversion value of a block of samples taken
+     * by the caller, e.g. over 1 second
+     *
+     * @param buffer ADC samples
+     * @param len Number of samples
+     * @return Highest value in the block
+     */
+    unsigned int highestValue(uint16_t *buffer, int len);
+
     /**
      * Computes the measured voltage
      *
@@ -106,6 +144,8 @@ namespace upm {
   private:
     struct timeval m_startTime;
     mraa_aio_context m_aio;
+    AioAcquisition *m_acq;
+    int m_acqChannel;
   };
 }
 
@@ -28,6 +28,7 @@
 #include <iostream>
 #include <unistd.h>
 #include <stdlib.h>
+#include <time.h>
 #include <stdexcept>
 
 #include "th02.h"
@@ -35,10 +36,23 @@
 using namespace std;
 using namespace upm;
 
+static uint64_t getMonotonicUs()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
 TH02::TH02 (int bus, uint8_t addr) : m_i2c(bus) {
     m_addr = addr;
     m_name = "TH02";
 
+    m_convState = CONV_IDLE;
+    m_convDeadline = 0;
+    m_temperature = 0.0;
+    m_humidity = 0.0;
+
     mraa::Result ret = m_i2c.address(m_addr);
     if (ret != mraa::SUCCESS) {
         throw std::invalid_argument(std::string(__FUNCTION__) + 
@@ -54,18 +68,14 @@ TH02::getTemperature () {
     uint16_t temperature = 0;
 
     /* Start a new temperature conversion */
-    if (m_i2c.writeReg(TH02_REG_CONFIG, TH02_CMD_MEASURE_TEMP)) {
-        throw std::runtime_error(std::string(__FUNCTION__) +
-                                 ": I2c.writeReg() failed");
-        return 0.0;
-    }
+    startMeasure(TH02_CMD_MEASURE_TEMP);
 
     /* Wait until conversion is done */
-    while (getStatus() == false);
+    usleep(TH02_CONV_TIME_US);
+    while (getStatus() == false)
+        usleep(1000);
 
-    temperature = m_i2c.readReg(TH02_REG_DATA_H) << 8;
-    temperature |= m_i2c.readReg(TH02_REG_DATA_L);
-    temperature >>= 2;
+    temperature = readData() >> 2;
 
     return ((float(temperature) / 32.0) - 50.0);
 }
@@ -75,18 +85,14 @@ TH02::getHumidity () {
     uint16_t humidity = 0;
 
     /* Start a new humidity conversion */
-    if (m_i2c.writeReg(TH02_REG_CONFIG, TH02_CMD_MEASURE_HUMI)) {
-        throw std::runtime_error(std::string(__FUNCTION__) +
-                                 ": I2c.writeReg() failed");
-        return 0.0;
-    }
+    startMeasure(TH02_CMD_MEASURE_HUMI);
 
     /* Wait until conversion is done */
-    while (getStatus() == false);
+    usleep(TH02_CONV_TIME_US);
+    while (getStatus() == false)
+        usleep(1000);
 
-    humidity = m_i2c.readReg(TH02_REG_DATA_H) << 8;
-    humidity |= m_i2c.readReg(TH02_REG_DATA_L);
-    humidity >>= 4;
+    humidity = readData() >> 4;
 
     return ((float(humidity) / 16.0) - 24.0);
 }
@@ -101,3 +107,65 @@ TH02::getStatus () {
         return true;            // ready
 }
 
+bool
+TH02::startConversion () {
+    startMeasure(TH02_CMD_MEASURE_TEMP);
+    m_convState = CONV_TEMPERATURE;
+
+    return true;
+}
+
+bool
+TH02::conversionReady () {
+    if (m_convState == CONV_IDLE || getMonotonicUs() < m_convDeadline)
+        return false;
+
+    if (!getStatus())
+        return false;
+
+    if (m_convState == CONV_TEMPERATURE) {
+        m_temperature = (float(readData() >> 2) / 32.0) - 50.0;
+
+        startMeasure(TH02_CMD_MEASURE_HUMI);
+        m_convState = CONV_HUMIDITY;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool
+TH02::collect () {
+    if (!conversionReady())
+        return false;
+
+    m_humidity = (float(readData() >> 4) / 16.0) - 24.0;
+    m_convState = CONV_IDLE;
+
+    return true;
+}
+
+bool
+TH02::startMeasure (uint8_t cmd) {
+    if (m_i2c.writeReg(TH02_REG_CONFIG, cmd)) {
+        m_convState = CONV_IDLE;
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": I2c.writeReg() failed");
+        return false;
+    }
+
+    m_convDeadline = getMonotonicUs() + TH02_CONV_TIME_US;
+
+    return true;
+}
+
+uint16_t
+TH02::readData () {
+    uint16_t data;
+
+    data = m_i2c.readReg(TH02_REG_DATA_H) << 8;
+    data |= m_i2c.readReg(TH02_REG_DATA_L);
+
+    return data;
+}
@@ -42,6 +42,8 @@
 #define TH02_CMD_MEASURE_HUMI    0x01
 #define TH02_CMD_MEASURE_TEMP    0x11
 
+#define TH02_CONV_TIME_US        35000 // typical, normal mode
+
 namespace upm {
 
 /**
@@ -66,6 +68,10 @@ namespace upm {
  *   Note: For use on Intel(R) Edison with an Arduino* breakout board, Intel
  *   Edison must be set to 3 V rather than 5 V.
  *
+ *   startConversion(), conversionReady() and collect() run the
+ *   temperature and humidity conversions back to back without
+ *   blocking the caller.
+ *
  * @image html th02.jpg
  * @snippet th02.cxx Interesting
  */
@@ -96,6 +102,42 @@ class TH02 {
          */
         bool getStatus ();
 
+        /**
+         * Starts a temperature conversion, followed by a humidity
+         * conversion, and returns immediately
+         *
+         * @return True if successful
+         */
+        bool startConversion ();
+
+        /**
+         * Checks whether both conversions started by startConversion()
+         * have finished.  The temperature is read and the humidity
+         * conversion started from here once the first one is done.
+         *
+         * @return True if collect() can be called
+         */
+        bool conversionReady ();
+
+        /**
+         * Reads the humidity result.  The values are then available
+         * from getLastTemperature() and getLastHumidity().
+         *
+         * @return True if a result was collected, false if the
+         * conversions are still in progress or none were started
+         */
+        bool collect ();
+
+        /**
+         * Returns the temperature from the last collect()
+         */
+        float getLastTemperature () { return m_temperature; };
+
+        /**
+         * Returns the humidity from the last collect()
+         */
+        float getLastHumidity () { return m_humidity; };
+
         /**
          * Returns the name of the component
          */
@@ -105,9 +147,23 @@ class TH02 {
         }
 
     private:
+        typedef enum {
+            CONV_IDLE = 0,
+            CONV_TEMPERATURE,
+            CONV_HUMIDITY
+        } CONV_STATE_T;
+
+        bool startMeasure (uint8_t cmd);
+        uint16_t readData ();
+
         std::string m_name;
         mraa::I2c m_i2c;
         uint8_t m_addr;
+
+        CONV_STATE_T m_convState;
+        uint64_t m_convDeadline;
+        float m_temperature;
+        float m_humidity;
 };
 
 }
@@ -30,10 +30,20 @@
 #include <string>
 #include <stdexcept>
 #include <unistd.h>
+#include <stdio.h>
+#include <time.h>
 #include "tsl2561.h"
 
 using namespace upm;
 
+static uint64_t getMonotonicUs()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
 
 TSL2561::TSL2561(int bus, uint8_t devAddr, uint8_t gain, uint8_t integrationTime)
                                                 : m_i2ControlCtx(bus)
@@ -42,6 +52,9 @@ TSL2561::TSL2561(int bus, uint8_t devAddr, uint8_t gain, uint8_t integrationTime
     m_bus = bus;
     m_gain = gain ;
     m_integrationTime = integrationTime;
+    m_converting = false;
+    m_convDeadline = 0;
+    m_lux = 0;
 
     m_name = "TSL2561- Digital Light Sensor";
 
@@ -88,10 +101,76 @@ TSL2561::~TSL2561()
 int
 TSL2561::getLux()
 {
-    mraa::Result error = mraa::SUCCESS;
-    int lux;
+    mraa::Result error;
+    uint16_t rawLuxCh0;
+    uint16_t rawLuxCh1;
+
+    error = readChannels(rawLuxCh0, rawLuxCh1);
+    if (error != mraa::SUCCESS)
+        return error;
+
+    return computeLux(rawLuxCh0, rawLuxCh1);
+}
+
+bool
+TSL2561::startConversion()
+{
+    // a power cycle restarts the integration
+    if (m_i2ControlCtx.writeReg(REGISTER_Control, CONTROL_POWEROFF) !=
+        mraa::SUCCESS ||
+        m_i2ControlCtx.writeReg(REGISTER_Control, CONTROL_POWERON) !=
+        mraa::SUCCESS)
+        return false;
+
+    // integration time plus margin for the internal oscillator
+    int us;
+    switch (m_integrationTime)
+    {
+      case 0:
+         us = 15000;
+      break;
+      case 1:
+         us = 110000;
+      break;
+      default:
+         us = 430000;
+      break;
+    }
+
+    m_convDeadline = getMonotonicUs() + us;
+    m_converting = true;
+
+    return true;
+}
+
+bool
+TSL2561::conversionReady()
+{
+    return (m_converting && getMonotonicUs() >= m_convDeadline);
+}
+
+bool
+TSL2561::collect()
+{
     uint16_t rawLuxCh0;
     uint16_t rawLuxCh1;
+
+    if (!conversionReady())
+        return false;
+
+    if (readChannels(rawLuxCh0, rawLuxCh1) != mraa::SUCCESS)
+        return false;
+
+    m_converting = false;
+    m_lux = computeLux(rawLuxCh0, rawLuxCh1);
+
+    return true;
+}
+
+mraa::Result
+TSL2561::readChannels(uint16_t &rawLuxCh0, uint16_t &rawLuxCh1)
+{
+    mraa::Result error = mraa::SUCCESS;
     uint8_t ch0_low, ch0_high, ch1_low, ch1_high;
 
     error = i2cReadReg(REGISTER_Channal0L, ch0_low);
@@ -122,6 +201,13 @@ TSL2561::getLux()
 
     rawLuxCh1 = ch1_high*256+ch1_low;
 
+    return error;
+}
+
+int
+TSL2561::computeLux(uint16_t rawLuxCh0, uint16_t rawLuxCh1)
+{
+    int lux;
     uint64_t scale = 0;
 
     switch (m_integrationTime)
@@ -242,7 +328,5 @@ TSL2561::i2cReadReg(uint8_t reg, uint8_t &data)
     // Read byte.
     data = m_i2ControlCtx.readByte();
 
-    usleep(10000);
-
     return error;
 }
@@ -112,6 +112,10 @@ namespace upm {
  *   TSL2560 and TSL2561 are light-to-digital converters that transform
  *   light intensity to a digital signal output capable of a direct I2C (TSL2561) interface
  *
+ *   startConversion(), conversionReady() and collect() restart the
+ *   integration cycle and harvest it once the integration time has
+ *   passed, without blocking the caller.
+ *
  * @image html tsl2561.jpg
  * @snippet tsl2561.cxx Interesting
  */
@@ -139,7 +143,51 @@ class TSL2561{
         */
         int getLux();
 
+       /**
+        * Restarts the ADC integration cycle, so that the next result
+        * only covers light measured from now on
+        *
+        * @return True if successful
+        */
+        bool startConversion();
+
+       /**
+        * Checks whether the integration cycle started by
+        * startConversion() has completed
+        *
+        * @return True if collect() can be called
+        */
+        bool conversionReady();
+
+       /**
+        * Reads the result of a completed integration cycle.  The
+        * value is then available from getLastLux().
+        *
+        * @return True if a result was collected, false if the
+        * integration is still running or none was started
+        */
+        bool collect();
+
+       /**
+        * Returns the lux value from the last collect()
+        */
+        int getLastLux() { return m_lux; };
+
     private:
+       /**
+        * Reads both ADC channels
+        *
+        * @param ch0 Channel 0 (visible + IR) count
+        * @param ch1 Channel 1 (IR) count
+        * @return mraa::Result
+        */
+        mraa::Result readChannels(uint16_t &ch0, uint16_t &ch1);
+
+       /**
+        * Computes lux from the raw channel counts
+        */
+        int computeLux(uint16_t rawLuxCh0, uint16_t rawLuxCh1);
+
        /**
         * Writes to a TSL2561 register
         *
@@ -165,6 +213,10 @@ class TSL2561{
 
         uint8_t m_gain;
         uint8_t m_integrationTime;
+
+        bool m_converting;
+        uint64_t m_convDeadline;
+        int m_lux;
 };
 
 }
@@ -0,0 +1,22 @@
+%module javaupm_uartport
+%include "../upm.i"
+%include "stdint.i"
+
+%{
+    #include "uartport.h"
+    speed_t int_B9600 = B9600;
+%}
+
+%include "uartport.h"
+speed_t int_B9600 = B9600;
+
+%pragma(java) jniclasscode=%{
+    static {
+        try {
+            System.loadLibrary("javaupm_uartport");
+        } catch (UnsatisfiedLinkError e) {
+            System.err.println("Native code library failed to load. \n" + e);
+            System.exit(1);
+        }
+    }
+%}
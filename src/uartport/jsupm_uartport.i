@@ -0,0 +1,13 @@
+%module jsupm_uartport
+%include "../upm.i"
+%include "stdint.i"
+%include "carrays.i"
+
+%{
+    #include "uartport.h"
+    speed_t int_B9600 = B9600;
+%}
+
+%include "uartport.h"
+speed_t int_B9600 = B9600;
+%array_class(uint8_t, byteArray);
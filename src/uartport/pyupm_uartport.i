@@ -0,0 +1,17 @@
+// Include doxygen-generated documentation
+%include "pyupm_doxy2swig.i"
+%module pyupm_uartport
+%include "../upm.i"
+%include "stdint.i"
+%include "carrays.i"
+
+%feature("autodoc", "3");
+
+%{
+    #include "uartport.h"
+    speed_t int_B9600 = B9600;
+%}
+
+%include "uartport.h"
+speed_t int_B9600 = B9600;
+%array_class(uint8_t, byteArray);
@@ -0,0 +1,626 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/epoll.h>
+
+#include "uartport.h"
+
+using namespace upm;
+using namespace std;
+
+// largest chunk read from a tty in one read() call
+#define UARTPORT_READ_CHUNK 512
+
+pthread_mutex_t UartPort::s_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t UartPort::s_threadLock = PTHREAD_MUTEX_INITIALIZER;
+std::vector<UartPort *> UartPort::s_ports;
+pthread_t UartPort::s_thread;
+int UartPort::s_epollFd = -1;
+int UartPort::s_wakeFds[2] = { -1, -1 };
+volatile bool UartPort::s_running = false;
+
+UartPort::UartPort(int uart, int bufferSize)
+{
+  m_uart = 0;
+  m_ttyFd = -1;
+
+  if ( !(m_uart = mraa_uart_init(uart)) )
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": mraa_uart_init() failed");
+      return;
+    }
+
+  // This requires a recent MRAA (1/2015)
+  const char *devPath = mraa_uart_get_dev_path(m_uart);
+
+  if (!devPath)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": mraa_uart_get_dev_path() failed");
+      return;
+    }
+
+  openTty(devPath, bufferSize);
+}
+
+UartPort::UartPort(std::string path, int bufferSize)
+{
+  m_uart = 0;
+  m_ttyFd = -1;
+
+  openTty(path.c_str(), bufferSize);
+}
+
+void UartPort::openTty(const char *path, int bufferSize)
+{
+  m_error = false;
+  m_head = 0;
+  m_tail = 0;
+  m_framer = 0;
+  m_frameHandler = 0;
+  m_frameCtx = 0;
+  m_frameTimeout = 0;
+  m_frameLen = 0;
+  m_frameStamp = 0;
+  m_overflows = 0;
+  m_frameTimeouts = 0;
+
+  // round the ring up to a power of 2 so the indices can wrap freely
+  unsigned int size = 64;
+  while (size < (unsigned int)bufferSize)
+    size <<= 1;
+
+  m_ring.resize(size);
+  m_ringMask = size - 1;
+  m_frame.resize(size);
+
+  if ( (m_ttyFd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK)) == -1)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": open of " + string(path) + " failed: " +
+                               string(strerror(errno)));
+      return;
+    }
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+  if (pthread_mutex_init(&m_waitLock, NULL) ||
+      pthread_cond_init(&m_waitCond, &attr))
+    {
+      pthread_condattr_destroy(&attr);
+      close(m_ttyFd);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_mutex/cond_init() failed");
+      return;
+    }
+  pthread_condattr_destroy(&attr);
+
+  try
+    {
+      registerPort(this);
+    }
+  catch (...)
+    {
+      pthread_cond_destroy(&m_waitCond);
+      pthread_mutex_destroy(&m_waitLock);
+      close(m_ttyFd);
+      throw;
+    }
+}
+
+UartPort::~UartPort()
+{
+  unregisterPort(this);
+
+  pthread_cond_destroy(&m_waitCond);
+  pthread_mutex_destroy(&m_waitLock);
+
+  if (m_ttyFd != -1)
+    close(m_ttyFd);
+}
+
+bool UartPort::setupTty(speed_t baud)
+{
+  if (m_ttyFd == -1)
+    return(false);
+
+  struct termios termio;
+
+  // get current modes
+  tcgetattr(m_ttyFd, &termio);
+
+  // setup for a 'raw' mode.  81N, no echo or special character
+  // handling, such as flow control.
+  cfmakeraw(&termio);
+
+  // set our baud rates
+  cfsetispeed(&termio, baud);
+  cfsetospeed(&termio, baud);
+
+  // make it so
+  if (tcsetattr(m_ttyFd, TCSAFLUSH, &termio) < 0)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": tcsetattr() failed: " +
+                               string(strerror(errno)));
+      return false;
+    }
+
+  return true;
+}
+
+int UartPort::available()
+{
+  return (int)(m_head - m_tail);
+}
+
+bool UartPort::dataAvailable(unsigned int millis)
+{
+  if (available())
+    return true;
+
+  if (!millis)
+    return false;
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += millis / 1000;
+  deadline.tv_nsec += (millis % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000)
+    {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+
+  // the reader thread takes m_waitLock after publishing new data, so
+  // checking under the lock cannot miss a wakeup
+  pthread_mutex_lock(&m_waitLock);
+  while (!available() && !m_error)
+    {
+      if (pthread_cond_timedwait(&m_waitCond, &m_waitLock, &deadline)
+          == ETIMEDOUT)
+        break;
+    }
+  pthread_mutex_unlock(&m_waitLock);
+
+  return (available() > 0);
+}
+
+int UartPort::readData(uint8_t *buffer, int len, int millis)
+{
+  if (m_ttyFd == -1)
+    return(-1);
+
+  if (millis < 0)
+    {
+      pthread_mutex_lock(&m_waitLock);
+      while (!available() && !m_error)
+        pthread_cond_wait(&m_waitCond, &m_waitLock);
+      pthread_mutex_unlock(&m_waitLock);
+    }
+  else if (!dataAvailable(millis))
+    {
+      if (m_error)
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": read() failed");
+      return 0;
+    }
+
+  if (!available() && m_error)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": read() failed");
+      return -1;
+    }
+
+  unsigned int tail = m_tail;
+  int count = std::min(len, (int)(m_head - tail));
+
+  // make sure the data is read after the head index it belongs to
+  __sync_synchronize();
+
+  for (int i = 0; i < count; i++)
+    buffer[i] = m_ring[(tail + i) & m_ringMask];
+
+  __sync_synchronize();
+  m_tail = tail + count;
+
+  return count;
+}
+
+int UartPort::writeData(const uint8_t *buffer, int len)
+{
+  if (m_ttyFd == -1)
+    return(-1);
+
+  int written = 0;
+
+  while (written < len)
+    {
+      int rv = write(m_ttyFd, buffer + written, len - written);
+
+      if (rv < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          if (errno == EAGAIN)
+            {
+              // the fd is non-blocking for the reader thread, so wait
+              // for room in the output queue
+              struct pollfd pfd;
+              pfd.fd = m_ttyFd;
+              pfd.events = POLLOUT;
+              poll(&pfd, 1, -1);
+              continue;
+            }
+
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": write() failed: " +
+                                   string(strerror(errno)));
+          return rv;
+        }
+
+      written += rv;
+    }
+
+  tcdrain(m_ttyFd);
+
+  return written;
+}
+
+void UartPort::flushInput()
+{
+  if (m_ttyFd == -1)
+    return;
+
+  tcflush(m_ttyFd, TCIFLUSH);
+
+  // the consumer owns the tail, so it may drop everything up to head
+  m_tail = m_head;
+}
+
+void UartPort::setFramer(FRAMER_T framer, FRAME_HANDLER_T handler, void *ctx,
+                         unsigned int timeoutMs)
+{
+  pthread_mutex_lock(&s_lock);
+  m_framer = framer;
+  m_frameHandler = handler;
+  m_frameCtx = ctx;
+  m_frameTimeout = timeoutMs;
+  m_frameLen = 0;
+  pthread_mutex_unlock(&s_lock);
+
+  // wake the reader thread so it picks up the new timeout
+  if (s_wakeFds[1] != -1)
+    {
+      char c = 0;
+      if (write(s_wakeFds[1], &c, 1) < 0)
+        {
+          // the pipe is full, so the thread is waking up anyway
+        }
+    }
+}
+
+uint64_t UartPort::getMillis()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void UartPort::wakeReaders()
+{
+  pthread_mutex_lock(&m_waitLock);
+  pthread_cond_broadcast(&m_waitCond);
+  pthread_mutex_unlock(&m_waitLock);
+}
+
+void UartPort::receive(const uint8_t *data, int len)
+{
+  if (!m_framer)
+    {
+      unsigned int head = m_head;
+      int room = (int)(m_ring.size() - (head - m_tail));
+
+      if (len > room)
+        {
+          m_overflows += len - room;
+          len = room;
+        }
+
+      for (int i = 0; i < len; i++)
+        m_ring[(head + i) & m_ringMask] = data[i];
+
+      // publish the data before the new head
+      __sync_synchronize();
+      m_head = head + len;
+
+      return;
+    }
+
+  m_frameStamp = getMillis();
+
+  while (len > 0)
+    {
+      int room = (int)m_frame.size() - m_frameLen;
+
+      // a framer that never completes a frame can't stall the port
+      if (!room)
+        {
+          m_overflows += m_frameLen;
+          m_frameLen = 0;
+          room = (int)m_frame.size();
+        }
+
+      int chunk = std::min(len, room);
+      memcpy(&m_frame[m_frameLen], data, chunk);
+      m_frameLen += chunk;
+      data += chunk;
+      len -= chunk;
+
+      // hand out every complete frame in the buffer
+      int offset = 0;
+      while (offset < m_frameLen)
+        {
+          int rv = m_framer(&m_frame[offset], m_frameLen - offset,
+                            m_frameCtx);
+
+          if (rv == 0)
+            break;
+
+          if (rv > 0)
+            {
+              rv = std::min(rv, m_frameLen - offset);
+              if (m_frameHandler)
+                m_frameHandler(&m_frame[offset], rv, m_frameCtx);
+              offset += rv;
+            }
+          else
+            offset += std::min(-rv, m_frameLen - offset);
+        }
+
+      if (offset)
+        {
+          m_frameLen -= offset;
+          memmove(&m_frame[0], &m_frame[offset], m_frameLen);
+        }
+    }
+}
+
+void UartPort::service()
+{
+  uint8_t buffer[UARTPORT_READ_CHUNK];
+  bool received = false;
+
+  for (;;)
+    {
+      int rv = read(m_ttyFd, buffer, sizeof(buffer));
+
+      if (rv > 0)
+        {
+          receive(buffer, rv);
+          received = true;
+          continue;
+        }
+
+      if (rv < 0 && errno == EINTR)
+        continue;
+
+      if (rv < 0 && errno == EAGAIN)
+        break;
+
+      // EOF (hangup) or a real error: stop watching this tty, and let
+      // blocked readers see the error
+      epoll_ctl(s_epollFd, EPOLL_CTL_DEL, m_ttyFd, NULL);
+      m_error = true;
+      received = true;
+      break;
+    }
+
+  if (received)
+    wakeReaders();
+}
+
+void UartPort::checkFrameTimeout(uint64_t now)
+{
+  if (m_framer && m_frameTimeout && m_frameLen &&
+      now - m_frameStamp >= m_frameTimeout)
+    {
+      m_frameTimeouts++;
+      m_frameLen = 0;
+    }
+}
+
+int UartPort::frameTimeoutRemaining(uint64_t now)
+{
+  if (!m_framer || !m_frameTimeout || !m_frameLen)
+    return -1;
+
+  uint64_t elapsed = now - m_frameStamp;
+
+  if (elapsed >= m_frameTimeout)
+    return 0;
+
+  return (int)(m_frameTimeout - elapsed);
+}
+
+void *UartPort::readerThread(void *)
+{
+  struct epoll_event events[16];
+  int timeout = -1;
+
+  while (s_running)
+    {
+      int count = epoll_wait(s_epollFd, events, 16, timeout);
+
+      if (count < 0 && errno != EINTR)
+        break;
+
+      pthread_mutex_lock(&s_lock);
+
+      for (int i = 0; i < count; i++)
+        {
+          if (events[i].data.ptr == 0)
+            {
+              // wakeup pipe
+              char buf[16];
+              while (read(s_wakeFds[0], buf, sizeof(buf)) > 0)
+                ;
+              continue;
+            }
+
+          UartPort *port = (UartPort *)events[i].data.ptr;
+
+          // the port may have been removed after epoll_wait() returned
+          if (std::find(s_ports.begin(), s_ports.end(), port) !=
+              s_ports.end())
+            port->service();
+        }
+
+      // expire stale partial frames and compute the next wait
+      uint64_t now = getMillis();
+      timeout = -1;
+      for (unsigned int i = 0; i < s_ports.size(); i++)
+        {
+          s_ports[i]->checkFrameTimeout(now);
+
+          int remaining = s_ports[i]->frameTimeoutRemaining(now);
+          if (remaining >= 0 && (timeout < 0 || remaining < timeout))
+            timeout = remaining;
+        }
+
+      pthread_mutex_unlock(&s_lock);
+    }
+
+  return 0;
+}
+
+void UartPort::registerPort(UartPort *port)
+{
+  pthread_mutex_lock(&s_threadLock);
+
+  if (!s_running)
+    {
+      if ( (s_epollFd = epoll_create(16)) < 0)
+        {
+          pthread_mutex_unlock(&s_threadLock);
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": epoll_create() failed: " +
+                                   string(strerror(errno)));
+        }
+
+      if (pipe(s_wakeFds) < 0)
+        {
+          close(s_epollFd);
+          s_epollFd = -1;
+          pthread_mutex_unlock(&s_threadLock);
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": pipe() failed: " +
+                                   string(strerror(errno)));
+        }
+
+      fcntl(s_wakeFds[0], F_SETFL, O_NONBLOCK);
+      fcntl(s_wakeFds[1], F_SETFL, O_NONBLOCK);
+
+      struct epoll_event ev;
+      memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN;
+      ev.data.ptr = 0;
+      epoll_ctl(s_epollFd, EPOLL_CTL_ADD, s_wakeFds[0], &ev);
+
+      s_running = true;
+      if (pthread_create(&s_thread, NULL, readerThread, NULL))
+        {
+          s_running = false;
+          close(s_wakeFds[0]);
+          close(s_wakeFds[1]);
+          close(s_epollFd);
+          s_wakeFds[0] = s_wakeFds[1] = s_epollFd = -1;
+          pthread_mutex_unlock(&s_threadLock);
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": pthread_create() failed");
+        }
+    }
+
+  pthread_mutex_lock(&s_lock);
+  s_ports.push_back(port);
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = port;
+  epoll_ctl(s_epollFd, EPOLL_CTL_ADD, port->m_ttyFd, &ev);
+  pthread_mutex_unlock(&s_lock);
+
+  pthread_mutex_unlock(&s_threadLock);
+}
+
+void UartPort::unregisterPort(UartPort *port)
+{
+  pthread_mutex_lock(&s_threadLock);
+
+  // once s_lock is held the reader thread is not inside service()
+  pthread_mutex_lock(&s_lock);
+  epoll_ctl(s_epollFd, EPOLL_CTL_DEL, port->m_ttyFd, NULL);
+  s_ports.erase(std::remove(s_ports.begin(), s_ports.end(), port),
+                s_ports.end());
+  bool last = s_ports.empty();
+  pthread_mutex_unlock(&s_lock);
+
+  if (last && s_running)
+    {
+      s_running = false;
+
+      char c = 0;
+      if (write(s_wakeFds[1], &c, 1) < 0)
+        {
+          // the pipe is full, so the thread is waking up anyway
+        }
+
+      pthread_join(s_thread, NULL);
+
+      close(s_wakeFds[0]);
+      close(s_wakeFds[1]);
+      close(s_epollFd);
+      s_wakeFds[0] = s_wakeFds[1] = s_epollFd = -1;
+    }
+
+  pthread_mutex_unlock(&s_threadLock);
+}
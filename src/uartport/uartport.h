@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <termios.h>
+#include <pthread.h>
+
+#include <mraa/uart.h>
+
+// default size of the per-port receive ring, in bytes (power of 2)
+#define UARTPORT_BUFFER_SIZE 4096
+
+namespace upm {
+  /**
+   * @brief Shared UART transport
+   * @defgroup uartport libupm-uartport
+   * @ingroup uart
+   */
+
+  /**
+   * @library uartport
+   * @sensor uartport
+   * @comname UART transport
+   * @con uart
+   *
+   * @brief Non-blocking UART transport shared by the serial drivers
+   *
+   * A UartPort owns one tty.  All ports in a process are serviced by
+   * a single reader thread waiting on an epoll set, so any number of
+   * serial devices can be handled without a thread or a polling loop
+   * per device.
+   *
+   * Received bytes are either stored in a lock-free single
+   * producer/single consumer ring buffer and retrieved with
+   * readData(), or, when a framer is installed with setFramer(),
+   * assembled into frames and handed to a callback from the reader
+   * thread.
+   *
+   * Any tty works, including the slave side of a pseudo-terminal
+   * (openpty()), which makes it possible to exercise a driver without
+   * the actual device.
+   */
+  class UartPort {
+  public:
+    /**
+     * Framing callback.  Called from the reader thread with all the
+     * bytes received but not yet consumed.
+     *
+     * @return the length of a complete frame at the start of data,
+     * 0 if more data is needed, or a negative count of leading bytes
+     * to discard (to resynchronize)
+     */
+    typedef int (*FRAMER_T)(const uint8_t *data, int len, void *ctx);
+
+    /**
+     * Frame callback.  Called from the reader thread for each
+     * complete frame.  It must not destroy the port or install a new
+     * framer.
+     */
+    typedef void (*FRAME_HANDLER_T)(const uint8_t *frame, int len,
+                                    void *ctx);
+
+    /**
+     * UartPort constructor, opening an MRAA UART
+     *
+     * @param uart MRAA UART number
+     * @param bufferSize size of the receive ring, rounded up to a
+     * power of 2
+     */
+    UartPort(int uart, int bufferSize=UARTPORT_BUFFER_SIZE);
+
+    /**
+     * UartPort constructor, opening a tty device by path
+     *
+     * @param path tty device, e.g. /dev/ttyS1 or a pty slave
+     * @param bufferSize size of the receive ring, rounded up to a
+     * power of 2
+     */
+    UartPort(std::string path, int bufferSize=UARTPORT_BUFFER_SIZE);
+
+    /**
+     * UartPort destructor
+     */
+    ~UartPort();
+
+    /**
+     * Sets up raw (8N1, no flow control) I/O and the baud rate
+     *
+     * @param baud Desired baud rate
+     * @return True if successful
+     */
+    bool setupTty(speed_t baud=B9600);
+
+    /**
+     * Waits for received data to become available
+     *
+     * @param millis Number of milliseconds to wait
+     * @return True if there is data available for reading
+     */
+    bool dataAvailable(unsigned int millis=0);
+
+    /**
+     * Returns the number of bytes waiting in the receive ring
+     *
+     * @return Number of bytes available
+     */
+    int available();
+
+    /**
+     * Reads received data into a buffer.  Returns as soon as at
+     * least one byte is available.  Nothing is returned while a
+     * framer is installed.
+     *
+     * @param buffer Buffer to hold the data read
+     * @param len Length of the buffer
+     * @param millis Number of milliseconds to wait for data, or -1
+     * to block until data arrives
+     * @return Number of bytes read, 0 on timeout
+     */
+    int readData(uint8_t *buffer, int len, int millis=-1);
+
+    /**
+     * Writes a buffer to the device and waits for it to be
+     * transmitted
+     *
+     * @param buffer Buffer to write
+     * @param len Number of bytes to write
+     * @return Number of bytes written
+     */
+    int writeData(const uint8_t *buffer, int len);
+
+    /**
+     * Discards all received data that has not been read yet
+     */
+    void flushInput();
+
+    /**
+     * Installs or removes a framer.  While a framer is installed,
+     * received bytes are passed to it instead of the receive ring.
+     *
+     * @param framer Framing callback, or NULL to go back to readData()
+     * @param handler Callback for complete frames
+     * @param ctx Argument passed to both callbacks
+     * @param timeoutMs Discard a partial frame if no byte is
+     * received for this many milliseconds, 0 to never time out
+     */
+    void setFramer(FRAMER_T framer, FRAME_HANDLER_T handler, void *ctx,
+                   unsigned int timeoutMs=0);
+
+    /**
+     * Returns the number of received bytes dropped because the
+     * receive ring or frame buffer was full
+     *
+     * @return Number of bytes dropped
+     */
+    unsigned int getOverflowCount() { return m_overflows; };
+
+    /**
+     * Returns the number of partial frames dropped on timeout
+     *
+     * @return Number of frames dropped
+     */
+    unsigned int getFrameTimeoutCount() { return m_frameTimeouts; };
+
+    /**
+     * Returns the tty file descriptor
+     *
+     * @return File descriptor
+     */
+    int ttyFd() { return m_ttyFd; };
+
+  private:
+    void openTty(const char *path, int bufferSize);
+
+    // called from the reader thread with s_lock held
+    void service();
+    void checkFrameTimeout(uint64_t now);
+    int frameTimeoutRemaining(uint64_t now);
+    void receive(const uint8_t *data, int len);
+    void wakeReaders();
+
+    static uint64_t getMillis();
+    static void registerPort(UartPort *port);
+    static void unregisterPort(UartPort *port);
+    static void *readerThread(void *ctx);
+
+    mraa_uart_context m_uart;
+    int m_ttyFd;
+    volatile bool m_error;
+
+    // receive ring.  The reader thread only advances m_head, the
+    // consumer only advances m_tail.
+    std::vector<uint8_t> m_ring;
+    unsigned int m_ringMask;
+    volatile unsigned int m_head;
+    volatile unsigned int m_tail;
+
+    // frame assembly, only touched by the reader thread (and under
+    // s_lock by setFramer())
+    FRAMER_T m_framer;
+    FRAME_HANDLER_T m_frameHandler;
+    void *m_frameCtx;
+    unsigned int m_frameTimeout;
+    std::vector<uint8_t> m_frame;
+    int m_frameLen;
+    uint64_t m_frameStamp;
+
+    volatile unsigned int m_overflows;
+    volatile unsigned int m_frameTimeouts;
+
+    // used only to sleep in dataAvailable()/readData()
+    pthread_mutex_t m_waitLock;
+    pthread_cond_t m_waitCond;
+
+    // shared reader thread state
+    static pthread_mutex_t s_lock;
+    static pthread_mutex_t s_threadLock;
+    static std::vector<UartPort *> s_ports;
+    static pthread_t s_thread;
+    static int s_epollFd;
+    static int s_wakeFds[2];
+    static volatile bool s_running;
+  };
+}
@@ -3,10 +3,12 @@
 %include "../java_buffer.i"
 
 %{
+    #include "nmeaparser.h"
     #include "ublox6.h"
     speed_t int_B9600 = B9600;
 %}
 
+%include "nmeaparser.h"
 %include "ublox6.h"
 speed_t int_B9600 = B9600;
 
@@ -4,10 +4,12 @@
 %include "carrays.i"
 
 %{
+    #include "nmeaparser.h"
     #include "ublox6.h"
     speed_t int_B9600 = B9600;
 %}
 
+%include "nmeaparser.h"
 %include "ublox6.h"
 speed_t int_B9600 = B9600;
 %array_class(char, charArray);
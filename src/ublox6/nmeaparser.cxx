@@ -0,0 +1,628 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "nmeaparser.h"
+
+using namespace upm;
+
+// UBX framing
+#define UBX_SYNC1 0xb5
+#define UBX_SYNC2 0x62
+
+// UBX messages in the NAV class that we decode
+#define UBX_CLASS_NAV       0x01
+#define UBX_NAV_POSLLH      0x02
+#define UBX_NAV_DOP         0x04
+#define UBX_NAV_SOL         0x06
+#define UBX_NAV_VELNED      0x12
+#define UBX_NAV_TIMEUTC     0x21
+
+// resync if a UBX header claims a length longer than this
+#define UBX_MAX_LENGTH      4096
+
+// maximum number of fields split out of a sentence
+#define NMEA_MAX_FIELDS     24
+
+#define KNOTS_TO_MPS        0.514444
+#define KMH_TO_MPS          (1.0 / 3.6)
+
+static const double powersOf10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+  1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+
+// little endian UBX payload accessors
+static inline uint16_t ubxU2(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t ubxU4(const uint8_t *p)
+{
+  return ( (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24) );
+}
+
+static inline int32_t ubxI4(const uint8_t *p)
+{
+  return (int32_t)ubxU4(p);
+}
+
+NMEAParser::NMEAParser()
+{
+  m_fixCallback = 0;
+  m_fixCtx = 0;
+
+  m_sentences = 0;
+  m_ubxMessages = 0;
+  m_errors = 0;
+  m_fixes = 0;
+
+  reset();
+}
+
+void NMEAParser::reset()
+{
+  m_state = STATE_IDLE;
+  m_sentenceLen = 0;
+  m_ubxHeaderLen = 0;
+  m_ubxLen = 0;
+  m_ubxIdx = 0;
+  m_ubxCkA = 0;
+  m_ubxCkB = 0;
+
+  memset(&m_work, 0, sizeof(m_work));
+  memset(&m_fix, 0, sizeof(m_fix));
+
+  m_ggaTime = -1;
+  m_rmcTime = -1;
+  m_posllhTow = -1;
+  m_velnedTow = -1;
+
+  m_newFixes = 0;
+}
+
+void NMEAParser::setFixCallback(FIX_CALLBACK_T cb, void *ctx)
+{
+  m_fixCallback = cb;
+  m_fixCtx = ctx;
+}
+
+int NMEAParser::parse(const uint8_t *data, int len)
+{
+  m_newFixes = 0;
+
+  for (int i = 0; i < len; i++)
+    {
+      uint8_t c = data[i];
+
+      switch (m_state)
+        {
+        case STATE_IDLE:
+          if (c == '$')
+            {
+              m_sentence[0] = c;
+              m_sentenceLen = 1;
+              m_state = STATE_NMEA;
+            }
+          else if (c == UBX_SYNC1)
+            m_state = STATE_UBX_SYNC2;
+          break;
+
+        case STATE_NMEA:
+          if (c == '\r' || c == '\n')
+            {
+              if (!processSentence())
+                m_errors++;
+              m_state = STATE_IDLE;
+            }
+          else if (c == '$')
+            {
+              // truncated sentence, start over
+              m_errors++;
+              m_sentenceLen = 1;
+            }
+          else if (m_sentenceLen >= NMEA_MAX_SENTENCE)
+            {
+              m_errors++;
+              m_state = STATE_IDLE;
+            }
+          else
+            m_sentence[m_sentenceLen++] = c;
+          break;
+
+        case STATE_UBX_SYNC2:
+          if (c == UBX_SYNC2)
+            {
+              m_ubxHeaderLen = 0;
+              m_ubxCkA = 0;
+              m_ubxCkB = 0;
+              m_state = STATE_UBX_HEADER;
+            }
+          else if (c == '$')
+            {
+              m_sentence[0] = c;
+              m_sentenceLen = 1;
+              m_state = STATE_NMEA;
+            }
+          else
+            m_state = (c == UBX_SYNC1) ? STATE_UBX_SYNC2 : STATE_IDLE;
+          break;
+
+        case STATE_UBX_HEADER:
+          m_ubxHeader[m_ubxHeaderLen++] = c;
+          m_ubxCkA += c;
+          m_ubxCkB += m_ubxCkA;
+
+          if (m_ubxHeaderLen == 4)
+            {
+              m_ubxLen = ubxU2(&m_ubxHeader[2]);
+              m_ubxIdx = 0;
+
+              if (m_ubxLen > UBX_MAX_LENGTH)
+                {
+                  m_errors++;
+                  m_state = STATE_IDLE;
+                }
+              else
+                m_state = m_ubxLen ? STATE_UBX_PAYLOAD : STATE_UBX_CK_A;
+            }
+          break;
+
+        case STATE_UBX_PAYLOAD:
+          // payloads longer than our buffer are checksummed but
+          // not stored
+          if (m_ubxIdx < UBX_MAX_PAYLOAD)
+            m_ubxPayload[m_ubxIdx] = c;
+          m_ubxIdx++;
+          m_ubxCkA += c;
+          m_ubxCkB += m_ubxCkA;
+
+          if (m_ubxIdx == m_ubxLen)
+            m_state = STATE_UBX_CK_A;
+          break;
+
+        case STATE_UBX_CK_A:
+          if (c == m_ubxCkA)
+            m_state = STATE_UBX_CK_B;
+          else
+            {
+              m_errors++;
+              m_state = STATE_IDLE;
+            }
+          break;
+
+        case STATE_UBX_CK_B:
+          if (c == m_ubxCkB)
+            {
+              m_ubxMessages++;
+              processUBX();
+            }
+          else
+            m_errors++;
+          m_state = STATE_IDLE;
+          break;
+        }
+    }
+
+  return m_newFixes;
+}
+
+int NMEAParser::hexValue(uint8_t c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+bool NMEAParser::processSentence()
+{
+  // "$<address>,<fields>*hh"
+  if (m_sentenceLen < 9 || m_sentence[m_sentenceLen - 3] != '*')
+    return false;
+
+  int hi = hexValue(m_sentence[m_sentenceLen - 2]);
+  int lo = hexValue(m_sentence[m_sentenceLen - 1]);
+  if (hi < 0 || lo < 0)
+    return false;
+
+  int end = m_sentenceLen - 3;
+  uint8_t cksum = 0;
+  for (int i = 1; i < end; i++)
+    cksum ^= m_sentence[i];
+
+  if (cksum != ((hi << 4) | lo))
+    return false;
+
+  m_sentences++;
+
+  // split the fields in place
+  FIELD_T fields[NMEA_MAX_FIELDS];
+  int count = 0;
+  const char *start = &m_sentence[1];
+
+  for (int i = 1; i <= end && count < NMEA_MAX_FIELDS; i++)
+    {
+      if (i == end || m_sentence[i] == ',')
+        {
+          fields[count].start = start;
+          fields[count].len = (int)(&m_sentence[i] - start);
+          count++;
+          start = &m_sentence[i + 1];
+        }
+    }
+
+  // the sentence type follows the talker ID (GP, GN, GL, ...)
+  if (fields[0].len < 5)
+    return true;
+
+  const char *type = fields[0].start + fields[0].len - 3;
+
+  if (!memcmp(type, "GGA", 3))
+    processGGA(fields, count);
+  else if (!memcmp(type, "RMC", 3))
+    processRMC(fields, count);
+  else if (!memcmp(type, "GSA", 3))
+    processGSA(fields, count);
+  else if (!memcmp(type, "VTG", 3))
+    processVTG(fields, count);
+
+  return true;
+}
+
+bool NMEAParser::parseNumber(const FIELD_T& f, double *value)
+{
+  const char *p = f.start;
+  const char *end = f.start + f.len;
+  bool negative = false;
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int decimals = -1;
+
+  if (p == end)
+    return false;
+
+  if (*p == '-' || *p == '+')
+    negative = (*p++ == '-');
+
+  for (; p < end; p++)
+    {
+      if (*p == '.' && decimals < 0)
+        decimals = 0;
+      else if (*p >= '0' && *p <= '9')
+        {
+          // ignore digits past what a double can hold
+          if (digits < 18)
+            {
+              mantissa = mantissa * 10 + (*p - '0');
+              digits++;
+              if (decimals >= 0)
+                decimals++;
+            }
+        }
+      else
+        return false;
+    }
+
+  if (!digits)
+    return false;
+
+  double v = (double)mantissa;
+  if (decimals > 0)
+    v /= powersOf10[decimals];
+
+  *value = negative ? -v : v;
+  return true;
+}
+
+bool NMEAParser::parseTime(const FIELD_T& f, uint8_t *hour, uint8_t *minute,
+                           uint8_t *second, uint16_t *millisecond)
+{
+  // hhmmss[.sss]
+  if (f.len < 6)
+    return false;
+
+  for (int i = 0; i < 6; i++)
+    if (f.start[i] < '0' || f.start[i] > '9')
+      return false;
+
+  *hour = (f.start[0] - '0') * 10 + (f.start[1] - '0');
+  *minute = (f.start[2] - '0') * 10 + (f.start[3] - '0');
+  *second = (f.start[4] - '0') * 10 + (f.start[5] - '0');
+
+  int ms = 0;
+  int scale = 100;
+  for (int i = 7; i < f.len && scale; i++, scale /= 10)
+    ms += (f.start[i] - '0') * scale;
+  *millisecond = ms;
+
+  return true;
+}
+
+bool NMEAParser::parseCoordinate(const FIELD_T& value, const FIELD_T& hemi,
+                                 double *degrees)
+{
+  // (d)ddmm.mmmm
+  double v;
+
+  if (!parseNumber(value, &v) || hemi.len != 1)
+    return false;
+
+  int whole = (int)(v / 100.0);
+  double d = whole + (v - whole * 100.0) / 60.0;
+
+  if (hemi.start[0] == 'S' || hemi.start[0] == 'W')
+    d = -d;
+
+  *degrees = d;
+  return true;
+}
+
+void NMEAParser::processGGA(const FIELD_T *f, int count)
+{
+  // time, lat, N/S, lon, E/W, quality, numSV, HDOP, alt, M, sep, M
+  if (count < 12)
+    return;
+
+  double v;
+
+  if (!parseTime(f[1], &m_work.hour, &m_work.minute, &m_work.second,
+                 &m_work.millisecond))
+    return;
+  m_work.valid |= FIX_VALID_TIME;
+
+  if (parseNumber(f[6], &v))
+    m_work.quality = (uint8_t)v;
+  if (parseNumber(f[7], &v))
+    m_work.satellites = (uint8_t)v;
+  if (parseNumber(f[8], &v))
+    m_work.hdop = v;
+
+  if (m_work.quality &&
+      parseCoordinate(f[2], f[3], &m_work.latitude) &&
+      parseCoordinate(f[4], f[5], &m_work.longitude))
+    {
+      m_work.valid |= FIX_VALID_POSITION;
+
+      if (parseNumber(f[9], &v))
+        {
+          m_work.altitude = v;
+          m_work.valid |= FIX_VALID_ALTITUDE;
+        }
+      if (parseNumber(f[11], &v))
+        m_work.geoidSeparation = v;
+    }
+  else
+    m_work.valid &= ~(FIX_VALID_POSITION | FIX_VALID_ALTITUDE);
+
+  m_ggaTime = ( (m_work.hour * 3600L + m_work.minute * 60L + m_work.second)
+                * 1000L + m_work.millisecond );
+
+  if (m_ggaTime == m_rmcTime)
+    completeFix();
+}
+
+void NMEAParser::processRMC(const FIELD_T *f, int count)
+{
+  // time, status, lat, N/S, lon, E/W, speed (kn), course, date, ...
+  if (count < 10)
+    return;
+
+  double v;
+
+  if (!parseTime(f[1], &m_work.hour, &m_work.minute, &m_work.second,
+                 &m_work.millisecond))
+    return;
+  m_work.valid |= FIX_VALID_TIME;
+
+  // ddmmyy
+  if (f[9].len == 6)
+    {
+      const char *d = f[9].start;
+
+      m_work.day = (d[0] - '0') * 10 + (d[1] - '0');
+      m_work.month = (d[2] - '0') * 10 + (d[3] - '0');
+      m_work.year = 2000 + (d[4] - '0') * 10 + (d[5] - '0');
+      m_work.valid |= FIX_VALID_DATE;
+    }
+
+  if (f[2].len == 1 && f[2].start[0] == 'A' &&
+      parseCoordinate(f[3], f[4], &m_work.latitude) &&
+      parseCoordinate(f[5], f[6], &m_work.longitude))
+    {
+      m_work.valid |= FIX_VALID_POSITION;
+
+      if (parseNumber(f[7], &v))
+        {
+          m_work.speed = v * KNOTS_TO_MPS;
+          m_work.valid |= FIX_VALID_VELOCITY;
+        }
+      if (parseNumber(f[8], &v))
+        m_work.course = v;
+    }
+  else
+    m_work.valid &= ~(FIX_VALID_POSITION | FIX_VALID_VELOCITY);
+
+  m_rmcTime = ( (m_work.hour * 3600L + m_work.minute * 60L + m_work.second)
+                * 1000L + m_work.millisecond );
+
+  if (m_ggaTime == m_rmcTime)
+    completeFix();
+}
+
+void NMEAParser::processGSA(const FIELD_T *f, int count)
+{
+  // mode, fix type, 12 satellite IDs, PDOP, HDOP, VDOP
+  if (count < 18)
+    return;
+
+  double v;
+
+  if (parseNumber(f[2], &v))
+    m_work.fixType = (uint8_t)v;
+
+  if (parseNumber(f[15], &v))
+    m_work.pdop = v;
+  if (parseNumber(f[16], &v))
+    m_work.hdop = v;
+  if (parseNumber(f[17], &v))
+    {
+      m_work.vdop = v;
+      m_work.valid |= FIX_VALID_DOP;
+    }
+}
+
+void NMEAParser::processVTG(const FIELD_T *f, int count)
+{
+  // course (T), T, course (M), M, speed (kn), N, speed (km/h), K
+  if (count < 9)
+    return;
+
+  double v;
+
+  if (parseNumber(f[1], &v))
+    m_work.course = v;
+
+  if (parseNumber(f[7], &v))
+    {
+      m_work.speed = v * KMH_TO_MPS;
+      m_work.valid |= FIX_VALID_VELOCITY;
+    }
+}
+
+bool NMEAParser::processUBX()
+{
+  if (m_ubxHeader[0] != UBX_CLASS_NAV)
+    return false;
+
+  const uint8_t *p = m_ubxPayload;
+  long tow;
+
+  switch (m_ubxHeader[1])
+    {
+    case UBX_NAV_POSLLH:
+      if (m_ubxLen < 28)
+        return false;
+
+      m_work.longitude = ubxI4(&p[4]) * 1e-7;
+      m_work.latitude = ubxI4(&p[8]) * 1e-7;
+      m_work.altitude = ubxI4(&p[16]) / 1000.0;
+      m_work.geoidSeparation = (ubxI4(&p[12]) - ubxI4(&p[16])) / 1000.0;
+
+      // fixType is still 0 until the first NAV-SOL or GSA, which
+      // follows NAV-POSLLH in an epoch
+      if (m_work.fixType >= FIX_TYPE_2D)
+        m_work.valid |= (FIX_VALID_POSITION | FIX_VALID_ALTITUDE);
+      else
+        m_work.valid &= ~(FIX_VALID_POSITION | FIX_VALID_ALTITUDE);
+
+      tow = ubxU4(&p[0]);
+      m_posllhTow = tow;
+      if (m_velnedTow == tow)
+        completeFix();
+      return true;
+
+    case UBX_NAV_VELNED:
+      if (m_ubxLen < 36)
+        return false;
+
+      m_work.climb = -ubxI4(&p[12]) / 100.0;
+      m_work.speed = ubxU4(&p[20]) / 100.0;
+      m_work.course = ubxI4(&p[24]) * 1e-5;
+      m_work.valid |= FIX_VALID_VELOCITY;
+
+      tow = ubxU4(&p[0]);
+      m_velnedTow = tow;
+      if (m_posllhTow == tow)
+        completeFix();
+      return true;
+
+    case UBX_NAV_SOL:
+      if (m_ubxLen < 52)
+        return false;
+
+      switch (p[10])
+        {
+        case 2:  m_work.fixType = FIX_TYPE_2D; break;
+        case 3:
+        case 4:  m_work.fixType = FIX_TYPE_3D; break;
+        default: m_work.fixType = FIX_TYPE_NONE; break;
+        }
+      m_work.quality = (m_work.fixType != FIX_TYPE_NONE);
+      m_work.pdop = ubxU2(&p[44]) / 100.0;
+      m_work.satellites = p[47];
+      return true;
+
+    case UBX_NAV_DOP:
+      if (m_ubxLen < 18)
+        return false;
+
+      m_work.pdop = ubxU2(&p[6]) / 100.0;
+      m_work.vdop = ubxU2(&p[10]) / 100.0;
+      m_work.hdop = ubxU2(&p[12]) / 100.0;
+      m_work.valid |= FIX_VALID_DOP;
+      return true;
+
+    case UBX_NAV_TIMEUTC:
+      if (m_ubxLen < 20)
+        return false;
+
+      // validUTC
+      if (!(p[19] & 0x04))
+        return true;
+
+      m_work.year = ubxU2(&p[12]);
+      m_work.month = p[14];
+      m_work.day = p[15];
+      m_work.hour = p[16];
+      m_work.minute = p[17];
+      m_work.second = p[18];
+      m_work.millisecond = (ubxI4(&p[8]) > 0) ? ubxI4(&p[8]) / 1000000 : 0;
+      m_work.valid |= (FIX_VALID_TIME | FIX_VALID_DATE);
+      return true;
+
+    default:
+      return false;
+    }
+}
+
+void NMEAParser::completeFix()
+{
+  m_fix = m_work;
+
+  m_fixes++;
+  m_newFixes++;
+
+  // don't report the same epoch twice
+  m_ggaTime = m_rmcTime = -1;
+  m_posllhTow = m_velnedTow = -1;
+
+  if (m_fixCallback)
+    m_fixCallback(&m_fix, m_fixCtx);
+}
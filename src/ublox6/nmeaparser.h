@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// longest NMEA sentence accepted, '$' through checksum (the standard
+// limit is 82 including CR/LF, receivers often exceed it slightly)
+#define NMEA_MAX_SENTENCE 128
+
+// largest UBX payload that is decoded, longer messages are skipped
+#define UBX_MAX_PAYLOAD 64
+
+namespace upm {
+
+  /**
+   * @brief Incremental NMEA 0183 and u-blox UBX protocol parser
+   *
+   * Bytes can be fed in chunks of any size with parse(); sentences
+   * and messages that straddle chunk boundaries are carried over in a
+   * fixed internal buffer, so no memory is allocated while parsing.
+   *
+   * GGA, RMC, GSA and VTG sentences (from any talker) and the UBX
+   * NAV-POSLLH, NAV-SOL, NAV-DOP, NAV-VELNED and NAV-TIMEUTC messages
+   * are decoded into a GPS_FIX_T.  Sentences with a bad checksum are
+   * counted and ignored.
+   *
+   * A fix is complete, and the fix callback is called, once both a
+   * GGA and an RMC sentence with the same time stamp have been seen,
+   * or both a NAV-POSLLH and a NAV-VELNED message for the same epoch.
+   */
+  class NMEAParser {
+  public:
+
+    // bits for GPS_FIX_T::valid
+    typedef enum {
+      FIX_VALID_TIME            = 0x01,
+      FIX_VALID_DATE            = 0x02,
+      FIX_VALID_POSITION        = 0x04,
+      FIX_VALID_ALTITUDE        = 0x08,
+      FIX_VALID_VELOCITY        = 0x10,
+      FIX_VALID_DOP             = 0x20
+    } FIX_VALID_BITS_T;
+
+    typedef enum {
+      FIX_TYPE_NONE             = 1,
+      FIX_TYPE_2D               = 2,
+      FIX_TYPE_3D               = 3
+    } FIX_TYPE_T;
+
+    typedef struct {
+      uint8_t valid;            // FIX_VALID_BITS_T bitmask
+
+      uint16_t year;
+      uint8_t month;
+      uint8_t day;
+      uint8_t hour;             // UTC
+      uint8_t minute;
+      uint8_t second;
+      uint16_t millisecond;
+
+      double latitude;          // degrees, north positive
+      double longitude;         // degrees, east positive
+      float altitude;           // meters above mean sea level
+      float geoidSeparation;    // meters
+
+      float speed;              // ground speed, m/s
+      float course;             // degrees from true north
+      float climb;              // vertical speed, m/s, up positive
+
+      float pdop;
+      float hdop;
+      float vdop;
+
+      uint8_t quality;          // GGA fix quality (0 = no fix)
+      uint8_t fixType;          // one of FIX_TYPE_T
+      uint8_t satellites;       // satellites used
+    } GPS_FIX_T;
+
+    typedef void (*FIX_CALLBACK_T)(const GPS_FIX_T *fix, void *ctx);
+
+    /**
+     * NMEAParser constructor
+     */
+    NMEAParser();
+
+    /**
+     * Discards any partial sentence and the current fix
+     */
+    void reset();
+
+    /**
+     * Sets a function to be called for each complete fix.  It is
+     * called from within parse().
+     *
+     * @param cb Callback, or NULL to disable
+     * @param ctx Argument passed to the callback
+     */
+    void setFixCallback(FIX_CALLBACK_T cb, void *ctx);
+
+    /**
+     * Feeds received bytes to the parser
+     *
+     * @param data Bytes received from the device
+     * @param len Number of bytes
+     * @return Number of fixes completed by this data
+     */
+    int parse(const uint8_t *data, int len);
+
+    /**
+     * Returns the most recently completed fix
+     *
+     * @return Pointer to the fix
+     */
+    const GPS_FIX_T *getFix() { return &m_fix; };
+
+    /**
+     * Returns the number of valid NMEA sentences parsed
+     */
+    unsigned long getSentenceCount() { return m_sentences; };
+
+    /**
+     * Returns the number of valid UBX messages parsed
+     */
+    unsigned long getUBXCount() { return m_ubxMessages; };
+
+    /**
+     * Returns the number of sentences and messages rejected for a
+     * bad checksum, or for being too long
+     */
+    unsigned long getErrorCount() { return m_errors; };
+
+    /**
+     * Returns the number of completed fixes
+     */
+    unsigned long getFixCount() { return m_fixes; };
+
+  private:
+    typedef enum {
+      STATE_IDLE,
+      STATE_NMEA,
+      STATE_UBX_SYNC2,
+      STATE_UBX_HEADER,
+      STATE_UBX_PAYLOAD,
+      STATE_UBX_CK_A,
+      STATE_UBX_CK_B
+    } STATE_T;
+
+    // a field of the current sentence, pointing into m_sentence
+    typedef struct {
+      const char *start;
+      int len;
+    } FIELD_T;
+
+    bool processSentence();
+    void processGGA(const FIELD_T *f, int count);
+    void processRMC(const FIELD_T *f, int count);
+    void processGSA(const FIELD_T *f, int count);
+    void processVTG(const FIELD_T *f, int count);
+    bool processUBX();
+
+    void completeFix();
+
+    static bool parseNumber(const FIELD_T& f, double *value);
+    static bool parseTime(const FIELD_T& f, uint8_t *hour, uint8_t *minute,
+                          uint8_t *second, uint16_t *millisecond);
+    static bool parseCoordinate(const FIELD_T& value, const FIELD_T& hemi,
+                                double *degrees);
+    static int hexValue(uint8_t c);
+
+    STATE_T m_state;
+
+    char m_sentence[NMEA_MAX_SENTENCE];
+    int m_sentenceLen;
+
+    uint8_t m_ubxHeader[4];     // class, id, length
+    int m_ubxHeaderLen;
+    uint8_t m_ubxPayload[UBX_MAX_PAYLOAD];
+    int m_ubxLen;
+    int m_ubxIdx;
+    uint8_t m_ubxCkA;
+    uint8_t m_ubxCkB;
+
+    // fix being assembled, and the last complete one
+    GPS_FIX_T m_work;
+    GPS_FIX_T m_fix;
+
+    // epoch tracking: time of the last GGA/RMC, iTOW of the last
+    // POSLLH/VELNED, -1 when not seen
+    long m_ggaTime;
+    long m_rmcTime;
+    long m_posllhTow;
+    long m_velnedTow;
+
+    int m_newFixes;
+
+    FIX_CALLBACK_T m_fixCallback;
+    void *m_fixCtx;
+
+    unsigned long m_sentences;
+    unsigned long m_ubxMessages;
+    unsigned long m_errors;
+    unsigned long m_fixes;
+  };
+}
@@ -8,10 +8,12 @@
 %feature("autodoc", "3");
 
 %{
+    #include "nmeaparser.h"
     #include "ublox6.h"
     speed_t int_B9600 = B9600;
 %}
 
+%include "nmeaparser.h"
 %include "ublox6.h"
 speed_t int_B9600 = B9600;
 %array_class(char, charArray);
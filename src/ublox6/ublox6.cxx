@@ -27,141 +27,60 @@
 #include <stdexcept>
 
 #include "ublox6.h"
+#include "uartport.h"
 
 using namespace upm;
 using namespace std;
 
 Ublox6::Ublox6(int uart)
 {
-  m_ttyFd = -1;
-
-  if ( !(m_uart = mraa_uart_init(uart)) )
-    {
-      throw std::invalid_argument(std::string(__FUNCTION__) +
-                                  ": mraa_uart_init() failed");
-      return;
-    }
-
-  // This requires a recent MRAA (1/2015)
-  const char *devPath = mraa_uart_get_dev_path(m_uart);
-
-  if (!devPath)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": mraa_uart_get_dev_path() failed");
-      return;
-    }
-
-  // now open the tty
-  if ( (m_ttyFd = open(devPath, O_RDWR)) == -1)
-    {
-      string err = __FUNCTION__;
-      err += ": open of " + std::string(devPath) + " failed: " + 
-        std::string(strerror(errno));
-
-      throw std::runtime_error(err);
-      return;
-    }
+  m_port = new UartPort(uart);
 }
 
 Ublox6::~Ublox6()
 {
-  if (m_ttyFd != -1)
-    close(m_ttyFd);
+  delete m_port;
 }
 
 bool Ublox6::dataAvailable()
 {
-  if (m_ttyFd == -1)
-    return false;
-
-  struct timeval timeout;
-
-  // no waiting
-  timeout.tv_sec = 0;
-  timeout.tv_usec = 0;
-
-  int nfds;  
-  fd_set readfds;
-
-  FD_ZERO(&readfds);
-
-  FD_SET(m_ttyFd, &readfds);
-  
-  if (select(m_ttyFd + 1, &readfds, NULL, NULL, &timeout) > 0)
-    return true;                // data is ready
-  else
-    return false;
+  return m_port->dataAvailable();
 }
 
 int Ublox6::readData(char *buffer, int len)
 {
-  if (m_ttyFd == -1)
-    return(-1);
-
-  int rv = read(m_ttyFd, buffer, len);
-
-  if (rv < 0)
-    {
-      string err = string(__FUNCTION__) + ": read failed: " + 
-        string(strerror(errno));
-
-      throw std::runtime_error(err);
-      return rv;
-    }
-
-  return rv;
+  return m_port->readData((uint8_t *)buffer, len);
 }
 
 int Ublox6::writeData(char * buffer, int len)
 {
-  if (m_ttyFd == -1)
-    return(-1);
-
-  int rv = write(m_ttyFd, buffer, len);
-
-  if (rv < 0)
-    {
-      string err = string(__FUNCTION__) + ": write failed: " + 
-        string(strerror(errno));
-
-      throw std::runtime_error(err);
-      return rv;
-    }
-
-  tcdrain(m_ttyFd);
-
-  return rv;
+  return m_port->writeData((uint8_t *)buffer, len);
 }
 
 bool Ublox6::setupTty(speed_t baud)
 {
-  if (m_ttyFd == -1)
-    return(false);
-  
-  struct termios termio;
+  return m_port->setupTty(baud);
+}
 
-  // get current modes
-  tcgetattr(m_ttyFd, &termio);
+int Ublox6::processData(unsigned int millis)
+{
+  uint8_t buffer[256];
+  int fixes = 0;
+  int rv;
 
-  // setup for a 'raw' mode.  81N, no echo or special character
-  // handling, such as flow control.
-  cfmakeraw(&termio);
+  if (!m_port->dataAvailable(millis))
+    return 0;
 
-  // set our baud rates
-  cfsetispeed(&termio, baud);
-  cfsetospeed(&termio, baud);
+  while ((rv = m_port->readData(buffer, sizeof(buffer), 0)) > 0)
+    fixes += m_parser.parse(buffer, rv);
 
-  // make it so
-  int rv;
-  if ( (rv = tcsetattr(m_ttyFd, TCSAFLUSH, &termio)) < 0)
-    {
-      string err = string(__FUNCTION__) + ": tcsetattr failed: " + 
-        string(strerror(errno));
+  if (rv < 0)
+    return -1;
 
-      throw std::runtime_error(err);
-      return false;
-    }
+  return fixes;
+}
 
-  return true;
+int Ublox6::ttyFd()
+{
+  return m_port->ttyFd();
 }
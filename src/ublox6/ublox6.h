@@ -40,9 +40,13 @@
 
 #include <mraa/uart.h>
 
+#include "nmeaparser.h"
+
 const int  UBLOX6_DEFAULT_UART = 0;
 
 namespace upm {
+  class UartPort;
+
     /**
      * @brief UBLOX6 & SIM28 GPS Module library
      * @defgroup ublox6 libupm-ublox6
@@ -118,12 +122,48 @@ namespace upm {
      */
     bool setupTty(speed_t baud=B9600);
 
+    /**
+     * Reads all available data and feeds it to the NMEA/UBX
+     * parser.  Use getFix() or a fix callback to retrieve the
+     * results.  Don't mix this with readData().
+     *
+     * @param millis Number of milliseconds to wait for data
+     * @return Number of fixes completed, or -1 on a read error
+     */
+    int processData(unsigned int millis=0);
+
+    /**
+     * Returns the most recent fix decoded by processData()
+     *
+     * @return Pointer to the fix
+     */
+    const NMEAParser::GPS_FIX_T *getFix() { return m_parser.getFix(); };
+
+    /**
+     * Sets a function to be called for each fix decoded by
+     * processData()
+     *
+     * @param cb Callback, or NULL to disable
+     * @param ctx Argument passed to the callback
+     */
+    void setFixCallback(NMEAParser::FIX_CALLBACK_T cb, void *ctx)
+    {
+      m_parser.setFixCallback(cb, ctx);
+    };
+
+    /**
+     * Returns the parser, for its statistics
+     *
+     * @return Reference to the parser
+     */
+    NMEAParser& getParser() { return m_parser; };
+
   protected:
-    int ttyFd() { return m_ttyFd; };
+    int ttyFd();
 
   private:
-    mraa_uart_context m_uart;
-    int m_ttyFd;
+    UartPort *m_port;
+    NMEAParser m_parser;
   };
 }
 
@@ -27,6 +27,7 @@
 #include <stdexcept>
 
 #include "uln200xa.h"
+#include "motionengine.h"
 
 using namespace upm;
 using namespace std;
@@ -77,6 +78,19 @@ ULN200XA::ULN200XA(int stepsPerRev, int i1, int i2, int i3, int i4)
     }
   mraa_gpio_dir(m_stepI4, MRAA_GPIO_OUT);
 
+  try
+    {
+      m_axis = new MotionAxis(&stepCallback, this);
+    }
+  catch (...)
+    {
+      mraa_gpio_close(m_stepI1);
+      mraa_gpio_close(m_stepI2);
+      mraa_gpio_close(m_stepI3);
+      mraa_gpio_close(m_stepI4);
+      throw;
+    }
+
   // set default speed to 1
   setSpeed(1);
 }
@@ -117,6 +131,8 @@ uint32_t ULN200XA::getMillis()
 
 ULN200XA::~ULN200XA()
 {
+  delete m_axis;
+
   mraa_gpio_close(m_stepI1);
   mraa_gpio_close(m_stepI2);
   mraa_gpio_close(m_stepI3);
@@ -126,6 +142,7 @@ ULN200XA::~ULN200XA()
 void ULN200XA::setSpeed(int speed)
 {
   m_stepDelay = 60 * 1000 / m_stepsPerRev / speed;
+  m_axis->setMaxSpeed(double(speed) * m_stepsPerRev / 60.0);
 }
 
 void ULN200XA::setDirection(ULN200XA_DIRECTION_T dir)
@@ -213,30 +230,27 @@ void ULN200XA::stepperStep()
 
 void ULN200XA::stepperSteps(unsigned int steps)
 {
-  while (steps > 0)
+  m_axis->waitMove(m_axis->move(m_stepDirection * int(steps)));
+}
+
+void ULN200XA::stepCallback(int dir, void *ctx)
+{
+  ULN200XA *This = (ULN200XA *)ctx;
+
+  This->m_currentStep += dir;
+
+  if (dir == 1)
     {
-      if (getMillis() >= m_stepDelay)
-        {
-          // reset the clock
-          initClock();
-
-          m_currentStep += m_stepDirection;
-
-          if (m_stepDirection == 1)
-            {
-              if (m_currentStep >= m_stepsPerRev)
-                m_currentStep = 0;
-            }
-          else
-            {
-              if (m_currentStep <= 0)
-                m_currentStep = m_stepsPerRev;
-            }
-
-          steps--;
-          stepperStep();
-        }
+      if (This->m_currentStep >= This->m_stepsPerRev)
+        This->m_currentStep = 0;
     }
+  else
+    {
+      if (This->m_currentStep <= 0)
+        This->m_currentStep = This->m_stepsPerRev;
+    }
+
+  This->stepperStep();
 }
 
 void ULN200XA::release()
@@ -30,6 +30,7 @@
 #include <mraa/pwm.h>
 
 namespace upm {
+  class MotionAxis;
 
   /**
    * @brief ULN200XA Stepper Driver library
@@ -115,12 +116,24 @@ namespace upm {
     void setDirection(ULN200XA_DIRECTION_T dir);
 
     /**
-     * Steps the stepper motor a specified number of steps
+     * Steps the stepper motor a specified number of steps.  The steps
+     * are generated by the background motion engine; this method
+     * sleeps until they are done.
      *
      * @param steps Number of steps to move the stepper motor
      */
     void stepperSteps(unsigned int steps);
 
+    /**
+     * Returns the motion engine axis driving this motor.  Use it to
+     * queue moves without blocking, set an acceleration, wait for or
+     * get called back on completion, and read the position.  Speeds
+     * are in steps per second.
+     *
+     * @return Motion axis
+     */
+    MotionAxis *getMotionAxis() { return m_axis; };
+
     /**
      * Releases the stepper motor by removing power
      *
@@ -141,12 +154,19 @@ namespace upm {
     int m_currentStep;
     uint32_t m_stepDelay;
 
+    MotionAxis *m_axis;
+
     /**
      * Steps the stepper motor one tick
      *
      */
     void stepperStep();
 
+    /**
+     * Motion engine step callback
+     */
+    static void stepCallback(int dir, void *ctx);
+
     /**
      * Defines the step direction: 1 = forward, -1 = backward
      *
@@ -30,13 +30,9 @@ using namespace upm;
 using namespace std;
 
 WheelEncoder::WheelEncoder(int pin) :
-  m_gpio(pin)
+  m_decoder(pin)
 {
-  m_gpio.dir(mraa::DIR_IN);
-
   initClock();
-  m_counter = 0;
-  m_isrInstalled = false;
 }
 
 WheelEncoder::~WheelEncoder()
@@ -80,27 +76,14 @@ uint32_t WheelEncoder::getMillis()
 void WheelEncoder::startCounter()
 {
   initClock();
-  m_counter = 0;
-
-  // install our interrupt handler
-  if (!m_isrInstalled)
-    m_gpio.isr(mraa::EDGE_RISING, &wheelISR, this);
+  m_decoder.setPosition(0);
 
-  m_isrInstalled = true;
+  // single channel: the decoder counts low to high transitions
+  m_decoder.start();
 }
 
 void WheelEncoder::stopCounter()
 {
-  // remove the interrupt handler
-  if (m_isrInstalled)
-    m_gpio.isrExit();
-
-  m_isrInstalled = false;
-}
-
-void WheelEncoder::wheelISR(void *ctx)
-{
-  upm::WheelEncoder *This = (upm::WheelEncoder *)ctx;
-  This->m_counter++;
+  m_decoder.stop();
 }
 
@@ -28,6 +28,8 @@
 #include <sys/time.h>
 #include <mraa/gpio.hpp>
 
+#include "quadrature.h"
+
 namespace upm {
 
   /**
@@ -57,7 +59,9 @@ namespace upm {
    *
    * This class also includes a millisecond counter, so that you can
    * correlate the number of counts to a time period for calculating
-   * an RPM or other value as needed.
+   * an RPM or other value as needed.  Each transition is also
+   * timestamped, and rpm() estimates the speed from the recent
+   * transitions directly.
    *
    * @snippet wheelencoder.cxx Interesting
    */
@@ -95,7 +99,7 @@ namespace upm {
      * stopped via stopCounter() prior to calling this function.
      *
      */
-    void clearCounter() { m_counter = 0; };
+    void clearCounter() { m_decoder.setPosition(0); };
 
     /**
      * Starts the counter.  This function will also clear the current
@@ -115,16 +119,30 @@ namespace upm {
      *
      * @return counter value
      */
-    uint32_t counter() { return m_counter; };
+    uint32_t counter() { return (uint32_t)m_decoder.getPosition(); };
+
+    /**
+     * Gets the rotation speed
+     *
+     * @param countsPerRev Counts per revolution of the wheel (20 for
+     * the DFRobot encoder disc)
+     * @return Revolutions per minute
+     */
+    double rpm(int countsPerRev=20) { return m_decoder.getRPM(countsPerRev); };
+
+    /**
+     * Returns the decoder, for velocity, acceleration and glitch
+     * statistics
+     *
+     * @return The decoder
+     */
+    QuadratureDecoder& decoder() { return m_decoder; };
 
   protected:
-    mraa::Gpio m_gpio;
-    static void wheelISR(void *ctx);
+    QuadratureDecoder m_decoder;
 
   private:
-    volatile uint32_t m_counter;
     struct timeval m_startTime;
-    bool m_isrInstalled;
   };
 }
 
@@ -48,6 +48,8 @@ const uint8_t WT5001_START = 0x7e;
 const uint8_t WT5001_END   = 0x7e;
 
 namespace upm {
+  class UartPort;
+
     /**
      * @brief WT5001 Serial MP3 module library
      * @defgroup wt5001 libupm-wt5001
@@ -372,11 +374,10 @@ namespace upm {
 
 
   protected:
-    int ttyFd() { return m_ttyFd; };
+    int ttyFd();
 
   private:
-    mraa_uart_context m_uart;
-    int m_ttyFd;
+    UartPort *m_port;
   };
 }
 
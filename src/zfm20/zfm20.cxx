@@ -27,6 +27,7 @@
 #include <stdexcept>
 
 #include "zfm20.h"
+#include "uartport.h"
 
 using namespace upm;
 using namespace std;
@@ -35,34 +36,7 @@ static const int defaultDelay = 100;     // max wait time for read
 
 ZFM20::ZFM20(int uart)
 {
-  m_ttyFd = -1;
-
-  if ( !(m_uart = mraa_uart_init(uart)) )
-    {
-      throw std::invalid_argument(std::string(__FUNCTION__) +
-                                  ": mraa_uart_init() failed");
-      return;
-    }
-
-  // This requires a recent MRAA (1/2015)
-  const char *devPath = mraa_uart_get_dev_path(m_uart);
-
-  if (!devPath)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": mraa_uart_get_dev_path() failed");
-      return;
-    }
-
-  // now open the tty
-  if ( (m_ttyFd = open(devPath, O_RDWR)) == -1)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": open of " + 
-                               string(devPath) + " failed: " +
-                               string(strerror(errno)));
-      return;
-    }
+  m_port = new UartPort(uart);
 
   // Set the default password and address
   setPassword(ZFM20_DEFAULT_PASSWORD);
@@ -73,74 +47,27 @@ ZFM20::ZFM20(int uart)
 
 ZFM20::~ZFM20()
 {
-  if (m_ttyFd != -1)
-    close(m_ttyFd);
+  delete m_port;
 
   mraa_deinit();
 }
 
 bool ZFM20::dataAvailable(unsigned int millis)
 {
-  if (m_ttyFd == -1)
-    return false;
-
-  struct timeval timeout;
-
-  // no waiting
-  timeout.tv_sec = 0;
-  timeout.tv_usec = millis * 1000;
-
-  int nfds;  
-  fd_set readfds;
-
-  FD_ZERO(&readfds);
-
-  FD_SET(m_ttyFd, &readfds);
-  
-  if (select(m_ttyFd + 1, &readfds, NULL, NULL, &timeout) > 0)
-    return true;                // data is ready
-  else
-    return false;
+  return m_port->dataAvailable(millis);
 }
 
 int ZFM20::readData(char *buffer, int len)
 {
-  if (m_ttyFd == -1)
-    return(-1);
-
-  if (!dataAvailable(defaultDelay))
-    return 0;               // timed out
-
-  int rv = read(m_ttyFd, buffer, len);
-
-  if (rv < 0)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": read() failed: " +
-                               string(strerror(errno)));
-      return rv;
-    }
-
-  return rv;
+  return m_port->readData((uint8_t *)buffer, len, defaultDelay);
 }
 
 int ZFM20::writeData(char *buffer, int len)
 {
-  if (m_ttyFd == -1)
-    return(-1);
-
   // first, flush any pending but unread input
-  tcflush(m_ttyFd, TCIFLUSH);
+  m_port->flushInput();
 
-  int rv = write(m_ttyFd, buffer, len);
-
-  if (rv < 0)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": write() failed: " +
-                               string(strerror(errno)));
-      return rv;
-    }
+  int rv = m_port->writeData((uint8_t *)buffer, len);
 
   if (rv == 0)
     {
@@ -149,39 +76,17 @@ int ZFM20::writeData(char *buffer, int len)
       return rv;
     }
 
-  tcdrain(m_ttyFd);
-
   return rv;
 }
 
 bool ZFM20::setupTty(speed_t baud)
 {
-  if (m_ttyFd == -1)
-    return(false);
-  
-  struct termios termio;
-
-  // get current modes
-  tcgetattr(m_ttyFd, &termio);
-
-  // setup for a 'raw' mode.  81N, no echo or special character
-  // handling, such as flow control.
-  cfmakeraw(&termio);
-
-  // set our baud rates
-  cfsetispeed(&termio, baud);
-  cfsetospeed(&termio, baud);
-
-  // make it so
-  if (tcsetattr(m_ttyFd, TCSAFLUSH, &termio) < 0)
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": tcsetattr() failed: " +
-                               string(strerror(errno)));
-      return false;
-    }
+  return m_port->setupTty(baud);
+}
 
-  return true;
+int ZFM20::ttyFd()
+{
+  return m_port->ttyFd();
 }
 
 int ZFM20::writeCmdPacket(uint8_t *pkt, int len)
@@ -274,8 +179,6 @@ bool ZFM20::verifyPacket(uint8_t *pkt, int len)
 
 bool ZFM20::getResponse(uint8_t *pkt, int len)
 {
-  char buf[ZFM20_MAX_PKT_LEN];
-
   initClock();
 
   int idx = 0;
@@ -299,20 +202,16 @@ bool ZFM20::getResponse(uint8_t *pkt, int len)
           continue;
         }
 
-      if ((rv = readData(buf, ZFM20_MAX_PKT_LEN)) == 0)
+      // read straight into the user supplied buffer, anything past
+      // the end of this packet stays queued in the port
+      if ((rv = readData((char *)&pkt[idx], len - idx)) == 0)
         {
           throw std::runtime_error(std::string(__FUNCTION__) +
                                    ": readData() failed, no data returned");
           return false;
         }
 
-      // copy it into the user supplied buffer
-      for (int i=0; i<rv; i++)
-        {
-          pkt[idx++] = buf[i];
-          if (idx >= len)
-            break;
-        }
+      idx += rv;
     }
 
   // now verify it.
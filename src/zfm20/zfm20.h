@@ -58,6 +58,8 @@
 
 
 namespace upm {
+  class UartPort;
+
     /**
      * @brief ZFM-20 Fingerprint Sensor Module library
      * @defgroup zfm20 libupm-zfm20
@@ -365,11 +367,10 @@ namespace upm {
 
 
   protected:
-    int ttyFd() { return m_ttyFd; };
+    int ttyFd();
 
   private:
-    mraa_uart_context m_uart;
-    int m_ttyFd;
+    UartPort *m_port;
     uint32_t m_password;
     uint32_t m_address;
     struct timeval m_startTime;